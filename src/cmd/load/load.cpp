@@ -0,0 +1,1297 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// opens many client sessions to a server from one process so the server
+// can be measured with hundreds of clients and no screen for each.  the
+// sessions answer the handshake and keepalives like a client would and
+// check every message they get.  a Host Control API connection switches
+// the server between them and each session times its enter.  the same
+// connection drives input on a virtual primary screen and the session
+// that was entered times its arrival.
+
+#include "barrier/PacketStreamFilter.h"
+#include "barrier/ProtocolUtil.h"
+#include "barrier/protocol_types.h"
+#include "net/IDataSocket.h"
+#include "net/NetworkAddress.h"
+#include "net/SocketMultiplexer.h"
+#include "net/TCPSocketFactory.h"
+#include "server/HostControlServer.h"
+#include "base/EventQueue.h"
+#include "base/Log.h"
+#include "base/String.h"
+#include "base/TMethodEventJob.h"
+#include "base/XBase.h"
+#include "arch/Arch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// an enter or input that hasn't arrived this long after it was
+// requested is counted as missed
+const double kEnterTimeout = 2.0;
+
+struct Options {
+    Options() :
+        m_server("localhost"),
+        m_primary("server"),
+        m_prefix("load-"),
+        m_clients(10),
+        m_tls(false),
+        m_rate(20.0),
+        m_inputRate(100.0),
+        m_duration(10.0),
+        m_serverPid(0),
+        m_w(1920),
+        m_h(1080),
+        m_perClient(false),
+        m_printConfig(false) {}
+
+    std::string m_server;
+    std::string m_control;
+    std::string m_primary;
+    std::string m_prefix;
+    int m_clients;
+    bool m_tls;
+    double m_rate;
+    double m_inputRate;
+    double m_duration;
+    int m_serverPid;
+    SInt16 m_w;
+    SInt16 m_h;
+    bool m_perClient;
+    bool m_printConfig;
+};
+
+double seconds(Clock::duration d)
+{
+    return std::chrono::duration<double>(d).count();
+}
+
+// CPU time used by process pid, or by this process if pid is 0, in
+// seconds.  negative if it can't be read.
+double getCpuTime(int pid)
+{
+#if defined(__linux__)
+    if (pid == 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+               static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1.0e6;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1.0;
+    }
+    char line[1024];
+    size_t n = fread(line, 1, sizeof(line) - 1, file);
+    fclose(file);
+    line[n] = 0;
+
+    // utime and stime are the 12th and 13th fields after the command,
+    // which is in parentheses and may hold spaces
+    const char* p = strrchr(line, ')');
+    unsigned long utime, stime;
+    if (p == NULL || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                            &utime, &stime) != 2) {
+        return -1.0;
+    }
+    return static_cast<double>(utime + stime) / static_cast<double>(sysconf(_SC_CLK_TCK));
+#else
+    (void)pid;
+    return -1.0;
+#endif
+}
+
+class LoadGenerator;
+
+// one client connection.  everything the server sends is read and
+// checked and the session is closed on the first protocol error.
+class Session {
+public:
+    enum EState {
+        kIdle,
+        kConnecting,
+        kHandshake,
+        kConnected,
+        kClosed
+    };
+
+    Session(LoadGenerator* generator, IEventQueue* events, const std::string& name,
+            SInt16 w, SInt16 h);
+    ~Session();
+
+    void connect(ISocketFactory* factory, const NetworkAddress& address, bool tls);
+    void close(const std::string& why);
+
+    // the server has just been asked to switch to this session
+    void expectEnter(Clock::time_point when);
+
+    // counts an enter that never arrived
+    void checkEnterTimeout(Clock::time_point now);
+
+    // input that reaches the client as the message \c code has just been
+    // sent to the server
+    void expectInput(const char* code, Clock::time_point when);
+
+    // counts input that never arrived
+    void checkInputTimeout(Clock::time_point now);
+
+public:
+    std::string m_name;
+    EState m_state;
+    std::string m_error;
+
+    std::uint64_t m_messages;
+    std::uint64_t m_bytes;
+    std::uint64_t m_inputMessages;
+    std::uint64_t m_keepAlives;
+    std::uint64_t m_invalid;
+    std::uint64_t m_missedEnters;
+    std::uint64_t m_missedInputs;
+
+    // milliseconds from each switch request to its enter
+    std::vector<double> m_latencies;
+
+    // milliseconds from each input request to its message
+    std::vector<double> m_inputLatencies;
+
+private:
+    void handleConnected(const Event&, void*);
+    void handleConnectionFailed(const Event&, void*);
+    void handleDisconnected(const Event&, void*);
+    void handleData(const Event&, void*);
+
+    bool readHello();
+    bool readMessage(const UInt8* code);
+    bool checkShape(SInt16 x, SInt16 y) const;
+    void inputArrived(const UInt8* code);
+
+private:
+    LoadGenerator* m_generator;
+    IEventQueue* m_events;
+    SInt16 m_w;
+    SInt16 m_h;
+    barrier::IStream* m_stream;
+    bool m_ready;
+    bool m_enterPending;
+    Clock::time_point m_switchTime;
+
+    struct PendingInput {
+        const char* m_code;
+        Clock::time_point m_time;
+    };
+
+    // input sent to the server and not yet received, oldest first
+    std::deque<PendingInput> m_pendingInputs;
+};
+
+// sends screen switches and input to the server's Host Control API
+class ControlConnection {
+public:
+    ControlConnection(IEventQueue* events);
+    ~ControlConnection();
+
+    void connect(ISocketFactory* factory, const NetworkAddress& address);
+    void requestSwitch(const std::string& screen);
+
+    // posts input commands for a virtual primary screen
+    void requestInput(const std::string& commands);
+
+public:
+    std::uint64_t m_switched;
+    std::uint64_t m_refused;
+    std::uint64_t m_inputs;
+    std::uint64_t m_inputsRefused;
+    bool m_failed;
+
+private:
+    void send(const std::string& request, bool isInput);
+    void handleConnected(const Event&, void*);
+    void handleFailed(const Event&, void*);
+    void handleData(const Event&, void*);
+    void close();
+
+private:
+    IEventQueue* m_events;
+    IDataSocket* m_socket;
+    bool m_connected;
+    std::string m_unsent;
+    std::string m_input;
+
+    // whether each request waiting for its response was input
+    std::deque<bool> m_requests;
+};
+
+class LoadGenerator {
+public:
+    LoadGenerator(const Options& options, IEventQueue* events, ISocketFactory* factory);
+    ~LoadGenerator();
+
+    bool start();
+    void report();
+
+    // a session has finished its handshake, or given up on it if it's
+    // closed
+    void sessionReady(Session*);
+
+    // a session that was ready has closed
+    void sessionClosed(Session*);
+
+    // the server has entered or left a session
+    void sessionEntered(Session*);
+    void sessionLeft(Session*);
+
+private:
+    void startMeasuring();
+    void handleConnectTimeout(const Event&, void*);
+    void handleSwitchTimer(const Event&, void*);
+    void handleInputTimer(const Event&, void*);
+    void handleDurationTimer(const Event&, void*);
+    void removeTimer(EventQueueTimer*& timer);
+    std::uint64_t countMessages() const;
+    std::uint64_t countBytes() const;
+
+private:
+    const Options& m_options;
+    IEventQueue* m_events;
+    ISocketFactory* m_factory;
+    std::vector<std::unique_ptr<Session> > m_sessions;
+    std::unique_ptr<ControlConnection> m_control;
+    int m_pending;
+    bool m_measuring;
+    size_t m_nextSwitch;
+    const Session* m_lastSwitch;
+    EventQueueTimer* m_connectTimer;
+    EventQueueTimer* m_switchTimer;
+    EventQueueTimer* m_inputTimer;
+    EventQueueTimer* m_durationTimer;
+
+    // the session input goes to, once its enter has arrived
+    Session* m_inputTarget;
+    unsigned int m_inputStep;
+
+    // measured between startMeasuring() and the end of the run
+    Clock::time_point m_start;
+    Clock::time_point m_end;
+    std::uint64_t m_startMessages;
+    std::uint64_t m_endMessages;
+    std::uint64_t m_startBytes;
+    std::uint64_t m_endBytes;
+    double m_startServerCpu;
+    double m_endServerCpu;
+    double m_startOwnCpu;
+    double m_endOwnCpu;
+};
+
+//
+// Session
+//
+
+Session::Session(LoadGenerator* generator, IEventQueue* events, const std::string& name,
+                 SInt16 w, SInt16 h) :
+    m_name(name),
+    m_state(kIdle),
+    m_messages(0),
+    m_bytes(0),
+    m_inputMessages(0),
+    m_keepAlives(0),
+    m_invalid(0),
+    m_missedEnters(0),
+    m_missedInputs(0),
+    m_generator(generator),
+    m_events(events),
+    m_w(w),
+    m_h(h),
+    m_stream(NULL),
+    m_ready(false),
+    m_enterPending(false)
+{
+}
+
+Session::~Session()
+{
+    if (m_stream != NULL) {
+        m_events->removeHandlers(m_stream->getEventTarget());
+        delete m_stream;
+    }
+}
+
+void Session::connect(ISocketFactory* factory, const NetworkAddress& address, bool tls)
+{
+    // like the client, a TLS session authenticates the server
+    ConnectionSecurityLevel level = tls ?
+        ConnectionSecurityLevel::ENCRYPTED_AUTHENTICATED : ConnectionSecurityLevel::PLAINTEXT;
+    IDataSocket* socket = factory->create(ARCH->getAddrFamily(address.getAddress()), level);
+    m_stream = new PacketStreamFilter(m_events, socket, true);
+    void* target = m_stream->getEventTarget();
+
+    m_events->adoptHandler(tls ? m_events->forIDataSocket().secureConnected() :
+                                 m_events->forIDataSocket().connected(),
+                           target, new TMethodEventJob<Session>(this, &Session::handleConnected));
+    m_events->adoptHandler(m_events->forIDataSocket().connectionFailed(), target,
+                           new TMethodEventJob<Session>(this, &Session::handleConnectionFailed));
+    m_events->adoptHandler(m_events->forIStream().inputReady(), target,
+                           new TMethodEventJob<Session>(this, &Session::handleData));
+    m_events->adoptHandler(m_events->forISocket().disconnected(), target,
+                           new TMethodEventJob<Session>(this, &Session::handleDisconnected));
+    m_events->adoptHandler(m_events->forIStream().inputShutdown(), target,
+                           new TMethodEventJob<Session>(this, &Session::handleDisconnected));
+    m_events->adoptHandler(m_events->forIStream().outputError(), target,
+                           new TMethodEventJob<Session>(this, &Session::handleDisconnected));
+
+    m_state = kConnecting;
+    socket->connect(address);
+}
+
+void Session::close(const std::string& why)
+{
+    if (m_state == kClosed) {
+        return;
+    }
+    m_state = kClosed;
+    if (m_error.empty()) {
+        m_error = why;
+    }
+    m_generator->sessionLeft(this);
+    if (m_stream != NULL) {
+        m_events->removeHandlers(m_stream->getEventTarget());
+        delete m_stream;
+        m_stream = NULL;
+    }
+    if (m_ready) {
+        m_generator->sessionClosed(this);
+    }
+    else {
+        m_generator->sessionReady(this);
+    }
+}
+
+void Session::expectEnter(Clock::time_point when)
+{
+    checkEnterTimeout(when);
+    m_enterPending = true;
+    m_switchTime = when;
+}
+
+void Session::checkEnterTimeout(Clock::time_point now)
+{
+    if (m_enterPending && seconds(now - m_switchTime) > kEnterTimeout) {
+        m_enterPending = false;
+        ++m_missedEnters;
+    }
+}
+
+void Session::expectInput(const char* code, Clock::time_point when)
+{
+    checkInputTimeout(when);
+    PendingInput input = { code, when };
+    m_pendingInputs.push_back(input);
+}
+
+void Session::checkInputTimeout(Clock::time_point now)
+{
+    while (!m_pendingInputs.empty() &&
+           seconds(now - m_pendingInputs.front().m_time) > kEnterTimeout) {
+        m_pendingInputs.pop_front();
+        ++m_missedInputs;
+    }
+}
+
+void Session::handleConnected(const Event&, void*)
+{
+    m_state = kHandshake;
+}
+
+void Session::handleConnectionFailed(const Event& event, void*)
+{
+    IDataSocket::ConnectionFailedInfo* info =
+        static_cast<IDataSocket::ConnectionFailedInfo*>(event.getData());
+    std::string why = "connection failed: " + info->m_what;
+    delete info;
+    close(why);
+}
+
+void Session::handleDisconnected(const Event&, void*)
+{
+    close("disconnected by server");
+}
+
+void Session::handleData(const Event&, void*)
+{
+    try {
+        if (m_state == kHandshake) {
+            if (!readHello()) {
+                close("bad hello from server");
+                return;
+            }
+            m_state = kConnected;
+        }
+
+        UInt8 code[4];
+        for (;;) {
+            UInt32 size = m_stream->getSize();
+            UInt32 n = m_stream->read(code, 4);
+            if (n == 0) {
+                break;
+            }
+            ++m_messages;
+            m_bytes += size + 4;
+            if (n != 4 || !readMessage(code)) {
+                ++m_invalid;
+                close(barrier::string::sprintf("bad message from server: %.4s", code));
+                return;
+            }
+            if (m_state == kClosed) {
+                return;
+            }
+        }
+    }
+    catch (XBase& e) {
+        ++m_invalid;
+        close(std::string("truncated message from server: ") + e.what());
+    }
+}
+
+bool Session::readHello()
+{
+    SInt16 major, minor;
+    if (!ProtocolUtil::readf(m_stream, kMsgHello, &major, &minor)) {
+        return false;
+    }
+    if (major < kProtocolMajorVersion ||
+        (major == kProtocolMajorVersion && minor < kProtocolMinorVersion)) {
+        return false;
+    }
+    ProtocolUtil::writef(m_stream, kMsgHelloBack, kProtocolMajorVersion,
+                         kProtocolMinorVersion, &m_name);
+    return true;
+}
+
+bool Session::readMessage(const UInt8* code)
+{
+    if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
+        ++m_keepAlives;
+        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+        return true;
+    }
+    if (memcmp(code, kMsgDMouseMove, 4) == 0) {
+        SInt16 x, y;
+        inputArrived(code);
+        return ProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y) &&
+               checkShape(x, y);
+    }
+    if (memcmp(code, kMsgDMouseRelMove, 4) == 0 ||
+        memcmp(code, kMsgDMouseWheel, 4) == 0) {
+        SInt16 dx, dy;
+        inputArrived(code);
+        return ProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
+    }
+    if (memcmp(code, kMsgDKeyDown, 4) == 0 || memcmp(code, kMsgDKeyUp, 4) == 0) {
+        UInt16 id, mask, button;
+        inputArrived(code);
+        return ProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
+    }
+    if (memcmp(code, kMsgDKeyRepeat, 4) == 0) {
+        UInt16 id, mask, count, button;
+        ++m_inputMessages;
+        return ProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4, &id, &mask, &count, &button);
+    }
+    if (memcmp(code, kMsgDMouseDown, 4) == 0 || memcmp(code, kMsgDMouseUp, 4) == 0) {
+        UInt8 id;
+        ++m_inputMessages;
+        return ProtocolUtil::readf(m_stream, kMsgDMouseDown + 4, &id);
+    }
+    if (memcmp(code, kMsgCEnter, 4) == 0) {
+        SInt16 x, y;
+        UInt32 seqNum;
+        UInt16 mask;
+        if (!ProtocolUtil::readf(m_stream, kMsgCEnter + 4, &x, &y, &seqNum, &mask) ||
+            !checkShape(x, y)) {
+            return false;
+        }
+        if (m_enterPending) {
+            m_enterPending = false;
+            m_latencies.push_back(
+                std::chrono::duration<double, std::milli>(Clock::now() - m_switchTime).count());
+        }
+        m_generator->sessionEntered(this);
+        return true;
+    }
+    if (memcmp(code, kMsgQInfo, 4) == 0) {
+        // one screen covering the whole shape
+        std::string screens;
+        ProtocolUtil::writef(m_stream, kMsgDInfo, 0, 0, m_w, m_h, 0, m_w / 2, m_h / 2);
+        ProtocolUtil::writef(m_stream, kMsgDScreenList, &screens);
+        return true;
+    }
+    if (memcmp(code, kMsgDSetOptions, 4) == 0) {
+        std::vector<UInt32> options;
+        return ProtocolUtil::readf(m_stream, kMsgDSetOptions + 4, &options) &&
+               options.size() % 2 == 0;
+    }
+    if (memcmp(code, kMsgCClipboard, 4) == 0) {
+        UInt8 id;
+        UInt32 seqNum;
+        return ProtocolUtil::readf(m_stream, kMsgCClipboard + 4, &id, &seqNum);
+    }
+    if (memcmp(code, kMsgDClipboard, 4) == 0) {
+        UInt8 id, mark;
+        UInt32 seqNum;
+        std::string data;
+        return ProtocolUtil::readf(m_stream, kMsgDClipboard + 4, &id, &seqNum, &mark, &data);
+    }
+    if (memcmp(code, kMsgCScreenSaver, 4) == 0) {
+        UInt8 on;
+        return ProtocolUtil::readf(m_stream, kMsgCScreenSaver + 4, &on);
+    }
+    if (memcmp(code, kMsgDFileTransfer, 4) == 0) {
+        UInt8 mark;
+        std::string data;
+        return ProtocolUtil::readf(m_stream, kMsgDFileTransfer + 4, &mark, &data);
+    }
+    if (memcmp(code, kMsgDDragInfo, 4) == 0) {
+        UInt16 count;
+        std::string data;
+        return ProtocolUtil::readf(m_stream, kMsgDDragInfo + 4, &count, &data);
+    }
+    if (memcmp(code, kMsgCInfoAck, 4) == 0) {
+        // the server has taken the screen info so the session is in
+        if (!m_ready) {
+            m_ready = true;
+            m_generator->sessionReady(this);
+        }
+        return true;
+    }
+    if (memcmp(code, kMsgCLeave, 4) == 0) {
+        // input sent while entered arrives before the leave
+        m_missedInputs += m_pendingInputs.size();
+        m_pendingInputs.clear();
+        m_generator->sessionLeft(this);
+        return true;
+    }
+    if (memcmp(code, kMsgCResetOptions, 4) == 0 ||
+        memcmp(code, kMsgCNoop, 4) == 0) {
+        return true;
+    }
+    if (memcmp(code, kMsgCClose, 4) == 0) {
+        close("closed by server");
+        return true;
+    }
+    if (memcmp(code, kMsgEUnknown, 4) == 0) {
+        close("server doesn't know the screen name (see --print-config)");
+        return true;
+    }
+    if (memcmp(code, kMsgEBusy, 4) == 0) {
+        close("screen name already in use");
+        return true;
+    }
+    if (memcmp(code, kMsgEIncompatible, 4) == 0) {
+        SInt16 major, minor;
+        ProtocolUtil::readf(m_stream, kMsgEIncompatible + 4, &major, &minor);
+        close(barrier::string::sprintf("server needs protocol %d.%d", major, minor));
+        return true;
+    }
+
+    // kMsgEBad or anything unknown
+    return false;
+}
+
+bool Session::checkShape(SInt16 x, SInt16 y) const
+{
+    return (x >= 0 && x < m_w && y >= 0 && y < m_h);
+}
+
+void Session::inputArrived(const UInt8* code)
+{
+    ++m_inputMessages;
+
+    // input from anything but the load generator isn't timed
+    if (!m_pendingInputs.empty() &&
+        memcmp(code, m_pendingInputs.front().m_code, 4) == 0) {
+        m_inputLatencies.push_back(std::chrono::duration<double, std::milli>(
+            Clock::now() - m_pendingInputs.front().m_time).count());
+        m_pendingInputs.pop_front();
+    }
+}
+
+//
+// ControlConnection
+//
+
+ControlConnection::ControlConnection(IEventQueue* events) :
+    m_switched(0),
+    m_refused(0),
+    m_inputs(0),
+    m_inputsRefused(0),
+    m_failed(false),
+    m_events(events),
+    m_socket(NULL),
+    m_connected(false)
+{
+}
+
+ControlConnection::~ControlConnection()
+{
+    close();
+}
+
+void ControlConnection::connect(ISocketFactory* factory, const NetworkAddress& address)
+{
+    m_socket = factory->create(ARCH->getAddrFamily(address.getAddress()),
+                               ConnectionSecurityLevel::PLAINTEXT);
+    void* target = m_socket->getEventTarget();
+    m_events->adoptHandler(m_events->forIDataSocket().connected(), target,
+                           new TMethodEventJob<ControlConnection>(this,
+                               &ControlConnection::handleConnected));
+    m_events->adoptHandler(m_events->forIDataSocket().connectionFailed(), target,
+                           new TMethodEventJob<ControlConnection>(this,
+                               &ControlConnection::handleFailed));
+    m_events->adoptHandler(m_events->forISocket().disconnected(), target,
+                           new TMethodEventJob<ControlConnection>(this,
+                               &ControlConnection::handleFailed));
+    m_events->adoptHandler(m_events->forIStream().inputReady(), target,
+                           new TMethodEventJob<ControlConnection>(this,
+                               &ControlConnection::handleData));
+    m_socket->connect(address);
+}
+
+void ControlConnection::requestSwitch(const std::string& screen)
+{
+    send("GET /set/screen/" + screen + " HTTP/1.1\r\n"
+         "Host: waver-load\r\n"
+         "\r\n", false);
+}
+
+void ControlConnection::requestInput(const std::string& commands)
+{
+    send(barrier::string::sprintf("POST /input HTTP/1.1\r\n"
+                                  "Host: waver-load\r\n"
+                                  "Content-Length: %u\r\n"
+                                  "\r\n",
+                                  static_cast<unsigned int>(commands.size())) + commands,
+         true);
+}
+
+void ControlConnection::send(const std::string& request, bool isInput)
+{
+    m_requests.push_back(isInput);
+    if (m_connected) {
+        m_socket->write(request.data(), static_cast<UInt32>(request.size()));
+    }
+    else {
+        m_unsent += request;
+    }
+}
+
+void ControlConnection::handleConnected(const Event&, void*)
+{
+    m_connected = true;
+    if (!m_unsent.empty()) {
+        m_socket->write(m_unsent.data(), static_cast<UInt32>(m_unsent.size()));
+        m_unsent.clear();
+    }
+}
+
+void ControlConnection::handleFailed(const Event& event, void*)
+{
+    if (event.getType() == m_events->forIDataSocket().connectionFailed()) {
+        delete static_cast<IDataSocket::ConnectionFailedInfo*>(event.getData());
+    }
+    m_failed = true;
+    close();
+}
+
+void ControlConnection::handleData(const Event&, void*)
+{
+    char buffer[4096];
+    UInt32 n;
+    while ((n = m_socket->read(buffer, sizeof(buffer))) > 0) {
+        m_input.append(buffer, n);
+    }
+
+    // count each whole response.  the body is "ok" if the server
+    // switched or took the input and "false" if it doesn't know the
+    // screen or has no virtual primary screen.
+    for (;;) {
+        size_t end = m_input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            return;
+        }
+        size_t length = 0;
+        size_t header = m_input.find("Content-Length:");
+        if (header != std::string::npos && header < end) {
+            length = static_cast<size_t>(strtoul(m_input.c_str() + header + 15, NULL, 10));
+        }
+        if (m_input.size() < end + 4 + length) {
+            return;
+        }
+        bool ok = (m_input.compare(0, 12, "HTTP/1.1 200") == 0 &&
+                   m_input.compare(end + 4, length, "ok") == 0);
+
+        // responses come in the order of the requests
+        const bool isInput = !m_requests.empty() && m_requests.front();
+        if (!m_requests.empty()) {
+            m_requests.pop_front();
+        }
+        if (isInput && ok) {
+            ++m_inputs;
+        }
+        else if (isInput) {
+            ++m_inputsRefused;
+        }
+        else if (ok) {
+            ++m_switched;
+        }
+        else {
+            ++m_refused;
+        }
+        m_input.erase(0, end + 4 + length);
+    }
+}
+
+void ControlConnection::close()
+{
+    if (m_socket != NULL) {
+        m_events->removeHandlers(m_socket->getEventTarget());
+        delete m_socket;
+        m_socket = NULL;
+    }
+    m_connected = false;
+}
+
+//
+// LoadGenerator
+//
+
+LoadGenerator::LoadGenerator(const Options& options, IEventQueue* events,
+                             ISocketFactory* factory) :
+    m_options(options),
+    m_events(events),
+    m_factory(factory),
+    m_pending(0),
+    m_measuring(false),
+    m_nextSwitch(0),
+    m_lastSwitch(NULL),
+    m_connectTimer(NULL),
+    m_switchTimer(NULL),
+    m_inputTimer(NULL),
+    m_durationTimer(NULL),
+    m_inputTarget(NULL),
+    m_inputStep(0),
+    m_startMessages(0),
+    m_endMessages(0),
+    m_startBytes(0),
+    m_endBytes(0),
+    m_startServerCpu(-1.0),
+    m_endServerCpu(-1.0),
+    m_startOwnCpu(0.0),
+    m_endOwnCpu(0.0)
+{
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    removeTimer(m_connectTimer);
+    removeTimer(m_switchTimer);
+    removeTimer(m_inputTimer);
+    removeTimer(m_durationTimer);
+}
+
+bool LoadGenerator::start()
+{
+    NetworkAddress address;
+    try {
+        address = NetworkAddress(m_options.m_server, kDefaultPort);
+        address.resolve();
+    }
+    catch (XBase& e) {
+        fprintf(stderr, "cannot resolve server \"%s\": %s\n",
+                m_options.m_server.c_str(), e.what());
+        return false;
+    }
+
+    if (!m_options.m_control.empty()) {
+        NetworkAddress controlAddress;
+        try {
+            controlAddress = NetworkAddress(m_options.m_control,
+                                            HostControlServer::kDefaultPort);
+            controlAddress.resolve();
+        }
+        catch (XBase& e) {
+            fprintf(stderr, "cannot resolve control address \"%s\": %s\n",
+                    m_options.m_control.c_str(), e.what());
+            return false;
+        }
+        m_control.reset(new ControlConnection(m_events));
+        m_control->connect(m_factory, controlAddress);
+    }
+
+    for (int i = 0; i < m_options.m_clients; ++i) {
+        std::string name = barrier::string::sprintf("%s%d", m_options.m_prefix.c_str(), i);
+        m_sessions.push_back(std::unique_ptr<Session>(
+            new Session(this, m_events, name, m_options.m_w, m_options.m_h)));
+    }
+    m_pending = m_options.m_clients;
+    for (std::unique_ptr<Session>& session : m_sessions) {
+        session->connect(m_factory, address, m_options.m_tls);
+    }
+
+    // measure with whatever has connected by then
+    m_connectTimer = m_events->newOneShotTimer(15.0, NULL);
+    m_events->adoptHandler(Event::kTimer, m_connectTimer,
+                           new TMethodEventJob<LoadGenerator>(this,
+                               &LoadGenerator::handleConnectTimeout));
+    return true;
+}
+
+void LoadGenerator::sessionReady(Session*)
+{
+    if (--m_pending == 0 && !m_measuring) {
+        startMeasuring();
+    }
+}
+
+void LoadGenerator::sessionClosed(Session* session)
+{
+    LOG((CLOG_NOTE "session %s closed: %s", session->m_name.c_str(),
+         session->m_error.c_str()));
+}
+
+void LoadGenerator::sessionEntered(Session* session)
+{
+    m_inputTarget = session;
+}
+
+void LoadGenerator::sessionLeft(Session* session)
+{
+    if (m_inputTarget == session) {
+        m_inputTarget = NULL;
+    }
+}
+
+void LoadGenerator::startMeasuring()
+{
+    removeTimer(m_connectTimer);
+    m_measuring = true;
+
+    int connected = 0;
+    for (const std::unique_ptr<Session>& session : m_sessions) {
+        if (session->m_state == Session::kConnected) {
+            ++connected;
+        }
+    }
+    printf("%d of %d sessions connected, measuring for %.1f s\n",
+           connected, m_options.m_clients, m_options.m_duration);
+    fflush(stdout);
+
+    m_start          = Clock::now();
+    m_startMessages  = countMessages();
+    m_startBytes     = countBytes();
+    m_startOwnCpu    = getCpuTime(0);
+    m_startServerCpu = (m_options.m_serverPid > 0) ? getCpuTime(m_options.m_serverPid) : -1.0;
+
+    if (m_control && m_options.m_rate > 0.0) {
+        m_switchTimer = m_events->newTimer(1.0 / m_options.m_rate, NULL);
+        m_events->adoptHandler(Event::kTimer, m_switchTimer,
+                               new TMethodEventJob<LoadGenerator>(this,
+                                   &LoadGenerator::handleSwitchTimer));
+    }
+    if (m_control && m_options.m_inputRate > 0.0) {
+        m_inputTimer = m_events->newTimer(1.0 / m_options.m_inputRate, NULL);
+        m_events->adoptHandler(Event::kTimer, m_inputTimer,
+                               new TMethodEventJob<LoadGenerator>(this,
+                                   &LoadGenerator::handleInputTimer));
+    }
+    m_durationTimer = m_events->newOneShotTimer(m_options.m_duration, NULL);
+    m_events->adoptHandler(Event::kTimer, m_durationTimer,
+                           new TMethodEventJob<LoadGenerator>(this,
+                               &LoadGenerator::handleDurationTimer));
+}
+
+void LoadGenerator::handleConnectTimeout(const Event&, void*)
+{
+    startMeasuring();
+}
+
+void LoadGenerator::handleSwitchTimer(const Event&, void*)
+{
+    if (m_control->m_failed) {
+        return;
+    }
+
+    // the next connected session after the last one switched to
+    Session* next = NULL;
+    for (size_t i = 0; i < m_sessions.size() && next == NULL; ++i) {
+        Session* session = m_sessions[(m_nextSwitch + i) % m_sessions.size()].get();
+        if (session->m_state == Session::kConnected) {
+            next = session;
+            m_nextSwitch = (m_nextSwitch + i + 1) % m_sessions.size();
+        }
+    }
+    if (next == NULL) {
+        return;
+    }
+
+    // input waits for the next enter so it can't race the switch
+    m_inputTarget = NULL;
+
+    // with one session go back to the primary screen in between, since
+    // switching to the active screen sends nothing
+    if (next == m_lastSwitch) {
+        m_control->requestSwitch(m_options.m_primary);
+        m_lastSwitch = NULL;
+        return;
+    }
+    next->expectEnter(Clock::now());
+    m_control->requestSwitch(next->m_name);
+    m_lastSwitch = next;
+}
+
+void LoadGenerator::handleInputTimer(const Event&, void*)
+{
+    if (m_control->m_failed || m_inputTarget == NULL) {
+        return;
+    }
+
+    // nudge the cursor back and forth, tap a key and scroll.  the key
+    // is released in the same request so a switch never finds it held.
+    const Clock::time_point now = Clock::now();
+    std::string commands;
+    switch (m_inputStep++ % 4) {
+    case 0:
+        commands = "rmove 4 0\n";
+        m_inputTarget->expectInput(kMsgDMouseMove, now);
+        break;
+
+    case 1:
+        commands = "rmove -4 0\n";
+        m_inputTarget->expectInput(kMsgDMouseMove, now);
+        break;
+
+    case 2:
+        commands = "key 0x61 down 0 38\nkey 0x61 up 0 38\n";
+        m_inputTarget->expectInput(kMsgDKeyDown, now);
+        m_inputTarget->expectInput(kMsgDKeyUp, now);
+        break;
+
+    default:
+        commands = "wheel 0 120\n";
+        m_inputTarget->expectInput(kMsgDMouseWheel, now);
+        break;
+    }
+    m_control->requestInput(commands);
+}
+
+void LoadGenerator::handleDurationTimer(const Event&, void*)
+{
+    m_end          = Clock::now();
+    m_endMessages  = countMessages();
+    m_endBytes     = countBytes();
+    m_endOwnCpu    = getCpuTime(0);
+    m_endServerCpu = (m_options.m_serverPid > 0) ? getCpuTime(m_options.m_serverPid) : -1.0;
+    for (std::unique_ptr<Session>& session : m_sessions) {
+        session->checkEnterTimeout(m_end + std::chrono::hours(1));
+        session->checkInputTimeout(m_end + std::chrono::hours(1));
+    }
+    removeTimer(m_switchTimer);
+    removeTimer(m_inputTimer);
+    m_events->addEvent(Event(Event::kQuit));
+}
+
+void LoadGenerator::removeTimer(EventQueueTimer*& timer)
+{
+    if (timer != NULL) {
+        m_events->removeHandler(Event::kTimer, timer);
+        m_events->deleteTimer(timer);
+        timer = NULL;
+    }
+}
+
+std::uint64_t LoadGenerator::countMessages() const
+{
+    std::uint64_t count = 0;
+    for (const std::unique_ptr<Session>& session : m_sessions) {
+        count += session->m_messages;
+    }
+    return count;
+}
+
+std::uint64_t LoadGenerator::countBytes() const
+{
+    std::uint64_t count = 0;
+    for (const std::unique_ptr<Session>& session : m_sessions) {
+        count += session->m_bytes;
+    }
+    return count;
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void printLatencies(const char* name, std::vector<double>& latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    printf("  %-18s %9zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, latencies.size(),
+           percentile(latencies, 0.5), percentile(latencies, 0.9),
+           percentile(latencies, 0.99), percentile(latencies, 0.999),
+           latencies.empty() ? 0.0 : latencies.back());
+}
+
+void LoadGenerator::report()
+{
+    double elapsed = seconds(m_end - m_start);
+    if (elapsed <= 0.0) {
+        return;
+    }
+
+    int connected = 0;
+    std::uint64_t keepAlives = 0, inputMessages = 0, invalid = 0, missed = 0;
+    std::uint64_t missedInputs = 0;
+    std::vector<double> all, allInput;
+    for (const std::unique_ptr<Session>& session : m_sessions) {
+        if (session->m_state == Session::kConnected) {
+            ++connected;
+        }
+        keepAlives    += session->m_keepAlives;
+        inputMessages += session->m_inputMessages;
+        invalid       += session->m_invalid;
+        missed        += session->m_missedEnters;
+        missedInputs  += session->m_missedInputs;
+        all.insert(all.end(), session->m_latencies.begin(), session->m_latencies.end());
+        allInput.insert(allInput.end(), session->m_inputLatencies.begin(),
+                        session->m_inputLatencies.end());
+    }
+
+    printf("\nsessions            %d of %d still connected\n", connected, m_options.m_clients);
+    std::map<std::string, int> errors;
+    for (const std::unique_ptr<Session>& session : m_sessions) {
+        if (!session->m_error.empty()) {
+            ++errors[session->m_error];
+        }
+    }
+    for (const auto& error : errors) {
+        printf("  %6d x %s\n", error.second, error.first.c_str());
+    }
+    printf("received            %.0f messages/s, %.1f KiB/s\n",
+           static_cast<double>(m_endMessages - m_startMessages) / elapsed,
+           static_cast<double>(m_endBytes - m_startBytes) / elapsed / 1024.0);
+    printf("                    %llu input, %llu keepalives echoed, %llu invalid\n",
+           static_cast<unsigned long long>(inputMessages),
+           static_cast<unsigned long long>(keepAlives),
+           static_cast<unsigned long long>(invalid));
+    if (m_control) {
+        printf("switches            %llu done, %llu refused, %llu enters missed%s\n",
+               static_cast<unsigned long long>(m_control->m_switched),
+               static_cast<unsigned long long>(m_control->m_refused),
+               static_cast<unsigned long long>(missed),
+               m_control->m_failed ? " (control connection failed)" : "");
+        if (m_control->m_inputs + m_control->m_inputsRefused > 0) {
+            printf("input requests      %llu done, %llu refused, %llu messages missed%s\n",
+                   static_cast<unsigned long long>(m_control->m_inputs),
+                   static_cast<unsigned long long>(m_control->m_inputsRefused),
+                   static_cast<unsigned long long>(missedInputs),
+                   m_control->m_inputs == 0 ? " (server needs --virtual-screen)" : "");
+        }
+    }
+    if (m_startServerCpu >= 0.0 && m_endServerCpu >= 0.0) {
+        printf("server cpu          %.1f%%\n",
+               100.0 * (m_endServerCpu - m_startServerCpu) / elapsed);
+    }
+    printf("load generator cpu  %.1f%%\n", 100.0 * (m_endOwnCpu - m_startOwnCpu) / elapsed);
+
+    if (!all.empty()) {
+        printf("\nswitch to enter, ms\n");
+        printf("  %-18s %9s %9s %9s %9s %9s %9s\n", "session", "count", "p50", "p90",
+               "p99", "p99.9", "max");
+        if (m_options.m_perClient) {
+            for (const std::unique_ptr<Session>& session : m_sessions) {
+                printLatencies(session->m_name.c_str(), session->m_latencies);
+            }
+        }
+        printLatencies("all", all);
+    }
+
+    if (!allInput.empty()) {
+        printf("\ninput to client, ms\n");
+        printf("  %-18s %9s %9s %9s %9s %9s %9s\n", "session", "count", "p50", "p90",
+               "p99", "p99.9", "max");
+        if (m_options.m_perClient) {
+            for (const std::unique_ptr<Session>& session : m_sessions) {
+                printLatencies(session->m_name.c_str(), session->m_inputLatencies);
+            }
+        }
+        printLatencies("all", allInput);
+    }
+}
+
+void usage(const char* exe)
+{
+    fprintf(stderr,
+        "Usage: %s [--server <host>[:<port>]] [--clients <count>] [--tls]\n"
+        "          [--name-prefix <prefix>] [--screen <width>x<height>]\n"
+        "          [--control <host>[:<port>]] [--primary <name>] [--rate <per second>]\n"
+        "          [--input-rate <per second>] [--duration <seconds>]\n"
+        "          [--server-pid <pid>] [--per-client]\n"
+        "          [--print-config]\n"
+        "\n"
+        "Connects <count> client sessions named <prefix>0, <prefix>1, ... to the\n"
+        "server, 10 named load-0 on by default.  The sessions answer the handshake\n"
+        "and keepalives and check every message they get.  With --control the\n"
+        "server's Host Control API switches between the sessions <rate> times a\n"
+        "second and the time from each switch to its enter is reported.  While a\n"
+        "session is entered, input is posted to the API <input-rate> times a\n"
+        "second, 100 by default, and the time until the session gets it is\n"
+        "reported.  That needs a server started with --virtual-screen.  With\n"
+        "--server-pid the server's CPU use is reported too.\n"
+        "\n"
+        "TLS sessions use the certificate and trusted servers of barrierc.\n"
+        "--print-config prints the screens for the server's configuration.\n", exe);
+}
+
+bool parseArgs(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--server") == 0 && hasValue) {
+            options.m_server = argv[++i];
+        }
+        else if (strcmp(argv[i], "--clients") == 0 && hasValue) {
+            options.m_clients = atoi(argv[++i]);
+            if (options.m_clients < 1) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--tls") == 0) {
+            options.m_tls = true;
+        }
+        else if (strcmp(argv[i], "--name-prefix") == 0 && hasValue) {
+            options.m_prefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "--screen") == 0 && hasValue) {
+            int w, h;
+            if (sscanf(argv[++i], "%dx%d", &w, &h) != 2 ||
+                w < 1 || h < 1 || w > 32767 || h > 32767) {
+                return false;
+            }
+            options.m_w = static_cast<SInt16>(w);
+            options.m_h = static_cast<SInt16>(h);
+        }
+        else if (strcmp(argv[i], "--control") == 0 && hasValue) {
+            options.m_control = argv[++i];
+        }
+        else if (strcmp(argv[i], "--primary") == 0 && hasValue) {
+            options.m_primary = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && hasValue) {
+            options.m_rate = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--input-rate") == 0 && hasValue) {
+            options.m_inputRate = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+            options.m_duration = atof(argv[++i]);
+            if (options.m_duration <= 0.0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--server-pid") == 0 && hasValue) {
+            options.m_serverPid = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--per-client") == 0) {
+            options.m_perClient = true;
+        }
+        else if (strcmp(argv[i], "--print-config") == 0) {
+            options.m_printConfig = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printConfig(const Options& options)
+{
+    printf("section: screens\n");
+    printf("\t%s:\n", options.m_primary.c_str());
+    for (int i = 0; i < options.m_clients; ++i) {
+        printf("\t%s%d:\n", options.m_prefix.c_str(), i);
+    }
+    printf("end\n");
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (options.m_printConfig) {
+        printConfig(options);
+        return 0;
+    }
+
+    Arch arch;
+    arch.init();
+    Log log;
+    log.setFilter(kWARNING);
+
+    EventQueue events;
+    SocketMultiplexer multiplexer;
+    TCPSocketFactory factory(&events, &multiplexer);
+
+    LoadGenerator generator(options, &events, &factory);
+    if (!generator.start()) {
+        return 1;
+    }
+    events.loop();
+    generator.report();
+    return 0;
+}
@@ -0,0 +1,357 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// replays an input log recorded with the client's --record-input through
+// one or more input backends and reports how long each call took.  for
+// uhid that is only the time to queue the call for the injection thread.
+
+#include "client/IInputBackend.h"
+#include "client/InputLog.h"
+#include "platform/UhidInjector.h"
+#include "platform/UhidServer.h"
+#include "platform/UinputDevice.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// calls nothing, so it measures the cost of the replay itself
+class NullBackend : public IInputBackend {
+public:
+    void enter(SInt32, SInt32) override {}
+    void leave() override {}
+    void keyDown(KeyID, KeyModifierMask, KeyButton) override {}
+    void keyRepeat(KeyID, KeyModifierMask, SInt32, KeyButton) override {}
+    void keyUp(KeyID, KeyModifierMask, KeyButton) override {}
+    void mouseDown(ButtonID) override {}
+    void mouseUp(ButtonID) override {}
+    void mouseMove(SInt32, SInt32) override {}
+    void mouseRelativeMove(SInt32, SInt32) override {}
+    void mouseWheel(SInt32, SInt32) override {}
+    void flush() override {}
+};
+
+class UhidBackend : public IInputBackend {
+public:
+    UhidBackend(SInt32 w, SInt32 h) : m_w(w), m_h(h) {}
+
+    ~UhidBackend() override
+    {
+        m_injector.reset();
+        m_server.stop();
+    }
+
+    bool start()
+    {
+        if (!m_server.start("Waver Replay")) {
+            return false;
+        }
+        m_injector.reset(new UhidInjector(&m_server));
+        m_injector->start(false);
+        return true;
+    }
+
+    void enter(SInt32 x, SInt32 y) override
+    {
+        m_injector->setScreenShape(0, 0, m_w, m_h);
+        m_injector->clearInputState();
+        m_injector->mouseMoveAbsolute(x, y);
+    }
+
+    void leave() override { m_injector->clearInputState(); }
+    void keyDown(KeyID id, KeyModifierMask mask, KeyButton) override { m_injector->keyDown(id, mask); }
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton) override
+    {
+        m_injector->keyRepeat(id, mask, count);
+    }
+    void keyUp(KeyID id, KeyModifierMask mask, KeyButton) override { m_injector->keyUp(id, mask); }
+    void mouseDown(ButtonID id) override { m_injector->mouseDown(id); }
+    void mouseUp(ButtonID id) override { m_injector->mouseUp(id); }
+    void mouseMove(SInt32 x, SInt32 y) override { m_injector->mouseMoveAbsolute(x, y); }
+    void mouseRelativeMove(SInt32 dx, SInt32 dy) override { m_injector->mouseRelativeMove(dx, dy); }
+    void mouseWheel(SInt32 x, SInt32 y) override { m_injector->mouseWheel(x, y); }
+    void flush() override { m_injector->flush(); }
+
+private:
+    SInt32 m_w;
+    SInt32 m_h;
+    UhidServer m_server;
+    std::unique_ptr<UhidInjector> m_injector;
+};
+
+class UinputBackend : public IInputBackend {
+public:
+    UinputBackend(SInt32 w, SInt32 h) : m_w(w), m_h(h) {}
+
+    bool start()
+    {
+        return m_device.start("Waver Replay");
+    }
+
+    void enter(SInt32 x, SInt32 y) override
+    {
+        m_device.setScreenShape(0, 0, m_w, m_h);
+        m_device.clearInputState();
+        m_device.mouseMoveAbsolute(x, y);
+    }
+
+    void leave() override
+    {
+        m_device.clearInputState();
+        m_device.flush();
+    }
+
+    void keyDown(KeyID id, KeyModifierMask mask, KeyButton) override { m_device.keyDown(id, mask); }
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton) override
+    {
+        m_device.keyRepeat(id, mask, count);
+    }
+    void keyUp(KeyID id, KeyModifierMask mask, KeyButton) override { m_device.keyUp(id, mask); }
+    void mouseDown(ButtonID id) override { m_device.mouseDown(id); }
+    void mouseUp(ButtonID id) override { m_device.mouseUp(id); }
+    void mouseMove(SInt32 x, SInt32 y) override { m_device.mouseMoveAbsolute(x, y); }
+    void mouseRelativeMove(SInt32 dx, SInt32 dy) override { m_device.mouseRelativeMove(dx, dy); }
+    void mouseWheel(SInt32 x, SInt32 y) override { m_device.mouseWheel(x, y); }
+    void flush() override { m_device.flush(); }
+
+private:
+    SInt32 m_w;
+    SInt32 m_h;
+    UinputDevice m_device;
+};
+
+struct Options {
+    Options() : m_maxSpeed(false), m_repeat(1), m_w(1920), m_h(1080) {}
+
+    bool m_maxSpeed;
+    int m_repeat;
+    SInt32 m_w;
+    SInt32 m_h;
+    std::vector<String> m_backends;
+    String m_path;
+};
+
+void usage(const char* exe)
+{
+    fprintf(stderr,
+        "Usage: %s [--speed original|max] [--backend <name>[,<name>...]]\n"
+        "          [--repeat <count>] [--screen <width>x<height>] <log>\n"
+        "\n"
+        "Replays a log recorded with the client's --record-input and prints\n"
+        "percentiles of the time each call took, in microseconds, for each\n"
+        "backend.  The backends are null, uhid and uinput; null is the default.\n"
+        "uhid calls only queue the input for its injection thread, so its times\n"
+        "are the cost of enqueueing rather than of reaching the kernel.\n"
+        "At the original speed calls are spaced as they were recorded.\n", exe);
+}
+
+bool parseArgs(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--speed") == 0 && hasValue) {
+            const char* speed = argv[++i];
+            if (strcmp(speed, "max") == 0) {
+                options.m_maxSpeed = true;
+            }
+            else if (strcmp(speed, "original") == 0) {
+                options.m_maxSpeed = false;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--backend") == 0 && hasValue) {
+            String list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t end = list.find(',', start);
+                if (end == String::npos) {
+                    end = list.size();
+                }
+                options.m_backends.push_back(list.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            options.m_repeat = atoi(argv[++i]);
+            if (options.m_repeat < 1) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--screen") == 0 && hasValue) {
+            int w, h;
+            if (sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w < 1 || h < 1) {
+                return false;
+            }
+            options.m_w = w;
+            options.m_h = h;
+        }
+        else if (argv[i][0] != '-' && i + 1 == argc) {
+            options.m_path = argv[i];
+        }
+        else {
+            return false;
+        }
+    }
+
+    if (options.m_backends.empty()) {
+        options.m_backends.push_back("null");
+    }
+    return !options.m_path.empty();
+}
+
+std::unique_ptr<IInputBackend> createBackend(const String& name, const Options& options)
+{
+    if (name == "null") {
+        return std::unique_ptr<IInputBackend>(new NullBackend());
+    }
+    if (name == "uhid") {
+        std::unique_ptr<UhidBackend> backend(new UhidBackend(options.m_w, options.m_h));
+        if (backend->start()) {
+            return std::move(backend);
+        }
+    }
+    else if (name == "uinput") {
+        std::unique_ptr<UinputBackend> backend(new UinputBackend(options.m_w, options.m_h));
+        if (backend->start()) {
+            return std::move(backend);
+        }
+    }
+    else {
+        fprintf(stderr, "unknown backend \"%s\"\n", name.c_str());
+    }
+    return std::unique_ptr<IInputBackend>();
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void report(const char* name, std::vector<double>& latencies)
+{
+    if (latencies.empty()) {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("  %-18s %9zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, latencies.size(),
+           percentile(latencies, 0.5), percentile(latencies, 0.9),
+           percentile(latencies, 0.99), percentile(latencies, 0.999), latencies.back());
+}
+
+void replay(IInputBackend& backend, const std::vector<InputLogRecord>& records,
+            const Options& options, std::vector<std::vector<double> >& latencies)
+{
+    for (int pass = 0; pass < options.m_repeat; ++pass) {
+        const Clock::time_point start = Clock::now();
+        for (const InputLogRecord& record : records) {
+            if (!options.m_maxSpeed) {
+                std::this_thread::sleep_until(start + std::chrono::microseconds(record.m_time));
+            }
+
+            const Clock::time_point before = Clock::now();
+            record.dispatch(backend);
+            const Clock::time_point after = Clock::now();
+            latencies[record.m_type].push_back(
+                std::chrono::duration<double, std::micro>(after - before).count());
+        }
+
+        // don't leave anything held down on the host
+        backend.leave();
+        backend.flush();
+    }
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Arch arch;
+    arch.init();
+    Log log;
+    log.setFilter(kWARNING);
+
+    std::vector<InputLogRecord> records;
+    InputLogReader reader;
+    if (!reader.open(options.m_path)) {
+        fprintf(stderr, "cannot read input log \"%s\"\n", options.m_path.c_str());
+        return 1;
+    }
+    InputLogRecord record;
+    while (reader.read(record)) {
+        records.push_back(record);
+    }
+    reader.close();
+    printf("%zu records, %.3f s\n", records.size(),
+           records.empty() ? 0.0 : static_cast<double>(records.back().m_time) / 1.0e6);
+
+    int result = 0;
+    for (const String& name : options.m_backends) {
+        std::unique_ptr<IInputBackend> backend = createBackend(name, options);
+        if (!backend) {
+            fprintf(stderr, "cannot start backend \"%s\"\n", name.c_str());
+            result = 1;
+            continue;
+        }
+
+        std::vector<std::vector<double> > latencies(InputLogRecord::kNumTypes);
+        replay(*backend, records, options, latencies);
+        backend.reset();
+
+        std::vector<double> all;
+        for (const std::vector<double>& type : latencies) {
+            all.insert(all.end(), type.begin(), type.end());
+        }
+
+        // the uhid injector writes on its own thread so its calls return
+        // once the input is queued
+        const bool enqueueOnly = (name == "uhid");
+        printf("\n%s%s\n", name.c_str(), enqueueOnly ? " (enqueue cost)" : "");
+        printf("  %-18s %9s %9s %9s %9s %9s %9s\n",
+               enqueueOnly ? "enqueued call" : "call", "count", "p50", "p90",
+               "p99", "p99.9", "max");
+        for (UInt8 type = 0; type < InputLogRecord::kNumTypes; ++type) {
+            report(InputLogRecord::getName(type), latencies[type]);
+        }
+        report("all", all);
+    }
+    return result;
+}
@@ -26,12 +26,29 @@
 #include "base/String.h"
 #include "io/filesystem.h"
 
+#include <cstdio>
+
 #ifdef WINAPI_MSWINDOWS
 #include <VersionHelpers.h>
 #endif
 
 ArgsBase* ArgParser::m_argsBase = NULL;
 
+// keys the host may have bound to Compose, for --uhid-compose-key
+static const struct {
+    const char* m_name;
+    KeyID m_id;
+} s_composeKeys[] = {
+    { "menu", kKeyMenu },
+    { "ralt", kKeyAlt_R },
+    { "rctrl", kKeyControl_R },
+    { "rwin", kKeySuper_R },
+    { "caps", kKeyCapsLock },
+    { "scroll", kKeyScrollLock },
+    { "pause", kKeyPause },
+    { "print", kKeyPrint }
+};
+
 ArgParser::ArgParser(App* app) :
     m_app(app)
 {
@@ -67,6 +84,47 @@ ArgParser::parseServerArgs(ServerArgs& args, int argc, const char* const* argv)
         }
         else if (isArg(i, argc, argv, nullptr, "--disable-client-cert-checking")) {
             args.check_client_certificates = false;
+        }
+        else if (isArg(i, argc, argv, NULL, "--virtual-screen", 1)) {
+            // save the virtual screen size, <width>x<height>
+            int width = 0, height = 0;
+            char extra;
+            if (sscanf(argv[++i], "%dx%d%c", &width, &height, &extra) != 2 ||
+                    width <= 0 || height <= 0) {
+                LOG((CLOG_PRINT "%s: invalid value for --virtual-screen (%s)" BYE,
+                    args.m_exename.c_str(), argv[i], args.m_exename.c_str()));
+                return false;
+            }
+            args.m_virtualScreen       = true;
+            args.m_virtualScreenWidth  = width;
+            args.m_virtualScreenHeight = height;
+        }
+        else if (isArg(i, argc, argv, NULL, "--socket-shards", 1)) {
+            // save the number of socket multiplexers for clients
+            int shards = 0;
+            char extra;
+            if (sscanf(argv[++i], "%d%c", &shards, &extra) != 1 ||
+                    shards < 1 || shards > 64) {
+                LOG((CLOG_PRINT "%s: invalid value for --socket-shards (%s)" BYE,
+                    args.m_exename.c_str(), argv[i], args.m_exename.c_str()));
+                return false;
+            }
+            args.m_socketShards = shards;
+        }
+        else if (isArg(i, argc, argv, NULL, "--socket-shard-by", 1)) {
+            // save how clients are assigned to socket shards
+            String mode = argv[++i];
+            if (mode == "round-robin") {
+                args.m_socketShardByAddress = false;
+            }
+            else if (mode == "address") {
+                args.m_socketShardByAddress = true;
+            }
+            else {
+                LOG((CLOG_PRINT "%s: invalid value for --socket-shard-by (%s)" BYE,
+                    args.m_exename.c_str(), argv[i], args.m_exename.c_str()));
+                return false;
+            }
         } else {
             LOG((CLOG_PRINT "%s: unrecognized option `%s'" BYE, args.m_exename.c_str(), argv[i], args.m_exename.c_str()));
             return false;
@@ -156,6 +214,35 @@ ArgParser::parseClientArgs(ClientArgs& args, int argc, const char* const* argv)
         else if (strncmp(argv[i], "--uhid-name-", 12) == 0) {
             args.m_uhidName = argv[i] + 12;
         }
+        else if (isArg(i, argc, argv, NULL, "--uhid-realtime")) {
+            args.m_uhidRealtime = true;
+        }
+        else if (isArg(i, argc, argv, NULL, "--uhid-boot-keyboard")) {
+            args.m_uhidBootKeyboard = true;
+        }
+        else if (isArg(i, argc, argv, NULL, "--uhid-compose-key", 1)) {
+            const char* value = argv[++i];
+            args.m_uhidComposeKey = kKeyNone;
+            for (size_t j = 0; j < sizeof(s_composeKeys) / sizeof(s_composeKeys[0]); ++j) {
+                if (strcmp(value, s_composeKeys[j].m_name) == 0) {
+                    args.m_uhidComposeKey = s_composeKeys[j].m_id;
+                }
+            }
+            if (args.m_uhidComposeKey == kKeyNone) {
+                LOG((CLOG_PRINT "%s: invalid value for --uhid-compose-key (%s)" BYE,
+                    args.m_exename.c_str(), value, args.m_exename.c_str()));
+                return false;
+            }
+        }
+        else if (isArg(i, argc, argv, NULL, "--uinput")) {
+            args.m_uinputEnabled = true;
+        }
+        else if (isArg(i, argc, argv, NULL, "--direct-input")) {
+            args.m_directInput = true;
+        }
+        else if (isArg(i, argc, argv, NULL, "--record-input", 1)) {
+            args.m_recordInputPath = argv[++i];
+        }
         else {
             if (i + 1 == argc) {
                 args.m_barrierAddress = argv[i];
@@ -118,7 +118,17 @@ ClientApp::help()
 #if defined(__linux__)
 #  define UHID_INFO \
     "      --uhid=enable        enable Linux uhid input (from Barrier events)\n" \
-    "      --uhid-name <name>   set the uhid device name\n"
+    "      --uhid-name <name>   set the uhid device name\n" \
+    "      --uhid-realtime      inject uhid input from a real-time thread\n" \
+    "      --uhid-boot-keyboard use a 6-key boot keyboard report for uhid\n" \
+    "      --uhid-compose-key <key>\n" \
+    "                           the key the uhid host uses as Compose: menu,\n" \
+    "                           ralt, rctrl, rwin, caps, scroll, pause or print\n" \
+    "      --uinput             inject input through /dev/uinput, falling back\n" \
+    "                           to uhid if enabled.  uses the uhid name and\n" \
+    "                           compose key.\n" \
+    "      --direct-input       inject uinput input on the network thread\n" \
+    "                           instead of through the event loop.\n"
 #else
 #  define UHID_INFO ""
 #endif
@@ -134,6 +144,9 @@ ClientApp::help()
            << "      --yscroll <delta>    defines the vertical scrolling delta, which is\n"
            << "                           120 by default.\n"
            << UHID_INFO
+           << "      --record-input <file>\n"
+           << "                           record the input injected on this screen to\n"
+           << "                           <file> for replaying with waver-replay.\n"
            << HELP_COMMON_INFO_2
            << "\n"
            << "Default options are marked with a *\n"
@@ -20,6 +20,12 @@
 ClientArgs::ClientArgs() :
     m_yscroll(0),
     m_uhidEnabled(false),
-    m_uhidName("")
+    m_uhidName(""),
+    m_uhidRealtime(false),
+    m_uhidBootKeyboard(false),
+    m_uhidComposeKey(kKeyNone),
+    m_uinputEnabled(false),
+    m_directInput(false),
+    m_recordInputPath()
 {
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "barrier/ArgsBase.h"
+#include "barrier/key_types.h"
 
 class NetworkAddress;
 
@@ -29,4 +30,10 @@ public:
     int                    m_yscroll;
     bool                m_uhidEnabled;
     String                m_uhidName;
+    bool                m_uhidRealtime;
+    bool                m_uhidBootKeyboard;
+    KeyID                m_uhidComposeKey;
+    bool                m_uinputEnabled;
+    bool                m_directInput;
+    String                m_recordInputPath;
 };
@@ -0,0 +1,68 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/key_types.h"
+#include "barrier/mouse_types.h"
+#include "common/IInterface.h"
+
+//! Injected input interface
+/*!
+This interface is implemented by primary screens that have no input
+devices of their own.  Input given to it is reported exactly as if the
+user had produced it locally.
+*/
+class IInputInjector : public IInterface {
+public:
+    //! @name manipulators
+    //@{
+
+    //! Inject mouse move
+    /*!
+    Move the cursor to the absolute coordinates \c x,y.
+    */
+    virtual void        injectMouseMove(SInt32 x, SInt32 y) = 0;
+
+    //! Inject relative mouse move
+    /*!
+    Move the cursor by \c dx,dy.
+    */
+    virtual void        injectMouseRelativeMove(SInt32 dx, SInt32 dy) = 0;
+
+    //! Inject mouse press/release
+    /*!
+    Press or release mouse button \c id.
+    */
+    virtual void        injectMouseButton(ButtonID id, bool press) = 0;
+
+    //! Inject mouse wheel
+    /*!
+    Turn the mouse wheel by \c xDelta and \c yDelta.
+    */
+    virtual void        injectMouseWheel(SInt32 xDelta, SInt32 yDelta) = 0;
+
+    //! Inject key press/release
+    /*!
+    Press or release the key on \c button that produces \c id with the
+    modifiers \c mask active.
+    */
+    virtual void        injectKey(KeyID id, KeyModifierMask mask,
+                            KeyButton button, bool press) = 0;
+
+    //@}
+};
@@ -57,5 +57,12 @@ public:
     */
     virtual void        fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const = 0;
 
+    //! Flush faked input
+    /*!
+    Send any faked input the screen is still holding.  This is called
+    after each batch of input so a screen may hold input until then.
+    */
+    virtual void        flushFakeInput() = 0;
+
     //@}
 };
@@ -21,11 +21,16 @@
 #include "base/Log.h"
 
 #include <assert.h>
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <tuple>
 
 namespace barrier {
 
+// most mapKey() results kept before starting over
+static const size_t s_mapKeyCacheSize = 1024;
+
 KeyMap::NameToKeyMap*            KeyMap::s_nameToKeyMap      = NULL;
 KeyMap::NameToModifierMap*        KeyMap::s_nameToModifierMap = NULL;
 KeyMap::KeyToNameMap*            KeyMap::s_keyToNameMap      = NULL;
@@ -33,7 +38,8 @@ KeyMap::ModifierToNameMap*        KeyMap::s_modifierToNameMap = NULL;
 
 KeyMap::KeyMap() :
     m_numGroups(0),
-    m_composeAcrossGroups(false)
+    m_composeAcrossGroups(false),
+    m_lookupTablesValid(false)
 {
     m_modifierKeyItem.m_id        = kKeyNone;
     m_modifierKeyItem.m_group     = 0;
@@ -64,6 +70,8 @@ KeyMap::swap(KeyMap& x)
     bool tmp2               = m_composeAcrossGroups;
     m_composeAcrossGroups   = x.m_composeAcrossGroups;
     x.m_composeAcrossGroups = tmp2;
+    changed(true);
+    x.changed(true);
 }
 
 void
@@ -73,6 +81,7 @@ KeyMap::addKeyEntry(const KeyItem& item)
     if (item.m_id == kKeyNone) {
         return;
     }
+    changed(true);
 
     // resize number of groups for key
     SInt32 numGroups = item.m_group + 1;
@@ -146,6 +155,7 @@ KeyMap::addKeyCombinationEntry(KeyID id, SInt32 group,
     if (id == kKeyNone) {
         return false;
     }
+    changed(true);
 
     SInt32 numGroups = group + 1;
     if (getNumGroups() > numGroups) {
@@ -203,24 +213,31 @@ void
 KeyMap::allowGroupSwitchDuringCompose()
 {
     m_composeAcrossGroups = true;
+    changed(false);
 }
 
 void
 KeyMap::addHalfDuplexButton(KeyButton button)
 {
-    m_halfDuplex.insert(button);
+    if (m_halfDuplex.size() <= button) {
+        m_halfDuplex.resize(button + 1);
+    }
+    m_halfDuplex[button] = true;
+    changed(false);
 }
 
 void
 KeyMap::clearHalfDuplexModifiers()
 {
     m_halfDuplexMods.clear();
+    changed(false);
 }
 
 void
 KeyMap::addHalfDuplexModifier(KeyID key)
 {
     m_halfDuplexMods.insert(key);
+    changed(false);
 }
 
 void
@@ -236,11 +253,15 @@ KeyMap::finish()
 
     // compute keys that generate each modifier
     setModifierKeys();
+
+    changed(true);
+    buildLookupTables();
 }
 
 void
 KeyMap::foreachKey(ForeachKeyCallback cb, void* userData)
 {
+    changed(true);
     for (KeyIDMap::iterator i = m_keyIDMap.begin();
                                 i != m_keyIDMap.end(); ++i) {
         KeyGroupTable& groupTable = i->second;
@@ -276,6 +297,48 @@ KeyMap::mapKey(Keystrokes& keys, KeyID id, SInt32 group,
         return NULL;
     }
 
+    // the result depends only on the arguments and the map
+    MapKeyArgs args;
+    args.m_id              = id;
+    args.m_group           = group;
+    args.m_state           = currentState;
+    args.m_desiredMask     = desiredMask;
+    args.m_isAutoRepeat    = isAutoRepeat;
+    args.m_activeModifiers = activeModifiers;
+    MapKeyCache::const_iterator cached = m_mapKeyCache.find(args);
+    if (cached != m_mapKeyCache.end()) {
+        const MapKeyResult& result = cached->second;
+        keys.insert(keys.end(), result.m_keys.begin(), result.m_keys.end());
+        activeModifiers = result.m_activeModifiers;
+        currentState    = result.m_state;
+        LOG((CLOG_DEBUG1 "mapped to %03x, new state %04x", result.m_item->m_button, currentState));
+        return result.m_item;
+    }
+
+    size_t start = keys.size();
+    const KeyItem* item = mapKeyUncached(keys, id, group, activeModifiers,
+                                currentState, desiredMask, isAutoRepeat);
+    if (item != NULL) {
+        // bound the cache by starting over when it fills
+        if (m_mapKeyCache.size() >= s_mapKeyCacheSize) {
+            m_mapKeyCache.clear();
+        }
+        MapKeyResult& result     = m_mapKeyCache[args];
+        result.m_keys.assign(keys.begin() + start, keys.end());
+        result.m_activeModifiers = activeModifiers;
+        result.m_state           = currentState;
+        result.m_item            = item;
+    }
+    return item;
+}
+
+const KeyMap::KeyItem*
+KeyMap::mapKeyUncached(Keystrokes& keys, KeyID id, SInt32 group,
+                ModifierToKeys& activeModifiers,
+                KeyModifierMask& currentState,
+                KeyModifierMask desiredMask,
+                bool isAutoRepeat) const
+{
     const KeyItem* item;
     switch (id) {
     case kKeyShift_L:
@@ -369,7 +432,8 @@ KeyMap::findCompatibleKey(KeyID id, SInt32 group,
 bool
 KeyMap::isHalfDuplex(KeyID key, KeyButton button) const
 {
-    return (m_halfDuplex.count(button) + m_halfDuplexMods.count(key) > 0);
+    return ((button < m_halfDuplex.size() && m_halfDuplex[button]) ||
+            m_halfDuplexMods.count(key) > 0);
 }
 
 bool
@@ -505,6 +569,89 @@ KeyMap::setModifierKeys()
     }
 }
 
+void
+KeyMap::changed(bool keysChanged)
+{
+    m_mapKeyCache.clear();
+    if (keysChanged) {
+        m_lookupTablesValid = false;
+    }
+}
+
+void
+KeyMap::buildLookupTables() const
+{
+    size_t numGroups  = static_cast<size_t>(m_numGroups);
+    size_t numEntries = 0;
+    size_t numItems   = 0;
+    for (KeyIDMap::const_iterator i = m_keyIDMap.begin();
+                                i != m_keyIDMap.end(); ++i) {
+        const KeyGroupTable& groupTable = i->second;
+        for (size_t g = 0; g < numGroups && g < groupTable.size(); ++g) {
+            const KeyEntryList& entryList = groupTable[g];
+            numEntries += entryList.size();
+            for (size_t j = 0; j < entryList.size(); ++j) {
+                numItems += entryList[j].size();
+            }
+        }
+    }
+
+    // the spans point into the other tables so those mustn't reallocate
+    m_lookupIDs.clear();
+    m_lookupGroups.clear();
+    m_lookupEntries.clear();
+    m_lookupItems.clear();
+    m_lookupIDs.reserve(m_keyIDMap.size());
+    m_lookupGroups.reserve(m_keyIDMap.size() * numGroups);
+    m_lookupEntries.reserve(numEntries);
+    m_lookupItems.reserve(numItems);
+
+    // std::map iterates in KeyID order so m_lookupIDs comes out sorted
+    for (KeyIDMap::const_iterator i = m_keyIDMap.begin();
+                                i != m_keyIDMap.end(); ++i) {
+        const KeyGroupTable& groupTable = i->second;
+        m_lookupIDs.push_back(i->first);
+        for (size_t g = 0; g < numGroups; ++g) {
+            EntrySpan entries;
+            entries.m_entries = m_lookupEntries.data() + m_lookupEntries.size();
+            entries.m_size    = 0;
+            if (g < groupTable.size()) {
+                const KeyEntryList& entryList = groupTable[g];
+                for (size_t j = 0; j < entryList.size(); ++j) {
+                    const KeyItemList& itemList = entryList[j];
+                    ItemSpan items;
+                    items.m_items = m_lookupItems.data() + m_lookupItems.size();
+                    items.m_size  = itemList.size();
+                    m_lookupItems.insert(m_lookupItems.end(),
+                                itemList.begin(), itemList.end());
+                    m_lookupEntries.push_back(items);
+                }
+                entries.m_size = entryList.size();
+            }
+            m_lookupGroups.push_back(entries);
+        }
+    }
+    m_lookupTablesValid = true;
+}
+
+const KeyMap::EntrySpan*
+KeyMap::findKeyGroups(KeyID id) const
+{
+    if (m_numGroups == 0) {
+        return NULL;
+    }
+    if (!m_lookupTablesValid) {
+        buildLookupTables();
+    }
+    std::vector<KeyID>::const_iterator i =
+        std::lower_bound(m_lookupIDs.begin(), m_lookupIDs.end(), id);
+    if (i == m_lookupIDs.end() || *i != id) {
+        return NULL;
+    }
+    size_t index = static_cast<size_t>(i - m_lookupIDs.begin());
+    return &m_lookupGroups[index * m_numGroups];
+}
+
 const KeyMap::KeyItem*
 KeyMap::mapCommandKey(Keystrokes& keys, KeyID id, SInt32 group,
                 ModifierToKeys& activeModifiers,
@@ -515,20 +662,19 @@ KeyMap::mapCommandKey(Keystrokes& keys, KeyID id, SInt32 group,
     static const KeyModifierMask s_overrideModifiers = 0xffffu;
 
     // find KeySym in table
-    KeyIDMap::const_iterator i = m_keyIDMap.find(id);
-    if (i == m_keyIDMap.end()) {
+    const EntrySpan* keyGroups = findKeyGroups(id);
+    if (keyGroups == NULL) {
         // unknown key
         LOG((CLOG_DEBUG1 "key %04x is not on keyboard", id));
         return NULL;
     }
-    const KeyGroupTable& keyGroupTable = i->second;
 
     // find the first key that generates this KeyID
     const KeyItem* keyItem = NULL;
     SInt32 numGroups       = getNumGroups();
     for (SInt32 groupOffset = 0; groupOffset < numGroups; ++groupOffset) {
         SInt32 effectiveGroup = getEffectiveGroup(group, groupOffset);
-        const KeyEntryList& entryList = keyGroupTable[effectiveGroup];
+        const EntrySpan& entryList = keyGroups[effectiveGroup];
         for (size_t i = 0; i < entryList.size(); ++i) {
             if (entryList[i].size() != 1) {
                 // ignore multikey entries
@@ -606,13 +752,12 @@ KeyMap::mapCharacterKey(Keystrokes& keys, KeyID id, SInt32 group,
                 bool isAutoRepeat) const
 {
     // find KeySym in table
-    KeyIDMap::const_iterator i = m_keyIDMap.find(id);
-    if (i == m_keyIDMap.end()) {
+    const EntrySpan* keyGroups = findKeyGroups(id);
+    if (keyGroups == NULL) {
         // unknown key
         LOG((CLOG_DEBUG1 "key %04x is not on keyboard", id));
         return NULL;
     }
-    const KeyGroupTable& keyGroupTable = i->second;
 
     // find best key in any group, starting with the active group
     SInt32 keyIndex  = -1;
@@ -621,7 +766,7 @@ KeyMap::mapCharacterKey(Keystrokes& keys, KeyID id, SInt32 group,
     LOG((CLOG_DEBUG1 "find best:  %04x %04x", currentState, desiredMask));
     for (groupOffset = 0; groupOffset < numGroups; ++groupOffset) {
         SInt32 effectiveGroup = getEffectiveGroup(group, groupOffset);
-        keyIndex = findBestKey(keyGroupTable[effectiveGroup],
+        keyIndex = findBestKey(keyGroups[effectiveGroup],
                                 currentState, desiredMask);
         if (keyIndex != -1) {
             LOG((CLOG_DEBUG1 "found key in group %d", effectiveGroup));
@@ -636,7 +781,7 @@ KeyMap::mapCharacterKey(Keystrokes& keys, KeyID id, SInt32 group,
 
     // get keys to press for key
     SInt32 effectiveGroup = getEffectiveGroup(group, groupOffset);
-    const KeyItemList& itemList = keyGroupTable[effectiveGroup][keyIndex];
+    const ItemSpan& itemList = keyGroups[effectiveGroup][keyIndex];
     if (itemList.empty()) {
         return NULL;
     }
@@ -689,8 +834,9 @@ KeyMap::mapModifierKey(Keystrokes& keys, KeyID id, SInt32 group,
                                 currentState, desiredMask, isAutoRepeat);
 }
 
+template <class EntryList>
 SInt32
-KeyMap::findBestKey(const KeyEntryList& entryList,
+KeyMap::findBestKey(const EntryList& entryList,
                 KeyModifierMask /*currentState*/,
                 KeyModifierMask desiredState) const
 {
@@ -725,6 +871,9 @@ KeyMap::findBestKey(const KeyEntryList& entryList,
     return bestIndex;
 }
 
+template SInt32 KeyMap::findBestKey(const KeyEntryList&,
+                            KeyModifierMask, KeyModifierMask) const;
+
 
 const KeyMap::KeyItem*
 KeyMap::keyForModifier(KeyButton button, SInt32 group,
@@ -1028,7 +1177,7 @@ KeyMap::addKeystrokes(EKeystroke type, const KeyItem& keyItem,
     case kKeystrokeUnmodify:
         if (keyItem.m_lock) {
             // we assume there's just one button for this modifier
-            if (m_halfDuplex.count(button) > 0) {
+            if (button < m_halfDuplex.size() && m_halfDuplex[button]) {
                 if (type == kKeystrokeModify) {
                     // turn half-duplex toggle on (press)
                     keystrokes.push_back(Keystroke(button,  true, false, data));
@@ -1320,6 +1469,44 @@ KeyMap::KeyItem::operator==(const KeyItem& x) const
 }
 
 
+//
+// KeyMap::MapKeyArgs
+//
+
+static bool
+lessActiveModifier(const KeyMap::ModifierToKeys::value_type& a,
+                const KeyMap::ModifierToKeys::value_type& b)
+{
+    const KeyMap::KeyItem& x = a.second;
+    const KeyMap::KeyItem& y = b.second;
+    return std::tie(a.first, x.m_id, x.m_group, x.m_button, x.m_required,
+                    x.m_sensitive, x.m_generates, x.m_dead, x.m_lock,
+                    x.m_client) <
+           std::tie(b.first, y.m_id, y.m_group, y.m_button, y.m_required,
+                    y.m_sensitive, y.m_generates, y.m_dead, y.m_lock,
+                    y.m_client);
+}
+
+bool
+KeyMap::MapKeyArgs::operator<(const MapKeyArgs& x) const
+{
+    if (std::tie(m_id, m_group, m_state, m_desiredMask, m_isAutoRepeat) <
+        std::tie(x.m_id, x.m_group, x.m_state, x.m_desiredMask,
+                    x.m_isAutoRepeat)) {
+        return true;
+    }
+    if (std::tie(x.m_id, x.m_group, x.m_state, x.m_desiredMask,
+                    x.m_isAutoRepeat) <
+        std::tie(m_id, m_group, m_state, m_desiredMask, m_isAutoRepeat)) {
+        return false;
+    }
+    return std::lexicographical_compare(
+                m_activeModifiers.begin(), m_activeModifiers.end(),
+                x.m_activeModifiers.begin(), x.m_activeModifiers.end(),
+                &lessActiveModifier);
+}
+
+
 //
 // KeyMap::Keystroke
 //
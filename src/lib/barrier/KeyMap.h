@@ -218,7 +218,9 @@ public:
     modifiers as given in \p currentState and the desired modifiers in
     \p desiredMask into the keystrokes necessary to synthesize that key
     event in \p keys.  It returns the \c KeyItem of the key being
-    pressed/repeated, or NULL if the key cannot be mapped.
+    pressed/repeated, or NULL if the key cannot be mapped.  Results are
+    remembered until the map changes so mapping the same key in the
+    same state again just copies them.
     */
     virtual const KeyItem*    mapKey(Keystrokes& keys, KeyID id, SInt32 group,
                             ModifierToKeys& activeModifiers,
@@ -359,12 +361,52 @@ private:
     // A list of ways to synthesize a KeyID
     typedef std::vector<KeyItemList> KeyEntryList;
 
+    // A KeyItemList and a KeyEntryList as stored in the lookup tables
+    class ItemSpan {
+    public:
+        size_t            size() const { return m_size; }
+        bool            empty() const { return m_size == 0; }
+        const KeyItem&    operator[](size_t i) const { return m_items[i]; }
+        const KeyItem&    back() const { return m_items[m_size - 1]; }
+
+    public:
+        const KeyItem*    m_items;
+        size_t            m_size;
+    };
+    class EntrySpan {
+    public:
+        size_t            size() const { return m_size; }
+        const ItemSpan&    operator[](size_t i) const { return m_entries[i]; }
+
+    public:
+        const ItemSpan*    m_entries;
+        size_t            m_size;
+    };
+
     // computes the number of groups
     SInt32                findNumGroups() const;
 
     // computes the map of modifiers to the keys that generate the modifiers
     void                setModifierKeys();
 
+    // forgets the mapKey() cache and, if \p keysChanged, the lookup tables
+    void                changed(bool keysChanged);
+
+    // copies the KeyID map into the lookup tables
+    void                buildLookupTables() const;
+
+    // returns the ways to synthesize \p id in each group, indexed by
+    // group, or NULL if \p id isn't on the keyboard
+    const EntrySpan*    findKeyGroups(KeyID id) const;
+
+    // maps a key without using or filling the mapKey() cache
+    const KeyItem*        mapKeyUncached(Keystrokes& keys,
+                            KeyID id, SInt32 group,
+                            ModifierToKeys& activeModifiers,
+                            KeyModifierMask& currentState,
+                            KeyModifierMask desiredMask,
+                            bool isAutoRepeat) const;
+
     // maps a command key.  a command key is a keyboard shortcut and we're
     // trying to synthesize a button press with an exact sets of modifiers,
     // not trying to synthesize a character.  so we just need to find the
@@ -399,7 +441,8 @@ private:
     // returns the index into \p entryList of the KeyItemList requiring
     // the fewest modifier changes between \p currentState and
     // \p desiredState.
-    SInt32                findBestKey(const KeyEntryList& entryList,
+    template <class EntryList>
+    SInt32                findBestKey(const EntryList& entryList,
                             KeyModifierMask currentState,
                             KeyModifierMask desiredState) const;
 
@@ -480,8 +523,27 @@ private:
     // A set of keys
     typedef std::set<KeyID> KeySet;
 
-    // A set of buttons
-    typedef std::set<KeyButton> KeyButtonSet;
+    // The arguments to a mapKey() call and what it produced
+    class MapKeyArgs {
+    public:
+        bool            operator<(const MapKeyArgs&) const;
+
+    public:
+        KeyID            m_id;
+        SInt32            m_group;
+        KeyModifierMask    m_state;
+        KeyModifierMask    m_desiredMask;
+        bool            m_isAutoRepeat;
+        ModifierToKeys    m_activeModifiers;
+    };
+    class MapKeyResult {
+    public:
+        Keystrokes        m_keys;
+        ModifierToKeys    m_activeModifiers;
+        KeyModifierMask    m_state;
+        const KeyItem*    m_item;
+    };
+    typedef std::map<MapKeyArgs, MapKeyResult> MapKeyCache;
 
     // Key maps for parsing/formatting
     typedef std::map<String, KeyID,
@@ -500,12 +562,24 @@ private:
     bool                m_composeAcrossGroups;
 
     // half-duplex info
-    KeyButtonSet        m_halfDuplex;            // half-duplex set by barrier
+    std::vector<bool>    m_halfDuplex;            // half-duplex set by barrier
     KeySet                m_halfDuplexMods;        // half-duplex set by user
 
     // dummy KeyItem for changing modifiers
     KeyItem                m_modifierKeyItem;
 
+    // the KeyID map laid out for lookups:  the sorted KeyIDs, each
+    // KeyID's m_numGroups entry lists, then the lists' items, each in
+    // one array.  built by finish() or by the first lookup after a change.
+    mutable bool                    m_lookupTablesValid;
+    mutable std::vector<KeyID>        m_lookupIDs;
+    mutable std::vector<EntrySpan>    m_lookupGroups;
+    mutable std::vector<ItemSpan>    m_lookupEntries;
+    mutable std::vector<KeyItem>    m_lookupItems;
+
+    // successful mapKey() calls since the map last changed
+    mutable MapKeyCache    m_mapKeyCache;
+
     // parsing/formatting tables
     static NameToKeyMap*        s_nameToKeyMap;
     static NameToModifierMap*    s_nameToModifierMap;
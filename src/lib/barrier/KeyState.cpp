@@ -481,6 +481,12 @@ KeyState::updateKeyMap()
     // get the current keyboard map
     barrier::KeyMap keyMap;
     getKeyMap(keyMap);
+    setKeyMap(keyMap);
+}
+
+void
+KeyState::setKeyMap(barrier::KeyMap& keyMap)
+{
     m_keyMap.swap(keyMap);
     m_keyMap.finish();
 
@@ -490,6 +496,12 @@ KeyState::updateKeyMap()
     addAliasEntries();
 }
 
+void
+KeyState::swapKeyMap(barrier::KeyMap& keyMap)
+{
+    m_keyMap.swap(keyMap);
+}
+
 void
 KeyState::updateKeyState()
 {
@@ -103,6 +103,22 @@ protected:
     */
     virtual void        fakeKey(const Keystroke& keystroke) = 0;
 
+    //! Install a keyboard map
+    /*!
+    Makes \p keyMap, filled in the way \c getKeyMap() does, the current
+    keyboard map and adds the key sequences derived from it.  The old
+    map is left in \p keyMap.
+    */
+    void                setKeyMap(barrier::KeyMap& keyMap);
+
+    //! Exchange keyboard maps
+    /*!
+    Swaps the current keyboard map with \p keyMap, which must have been
+    installed by \c setKeyMap() before.  This restores a map without
+    building it again.
+    */
+    void                swapKeyMap(barrier::KeyMap& keyMap);
+
     //! Get the active modifiers
     /*!
     Returns the modifiers that are currently active according to our
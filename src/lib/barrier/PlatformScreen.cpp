@@ -32,6 +32,12 @@ PlatformScreen::~PlatformScreen()
     // do nothing
 }
 
+void
+PlatformScreen::flushFakeInput()
+{
+    // do nothing.  faked input is sent immediately.
+}
+
 void
 PlatformScreen::updateKeyMap()
 {
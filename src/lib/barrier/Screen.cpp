@@ -248,6 +248,12 @@ Screen::mouseWheel(SInt32 xDelta, SInt32 yDelta)
     m_screen->fakeMouseWheel(xDelta, yDelta);
 }
 
+void
+Screen::flushInput()
+{
+    m_screen->flushFakeInput();
+}
+
 void
 Screen::resetOptions()
 {
@@ -174,6 +174,12 @@ public:
     */
     void                mouseWheel(SInt32 xDelta, SInt32 yDelta);
 
+    //! Notify of the end of a batch of input
+    /*!
+    Send any synthesized input the platform screen is still holding.
+    */
+    void                flushInput();
+
     //! Notify of options changes
     /*!
     Resets all options to their default values.
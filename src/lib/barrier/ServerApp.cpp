@@ -20,6 +20,7 @@
 
 #include "server/Server.h"
 #include "server/ClientListener.h"
+#include "server/HostControlServer.h"
 #include "server/ClientProxy.h"
 #include "server/PrimaryClient.h"
 #include "barrier/ArgParser.h"
@@ -27,7 +28,10 @@
 #include "barrier/XScreen.h"
 #include "barrier/ServerTaskBarReceiver.h"
 #include "barrier/ServerArgs.h"
+#include "barrier/IInputInjector.h"
+#include "platform/VirtualScreen.h"
 #include "net/SocketMultiplexer.h"
+#include "net/SocketMultiplexerShards.h"
 #include "net/TCPSocketFactory.h"
 #include "net/XSocket.h"
 #include "arch/Arch.h"
@@ -74,6 +78,7 @@ ServerApp::ServerApp(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBa
     m_serverScreen(NULL),
     m_primaryClient(NULL),
     m_listener(NULL),
+    m_hostControl(NULL),
     m_timer(NULL),
     m_barrierAddress(NULL)
 {
@@ -144,6 +149,8 @@ ServerApp::help()
            << "Usage: " << args().m_exename
            << " [--address <address>]"
            << " [--config <pathname>]"
+           << " [--virtual-screen <width>x<height>]"
+           << " [--socket-shards <n>]"
            << WINAPI_ARGS << HELP_SYS_ARGS << HELP_COMMON_ARGS << "\n"
            << "\n"
            << "Options:\n"
@@ -152,6 +159,15 @@ ServerApp::help()
            << HELP_COMMON_INFO_1
            << "      --disable-client-cert-checking disable client SSL certificate \n"
               "                                     checking (deprecated)\n"
+           << "      --virtual-screen <width>x<height>\n"
+              "                           use a screen of the given size with no display\n"
+              "                           or input devices.  input is posted to /input\n"
+              "                           on the host control API.\n"
+           << "      --socket-shards <n>  service client connections on <n> socket\n"
+              "                           threads instead of one.\n"
+           << "      --socket-shard-by round-robin|address\n"
+              "                           spread clients over the socket threads in\n"
+              "                           turn (*) or by their host address.\n"
            << WINAPI_INFO << HELP_SYS_INFO << HELP_COMMON_INFO_2 << "\n"
            << "Default options are marked with a *\n"
            << "\n"
@@ -344,12 +360,23 @@ ServerApp::closeClientListener(ClientListener* listen)
     }
 }
 
+void
+ServerApp::closeHostControl(HostControlServer* hostControl)
+{
+    if (hostControl != NULL) {
+        m_server->setHostControl(NULL);
+        delete hostControl;
+    }
+}
+
 void
 ServerApp::stopServer()
 {
     if (m_serverState == kStarted) {
+        closeHostControl(m_hostControl);
         closeServer(m_server);
         closeClientListener(m_listener);
+        m_hostControl = NULL;
         m_server      = NULL;
         m_listener    = NULL;
         m_serverState = kInitialized;
@@ -570,6 +597,10 @@ ServerApp::startServer()
         listener->setServer(m_server);
         m_server->setListener(listener);
         m_listener = listener;
+        m_hostControl = openHostControl(m_server);
+        m_server->setHostControl(m_hostControl);
+        m_server->setInputInjector(dynamic_cast<IInputInjector*>(
+            m_serverScreen->getPlatformScreen()));
         updateStatus();
 
         // using CLOG_PRINT here allows the GUI to see that the server is started
@@ -609,6 +640,12 @@ ServerApp::startServer()
 barrier::Screen*
 ServerApp::createScreen()
 {
+    if (args().m_virtualScreen) {
+        return new barrier::Screen(new VirtualScreen(0, 0,
+            args().m_virtualScreenWidth, args().m_virtualScreenHeight,
+            m_events), m_events);
+    }
+
 #if WINAPI_MSWINDOWS
     return new barrier::Screen(new MSWindowsScreen(
         true, args().m_noHooks, args().m_stopOnDeskSwitch, m_events), m_events);
@@ -671,6 +708,7 @@ ServerApp::openClientListener(const NetworkAddress& address)
         address,
         new TCPSocketFactory(m_events, getSocketMultiplexer()),
         m_events, security_level);
+    listen->setSocketShards(m_socketShards.get());
 
     m_events->adoptHandler(
         m_events->forClientListener().connected(), listen,
@@ -680,6 +718,26 @@ ServerApp::openClientListener(const NetworkAddress& address)
     return listen;
 }
 
+HostControlServer*
+ServerApp::openHostControl(Server* server)
+{
+    // the host control api is optional so failing to open it isn't fatal
+    HostControlServer* hostControl = NULL;
+    try {
+        NetworkAddress address("0.0.0.0", HostControlServer::kDefaultPort);
+        address.resolve();
+        hostControl = new HostControlServer(
+            address,
+            new TCPSocketFactory(m_events, getSocketMultiplexer()),
+            m_events);
+        hostControl->setServer(server);
+    }
+    catch (XBase& e) {
+        LOG((CLOG_ERR "Failed to start HTTP endpoint: %s", e.what()));
+    }
+    return hostControl;
+}
+
 Server*
 ServerApp::openServer(Config& config, PrimaryClient* primaryClient)
 {
@@ -740,6 +798,16 @@ ServerApp::mainLoop()
     // create socket multiplexer.  this must happen after daemonization
     // on unix because threads evaporate across a fork().
     setSocketMultiplexer(std::make_unique<SocketMultiplexer>());
+    if (args().m_socketShards > 1) {
+        // the main multiplexer is the first shard
+        m_socketShards = std::make_unique<SocketMultiplexerShards>(
+            getSocketMultiplexer(), args().m_socketShards,
+            args().m_socketShardByAddress ?
+                SocketMultiplexerShards::kByAddress :
+                SocketMultiplexerShards::kRoundRobin);
+        LOG((CLOG_DEBUG "servicing clients on %d socket shards",
+            args().m_socketShards));
+    }
 
     // if configuration has no screens then add this system
     // as the default
@@ -798,14 +866,20 @@ ServerApp::mainLoop()
 
 #if defined(MAC_OS_X_VERSION_10_7)
 
-    Thread thread([this](){ run_events_loop(); });
-
-    // wait until carbon loop is ready
+    // a virtual screen doesn't need the cocoa app
     OSXScreen* screen = dynamic_cast<OSXScreen*>(
         m_serverScreen->getPlatformScreen());
-    screen->waitForCarbonLoop();
+    if (screen == NULL) {
+        m_events->loop();
+    }
+    else {
+        Thread thread([this](){ run_events_loop(); });
 
-    runCocoaApp();
+        // wait until carbon loop is ready
+        screen->waitForCarbonLoop();
+
+        runCocoaApp();
+    }
 #else
     m_events->loop();
 #endif
@@ -819,6 +893,7 @@ ServerApp::mainLoop()
     m_events->removeHandler(m_events->forServerApp().reloadConfig(),
         m_events->getSystemTarget());
     cleanupServer();
+    m_socketShards.reset();
     updateStatus();
     LOG((CLOG_NOTE "stopped server"));
 
@@ -29,6 +29,7 @@
 #include "base/EventTypes.h"
 
 #include <map>
+#include <memory>
 
 enum EServerState {
     kUninitialized,
@@ -42,10 +43,12 @@ enum EServerState {
 class Server;
 namespace barrier { class Screen; }
 class ClientListener;
+class HostControlServer;
 class EventQueueTimer;
 class ILogOutputter;
 class IEventQueue;
 class ServerArgs;
+class SocketMultiplexerShards;
 
 class ServerApp : public App {
 public:
@@ -79,6 +82,7 @@ public:
     void updateStatus();
     void updateStatus(const String& msg);
     void closeClientListener(ClientListener* listen);
+    void closeHostControl(HostControlServer* hostControl);
     void stopServer();
     void closePrimaryClient(PrimaryClient* primaryClient);
     void closeServerScreen(barrier::Screen* screen);
@@ -92,6 +96,7 @@ public:
     void handleSuspend(const Event&, void*);
     void handleResume(const Event&, void*);
     ClientListener* openClientListener(const NetworkAddress& address);
+    HostControlServer* openHostControl(Server* server);
     Server* openServer(Config& config, PrimaryClient* primaryClient);
     void handleNoClients(const Event&, void*);
     bool startServer();
@@ -110,8 +115,10 @@ public:
     barrier::Screen*    m_serverScreen;
     PrimaryClient*        m_primaryClient;
     ClientListener*        m_listener;
+    HostControlServer*    m_hostControl;
     EventQueueTimer*    m_timer;
     NetworkAddress*        m_barrierAddress;
+    std::unique_ptr<SocketMultiplexerShards> m_socketShards;
 
 private:
     void handleScreenSwitched(const Event&, void*  data);
@@ -20,7 +20,12 @@
 ServerArgs::ServerArgs() :
     m_configFile(),
     m_config(NULL),
-    m_screenChangeScript()
+    m_screenChangeScript(),
+    m_virtualScreen(false),
+    m_virtualScreenWidth(0),
+    m_virtualScreenHeight(0),
+    m_socketShards(1),
+    m_socketShardByAddress(false)
 {
 }
 
@@ -30,5 +30,10 @@ public:
     String                m_configFile;
     Config*                m_config;
     String                m_screenChangeScript;
+    bool                m_virtualScreen;
+    int                    m_virtualScreenWidth;
+    int                    m_virtualScreenHeight;
+    int                    m_socketShards;
+    bool                m_socketShardByAddress;
     bool check_client_certificates = true;
 };
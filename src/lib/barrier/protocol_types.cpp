@@ -44,6 +44,7 @@ const char*                kMsgDMouseWheel1_0    = "DMWM%2i";
 const char*                kMsgDClipboard        = "DCLP%1i%4i%1i%s";
 const char*                kMsgDInfo            = "DINF%2i%2i%2i%2i%2i%2i%2i";
 const char*                kMsgDScreenList      = "DSCL%s";
+const char*                kMsgDLockState       = "DLKS%4i";
 const char*                kMsgDSetOptions        = "DSOP%4I";
 const char*                kMsgDFileTransfer    = "DFTR%1i%s";
 const char*                kMsgDDragInfo        = "DDRG%2i%s";
@@ -33,9 +33,10 @@
 // 1.5:  adds file transfer and removes home brew crypto
 // 1.6:  adds clipboard streaming
 // 1.7:  adds per-host screen list reporting
+// 1.8:  adds lock state reporting
 // NOTE: with new version, barrier minor version should increment
 static const SInt16        kProtocolMajorVersion = 1;
-static const SInt16        kProtocolMinorVersion = 7;
+static const SInt16        kProtocolMinorVersion = 8;
 
 // default contact port number
 static const UInt16        kDefaultPort = 24800;
@@ -269,6 +270,11 @@ extern const char*        kMsgDInfo;
 // payload is a serialized list of screens reported by the client.
 extern const char*        kMsgDScreenList;
 
+// lock state:  secondary -> primary
+// the host changed the state of the lock keys on its own, e.g. from
+// another keyboard.  $1 = KeyModifierMask of the locks that are on.
+extern const char*        kMsgDLockState;
+
 // set options:  primary -> secondary
 // client should set the given option/value pairs.  $1 = option/value
 // pairs.
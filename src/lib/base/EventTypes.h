@@ -374,7 +374,8 @@ class ClientProxyEvents : public EventTypes {
 public:
     ClientProxyEvents() :
         m_ready(Event::kUnknown),
-        m_disconnected(Event::kUnknown) { }
+        m_disconnected(Event::kUnknown),
+        m_lockStateChanged(Event::kUnknown) { }
 
     //! @name accessors
     //@{
@@ -394,11 +395,21 @@ public:
     */
     Event::Type        disconnected();
 
+    //! Get lock state changed event type
+    /*!
+    Returns the lock state changed event type.  This is sent when the
+    client reports that its lock keys changed.  The target is
+    getEventTarget() and the data is a pointer to the KeyModifierMask
+    of the locks that are on.
+    */
+    Event::Type        lockStateChanged();
+
     //@}
 
 private:
     Event::Type        m_ready;
     Event::Type        m_disconnected;
+    Event::Type        m_lockStateChanged;
 };
 
 class ClientProxyUnknownEvents : public EventTypes {
@@ -657,6 +668,7 @@ public:
     IScreenEvents() :
         m_error(Event::kUnknown),
         m_shapeChanged(Event::kUnknown),
+        m_lockStateChanged(Event::kUnknown),
         m_suspend(Event::kUnknown),
         m_resume(Event::kUnknown) { }
 
@@ -677,6 +689,15 @@ public:
     */
     Event::Type        shapeChanged();
 
+    //! Get lock state changed event type
+    /*!
+    Returns the lock state changed event type.  This is sent when the
+    lock keys are changed by something other than barrier, e.g. by
+    another keyboard.  The data is a pointer to the KeyModifierMask of
+    the locks that are on.
+    */
+    Event::Type        lockStateChanged();
+
     //! Get suspend event type
     /*!
     Returns the suspend event type. This is sent whenever the system goes
@@ -696,6 +717,7 @@ public:
 private:
     Event::Type        m_error;
     Event::Type        m_shapeChanged;
+    Event::Type        m_lockStateChanged;
     Event::Type        m_suspend;
     Event::Type        m_resume;
 };
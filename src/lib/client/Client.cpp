@@ -18,6 +18,7 @@
 
 #include "client/Client.h"
 
+#include "client/DirectInputDispatcher.h"
 #include "client/IInputBackend.h"
 #include "client/ServerProxy.h"
 #include "client/InputBackendFactory.h"
@@ -73,7 +74,7 @@ Client::Client(IEventQueue* events, const std::string& name, const NetworkAddres
     m_useSecureNetwork(args.m_enableCrypto),
     m_args(args),
     m_enableClipboard(true),
-    m_inputBackend(createInputBackend(screen, args))
+    m_inputBackend(createInputBackend(screen, args, events))
 {
     assert(m_socketFactory != NULL);
     assert(m_screen        != NULL);
@@ -162,6 +163,12 @@ Client::connect()
         m_stream = socket;
         m_stream = new PacketStreamFilter(m_events, m_stream, true);
 
+        // the dispatcher must see the stream from its first byte to
+        // find the packets in it
+        if (m_args.m_directInput) {
+            setupDirectInput();
+        }
+
         // connect
         LOG((CLOG_DEBUG1 "connecting to server"));
         setupConnecting();
@@ -354,6 +361,12 @@ Client::mouseWheel(SInt32 xDelta, SInt32 yDelta)
     m_inputBackend->mouseWheel(xDelta, yDelta);
 }
 
+void
+Client::flushInput()
+{
+    m_inputBackend->flush();
+}
+
 void
 Client::screensaver(bool activate)
 {
@@ -508,6 +521,19 @@ Client::setupConnection()
                            new TMethodEventJob<Client>(this, &Client::handleStopRetry));
 }
 
+void
+Client::setupDirectInput()
+{
+    if (m_socket == NULL || !m_inputBackend->isThreadSafe()) {
+        LOG((CLOG_WARN "direct input needs the uinput backend, using the event loop"));
+        return;
+    }
+
+    LOG((CLOG_DEBUG1 "injecting input directly from the network thread"));
+    m_directInput.reset(new DirectInputDispatcher(m_inputBackend.get()));
+    m_socket->setInputHook(m_directInput.get());
+}
+
 void
 Client::setupScreen()
 {
@@ -515,6 +541,9 @@ Client::setupScreen()
 
     m_ready  = false;
     m_server = new ServerProxy(this, m_stream, m_events);
+    if (m_directInput) {
+        m_server->setDirectInput(m_directInput.get());
+    }
     m_events->adoptHandler(m_events->forIScreen().shapeChanged(),
                             getEventTarget(),
                             new TMethodEventJob<Client>(this,
@@ -523,6 +552,10 @@ Client::setupScreen()
                             getEventTarget(),
                             new TMethodEventJob<Client>(this,
                                 &Client::handleClipboardGrabbed));
+    m_events->adoptHandler(m_events->forIScreen().lockStateChanged(),
+                            getEventTarget(),
+                            new TMethodEventJob<Client>(this,
+                                &Client::handleLockStateChanged));
 }
 
 void
@@ -579,6 +612,8 @@ Client::cleanupScreen()
                             getEventTarget());
         m_events->removeHandler(m_events->forClipboard().clipboardGrabbed(),
                             getEventTarget());
+        m_events->removeHandler(m_events->forIScreen().lockStateChanged(),
+                            getEventTarget());
         delete m_server;
         m_server = NULL;
     }
@@ -599,6 +634,10 @@ Client::cleanupStream()
 {
     delete m_stream;
     m_stream = NULL;
+    m_socket = NULL;
+
+    // the socket that used it is gone
+    m_directInput.reset();
 }
 
 void
@@ -704,6 +743,10 @@ Client::handleHello(const Event&, void*)
         return;
     }
 
+    if (m_directInput) {
+        m_directInput->processed(1);
+    }
+
     // check versions
     LOG((CLOG_DEBUG1 "got hello version %d.%d", major, minor));
     if (major < kProtocolMajorVersion ||
@@ -780,6 +823,14 @@ Client::handleStopRetry(const Event&, void*)
     m_args.m_restartable = false;
 }
 
+void
+Client::handleLockStateChanged(const Event& event, void*)
+{
+    if (m_server != NULL) {
+        m_server->sendLockState(*static_cast<KeyModifierMask*>(event.getData()));
+    }
+}
+
 void Client::write_to_drop_dir_thread()
 {
     LOG((CLOG_DEBUG "starting write to drop dir thread"));
@@ -40,6 +40,7 @@ class IEventQueue;
 class Thread;
 class TCPSocket;
 class IInputBackend;
+class DirectInputDispatcher;
 
 //! Barrier client
 /*!
@@ -97,6 +98,13 @@ public:
     //! Send dragging file information back to server
     void sendDragInfo(UInt32 fileCount, std::string& info, size_t size);
 
+    //! Flush injected input
+    /*!
+    Submits input buffered by the input backend.  Called once a batch
+    of messages from the server has been handled.
+    */
+    void                flushInput();
+
 
     //@}
     //! @name accessors
@@ -175,6 +183,7 @@ private:
     void write_to_drop_dir_thread();
     void                setupConnecting();
     void                setupConnection();
+    void                setupDirectInput();
     void                setupScreen();
     void                setupTimer();
     void                cleanupConnecting();
@@ -195,6 +204,7 @@ private:
     void                handleFileChunkSending(const Event&, void*);
     void                handleFileRecieveCompleted(const Event&, void*);
     void                handleStopRetry(const Event&, void*);
+    void                handleLockStateChanged(const Event&, void*);
     void                onFileRecieveCompleted();
     void                sendClipboardThread(void*);
 
@@ -229,4 +239,5 @@ private:
     ClientArgs            m_args;
     bool                m_enableClipboard;
     std::unique_ptr<IInputBackend> m_inputBackend;
+    std::unique_ptr<DirectInputDispatcher> m_directInput;
 };
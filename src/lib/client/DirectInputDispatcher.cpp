@@ -0,0 +1,230 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/DirectInputDispatcher.h"
+
+#include "client/IInputBackend.h"
+#include "client/ServerProxy.h"
+#include "barrier/protocol_types.h"
+#include "mt/Lock.h"
+#include "base/Log.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+UInt16
+readUInt16(const UInt8* data)
+{
+    return static_cast<UInt16>((static_cast<UInt16>(data[0]) << 8) | data[1]);
+}
+
+SInt16
+readSInt16(const UInt8* data)
+{
+    return static_cast<SInt16>(readUInt16(data));
+}
+
+UInt32
+readUInt32(const UInt8* data)
+{
+    return (static_cast<UInt32>(data[0]) << 24) |
+           (static_cast<UInt32>(data[1]) << 16) |
+           (static_cast<UInt32>(data[2]) <<  8) |
+            static_cast<UInt32>(data[3]);
+}
+
+bool
+isMessage(const UInt8* message, const char* code)
+{
+    return memcmp(message, code, 4) == 0;
+}
+
+bool
+isInputMessage(const UInt8* message, UInt32 size)
+{
+    return size >= 4 && message[0] == 'D' &&
+           (isMessage(message, kMsgDMouseMove) ||
+            isMessage(message, kMsgDMouseRelMove) ||
+            isMessage(message, kMsgDMouseWheel) ||
+            isMessage(message, kMsgDKeyDown) ||
+            isMessage(message, kMsgDKeyRepeat) ||
+            isMessage(message, kMsgDKeyUp) ||
+            isMessage(message, kMsgDMouseDown) ||
+            isMessage(message, kMsgDMouseUp));
+}
+
+} // namespace
+
+//
+// DirectInputDispatcher
+//
+
+DirectInputDispatcher::DirectInputDispatcher(IInputBackend* backend) :
+    m_backend(backend),
+    m_passThrough(false),
+    m_table(NULL),
+    m_held(false),
+    m_pending(0),
+    m_direct(0),
+    m_queued(0)
+{
+    assert(m_backend != NULL);
+}
+
+DirectInputDispatcher::~DirectInputDispatcher()
+{
+    LOG((CLOG_DEBUG "direct input: %u input messages injected directly, %u queued",
+         m_direct, m_queued));
+}
+
+void
+DirectInputDispatcher::setModifierTranslation(const KeyModifierID* table)
+{
+    Lock lock(&m_mutex);
+    m_table = table;
+}
+
+void
+DirectInputDispatcher::setHeld(bool held)
+{
+    Lock lock(&m_mutex);
+    m_held = held;
+}
+
+void
+DirectInputDispatcher::processed(UInt32 count)
+{
+    Lock lock(&m_mutex);
+    assert(count <= m_pending);
+    m_pending -= count;
+}
+
+UInt32
+DirectInputDispatcher::getDirectCount() const
+{
+    Lock lock(&m_mutex);
+    return m_direct;
+}
+
+UInt32
+DirectInputDispatcher::getQueuedCount() const
+{
+    Lock lock(&m_mutex);
+    return m_queued;
+}
+
+void
+DirectInputDispatcher::onSocketInput(const UInt8* data, UInt32 n,
+                StreamBuffer& input)
+{
+    Lock lock(&m_mutex);
+
+    if (m_passThrough) {
+        input.write(data, n);
+        return;
+    }
+
+    // split the data into packets, as PacketStreamFilter does on the
+    // other side of the input buffer
+    m_partial.write(data, n);
+    bool injected = false;
+    while (m_partial.getSize() >= 4) {
+        UInt32 size = readUInt32(static_cast<const UInt8*>(m_partial.peek(4)));
+        if (size > PROTOCOL_MAX_MESSAGE_LENGTH) {
+            // PacketStreamFilter will reject this.  we can't find the
+            // packets after it so stop looking.
+            LOG((CLOG_DEBUG "direct input: packet too long, passing everything on"));
+            m_passThrough = true;
+            input.write(m_partial.peek(m_partial.getSize()), m_partial.getSize());
+            m_partial.pop(m_partial.getSize());
+            break;
+        }
+        if (m_partial.getSize() < size + 4) {
+            break;
+        }
+
+        const UInt8* packet = static_cast<const UInt8*>(m_partial.peek(size + 4));
+        if (m_pending == 0 && !m_held && m_table != NULL &&
+                m_backend->isThreadSafe() && dispatch(packet + 4, size)) {
+            injected = true;
+            ++m_direct;
+        }
+        else {
+            if (isInputMessage(packet + 4, size)) {
+                ++m_queued;
+            }
+            input.write(packet, size + 4);
+            ++m_pending;
+        }
+        m_partial.pop(size + 4);
+    }
+
+    if (injected) {
+        m_backend->flush();
+    }
+}
+
+bool
+DirectInputDispatcher::dispatch(const UInt8* message, UInt32 size)
+{
+    // messages of the wrong size are left for ServerProxy to complain
+    // about.  the sizes are the code plus the arguments in protocol_types.h.
+    if (size < 4 || message[0] != 'D') {
+        return false;
+    }
+    const UInt8* args = message + 4;
+
+    if (isMessage(message, kMsgDMouseMove) && size == 8) {
+        m_backend->mouseMove(readSInt16(args), readSInt16(args + 2));
+    }
+    else if (isMessage(message, kMsgDMouseRelMove) && size == 8) {
+        m_backend->mouseRelativeMove(readSInt16(args), readSInt16(args + 2));
+    }
+    else if (isMessage(message, kMsgDMouseWheel) && size == 8) {
+        m_backend->mouseWheel(readSInt16(args), readSInt16(args + 2));
+    }
+    else if (isMessage(message, kMsgDKeyDown) && size == 10) {
+        m_backend->keyDown(
+            ServerProxy::translateKey(m_table, readUInt16(args)),
+            ServerProxy::translateModifierMask(m_table, readUInt16(args + 2)),
+            readUInt16(args + 4));
+    }
+    else if (isMessage(message, kMsgDKeyRepeat) && size == 12) {
+        m_backend->keyRepeat(
+            ServerProxy::translateKey(m_table, readUInt16(args)),
+            ServerProxy::translateModifierMask(m_table, readUInt16(args + 2)),
+            readUInt16(args + 4), readUInt16(args + 6));
+    }
+    else if (isMessage(message, kMsgDKeyUp) && size == 10) {
+        m_backend->keyUp(
+            ServerProxy::translateKey(m_table, readUInt16(args)),
+            ServerProxy::translateModifierMask(m_table, readUInt16(args + 2)),
+            readUInt16(args + 4));
+    }
+    else if (isMessage(message, kMsgDMouseDown) && size == 5) {
+        m_backend->mouseDown(static_cast<ButtonID>(args[0]));
+    }
+    else if (isMessage(message, kMsgDMouseUp) && size == 5) {
+        m_backend->mouseUp(static_cast<ButtonID>(args[0]));
+    }
+    else {
+        return false;
+    }
+    return true;
+}
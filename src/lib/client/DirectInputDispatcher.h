@@ -0,0 +1,113 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "net/ISocketInputHook.h"
+#include "barrier/key_types.h"
+#include "io/StreamBuffer.h"
+#include "mt/Mutex.h"
+
+class IInputBackend;
+
+//! Injects input straight from the socket
+/*!
+A socket input hook that injects the server's input messages (motion,
+keys, buttons and the wheel) on the socket's thread instead of waiting
+for the event loop to hand them to ServerProxy.  Every other message is
+passed on to be read as usual.  Once a message has been passed on, the
+input after it is passed on too until ServerProxy reports the message
+handled, so input never overtakes what came before it and the backend
+is never used by two threads at once.
+
+The backend must be thread safe (see IInputBackend::isThreadSafe()).
+Injected messages aren't answered with a no-op like the ones ServerProxy
+handles;  that reply only helps BSD hosts, which have neither backend.
+*/
+class DirectInputDispatcher : public ISocketInputHook {
+public:
+    //! Injects into \p backend, which is not adopted
+    explicit DirectInputDispatcher(IInputBackend* backend);
+    ~DirectInputDispatcher();
+
+    //! @name manipulators
+    //@{
+
+    //! Set modifier translation
+    /*!
+    Keys are translated with \p table, as by ServerProxy::translateKey().
+    Nothing is injected directly while the table is NULL, which it is to
+    start with.  The table must only change while the main thread is
+    handling a message.
+    */
+    void                setModifierTranslation(const KeyModifierID* table);
+
+    //! Hold input
+    /*!
+    While \p held is true every message is passed on, for when the main
+    thread must see all input, e.g. to drop motion while the screen's
+    shape is being updated.
+    */
+    void                setHeld(bool held);
+
+    //! Note messages handled
+    /*!
+    Called on the main thread when \p count messages passed on have been
+    handled and the input they produced flushed.
+    */
+    void                processed(UInt32 count);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get number of input messages injected directly
+    UInt32                getDirectCount() const;
+
+    //! Get number of input messages passed on
+    UInt32                getQueuedCount() const;
+
+    //@}
+
+    // ISocketInputHook overrides
+    virtual void        onSocketInput(const UInt8* data, UInt32 n,
+                            StreamBuffer& input);
+
+private:
+    // injects the message \p size bytes long at \p message if it's
+    // input.  returns false if it's not.
+    bool                dispatch(const UInt8* message, UInt32 size);
+
+private:
+    IInputBackend*        m_backend;
+    mutable Mutex        m_mutex;
+
+    // data that doesn't make up a whole packet yet
+    StreamBuffer        m_partial;
+
+    // set if a packet was too long to frame the stream after it
+    bool                m_passThrough;
+
+    const KeyModifierID*    m_table;
+    bool                m_held;
+
+    // messages passed on that the main thread hasn't handled yet
+    UInt32                m_pending;
+
+    UInt32                m_direct;
+    UInt32                m_queued;
+};
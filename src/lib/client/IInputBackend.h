@@ -36,5 +36,14 @@ public:
     virtual void mouseMove(SInt32 xAbs, SInt32 yAbs) = 0;
     virtual void mouseRelativeMove(SInt32 dx, SInt32 dy) = 0;
     virtual void mouseWheel(SInt32 xDelta, SInt32 yDelta) = 0;
+
+    // called after each batch of input so a backend that buffers can
+    // submit it together
+    virtual void flush() = 0;
+
+    // true if input can be given from a thread other than the one
+    // running the event loop, one call at a time.  the answer must not
+    // change, so a backend that can fall back to the screen isn't.
+    virtual bool isThreadSafe() const { return false; }
 };
 
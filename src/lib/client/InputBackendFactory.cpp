@@ -18,12 +18,17 @@
 #include "client/InputBackendFactory.h"
 
 #include "client/IInputBackend.h"
+#include "client/RecordingInputBackend.h"
 #include "barrier/ClientArgs.h"
 #include "barrier/Screen.h"
+#include "base/IEventQueue.h"
 #include "base/Log.h"
+#include "platform/UhidInjector.h"
 #include "platform/UhidServer.h"
+#include "platform/UinputDevice.h"
 
 #include <cassert>
+#include <cstdlib>
 
 namespace {
 
@@ -84,17 +89,196 @@ public:
         m_screen->mouseWheel(xDelta, yDelta);
     }
 
+    void flush() override
+    {
+        m_screen->flushInput();
+    }
+
 private:
     barrier::Screen* m_screen;
 };
 
 class UhidInputBackend : public IInputBackend {
 public:
-    explicit UhidInputBackend(const String& deviceName)
+    UhidInputBackend(barrier::Screen* screen, const ClientArgs& args, IEventQueue* events)
         : m_started(false)
+        , m_fellBack(false)
+        , m_screen(screen)
+        , m_fallback(screen)
         , m_uhidServer(new UhidServer())
     {
-        m_started = m_uhidServer->start(deviceName);
+        assert(m_screen != NULL);
+        if (args.m_uhidBootKeyboard) {
+            m_uhidServer->setKeyboardReport(UhidServer::kKeyboardReportBoot);
+        }
+        m_uhidServer->setComposeKey(args.m_uhidComposeKey);
+        m_started = m_uhidServer->start(args.m_uhidName);
+        if (m_started) {
+            // the device is only touched by the injection thread from
+            // here on so protocol handling never waits on a write
+            m_injector.reset(new UhidInjector(m_uhidServer.get()));
+
+            // the lock LEDs set by the host are reported from the
+            // injection thread through the event queue
+            const Event::Type type = events->forIScreen().lockStateChanged();
+            void* target = m_screen->getEventTarget();
+            m_injector->setLockStateCallback([events, type, target](KeyModifierMask mask) {
+                KeyModifierMask* data = static_cast<KeyModifierMask*>(malloc(sizeof(KeyModifierMask)));
+                *data = mask;
+                events->addEvent(Event(type, target, data));
+            });
+            m_injector->start(args.m_uhidRealtime);
+        }
+    }
+
+    bool started() const
+    {
+        return m_started;
+    }
+
+    void enter(SInt32 xAbs, SInt32 yAbs) override
+    {
+        if (useFallback()) {
+            m_fallback.enter(xAbs, yAbs);
+            return;
+        }
+
+        // the screen may have been resized since the last visit
+        SInt32 x, y, w, h;
+        m_screen->getShape(x, y, w, h);
+        m_injector->setScreenShape(x, y, w, h);
+
+        m_injector->clearInputState();
+        m_injector->mouseMoveAbsolute(xAbs, yAbs);
+    }
+
+    void leave() override
+    {
+        if (useFallback()) {
+            m_fallback.leave();
+            return;
+        }
+        m_injector->clearInputState();
+    }
+
+    void keyDown(KeyID id, KeyModifierMask mask, KeyButton button) override
+    {
+        if (useFallback()) {
+            m_fallback.keyDown(id, mask, button);
+            return;
+        }
+        m_injector->keyDown(id, mask);
+    }
+
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton button) override
+    {
+        if (useFallback()) {
+            m_fallback.keyRepeat(id, mask, count, button);
+            return;
+        }
+        m_injector->keyRepeat(id, mask, count);
+    }
+
+    void keyUp(KeyID id, KeyModifierMask mask, KeyButton button) override
+    {
+        if (useFallback()) {
+            m_fallback.keyUp(id, mask, button);
+            return;
+        }
+        m_injector->keyUp(id, mask);
+    }
+
+    void mouseDown(ButtonID id) override
+    {
+        if (useFallback()) {
+            m_fallback.mouseDown(id);
+            return;
+        }
+        m_injector->mouseDown(id);
+    }
+
+    void mouseUp(ButtonID id) override
+    {
+        if (useFallback()) {
+            m_fallback.mouseUp(id);
+            return;
+        }
+        m_injector->mouseUp(id);
+    }
+
+    void mouseMove(SInt32 xAbs, SInt32 yAbs) override
+    {
+        if (useFallback()) {
+            m_fallback.mouseMove(xAbs, yAbs);
+            return;
+        }
+        m_injector->mouseMoveAbsolute(xAbs, yAbs);
+    }
+
+    void mouseRelativeMove(SInt32 dx, SInt32 dy) override
+    {
+        if (useFallback()) {
+            m_fallback.mouseRelativeMove(dx, dy);
+            return;
+        }
+        m_injector->mouseRelativeMove(dx, dy);
+    }
+
+    void mouseWheel(SInt32 xDelta, SInt32 yDelta) override
+    {
+        if (useFallback()) {
+            m_fallback.mouseWheel(xDelta, yDelta);
+            return;
+        }
+        m_injector->mouseWheel(xDelta, yDelta);
+    }
+
+    void flush() override
+    {
+        if (useFallback()) {
+            m_fallback.flush();
+            return;
+        }
+        m_injector->flush();
+    }
+
+private:
+    // the device is created without waiting for the kernel, so it can
+    // still turn out to be unusable after the backend was chosen.  the
+    // fallback uses the screen, which is why this backend isn't thread
+    // safe even while the injector is running.
+    bool useFallback()
+    {
+        if (!m_injector->failed()) {
+            return false;
+        }
+        if (!m_fellBack) {
+            LOG((CLOG_WARN "uhid: device unavailable, falling back to screen backend"));
+            m_fellBack = true;
+        }
+        return true;
+    }
+
+private:
+    bool m_started;
+    bool m_fellBack;
+    barrier::Screen* m_screen;
+    ScreenInputBackend m_fallback;
+    std::unique_ptr<UhidServer> m_uhidServer;
+
+    // declared after the server so it's stopped before the server goes
+    std::unique_ptr<UhidInjector> m_injector;
+};
+
+class UinputInputBackend : public IInputBackend {
+public:
+    UinputInputBackend(barrier::Screen* screen, const ClientArgs& args)
+        : m_started(false)
+        , m_screen(screen)
+    {
+        assert(m_screen != NULL);
+        m_device.setComposeKey(args.m_uhidComposeKey);
+        m_started = m_device.start(args.m_uhidName);
     }
 
     bool started() const
@@ -104,69 +288,100 @@ public:
 
     void enter(SInt32 xAbs, SInt32 yAbs) override
     {
-        m_uhidServer->clearInputState();
-        m_uhidServer->mouseMoveAbsolute(xAbs, yAbs);
+        SInt32 x, y, w, h;
+        m_screen->getShape(x, y, w, h);
+        m_device.setScreenShape(x, y, w, h);
+
+        m_device.clearInputState();
+        m_device.mouseMoveAbsolute(xAbs, yAbs);
     }
 
     void leave() override
     {
-        m_uhidServer->clearInputState();
+        m_device.clearInputState();
+        m_device.flush();
     }
 
     void keyDown(KeyID id, KeyModifierMask mask, KeyButton) override
     {
-        m_uhidServer->keyDown(id, mask);
+        m_device.keyDown(id, mask);
     }
 
     void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton) override
     {
-        m_uhidServer->keyRepeat(id, mask, count);
+        m_device.keyRepeat(id, mask, count);
     }
 
     void keyUp(KeyID id, KeyModifierMask mask, KeyButton) override
     {
-        m_uhidServer->keyUp(id, mask);
+        m_device.keyUp(id, mask);
     }
 
     void mouseDown(ButtonID id) override
     {
-        m_uhidServer->mouseDown(id);
+        m_device.mouseDown(id);
     }
 
     void mouseUp(ButtonID id) override
     {
-        m_uhidServer->mouseUp(id);
+        m_device.mouseUp(id);
     }
 
     void mouseMove(SInt32 xAbs, SInt32 yAbs) override
     {
-        m_uhidServer->mouseMoveAbsolute(xAbs, yAbs);
+        m_device.mouseMoveAbsolute(xAbs, yAbs);
     }
 
     void mouseRelativeMove(SInt32 dx, SInt32 dy) override
     {
-        m_uhidServer->mouseRelativeMove(dx, dy);
+        m_device.mouseRelativeMove(dx, dy);
     }
 
     void mouseWheel(SInt32 xDelta, SInt32 yDelta) override
     {
-        m_uhidServer->mouseWheel(xDelta, yDelta);
+        m_device.mouseWheel(xDelta, yDelta);
+    }
+
+    void flush() override
+    {
+        m_device.flush();
+    }
+
+    bool isThreadSafe() const override
+    {
+        return true;
     }
 
 private:
     bool m_started;
-    std::unique_ptr<UhidServer> m_uhidServer;
+    barrier::Screen* m_screen;
+
+    // writes to uinput don't wait on the kernel so, unlike uhid, the
+    // device is driven from the caller's thread
+    UinputDevice m_device;
 };
 
 } // namespace
 
-std::unique_ptr<IInputBackend> createInputBackend(barrier::Screen* screen, const ClientArgs& args)
+static std::unique_ptr<IInputBackend> createInjectingBackend(barrier::Screen* screen,
+                                                             const ClientArgs& args,
+                                                             IEventQueue* events)
 {
+    if (args.m_uinputEnabled) {
+        std::unique_ptr<UinputInputBackend> uinputBackend(new UinputInputBackend(screen, args));
+        if (uinputBackend->started()) {
+            LOG((CLOG_NOTE "uinput: using backend"));
+            return std::move(uinputBackend);
+        }
+        LOG((CLOG_WARN "uinput: failed to start, falling back to %s backend",
+             args.m_uhidEnabled ? "uhid" : "screen"));
+    }
+
     if (!args.m_uhidEnabled) {
         return std::unique_ptr<IInputBackend>(new ScreenInputBackend(screen));
     }
 
-    std::unique_ptr<UhidInputBackend> uhidBackend(new UhidInputBackend(args.m_uhidName));
+    std::unique_ptr<UhidInputBackend> uhidBackend(new UhidInputBackend(screen, args, events));
     if (uhidBackend->started()) {
         LOG((CLOG_NOTE "uhid: using backend"));
         return std::move(uhidBackend);
@@ -175,3 +390,21 @@ std::unique_ptr<IInputBackend> createInputBackend(barrier::Screen* screen, const
     LOG((CLOG_WARN "uhid: failed to start, falling back to screen backend"));
     return std::unique_ptr<IInputBackend>(new ScreenInputBackend(screen));
 }
+
+std::unique_ptr<IInputBackend> createInputBackend(barrier::Screen* screen, const ClientArgs& args,
+                                                  IEventQueue* events)
+{
+    std::unique_ptr<IInputBackend> backend = createInjectingBackend(screen, args, events);
+    if (args.m_recordInputPath.empty()) {
+        return backend;
+    }
+
+    std::unique_ptr<InputLogWriter> log(new InputLogWriter());
+    if (!log->open(args.m_recordInputPath)) {
+        LOG((CLOG_WARN "cannot record input to \"%s\"", args.m_recordInputPath.c_str()));
+        return backend;
+    }
+
+    LOG((CLOG_NOTE "recording input to \"%s\"", args.m_recordInputPath.c_str()));
+    return std::unique_ptr<IInputBackend>(new RecordingInputBackend(std::move(backend), std::move(log)));
+}
@@ -24,7 +24,9 @@ class Screen;
 }
 
 class ClientArgs;
+class IEventQueue;
 class IInputBackend;
 
-std::unique_ptr<IInputBackend> createInputBackend(barrier::Screen* screen, const ClientArgs& args);
+std::unique_ptr<IInputBackend> createInputBackend(barrier::Screen* screen, const ClientArgs& args,
+                                                  IEventQueue* events);
 
@@ -0,0 +1,330 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/InputLog.h"
+
+#include "client/IInputBackend.h"
+
+#include <cstring>
+
+namespace {
+
+static const char kMagic[4] = { 'W', 'V', 'I', 'L' };
+static const UInt8 kVersion = 1;
+
+static const size_t kNumArgs[InputLogRecord::kNumTypes] = {
+    2,  // kEnter
+    0,  // kLeave
+    3,  // kKeyDown
+    4,  // kKeyRepeat
+    3,  // kKeyUp
+    1,  // kMouseDown
+    1,  // kMouseUp
+    2,  // kMouseMove
+    2,  // kMouseRelativeMove
+    2,  // kMouseWheel
+    0   // kFlush
+};
+
+static const char* const kNames[InputLogRecord::kNumTypes] = {
+    "enter",
+    "leave",
+    "keyDown",
+    "keyRepeat",
+    "keyUp",
+    "mouseDown",
+    "mouseUp",
+    "mouseMove",
+    "mouseRelativeMove",
+    "mouseWheel",
+    "flush"
+};
+
+// arguments are mostly small and often negative so they're zigzag
+// encoded before going into a varint
+static uint64_t zigzag(SInt32 value)
+{
+    return (static_cast<uint64_t>(static_cast<UInt32>(value)) << 1) ^
+           static_cast<uint64_t>(static_cast<int64_t>(value >> 31));
+}
+
+static SInt32 unzigzag(uint64_t value)
+{
+    return static_cast<SInt32>(static_cast<UInt32>(value >> 1) ^ -static_cast<UInt32>(value & 1));
+}
+
+} // namespace
+
+//
+// InputLogRecord
+//
+
+size_t
+InputLogRecord::getNumArgs(UInt8 type)
+{
+    return type < kNumTypes ? kNumArgs[type] : 0;
+}
+
+const char*
+InputLogRecord::getName(UInt8 type)
+{
+    return type < kNumTypes ? kNames[type] : "unknown";
+}
+
+void
+InputLogRecord::dispatch(IInputBackend& backend) const
+{
+    switch (m_type) {
+    case kEnter:
+        backend.enter(m_arg[0], m_arg[1]);
+        break;
+
+    case kLeave:
+        backend.leave();
+        break;
+
+    case kKeyDown:
+        backend.keyDown(static_cast<KeyID>(m_arg[0]), static_cast<KeyModifierMask>(m_arg[1]),
+                        static_cast<KeyButton>(m_arg[2]));
+        break;
+
+    case kKeyRepeat:
+        backend.keyRepeat(static_cast<KeyID>(m_arg[0]), static_cast<KeyModifierMask>(m_arg[1]),
+                          m_arg[2], static_cast<KeyButton>(m_arg[3]));
+        break;
+
+    case kKeyUp:
+        backend.keyUp(static_cast<KeyID>(m_arg[0]), static_cast<KeyModifierMask>(m_arg[1]),
+                      static_cast<KeyButton>(m_arg[2]));
+        break;
+
+    case kMouseDown:
+        backend.mouseDown(static_cast<ButtonID>(m_arg[0]));
+        break;
+
+    case kMouseUp:
+        backend.mouseUp(static_cast<ButtonID>(m_arg[0]));
+        break;
+
+    case kMouseMove:
+        backend.mouseMove(m_arg[0], m_arg[1]);
+        break;
+
+    case kMouseRelativeMove:
+        backend.mouseRelativeMove(m_arg[0], m_arg[1]);
+        break;
+
+    case kMouseWheel:
+        backend.mouseWheel(m_arg[0], m_arg[1]);
+        break;
+
+    case kFlush:
+        backend.flush();
+        break;
+    }
+}
+
+//
+// InputLogWriter
+//
+
+InputLogWriter::InputLogWriter() :
+    m_file(NULL),
+    m_lastTime(0)
+{
+}
+
+InputLogWriter::~InputLogWriter()
+{
+    close();
+}
+
+bool
+InputLogWriter::open(const String& path)
+{
+    close();
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == NULL) {
+        return false;
+    }
+    fwrite(kMagic, 1, sizeof(kMagic), m_file);
+    fputc(kVersion, m_file);
+    m_start = std::chrono::steady_clock::now();
+    m_lastTime = 0;
+    return true;
+}
+
+void
+InputLogWriter::close()
+{
+    if (m_file != NULL) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+}
+
+bool
+InputLogWriter::isOpen() const
+{
+    return m_file != NULL;
+}
+
+void
+InputLogWriter::write(InputLogRecord record)
+{
+    if (m_file == NULL || record.m_type >= InputLogRecord::kNumTypes) {
+        return;
+    }
+    if (record.m_time == 0) {
+        record.m_time = now();
+    }
+
+    // times only go forward so the delta is never negative
+    if (record.m_time < m_lastTime) {
+        record.m_time = m_lastTime;
+    }
+
+    fputc(record.m_type, m_file);
+    writeVarint(record.m_time - m_lastTime);
+    for (size_t i = 0; i < InputLogRecord::getNumArgs(record.m_type); ++i) {
+        writeVarint(zigzag(record.m_arg[i]));
+    }
+    m_lastTime = record.m_time;
+}
+
+void
+InputLogWriter::flush()
+{
+    if (m_file != NULL) {
+        fflush(m_file);
+    }
+}
+
+uint64_t
+InputLogWriter::now() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_start).count());
+}
+
+void
+InputLogWriter::writeVarint(uint64_t value)
+{
+    UInt8 buffer[10];
+    size_t n = 0;
+    do {
+        buffer[n] = static_cast<UInt8>(value & 0x7f);
+        value >>= 7;
+        if (value != 0) {
+            buffer[n] |= 0x80;
+        }
+        ++n;
+    } while (value != 0);
+    fwrite(buffer, 1, n, m_file);
+}
+
+//
+// InputLogReader
+//
+
+InputLogReader::InputLogReader() :
+    m_file(NULL),
+    m_time(0)
+{
+}
+
+InputLogReader::~InputLogReader()
+{
+    close();
+}
+
+bool
+InputLogReader::open(const String& path)
+{
+    close();
+    m_file = fopen(path.c_str(), "rb");
+    if (m_file == NULL) {
+        return false;
+    }
+
+    char magic[sizeof(kMagic)];
+    if (fread(magic, 1, sizeof(magic), m_file) != sizeof(magic) ||
+            memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            fgetc(m_file) != kVersion) {
+        close();
+        return false;
+    }
+    m_time = 0;
+    return true;
+}
+
+void
+InputLogReader::close()
+{
+    if (m_file != NULL) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+}
+
+bool
+InputLogReader::read(InputLogRecord& record)
+{
+    if (m_file == NULL) {
+        return false;
+    }
+
+    int type = fgetc(m_file);
+    if (type == EOF || type >= InputLogRecord::kNumTypes) {
+        return false;
+    }
+
+    uint64_t delta;
+    if (!readVarint(delta)) {
+        return false;
+    }
+    m_time += delta;
+
+    record.m_type = static_cast<UInt8>(type);
+    record.m_time = m_time;
+    memset(record.m_arg, 0, sizeof(record.m_arg));
+    for (size_t i = 0; i < InputLogRecord::getNumArgs(record.m_type); ++i) {
+        uint64_t value;
+        if (!readVarint(value)) {
+            return false;
+        }
+        record.m_arg[i] = unzigzag(value);
+    }
+    return true;
+}
+
+bool
+InputLogReader::readVarint(uint64_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(m_file);
+        if (c == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
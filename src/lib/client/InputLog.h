@@ -0,0 +1,117 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/key_types.h"
+#include "barrier/mouse_types.h"
+#include "base/String.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+class IInputBackend;
+
+//! A call made on an IInputBackend
+struct InputLogRecord {
+    enum Type {
+        kEnter,
+        kLeave,
+        kKeyDown,
+        kKeyRepeat,
+        kKeyUp,
+        kMouseDown,
+        kMouseUp,
+        kMouseMove,
+        kMouseRelativeMove,
+        kMouseWheel,
+        kFlush,
+        kNumTypes
+    };
+
+    //! Microseconds since the log was started, on a monotonic clock
+    uint64_t m_time;
+    UInt8 m_type;
+    SInt32 m_arg[4];
+
+    //! Number of arguments a record of \p type has
+    static size_t getNumArgs(UInt8 type);
+
+    //! Short name of \p type, for reports
+    static const char* getName(UInt8 type);
+
+    //! Makes the matching call on \p backend
+    void dispatch(IInputBackend& backend) const;
+};
+
+//! Writes an input log
+/*!
+The log starts with a magic number and a version.  Each record is its
+type byte followed by the time since the previous record and then its
+arguments, all as variable length integers, so a motion event usually
+takes 4 or 5 bytes.
+*/
+class InputLogWriter {
+public:
+    InputLogWriter();
+    ~InputLogWriter();
+
+    //! Creates or truncates \p path.  Returns false on error.
+    bool open(const String& path);
+    void close();
+    bool isOpen() const;
+
+    //! Appends \p record, taking its time from the clock if it's 0
+    void write(InputLogRecord record);
+
+    //! Hands what's buffered to the OS
+    void flush();
+
+    //! Microseconds since the log was opened
+    uint64_t now() const;
+
+private:
+    void writeVarint(uint64_t value);
+
+private:
+    FILE* m_file;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_lastTime;
+};
+
+//! Reads an input log
+class InputLogReader {
+public:
+    InputLogReader();
+    ~InputLogReader();
+
+    //! Opens \p path and checks its header.  Returns false on error.
+    bool open(const String& path);
+    void close();
+
+    //! Reads the next record.  Returns false at the end of the log or
+    //! if it's truncated or damaged.
+    bool read(InputLogRecord& record);
+
+private:
+    bool readVarint(uint64_t& value);
+
+private:
+    FILE* m_file;
+    uint64_t m_time;
+};
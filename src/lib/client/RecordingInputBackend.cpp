@@ -0,0 +1,136 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/RecordingInputBackend.h"
+
+#include <cassert>
+
+RecordingInputBackend::RecordingInputBackend(std::unique_ptr<IInputBackend> backend,
+                                             std::unique_ptr<InputLogWriter> log) :
+    m_backend(std::move(backend)),
+    m_log(std::move(log))
+{
+    assert(m_backend);
+    assert(m_log && m_log->isOpen());
+}
+
+RecordingInputBackend::~RecordingInputBackend()
+{
+    m_log->close();
+}
+
+void
+RecordingInputBackend::enter(SInt32 xAbs, SInt32 yAbs)
+{
+    record(InputLogRecord::kEnter, xAbs, yAbs);
+    m_backend->enter(xAbs, yAbs);
+}
+
+void
+RecordingInputBackend::leave()
+{
+    record(InputLogRecord::kLeave);
+    m_backend->leave();
+
+    // nothing is lost if the client is killed while on another screen
+    m_log->flush();
+}
+
+void
+RecordingInputBackend::keyDown(KeyID id, KeyModifierMask mask, KeyButton button)
+{
+    record(InputLogRecord::kKeyDown, static_cast<SInt32>(id), static_cast<SInt32>(mask), button);
+    m_backend->keyDown(id, mask, button);
+}
+
+void
+RecordingInputBackend::keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton button)
+{
+    record(InputLogRecord::kKeyRepeat, static_cast<SInt32>(id), static_cast<SInt32>(mask),
+           count, button);
+    m_backend->keyRepeat(id, mask, count, button);
+}
+
+void
+RecordingInputBackend::keyUp(KeyID id, KeyModifierMask mask, KeyButton button)
+{
+    record(InputLogRecord::kKeyUp, static_cast<SInt32>(id), static_cast<SInt32>(mask), button);
+    m_backend->keyUp(id, mask, button);
+}
+
+void
+RecordingInputBackend::mouseDown(ButtonID id)
+{
+    record(InputLogRecord::kMouseDown, id);
+    m_backend->mouseDown(id);
+}
+
+void
+RecordingInputBackend::mouseUp(ButtonID id)
+{
+    record(InputLogRecord::kMouseUp, id);
+    m_backend->mouseUp(id);
+}
+
+void
+RecordingInputBackend::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+    record(InputLogRecord::kMouseMove, xAbs, yAbs);
+    m_backend->mouseMove(xAbs, yAbs);
+}
+
+void
+RecordingInputBackend::mouseRelativeMove(SInt32 dx, SInt32 dy)
+{
+    record(InputLogRecord::kMouseRelativeMove, dx, dy);
+    m_backend->mouseRelativeMove(dx, dy);
+}
+
+void
+RecordingInputBackend::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+    record(InputLogRecord::kMouseWheel, xDelta, yDelta);
+    m_backend->mouseWheel(xDelta, yDelta);
+}
+
+void
+RecordingInputBackend::flush()
+{
+    record(InputLogRecord::kFlush);
+    m_backend->flush();
+}
+
+bool
+RecordingInputBackend::isThreadSafe() const
+{
+    // the log is only ever written by one caller at a time
+    return m_backend->isThreadSafe();
+}
+
+void
+RecordingInputBackend::record(InputLogRecord::Type type, SInt32 a0, SInt32 a1,
+                              SInt32 a2, SInt32 a3)
+{
+    InputLogRecord record;
+    record.m_time = 0;
+    record.m_type = static_cast<UInt8>(type);
+    record.m_arg[0] = a0;
+    record.m_arg[1] = a1;
+    record.m_arg[2] = a2;
+    record.m_arg[3] = a3;
+    m_log->write(record);
+}
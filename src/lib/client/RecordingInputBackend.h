@@ -0,0 +1,58 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "client/IInputBackend.h"
+#include "client/InputLog.h"
+
+#include <memory>
+
+//! Records input on its way to another backend
+/*!
+Every call is appended to an InputLogWriter with the time it was made
+and then passed on unchanged, so a session can be replayed later with
+the same timing.
+*/
+class RecordingInputBackend : public IInputBackend {
+public:
+    //! Records into \p log, which must be open, and forwards to \p backend
+    RecordingInputBackend(std::unique_ptr<IInputBackend> backend,
+                          std::unique_ptr<InputLogWriter> log);
+    ~RecordingInputBackend() override;
+
+    void enter(SInt32 xAbs, SInt32 yAbs) override;
+    void leave() override;
+    void keyDown(KeyID id, KeyModifierMask mask, KeyButton button) override;
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton button) override;
+    void keyUp(KeyID id, KeyModifierMask mask, KeyButton button) override;
+    void mouseDown(ButtonID id) override;
+    void mouseUp(ButtonID id) override;
+    void mouseMove(SInt32 xAbs, SInt32 yAbs) override;
+    void mouseRelativeMove(SInt32 dx, SInt32 dy) override;
+    void mouseWheel(SInt32 xDelta, SInt32 yDelta) override;
+    void flush() override;
+    bool isThreadSafe() const override;
+
+private:
+    void record(InputLogRecord::Type type, SInt32 a0 = 0, SInt32 a1 = 0,
+                SInt32 a2 = 0, SInt32 a3 = 0);
+
+private:
+    std::unique_ptr<IInputBackend> m_backend;
+    std::unique_ptr<InputLogWriter> m_log;
+};
@@ -19,6 +19,7 @@
 #include "client/ServerProxy.h"
 
 #include "client/Client.h"
+#include "client/DirectInputDispatcher.h"
 #include "barrier/FileChunk.h"
 #include "barrier/ClipboardChunk.h"
 #include "barrier/StreamChunker.h"
@@ -76,7 +77,8 @@ ServerProxy::ServerProxy(Client* client, barrier::IStream* stream, IEventQueue*
     m_keepAliveAlarm(0.0),
     m_keepAliveAlarmTimer(NULL),
     m_parser(&ServerProxy::parseHandshakeMessage),
-    m_events(events)
+    m_events(events),
+    m_directInput(NULL)
 {
     assert(m_client != NULL);
     assert(m_stream != NULL);
@@ -102,12 +104,26 @@ ServerProxy::ServerProxy(Client* client, barrier::IStream* stream, IEventQueue*
 
 ServerProxy::~ServerProxy()
 {
+    setDirectInput(NULL);
     setKeepAliveRate(-1.0);
     m_events->removeHandler(m_events->forIStream().inputReady(),
                             m_stream->getEventTarget());
     m_events->removeHandler(m_events->forClipboard().clipboardSending(), this);
 }
 
+void
+ServerProxy::setDirectInput(DirectInputDispatcher* dispatcher)
+{
+    if (m_directInput != NULL) {
+        m_directInput->setModifierTranslation(NULL);
+    }
+    m_directInput = dispatcher;
+    if (m_directInput != NULL) {
+        m_directInput->setModifierTranslation(m_modifierTranslationTable);
+        m_directInput->setHeld(m_ignoreMouse);
+    }
+}
+
 void
 ServerProxy::resetKeepAliveAlarm()
 {
@@ -137,8 +153,11 @@ ServerProxy::handleData(const Event&, void*)
 {
     // handle messages until there are no more.  first read message code.
     UInt8 code[4];
+    UInt32 count = 0;
     UInt32 n = m_stream->read(code, 4);
     while (n != 0) {
+        ++count;
+
         // verify we got an entire code
         if (n != 4) {
             LOG((CLOG_ERR "incomplete message from server: %d bytes", n));
@@ -176,6 +195,12 @@ ServerProxy::handleData(const Event&, void*)
     }
 
     flushCompressedMouse();
+    m_client->flushInput();
+
+    // input that arrives from now on can skip the queue
+    if (m_directInput != NULL) {
+        m_directInput->processed(count);
+    }
 }
 
 ServerProxy::EResult
@@ -379,6 +404,9 @@ ServerProxy::onInfoChanged()
     // ignore mouse motion until we receive acknowledgment of our info
     // change message.
     m_ignoreMouse = true;
+    if (m_directInput != NULL) {
+        m_directInput->setHeld(true);
+    }
 
     // send info update
     queryInfo();
@@ -432,7 +460,7 @@ ServerProxy::sendInfo(const ClientInfo& info)
 }
 
 KeyID
-ServerProxy::translateKey(KeyID id) const
+ServerProxy::translateKey(const KeyModifierID* table, KeyID id)
 {
     static const KeyID s_translationTable[kKeyModifierIDLast][2] = {
         { kKeyNone,      kKeyNone },
@@ -504,7 +532,7 @@ ServerProxy::translateKey(KeyID id) const
     }
 
     if (id2 != kKeyModifierIDNull) {
-        return s_translationTable[m_modifierTranslationTable[id2]][side];
+        return s_translationTable[table[id2]][side];
     }
     else {
         return id;
@@ -512,7 +540,8 @@ ServerProxy::translateKey(KeyID id) const
 }
 
 KeyModifierMask
-ServerProxy::translateModifierMask(KeyModifierMask mask) const
+ServerProxy::translateModifierMask(const KeyModifierID* table,
+                                    KeyModifierMask mask)
 {
     static const KeyModifierMask s_masks[kKeyModifierIDLast] = {
         0x0000,
@@ -531,22 +560,22 @@ ServerProxy::translateModifierMask(KeyModifierMask mask) const
                                         KeyModifierSuper |
                                         KeyModifierAltGr );
     if ((mask & KeyModifierShift) != 0) {
-        newMask |= s_masks[m_modifierTranslationTable[kKeyModifierIDShift]];
+        newMask |= s_masks[table[kKeyModifierIDShift]];
     }
     if ((mask & KeyModifierControl) != 0) {
-        newMask |= s_masks[m_modifierTranslationTable[kKeyModifierIDControl]];
+        newMask |= s_masks[table[kKeyModifierIDControl]];
     }
     if ((mask & KeyModifierAlt) != 0) {
-        newMask |= s_masks[m_modifierTranslationTable[kKeyModifierIDAlt]];
+        newMask |= s_masks[table[kKeyModifierIDAlt]];
     }
     if ((mask & KeyModifierAltGr) != 0) {
-        newMask |= s_masks[m_modifierTranslationTable[kKeyModifierIDAltGr]];
+        newMask |= s_masks[table[kKeyModifierIDAltGr]];
     }
     if ((mask & KeyModifierMeta) != 0) {
-        newMask |= s_masks[m_modifierTranslationTable[kKeyModifierIDMeta]];
+        newMask |= s_masks[table[kKeyModifierIDMeta]];
     }
     if ((mask & KeyModifierSuper) != 0) {
-        newMask |= s_masks[m_modifierTranslationTable[kKeyModifierIDSuper]];
+        newMask |= s_masks[table[kKeyModifierIDSuper]];
     }
     return newMask;
 }
@@ -641,8 +670,9 @@ ServerProxy::keyDown()
     LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
     // translate
-    KeyID id2             = translateKey(static_cast<KeyID>(id));
-    KeyModifierMask mask2 = translateModifierMask(
+    KeyID id2             = translateKey(m_modifierTranslationTable,
+                                static_cast<KeyID>(id));
+    KeyModifierMask mask2 = translateModifierMask(m_modifierTranslationTable,
                                 static_cast<KeyModifierMask>(mask));
     if (id2   != static_cast<KeyID>(id) ||
         mask2 != static_cast<KeyModifierMask>(mask))
@@ -665,8 +695,9 @@ ServerProxy::keyRepeat()
     LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
 
     // translate
-    KeyID id2             = translateKey(static_cast<KeyID>(id));
-    KeyModifierMask mask2 = translateModifierMask(
+    KeyID id2             = translateKey(m_modifierTranslationTable,
+                                static_cast<KeyID>(id));
+    KeyModifierMask mask2 = translateModifierMask(m_modifierTranslationTable,
                                 static_cast<KeyModifierMask>(mask));
     if (id2   != static_cast<KeyID>(id) ||
         mask2 != static_cast<KeyModifierMask>(mask))
@@ -688,8 +719,9 @@ ServerProxy::keyUp()
     LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
     // translate
-    KeyID id2             = translateKey(static_cast<KeyID>(id));
-    KeyModifierMask mask2 = translateModifierMask(
+    KeyID id2             = translateKey(m_modifierTranslationTable,
+                                static_cast<KeyID>(id));
+    KeyModifierMask mask2 = translateModifierMask(m_modifierTranslationTable,
                                 static_cast<KeyModifierMask>(mask));
     if (id2   != static_cast<KeyID>(id) ||
         mask2 != static_cast<KeyModifierMask>(mask))
@@ -896,6 +928,9 @@ ServerProxy::infoAcknowledgment()
 {
     LOG((CLOG_DEBUG1 "recv info acknowledgment"));
     m_ignoreMouse = false;
+    if (m_directInput != NULL) {
+        m_directInput->setHeld(false);
+    }
 }
 
 void
@@ -946,3 +981,10 @@ ServerProxy::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
     std::string data(info, size);
     ProtocolUtil::writef(m_stream, kMsgDDragInfo, fileCount, &data);
 }
+
+void
+ServerProxy::sendLockState(KeyModifierMask mask)
+{
+    LOG((CLOG_DEBUG1 "sending lock state 0x%04x", mask));
+    ProtocolUtil::writef(m_stream, kMsgDLockState, mask);
+}
@@ -25,6 +25,7 @@
 
 class Client;
 class ClientInfo;
+class DirectInputDispatcher;
 class EventQueueTimer;
 class IClipboard;
 namespace barrier { class IStream; }
@@ -51,6 +52,33 @@ public:
     bool                onGrabClipboard(ClipboardID);
     void                onClipboardChanged(ClipboardID, const IClipboard*);
 
+    //! Share input with a direct dispatcher
+    /*!
+    Lets \p dispatcher inject input on the socket's thread while this
+    proxy has nothing from the server left to handle.  The dispatcher
+    must outlive this proxy.
+    */
+    void                setDirectInput(DirectInputDispatcher* dispatcher);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Translate modifier key
+    /*!
+    Returns the key that \p id becomes with the modifier translation
+    \p table, which has an entry for every KeyModifierID, as set by the
+    server's options.
+    */
+    static KeyID        translateKey(const KeyModifierID* table, KeyID id);
+
+    //! Translate modifier mask
+    /*!
+    Returns \p mask with its modifiers translated by \p table.
+    */
+    static KeyModifierMask    translateModifierMask(const KeyModifierID* table,
+                            KeyModifierMask mask);
+
     //@}
 
     // sending file chunk to server
@@ -59,6 +87,9 @@ public:
     // sending dragging information to server
     void                sendDragInfo(UInt32 fileCount, const char* info, size_t size);
 
+    // sending the lock keys that are on to server
+    void                sendLockState(KeyModifierMask mask);
+
 #ifdef BARRIER_TEST_ENV
     void                handleDataForTest() { handleData(Event(), NULL); }
 #endif
@@ -77,10 +108,6 @@ private:
     void                resetKeepAliveAlarm();
     void                setKeepAliveRate(double);
 
-    // modifier key translation
-    KeyID                translateKey(KeyID) const;
-    KeyModifierMask            translateModifierMask(KeyModifierMask) const;
-
     // event handlers
     void                handleData(const Event&, void*);
     void                handleKeepAliveAlarm(const Event&, void*);
@@ -129,4 +156,5 @@ private:
 
     MessageParser        m_parser;
     IEventQueue*        m_events;
+    DirectInputDispatcher*    m_directInput;
 };
@@ -0,0 +1,132 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//! Lock-free single-producer single-consumer ring
+/*!
+A bounded FIFO that one thread pushes to and one other thread pops
+from without either of them taking a lock.  push() must only be called
+by the producer and front() and pop() only by the consumer.  size()
+and empty() may be called from either thread.
+*/
+template <class T>
+class SpscRing {
+public:
+    /*!
+    The capacity is rounded up to a power of two.
+    */
+    explicit SpscRing(size_t capacity) :
+        m_head(0),
+        m_tail(0)
+    {
+        size_t n = 1;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        m_slots.resize(n);
+        m_mask = n - 1;
+    }
+
+    //! @name manipulators
+    //@{
+
+    //! Add an item
+    /*!
+    Copies \c item to the back of the ring.  Returns false, without
+    waiting, if the ring is full.
+    */
+    bool                push(const T& item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_slots[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Get the oldest item
+    /*!
+    Returns the item at the front of the ring or NULL if it's empty.
+    The item stays valid until pop().
+    */
+    T*                    front()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return NULL;
+        }
+        return &m_slots[head & m_mask];
+    }
+
+    //! Remove the oldest item
+    /*!
+    Must only be called when front() returned an item.
+    */
+    void                pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_release);
+    }
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the number of queued items
+    size_t                size() const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    //! Test if empty
+    bool                empty() const
+    {
+        return size() == 0;
+    }
+
+    //! Get the most items the ring holds
+    size_t                capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    //@}
+
+private:
+    SpscRing(const SpscRing&);
+    SpscRing&            operator=(const SpscRing&);
+
+private:
+    std::vector<T>        m_slots;
+    size_t                m_mask;
+
+    // the producer and consumer indices are kept on separate cache
+    // lines so the two threads don't contend for one
+    char                m_pad0[64];
+    std::atomic<size_t>    m_head;
+    char                m_pad1[64];
+    std::atomic<size_t>    m_tail;
+    char                m_pad2[64];
+};
@@ -22,6 +22,7 @@
 #include "base/EventTypes.h"
 
 class IDataSocket;
+class SocketMultiplexerShards;
 
 //! Listen socket interface
 /*!
@@ -42,6 +43,15 @@ public:
     virtual IDataSocket*
                         accept() = 0;
 
+    //! Accept connection onto a shard
+    /*!
+    Like accept() but the returned socket is serviced by the multiplexer
+    that \p shards assigns to the peer.  If \p shards is NULL this is
+    the same as accept().
+    */
+    virtual IDataSocket*
+                        accept(SocketMultiplexerShards* shards) = 0;
+
     //@}
 
     // ISocket overrides
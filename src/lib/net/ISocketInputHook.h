@@ -0,0 +1,46 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/IInterface.h"
+#include "common/basic_types.h"
+
+class StreamBuffer;
+
+//! Socket input hook
+/*!
+A socket input hook sees the data a TCPSocket reads before it's buffered
+for \c read().  It's called on the socket multiplexer's thread with the
+socket locked so it must be quick and must not call back into the socket.
+*/
+class ISocketInputHook : public IInterface {
+public:
+    //! @name manipulators
+    //@{
+
+    //! Handle data read from the socket
+    /*!
+    Called with each chunk of \p n bytes read from the socket.  Whatever
+    the hook writes to \p input is buffered for \c read() as if it had
+    come straight from the socket;  the rest is consumed by the hook.
+    */
+    virtual void        onSocketInput(const UInt8* data, UInt32 n,
+                            StreamBuffer& input) = 0;
+
+    //@}
+};
@@ -35,11 +35,19 @@ SecureListenSocket::SecureListenSocket(IEventQueue* events, SocketMultiplexer* s
 
 IDataSocket*
 SecureListenSocket::accept()
+{
+    return accept(static_cast<SocketMultiplexerShards*>(NULL));
+}
+
+IDataSocket*
+SecureListenSocket::accept(SocketMultiplexerShards* shards)
 {
     SecureSocket* socket = NULL;
     try {
-        socket = new SecureSocket(m_events, m_socketMultiplexer,
-                                  ARCH->acceptSocket(m_socket, NULL), security_level_);
+        SocketMultiplexer* multiplexer;
+        ArchSocket accepted = acceptSocket(shards, multiplexer);
+        socket = new SecureSocket(m_events, multiplexer, accepted,
+                                  security_level_);
         socket->initSsl(true);
 
         if (socket != NULL) {
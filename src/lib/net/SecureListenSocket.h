@@ -34,6 +34,8 @@ public:
     // IListenSocket overrides
     virtual IDataSocket*
                         accept();
+    virtual IDataSocket*
+                        accept(SocketMultiplexerShards* shards);
 private:
     ConnectionSecurityLevel security_level_;
 };
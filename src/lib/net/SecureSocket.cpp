@@ -179,7 +179,7 @@ SecureSocket::doRead()
 
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, bytesRead);
+            bufferInput(buffer, bytesRead);
 
             if (m_inputBuffer.getSize() > MAX_INPUT_BUFFER_SIZE) {
                 break;
@@ -192,7 +192,7 @@ SecureSocket::doRead()
         } while (bytesRead > 0 || status > 0);
 
         // send input ready if input buffer was empty
-        if (wasEmpty) {
+        if (wasEmpty && m_inputBuffer.getSize() > 0) {
             sendEvent(m_events->forIStream().inputReady());
         }
     }
@@ -0,0 +1,77 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/SocketMultiplexerShards.h"
+
+#include "net/SocketMultiplexer.h"
+#include "arch/Arch.h"
+
+#include <cassert>
+#include <functional>
+#include <string>
+
+//
+// SocketMultiplexerShards
+//
+
+SocketMultiplexerShards::SocketMultiplexerShards(SocketMultiplexer* first,
+                size_t numShards, EAssignment assignment) :
+    m_first(first),
+    m_assignment(assignment),
+    m_next(0)
+{
+    assert(m_first != NULL);
+    assert(numShards > 0);
+
+    for (size_t i = 1; i < numShards; ++i) {
+        m_others.push_back(std::make_unique<SocketMultiplexer>());
+    }
+}
+
+SocketMultiplexerShards::~SocketMultiplexerShards()
+{
+    // nothing
+}
+
+SocketMultiplexer*
+SocketMultiplexerShards::assign(ArchNetAddress address)
+{
+    size_t index;
+    if (m_assignment == kByAddress && address != NULL) {
+        // leave out the port so reconnects from a host land together
+        index = std::hash<std::string>()(ARCH->addrToString(address)) %
+                    getNumShards();
+    }
+    else {
+        index  = m_next;
+        m_next = (m_next + 1) % getNumShards();
+    }
+    return getShard(index);
+}
+
+size_t
+SocketMultiplexerShards::getNumShards() const
+{
+    return m_others.size() + 1;
+}
+
+SocketMultiplexer*
+SocketMultiplexerShards::getShard(size_t index) const
+{
+    assert(index < getNumShards());
+    return index == 0 ? m_first : m_others[index - 1].get();
+}
@@ -0,0 +1,81 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "arch/IArchNetwork.h"
+#include "common/stdvector.h"
+
+#include <memory>
+
+class SocketMultiplexer;
+
+//! Socket multiplexer shards
+/*!
+Spreads accepted sockets over several socket multiplexers.  Each shard
+is a multiplexer of its own, so it has its own service thread, poll set
+and wakeup, and a connection that is slow to service only holds up the
+others on its shard.
+*/
+class SocketMultiplexerShards {
+public:
+    //! How sockets are assigned to shards
+    enum EAssignment {
+        kRoundRobin,    //!< Each socket goes to the next shard in turn
+        kByAddress        //!< Sockets from the same host share a shard
+    };
+
+    /*!
+    Uses \p first as the first shard and starts \p numShards - 1 more.
+    \p first is not adopted and must outlive this object.
+    */
+    SocketMultiplexerShards(SocketMultiplexer* first, size_t numShards,
+                            EAssignment assignment);
+    ~SocketMultiplexerShards();
+
+    //! @name manipulators
+    //@{
+
+    //! Assign a shard
+    /*!
+    Returns the multiplexer that should service a socket connected from
+    \p address, which may be NULL if the address isn't known.  Must
+    only be called from one thread.
+    */
+    SocketMultiplexer*    assign(ArchNetAddress address);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get number of shards
+    size_t                getNumShards() const;
+
+    //! Get shard
+    /*!
+    Returns shard \p index, which must be less than getNumShards().
+    */
+    SocketMultiplexer*    getShard(size_t index) const;
+
+    //@}
+
+private:
+    SocketMultiplexer*    m_first;
+    std::vector<std::unique_ptr<SocketMultiplexer>> m_others;
+    EAssignment            m_assignment;
+    size_t                m_next;
+};
@@ -20,6 +20,7 @@
 
 #include "net/NetworkAddress.h"
 #include "net/SocketMultiplexer.h"
+#include "net/SocketMultiplexerShards.h"
 #include "net/TCPSocket.h"
 #include "net/TSocketMultiplexerMethodJob.h"
 #include "net/XSocket.h"
@@ -110,10 +111,18 @@ TCPListenSocket::getEventTarget() const
 
 IDataSocket*
 TCPListenSocket::accept()
+{
+    return accept(static_cast<SocketMultiplexerShards*>(NULL));
+}
+
+IDataSocket*
+TCPListenSocket::accept(SocketMultiplexerShards* shards)
 {
     IDataSocket* socket = NULL;
     try {
-        socket = new TCPSocket(m_events, m_socketMultiplexer, ARCH->acceptSocket(m_socket, NULL));
+        SocketMultiplexer* multiplexer;
+        ArchSocket accepted = acceptSocket(shards, multiplexer);
+        socket = new TCPSocket(m_events, multiplexer, accepted);
         if (socket != NULL) {
             setListeningJob();
         }
@@ -135,6 +144,25 @@ TCPListenSocket::accept()
     }
 }
 
+ArchSocket
+TCPListenSocket::acceptSocket(SocketMultiplexerShards* shards,
+                SocketMultiplexer*& multiplexer)
+{
+    multiplexer = m_socketMultiplexer;
+    if (shards == NULL) {
+        return ARCH->acceptSocket(m_socket, NULL);
+    }
+
+    // the peer address picks the shard
+    ArchNetAddress address = NULL;
+    ArchSocket socket = ARCH->acceptSocket(m_socket, &address);
+    if (address != NULL) {
+        multiplexer = shards->assign(address);
+        ARCH->closeAddr(address);
+    }
+    return socket;
+}
+
 void
 TCPListenSocket::setListeningJob()
 {
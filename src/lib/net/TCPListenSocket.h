@@ -25,6 +25,7 @@
 class Mutex;
 class IEventQueue;
 class SocketMultiplexer;
+class SocketMultiplexerShards;
 
 //! TCP listen socket
 /*!
@@ -43,10 +44,20 @@ public:
     // IListenSocket overrides
     virtual IDataSocket*
                         accept();
+    virtual IDataSocket*
+                        accept(SocketMultiplexerShards* shards);
 
 protected:
     void                setListeningJob();
 
+    //! Accept a pending socket
+    /*!
+    Returns the accepted socket, or NULL if none is waiting, and sets
+    \p multiplexer to the multiplexer that should service it.
+    */
+    ArchSocket            acceptSocket(SocketMultiplexerShards* shards,
+                            SocketMultiplexer*& multiplexer);
+
 public:
     MultiplexerJobStatus serviceListening(ISocketMultiplexerJob*, bool, bool, bool);
 
@@ -18,6 +18,7 @@
 
 #include "net/TCPSocket.h"
 
+#include "net/ISocketInputHook.h"
 #include "net/NetworkAddress.h"
 #include "net/SocketMultiplexer.h"
 #include "net/TSocketMultiplexerMethodJob.h"
@@ -40,7 +41,8 @@ TCPSocket::TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer,
     m_events(events),
     m_mutex(),
     m_flushed(&m_mutex, true),
-    m_socketMultiplexer(socketMultiplexer)
+    m_socketMultiplexer(socketMultiplexer),
+    m_inputHook(NULL)
 {
     try {
         m_socket = ARCH->newSocket(family, IArchNetwork::kSTREAM);
@@ -60,7 +62,8 @@ TCPSocket::TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer,
     m_mutex(),
     m_socket(socket),
     m_flushed(&m_mutex, true),
-    m_socketMultiplexer(socketMultiplexer)
+    m_socketMultiplexer(socketMultiplexer),
+    m_inputHook(NULL)
 {
     assert(m_socket != NULL);
 
@@ -341,7 +344,7 @@ TCPSocket::doRead()
 
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, (UInt32)bytesRead);
+            bufferInput(buffer, (UInt32)bytesRead);
 
             if (m_inputBuffer.getSize() > MAX_INPUT_BUFFER_SIZE) {
                 break;
@@ -350,8 +353,9 @@ TCPSocket::doRead()
             bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
         } while (bytesRead > 0);
 
-        // send input ready if input buffer was empty
-        if (wasEmpty) {
+        // send input ready if input buffer was empty.  the input hook
+        // may have taken everything, leaving nothing to be read.
+        if (wasEmpty && m_inputBuffer.getSize() > 0) {
             sendEvent(m_events->forIStream().inputReady());
         }
     }
@@ -371,6 +375,26 @@ TCPSocket::doRead()
     return kRetry;
 }
 
+void
+TCPSocket::setInputHook(ISocketInputHook* hook)
+{
+    // reads happen with the mutex held so taking it waits for any call
+    // to the old hook to finish
+    Lock lock(&m_mutex);
+    m_inputHook = hook;
+}
+
+void
+TCPSocket::bufferInput(const UInt8* data, UInt32 n)
+{
+    if (m_inputHook != NULL) {
+        m_inputHook->onSocketInput(data, n, m_inputBuffer);
+    }
+    else {
+        m_inputBuffer.write(data, n);
+    }
+}
+
 TCPSocket::EJobResult
 TCPSocket::doWrite()
 {
@@ -29,6 +29,7 @@
 class Mutex;
 class Thread;
 class IEventQueue;
+class ISocketInputHook;
 class SocketMultiplexer;
 
 //! TCP data socket
@@ -62,6 +63,14 @@ public:
 
     virtual std::unique_ptr<ISocketMultiplexerJob> newJob();
 
+    //! Set input hook
+    /*!
+    Pass everything read from the socket through \p hook before it's
+    buffered.  The hook is not adopted.  Set it to NULL to stop using it;
+    once this returns the old hook is no longer being called.
+    */
+    void                setInputHook(ISocketInputHook* hook);
+
 protected:
     enum EJobResult {
         kBreak = -1,    //!< Break the Job chain
@@ -86,6 +95,9 @@ protected:
     void                sendEvent(Event::Type);
     void                discardWrittenData(int bytesWrote);
 
+    // buffer data read from the socket, through the input hook if set
+    void                bufferInput(const UInt8* data, UInt32 n);
+
 private:
     void                init();
 
@@ -111,4 +123,5 @@ private:
     ArchSocket            m_socket;
     CondVar<bool>        m_flushed;
     SocketMultiplexer*    m_socketMultiplexer;
+    ISocketInputHook*    m_inputHook;
 };
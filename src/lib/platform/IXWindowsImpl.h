@@ -178,6 +178,9 @@ public:
     virtual int XRefreshKeyboardMapping(XMappingEvent* event_map) = 0;
     virtual int XISelectEvents(Display* display, Window w, XIEventMask* masks,
                                int num_masks) = 0;
+    virtual XIDeviceInfo* XIQueryDevice(Display* display, int deviceid,
+                                        int* ndevices_return) = 0;
+    virtual void XIFreeDeviceInfo(XIDeviceInfo* info) = 0;
     virtual Atom XInternAtom(Display* display, _Xconst char* atom_name,
                              Bool only_if_exists) = 0;
     virtual int XGetScreenSaver(Display* display, int* timeout_return,
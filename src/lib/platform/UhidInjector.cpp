@@ -0,0 +1,513 @@
+#include "platform/UhidInjector.h"
+
+#include "platform/UhidServer.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "mt/Lock.h"
+#include "mt/Thread.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace {
+
+SInt32 addClamped(SInt32 a, SInt32 b)
+{
+    const int64_t sum = static_cast<int64_t>(a) + b;
+    return static_cast<SInt32>(std::max<int64_t>(std::numeric_limits<SInt32>::min(),
+                               std::min<int64_t>(std::numeric_limits<SInt32>::max(), sum)));
+}
+
+} // namespace
+
+const double UhidInjector::kFlushDelay = 0.005;
+const double UhidInjector::kServiceInterval = 0.1;
+const double UhidInjector::kStartTimeout = 3.0;
+
+UhidInjector::UhidInjector(UhidServer* server)
+    : m_server(server)
+    , m_ring(kQueueSize)
+    , m_thread(NULL)
+    , m_elevatePriority(false)
+    , m_stopping(false)
+    , m_sleeping(false)
+    , m_failed(false)
+    , m_peakDepth(0)
+    , m_dropped(0)
+    , m_overflowing(false)
+    , m_overflowSize(0)
+    , m_coalesced(0)
+    , m_unflushed(false)
+    , m_waitingForStart(false)
+    , m_lockState(0)
+{
+    m_wakePipe[0] = -1;
+    m_wakePipe[1] = -1;
+}
+
+UhidInjector::~UhidInjector()
+{
+    stop();
+}
+
+void UhidInjector::start(bool elevatePriority)
+{
+    if (m_thread != NULL) {
+        return;
+    }
+
+#if defined(__linux__)
+    if (pipe2(m_wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        fail(strerror(errno));
+        return;
+    }
+#else
+    fail("not supported on this platform");
+    return;
+#endif
+
+    m_elevatePriority = elevatePriority;
+    m_stopping = false;
+    m_thread = new Thread([this]() { injectThread(); });
+}
+
+void UhidInjector::stop()
+{
+    if (m_thread == NULL) {
+        return;
+    }
+
+    m_stopping = true;
+    wake();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = NULL;
+
+#if defined(__linux__)
+    close(m_wakePipe[0]);
+    close(m_wakePipe[1]);
+#endif
+    m_wakePipe[0] = -1;
+    m_wakePipe[1] = -1;
+
+    LOG((CLOG_DEBUG "uhid: injection queue peak depth %d, %d coalesced, %d dropped",
+        static_cast<int>(getPeakQueueDepth()), getNumCoalesced(), getNumDropped()));
+}
+
+void UhidInjector::setLockStateCallback(const LockStateCallback& callback)
+{
+    m_lockStateCallback = callback;
+}
+
+void UhidInjector::setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h)
+{
+    push(kScreenShape, x, y, w, h);
+}
+
+void UhidInjector::clearInputState()
+{
+    push(kClearInputState);
+}
+
+void UhidInjector::keyDown(KeyID id, KeyModifierMask mask)
+{
+    push(kKeyDown, static_cast<SInt32>(id), static_cast<SInt32>(mask));
+}
+
+void UhidInjector::keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count)
+{
+    push(kKeyRepeat, static_cast<SInt32>(id), static_cast<SInt32>(mask), count);
+}
+
+void UhidInjector::keyUp(KeyID id, KeyModifierMask mask)
+{
+    push(kKeyUp, static_cast<SInt32>(id), static_cast<SInt32>(mask));
+}
+
+void UhidInjector::mouseDown(ButtonID id)
+{
+    push(kMouseDown, id);
+}
+
+void UhidInjector::mouseUp(ButtonID id)
+{
+    push(kMouseUp, id);
+}
+
+void UhidInjector::mouseMoveAbsolute(SInt32 x, SInt32 y)
+{
+    push(kMouseMoveAbsolute, x, y);
+}
+
+void UhidInjector::mouseRelativeMove(SInt32 dx, SInt32 dy)
+{
+    push(kMouseRelativeMove, dx, dy);
+}
+
+void UhidInjector::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+    push(kMouseWheel, xDelta, yDelta);
+}
+
+void UhidInjector::flush()
+{
+    push(kFlush);
+}
+
+size_t UhidInjector::getQueueDepth() const
+{
+    return m_ring.size() + m_overflowSize.load(std::memory_order_acquire);
+}
+
+size_t UhidInjector::getPeakQueueDepth() const
+{
+    return m_peakDepth.load(std::memory_order_relaxed);
+}
+
+UInt32 UhidInjector::getNumCoalesced() const
+{
+    return m_coalesced.load(std::memory_order_relaxed);
+}
+
+UInt32 UhidInjector::getNumDropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+bool UhidInjector::failed() const
+{
+    return m_failed.load(std::memory_order_acquire);
+}
+
+void UhidInjector::push(RecordType type, SInt32 a0, SInt32 a1, SInt32 a2, SInt32 a3)
+{
+    Record record;
+    record.m_type = static_cast<UInt8>(type);
+    record.m_arg[0] = a0;
+    record.m_arg[1] = a1;
+    record.m_arg[2] = a2;
+    record.m_arg[3] = a3;
+
+    // never wait for the device.  if it's this far behind something is
+    // badly wrong, and losing motion beats stalling the connection, but
+    // anything that changes what's held down must still arrive.
+    if (m_overflowSize.load(std::memory_order_acquire) != 0 || !m_ring.push(record)) {
+        if (isDroppable(record) || failed()) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            if (!m_overflowing) {
+                LOG((CLOG_WARN "uhid: injection queue full, dropping motion"));
+                m_overflowing = true;
+            }
+            return;
+        }
+
+        Lock lock(&m_overflowMutex);
+        m_overflow.push_back(record);
+        m_overflowSize.store(m_overflow.size(), std::memory_order_release);
+    }
+    else {
+        m_overflowing = false;
+    }
+
+    const size_t depth = getQueueDepth();
+    if (depth > m_peakDepth.load(std::memory_order_relaxed)) {
+        m_peakDepth.store(depth, std::memory_order_relaxed);
+    }
+
+    // pairs with the fence in injectThread().  either the injection
+    // thread sees the new record before it sleeps or we see that it's
+    // sleeping and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed)) {
+        wake();
+    }
+}
+
+bool UhidInjector::isDroppable(const Record& record)
+{
+    switch (record.m_type) {
+    case kMouseMoveAbsolute:
+    case kMouseRelativeMove:
+    case kMouseWheel:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool UhidInjector::popOverflow(Record& record)
+{
+    if (m_overflowSize.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    Lock lock(&m_overflowMutex);
+    record = m_overflow.front();
+    m_overflow.pop_front();
+    m_overflowSize.store(m_overflow.size(), std::memory_order_release);
+    return true;
+}
+
+void UhidInjector::wake()
+{
+#if defined(__linux__)
+    // a full pipe already has a wake-up waiting
+    const char byte = 0;
+    ssize_t ignored = write(m_wakePipe[1], &byte, 1);
+    (void)ignored;
+#endif
+}
+
+void UhidInjector::injectThread()
+{
+#if defined(__linux__)
+    if (m_elevatePriority) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            LOG((CLOG_WARN "uhid: cannot raise injection thread priority (%s)", strerror(err)));
+        }
+        else {
+            LOG((CLOG_DEBUG "uhid: injection thread running with real-time priority"));
+        }
+    }
+#else
+    if (m_elevatePriority) {
+        LOG((CLOG_WARN "uhid: real-time injection priority is not supported"));
+    }
+#endif
+
+    m_server->setBuffered(true);
+    m_waitingForStart = !m_server->isStarted();
+    const double startDeadline = ARCH->time() + kStartTimeout;
+    double lastService = ARCH->time();
+    for (;;) {
+        // spilled records are newer than everything in the ring
+        Record record;
+        Record* next = m_ring.front();
+        if (next != NULL || popOverflow(record)) {
+            if (next != NULL) {
+                record = *next;
+                m_ring.pop();
+                coalesce(record);
+            }
+            inject(record);
+
+            // the kernel waits on replies to its requests so they're
+            // answered regularly even while input keeps coming
+            const double now = ARCH->time();
+            if (now - lastService >= kServiceInterval) {
+                if (!service()) {
+                    break;
+                }
+                lastService = now;
+            }
+            continue;
+        }
+
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (getQueueDepth() != 0) {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        if (m_stopping) {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            break;
+        }
+
+        // don't hold reports forever if a flush never comes, and don't
+        // wait forever for a device that never starts
+        double timeout = -1.0;
+        if (m_waitingForStart) {
+            timeout = std::max(0.0, startDeadline - ARCH->time());
+        }
+        else if (m_unflushed) {
+            timeout = kFlushDelay;
+        }
+
+        bool deviceReady = false;
+        const bool ok = waitForWork(timeout, deviceReady);
+        m_sleeping.store(false, std::memory_order_relaxed);
+        if (!ok) {
+            fail(strerror(errno));
+            break;
+        }
+
+        if (deviceReady) {
+            if (!service()) {
+                break;
+            }
+            lastService = ARCH->time();
+        }
+
+        if (m_waitingForStart) {
+            if (ARCH->time() >= startDeadline) {
+                fail("timed out waiting for the kernel to start the device");
+                break;
+            }
+        }
+        else if (m_unflushed && getQueueDepth() == 0) {
+            m_server->flush();
+            m_unflushed = false;
+        }
+    }
+    m_server->setBuffered(false);
+    m_unflushed = false;
+}
+
+bool UhidInjector::waitForWork(double timeout, bool& deviceReady)
+{
+#if defined(__linux__)
+    struct pollfd pfd[2];
+    pfd[0].fd = m_wakePipe[0];
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd = m_server->getFd();
+    pfd[1].events = POLLIN;
+    pfd[1].revents = 0;
+
+    const int timeoutMs = (timeout < 0.0) ? -1 : static_cast<int>(timeout * 1000.0 + 0.5);
+    int ret = poll(pfd, 2, timeoutMs);
+    if (ret < 0) {
+        return (errno == EINTR);
+    }
+
+    if ((pfd[0].revents & POLLIN) != 0) {
+        char buffer[64];
+        while (read(m_wakePipe[0], buffer, sizeof(buffer)) > 0) {
+            // discard
+        }
+    }
+    deviceReady = (pfd[1].revents != 0);
+    return true;
+#else
+    (void)timeout;
+    deviceReady = false;
+    return false;
+#endif
+}
+
+bool UhidInjector::service()
+{
+    if (!m_server->processEvents()) {
+        fail("device failed");
+        return false;
+    }
+
+    // reports held while the device was starting go out now
+    if (m_waitingForStart && m_server->isStarted()) {
+        m_waitingForStart = false;
+        m_server->flush();
+        m_unflushed = false;
+    }
+
+    const KeyModifierMask lockState = m_server->getLockState();
+    if (lockState != m_lockState) {
+        m_lockState = lockState;
+        if (m_lockStateCallback) {
+            m_lockStateCallback(lockState);
+        }
+    }
+    return true;
+}
+
+void UhidInjector::fail(const char* reason)
+{
+    LOG((CLOG_WARN "uhid: injection stopped, %s", reason));
+    m_server->stop();
+    m_failed.store(true, std::memory_order_release);
+}
+
+void UhidInjector::coalesce(Record& record)
+{
+    if (record.m_type != kMouseRelativeMove && record.m_type != kMouseMoveAbsolute) {
+        return;
+    }
+
+    // only records already waiting are merged so motion is never held
+    // back when the device keeps up
+    for (Record* next = m_ring.front(); next != NULL; next = m_ring.front()) {
+        if (next->m_type != record.m_type) {
+            break;
+        }
+
+        if (record.m_type == kMouseRelativeMove) {
+            record.m_arg[0] = addClamped(record.m_arg[0], next->m_arg[0]);
+            record.m_arg[1] = addClamped(record.m_arg[1], next->m_arg[1]);
+        }
+        else {
+            record.m_arg[0] = next->m_arg[0];
+            record.m_arg[1] = next->m_arg[1];
+        }
+        m_ring.pop();
+        m_coalesced.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void UhidInjector::inject(const Record& record)
+{
+    const SInt32* arg = record.m_arg;
+    switch (record.m_type) {
+    case kScreenShape:
+        m_server->setScreenShape(arg[0], arg[1], arg[2], arg[3]);
+        break;
+
+    case kClearInputState:
+        m_server->clearInputState();
+        break;
+
+    case kKeyDown:
+        m_server->keyDown(static_cast<KeyID>(arg[0]), static_cast<KeyModifierMask>(arg[1]));
+        break;
+
+    case kKeyRepeat:
+        m_server->keyRepeat(static_cast<KeyID>(arg[0]), static_cast<KeyModifierMask>(arg[1]), arg[2]);
+        break;
+
+    case kKeyUp:
+        m_server->keyUp(static_cast<KeyID>(arg[0]), static_cast<KeyModifierMask>(arg[1]));
+        break;
+
+    case kMouseDown:
+        m_server->mouseDown(static_cast<ButtonID>(arg[0]));
+        break;
+
+    case kMouseUp:
+        m_server->mouseUp(static_cast<ButtonID>(arg[0]));
+        break;
+
+    case kMouseMoveAbsolute:
+        m_server->mouseMoveAbsolute(arg[0], arg[1]);
+        break;
+
+    case kMouseRelativeMove:
+        m_server->mouseRelativeMove(arg[0], arg[1]);
+        break;
+
+    case kMouseWheel:
+        m_server->mouseWheel(arg[0], arg[1]);
+        break;
+
+    case kFlush:
+        m_server->flush();
+        m_unflushed = false;
+        return;
+    }
+    m_unflushed = true;
+}
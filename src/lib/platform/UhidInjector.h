@@ -0,0 +1,150 @@
+#pragma once
+
+#include "barrier/key_types.h"
+#include "barrier/mouse_types.h"
+#include "mt/Mutex.h"
+#include "mt/SpscRing.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+
+class Thread;
+class UhidServer;
+
+// feeds a UhidServer from its own thread so the caller never blocks on
+// the device.  calls are queued as compact records on a lock-free ring
+// and written by the injection thread.  while the ring is backed up,
+// consecutive pointer motion is merged into a single report.  reports
+// are held until flush() so a batch of input costs one write.  the
+// thread also waits on the device itself, so it finishes starting it and
+// answers the kernel's requests as they arrive.
+class UhidInjector {
+public:
+    static const size_t kQueueSize = 4096;
+
+    // how long reports wait for a flush() before they're written anyway
+    static const double kFlushDelay;
+
+    // longest the kernel's requests wait while input keeps coming
+    static const double kServiceInterval;
+
+    // how long the kernel has to start the device
+    static const double kStartTimeout;
+
+    // called on the injection thread when the host changes the lock LEDs
+    typedef std::function<void(KeyModifierMask)> LockStateCallback;
+
+    // the server must be started and must outlive the injector
+    explicit UhidInjector(UhidServer* server);
+    ~UhidInjector();
+
+    // starts the injection thread, optionally with real-time scheduling
+    void start(bool elevatePriority);
+
+    // injects everything still queued and stops the thread
+    void stop();
+
+    void setLockStateCallback(const LockStateCallback& callback);
+
+    // these queue the matching UhidServer call.  they may only be called
+    // from one thread.
+    void setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h);
+    void clearInputState();
+    void keyDown(KeyID id, KeyModifierMask mask);
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count);
+    void keyUp(KeyID id, KeyModifierMask mask);
+    void mouseDown(ButtonID id);
+    void mouseUp(ButtonID id);
+    void mouseMoveAbsolute(SInt32 x, SInt32 y);
+    void mouseRelativeMove(SInt32 dx, SInt32 dy);
+    void mouseWheel(SInt32 xDelta, SInt32 yDelta);
+
+    // writes the reports for everything queued so far
+    void flush();
+
+    // records waiting for the injection thread
+    size_t getQueueDepth() const;
+
+    // deepest the queue has been
+    size_t getPeakQueueDepth() const;
+
+    // motion records merged into a preceding one
+    UInt32 getNumCoalesced() const;
+
+    // motion and wheel records discarded because the queue was full
+    UInt32 getNumDropped() const;
+
+    // true if the device never started or has failed.  the server has
+    // been stopped and nothing more is injected.
+    bool failed() const;
+
+private:
+    enum RecordType {
+        kScreenShape,
+        kClearInputState,
+        kKeyDown,
+        kKeyRepeat,
+        kKeyUp,
+        kMouseDown,
+        kMouseUp,
+        kMouseMoveAbsolute,
+        kMouseRelativeMove,
+        kMouseWheel,
+        kFlush
+    };
+
+    struct Record {
+        UInt8 m_type;
+        SInt32 m_arg[4];
+    };
+
+    void push(RecordType type, SInt32 a0 = 0, SInt32 a1 = 0, SInt32 a2 = 0, SInt32 a3 = 0);
+    // true if the record can be lost without leaving input stuck
+    static bool isDroppable(const Record& record);
+    // takes the oldest spilled record.  returns false if there's none.
+    bool popOverflow(Record& record);
+    void wake();
+    void injectThread();
+
+    // waits up to timeout seconds, or forever if negative, for a wake()
+    // or the device.  returns false on error.
+    bool waitForWork(double timeout, bool& deviceReady);
+
+    // handles the device's events.  returns false if it failed.
+    bool service();
+    void fail(const char* reason);
+    void inject(const Record& record);
+
+    // merges the records queued behind a motion record into it
+    void coalesce(Record& record);
+
+private:
+    UhidServer* m_server;
+    SpscRing<Record> m_ring;
+    Thread* m_thread;
+    bool m_elevatePriority;
+
+    // written to wake the injection thread
+    int m_wakePipe[2];
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_sleeping;
+    std::atomic<bool> m_failed;
+
+    // written by the producer
+    std::atomic<size_t> m_peakDepth;
+    std::atomic<UInt32> m_dropped;
+    bool m_overflowing;
+    // records that didn't fit in the ring.  while any are here every
+    // record goes here, after the ring, so the order is kept.
+    Mutex m_overflowMutex;
+    std::deque<Record> m_overflow;
+    std::atomic<size_t> m_overflowSize;
+
+    // written by the injection thread
+    std::atomic<UInt32> m_coalesced;
+    bool m_unflushed;
+    bool m_waitingForStart;
+    KeyModifierMask m_lockState;
+    LockStateCallback m_lockStateCallback;
+};
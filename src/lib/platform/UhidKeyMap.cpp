@@ -0,0 +1,628 @@
+#include "platform/UhidKeyMap.h"
+
+#include <algorithm>
+
+#include <stdio.h>
+
+namespace {
+
+typedef UhidKeyMap::Entry Entry;
+
+const UInt8 kShift = UhidKeyMap::kLeftShift;
+
+constexpr Entry key(KeyID id, UInt8 usage, UInt8 modifiers = 0)
+{
+    return Entry{ id, UhidKeyMap::kKey, usage, modifiers, { 0, 0 } };
+}
+
+constexpr Entry modifier(KeyID id, UInt8 bit)
+{
+    return Entry{ id, UhidKeyMap::kModifier, 0, bit, { 0, 0 } };
+}
+
+constexpr Entry compose(KeyID id, char first, char second)
+{
+    return Entry{ id, UhidKeyMap::kCompose, 0, 0, { first, second } };
+}
+
+constexpr Entry kEntries[] = {
+    // ASCII
+    key(' ', 0x2c),
+    key('a', 0x04),
+    key('b', 0x05),
+    key('c', 0x06),
+    key('d', 0x07),
+    key('e', 0x08),
+    key('f', 0x09),
+    key('g', 0x0a),
+    key('h', 0x0b),
+    key('i', 0x0c),
+    key('j', 0x0d),
+    key('k', 0x0e),
+    key('l', 0x0f),
+    key('m', 0x10),
+    key('n', 0x11),
+    key('o', 0x12),
+    key('p', 0x13),
+    key('q', 0x14),
+    key('r', 0x15),
+    key('s', 0x16),
+    key('t', 0x17),
+    key('u', 0x18),
+    key('v', 0x19),
+    key('w', 0x1a),
+    key('x', 0x1b),
+    key('y', 0x1c),
+    key('z', 0x1d),
+    key('A', 0x04, kShift),
+    key('B', 0x05, kShift),
+    key('C', 0x06, kShift),
+    key('D', 0x07, kShift),
+    key('E', 0x08, kShift),
+    key('F', 0x09, kShift),
+    key('G', 0x0a, kShift),
+    key('H', 0x0b, kShift),
+    key('I', 0x0c, kShift),
+    key('J', 0x0d, kShift),
+    key('K', 0x0e, kShift),
+    key('L', 0x0f, kShift),
+    key('M', 0x10, kShift),
+    key('N', 0x11, kShift),
+    key('O', 0x12, kShift),
+    key('P', 0x13, kShift),
+    key('Q', 0x14, kShift),
+    key('R', 0x15, kShift),
+    key('S', 0x16, kShift),
+    key('T', 0x17, kShift),
+    key('U', 0x18, kShift),
+    key('V', 0x19, kShift),
+    key('W', 0x1a, kShift),
+    key('X', 0x1b, kShift),
+    key('Y', 0x1c, kShift),
+    key('Z', 0x1d, kShift),
+    key('1', 0x1e),
+    key('2', 0x1f),
+    key('3', 0x20),
+    key('4', 0x21),
+    key('5', 0x22),
+    key('6', 0x23),
+    key('7', 0x24),
+    key('8', 0x25),
+    key('9', 0x26),
+    key('0', 0x27),
+    key('!', 0x1e, kShift),
+    key('@', 0x1f, kShift),
+    key('#', 0x20, kShift),
+    key('$', 0x21, kShift),
+    key('%', 0x22, kShift),
+    key('^', 0x23, kShift),
+    key('&', 0x24, kShift),
+    key('*', 0x25, kShift),
+    key('(', 0x26, kShift),
+    key(')', 0x27, kShift),
+    key('-', 0x2d),
+    key('_', 0x2d, kShift),
+    key('=', 0x2e),
+    key('+', 0x2e, kShift),
+    key('[', 0x2f),
+    key('{', 0x2f, kShift),
+    key(']', 0x30),
+    key('}', 0x30, kShift),
+    key('\\', 0x31),
+    key('|', 0x31, kShift),
+    key(';', 0x33),
+    key(':', 0x33, kShift),
+    key('\'', 0x34),
+    key('"', 0x34, kShift),
+    key('`', 0x35),
+    key('~', 0x35, kShift),
+    key(',', 0x36),
+    key('<', 0x36, kShift),
+    key('.', 0x37),
+    key('>', 0x37, kShift),
+    key('/', 0x38),
+    key('?', 0x38, kShift),
+
+    // Latin-1, with the X11 Compose sequences of a US layout
+    compose(0x00a0, ' ', ' '),
+    compose(0x00a1, '!', '!'),
+    compose(0x00a2, '|', 'c'),
+    compose(0x00a3, '-', 'L'),
+    compose(0x00a4, 'o', 'x'),
+    compose(0x00a5, '=', 'Y'),
+    compose(0x00a6, '!', '^'),
+    compose(0x00a7, 's', 'o'),
+    compose(0x00a8, '"', '"'),
+    compose(0x00a9, 'o', 'c'),
+    compose(0x00ab, '<', '<'),
+    compose(0x00ac, ',', '-'),
+    compose(0x00ae, 'o', 'r'),
+    compose(0x00af, '^', '-'),
+    compose(0x00b0, 'o', 'o'),
+    compose(0x00b1, '+', '-'),
+    compose(0x00b2, '^', '2'),
+    compose(0x00b3, '^', '3'),
+    compose(0x00b4, '\'', '\''),
+    compose(0x00b5, 'm', 'u'),
+    compose(0x00b6, 'P', '!'),
+    compose(0x00b7, '^', '.'),
+    compose(0x00b9, '^', '1'),
+    compose(0x00bb, '>', '>'),
+    compose(0x00bc, '1', '4'),
+    compose(0x00bd, '1', '2'),
+    compose(0x00be, '3', '4'),
+    compose(0x00bf, '?', '?'),
+    compose(0x00c0, '`', 'A'),
+    compose(0x00c1, '\'', 'A'),
+    compose(0x00c2, '^', 'A'),
+    compose(0x00c3, '~', 'A'),
+    compose(0x00c4, '"', 'A'),
+    compose(0x00c5, 'o', 'A'),
+    compose(0x00c6, 'A', 'E'),
+    compose(0x00c7, ',', 'C'),
+    compose(0x00c8, '`', 'E'),
+    compose(0x00c9, '\'', 'E'),
+    compose(0x00ca, '^', 'E'),
+    compose(0x00cb, '"', 'E'),
+    compose(0x00cc, '`', 'I'),
+    compose(0x00cd, '\'', 'I'),
+    compose(0x00ce, '^', 'I'),
+    compose(0x00cf, '"', 'I'),
+    compose(0x00d0, 'D', 'H'),
+    compose(0x00d1, '~', 'N'),
+    compose(0x00d2, '`', 'O'),
+    compose(0x00d3, '\'', 'O'),
+    compose(0x00d4, '^', 'O'),
+    compose(0x00d5, '~', 'O'),
+    compose(0x00d6, '"', 'O'),
+    compose(0x00d7, 'x', 'x'),
+    compose(0x00d8, '/', 'O'),
+    compose(0x00d9, '`', 'U'),
+    compose(0x00da, '\'', 'U'),
+    compose(0x00db, '^', 'U'),
+    compose(0x00dc, '"', 'U'),
+    compose(0x00dd, '\'', 'Y'),
+    compose(0x00de, 'T', 'H'),
+    compose(0x00df, 's', 's'),
+    compose(0x00e0, '`', 'a'),
+    compose(0x00e1, '\'', 'a'),
+    compose(0x00e2, '^', 'a'),
+    compose(0x00e3, '~', 'a'),
+    compose(0x00e4, '"', 'a'),
+    compose(0x00e5, 'o', 'a'),
+    compose(0x00e6, 'a', 'e'),
+    compose(0x00e7, ',', 'c'),
+    compose(0x00e8, '`', 'e'),
+    compose(0x00e9, '\'', 'e'),
+    compose(0x00ea, '^', 'e'),
+    compose(0x00eb, '"', 'e'),
+    compose(0x00ec, '`', 'i'),
+    compose(0x00ed, '\'', 'i'),
+    compose(0x00ee, '^', 'i'),
+    compose(0x00ef, '"', 'i'),
+    compose(0x00f0, 'd', 'h'),
+    compose(0x00f1, '~', 'n'),
+    compose(0x00f2, '`', 'o'),
+    compose(0x00f3, '\'', 'o'),
+    compose(0x00f4, '^', 'o'),
+    compose(0x00f5, '~', 'o'),
+    compose(0x00f6, '"', 'o'),
+    compose(0x00f7, ':', '-'),
+    compose(0x00f8, '/', 'o'),
+    compose(0x00f9, '`', 'u'),
+    compose(0x00fa, '\'', 'u'),
+    compose(0x00fb, '^', 'u'),
+    compose(0x00fc, '"', 'u'),
+    compose(0x00fd, '\'', 'y'),
+    compose(0x00fe, 't', 'h'),
+    compose(0x00ff, '"', 'y'),
+
+    // special keys
+    key(kKeyBackSpace, 0x2a),
+    key(kKeyTab, 0x2b),
+    key(kKeyClear, 0x9c),
+    key(kKeyReturn, 0x28),
+    key(kKeyPause, 0x48),
+    key(kKeyScrollLock, 0x47),
+    key(kKeySysReq, 0x9a),
+    key(kKeyEscape, 0x29),
+    key(kKeyMuhenkan, 0x8b),
+    key(kKeyHenkan, 0x8a),
+    key(kKeyKana, 0x92),
+    key(kKeyHiraganaKatakana, 0x88),
+    key(kKeyZenkaku, 0x94),
+    key(kKeyHangul, 0x90),
+    key(kKeyHanja, 0x91),
+    key(kKeyDelete, 0x4c),
+    key(kKeyHome, 0x4a),
+    key(kKeyLeft, 0x50),
+    key(kKeyUp, 0x52),
+    key(kKeyRight, 0x4f),
+    key(kKeyDown, 0x51),
+    key(kKeyPageUp, 0x4b),
+    key(kKeyPageDown, 0x4e),
+    key(kKeyEnd, 0x4d),
+    key(kKeySelect, 0x77),
+    key(kKeyPrint, 0x46),
+    key(kKeyExecute, 0x74),
+    key(kKeyInsert, 0x49),
+    key(kKeyUndo, 0x7a),
+    key(kKeyRedo, 0x79),
+    key(kKeyMenu, 0x65),
+    key(kKeyFind, 0x7e),
+    key(kKeyCancel, 0x9b),
+    key(kKeyHelp, 0x75),
+    key(kKeyBreak, 0x48, UhidKeyMap::kLeftControl),
+    key(kKeyNumLock, 0x53),
+    key(kKeyCapsLock, 0x39),
+
+    // keypad
+    key(kKeyKP_Space, 0x2c),
+    key(kKeyKP_Tab, 0x2b),
+    key(kKeyKP_Enter, 0x58),
+    key(kKeyKP_Home, 0x5f),
+    key(kKeyKP_Left, 0x5c),
+    key(kKeyKP_Up, 0x60),
+    key(kKeyKP_Right, 0x5e),
+    key(kKeyKP_Down, 0x5a),
+    key(kKeyKP_PageUp, 0x61),
+    key(kKeyKP_PageDown, 0x5b),
+    key(kKeyKP_End, 0x59),
+    key(kKeyKP_Begin, 0x5d),
+    key(kKeyKP_Insert, 0x62),
+    key(kKeyKP_Delete, 0x63),
+    key(kKeyKP_Equal, 0x67),
+    key(kKeyKP_Multiply, 0x55),
+    key(kKeyKP_Add, 0x57),
+    key(kKeyKP_Separator, 0x85),
+    key(kKeyKP_Subtract, 0x56),
+    key(kKeyKP_Decimal, 0x63),
+    key(kKeyKP_Divide, 0x54),
+    key(kKeyKP_0, 0x62),
+    key(kKeyKP_1, 0x59),
+    key(kKeyKP_2, 0x5a),
+    key(kKeyKP_3, 0x5b),
+    key(kKeyKP_4, 0x5c),
+    key(kKeyKP_5, 0x5d),
+    key(kKeyKP_6, 0x5e),
+    key(kKeyKP_7, 0x5f),
+    key(kKeyKP_8, 0x60),
+    key(kKeyKP_9, 0x61),
+
+    // function keys
+    key(kKeyF1, 0x3a),
+    key(kKeyF2, 0x3b),
+    key(kKeyF3, 0x3c),
+    key(kKeyF4, 0x3d),
+    key(kKeyF5, 0x3e),
+    key(kKeyF6, 0x3f),
+    key(kKeyF7, 0x40),
+    key(kKeyF8, 0x41),
+    key(kKeyF9, 0x42),
+    key(kKeyF10, 0x43),
+    key(kKeyF11, 0x44),
+    key(kKeyF12, 0x45),
+    key(kKeyF13, 0x68),
+    key(kKeyF14, 0x69),
+    key(kKeyF15, 0x6a),
+    key(kKeyF16, 0x6b),
+    key(kKeyF17, 0x6c),
+    key(kKeyF18, 0x6d),
+    key(kKeyF19, 0x6e),
+    key(kKeyF20, 0x6f),
+    key(kKeyF21, 0x70),
+    key(kKeyF22, 0x71),
+    key(kKeyF23, 0x72),
+    key(kKeyF24, 0x73),
+
+    // modifiers
+    modifier(kKeyShift_L, UhidKeyMap::kLeftShift),
+    modifier(kKeyShift_R, UhidKeyMap::kRightShift),
+    modifier(kKeyControl_L, UhidKeyMap::kLeftControl),
+    modifier(kKeyControl_R, UhidKeyMap::kRightControl),
+    modifier(kKeyMeta_L, UhidKeyMap::kLeftGui),
+    modifier(kKeyMeta_R, UhidKeyMap::kRightGui),
+    modifier(kKeyAlt_L, UhidKeyMap::kLeftAlt),
+    modifier(kKeyAlt_R, UhidKeyMap::kRightAlt),
+    modifier(kKeySuper_L, UhidKeyMap::kLeftGui),
+    modifier(kKeySuper_R, UhidKeyMap::kRightGui),
+    modifier(kKeyAltGr, UhidKeyMap::kRightAlt),
+
+    // outside the dense ranges
+    key(kKeyLeftTab, 0x2b),
+    key(kKeyAudioMute, 0x7f),
+    key(kKeyAudioUp, 0x80),
+    key(kKeyAudioDown, 0x81),
+    key(kKeyCopy, 0x7c),
+    key(kKeyCut, 0x7b),
+    key(kKeyPaste, 0x7d),
+
+    // Latin Extended-A and symbols
+    compose(0x0100, '_', 'A'),
+    compose(0x0101, '_', 'a'),
+    compose(0x0102, 'U', 'A'),
+    compose(0x0103, 'U', 'a'),
+    compose(0x0104, ';', 'A'),
+    compose(0x0105, ';', 'a'),
+    compose(0x0106, '\'', 'C'),
+    compose(0x0107, '\'', 'c'),
+    compose(0x010c, 'c', 'C'),
+    compose(0x010d, 'c', 'c'),
+    compose(0x010e, 'c', 'D'),
+    compose(0x010f, 'c', 'd'),
+    compose(0x0110, '-', 'D'),
+    compose(0x0111, '-', 'd'),
+    compose(0x0112, '_', 'E'),
+    compose(0x0113, '_', 'e'),
+    compose(0x0116, '.', 'E'),
+    compose(0x0117, '.', 'e'),
+    compose(0x0118, ';', 'E'),
+    compose(0x0119, ';', 'e'),
+    compose(0x011a, 'c', 'E'),
+    compose(0x011b, 'c', 'e'),
+    compose(0x011e, 'U', 'G'),
+    compose(0x011f, 'U', 'g'),
+    compose(0x012a, '_', 'I'),
+    compose(0x012b, '_', 'i'),
+    compose(0x0130, '.', 'I'),
+    compose(0x0131, 'i', '.'),
+    compose(0x0141, '/', 'L'),
+    compose(0x0142, '/', 'l'),
+    compose(0x0143, '\'', 'N'),
+    compose(0x0144, '\'', 'n'),
+    compose(0x0147, 'c', 'N'),
+    compose(0x0148, 'c', 'n'),
+    compose(0x014c, '_', 'O'),
+    compose(0x014d, '_', 'o'),
+    compose(0x0150, '=', 'O'),
+    compose(0x0151, '=', 'o'),
+    compose(0x0152, 'O', 'E'),
+    compose(0x0153, 'o', 'e'),
+    compose(0x0158, 'c', 'R'),
+    compose(0x0159, 'c', 'r'),
+    compose(0x015a, '\'', 'S'),
+    compose(0x015b, '\'', 's'),
+    compose(0x015e, ',', 'S'),
+    compose(0x015f, ',', 's'),
+    compose(0x0160, 'c', 'S'),
+    compose(0x0161, 'c', 's'),
+    compose(0x0164, 'c', 'T'),
+    compose(0x0165, 'c', 't'),
+    compose(0x016a, '_', 'U'),
+    compose(0x016b, '_', 'u'),
+    compose(0x016e, 'o', 'U'),
+    compose(0x016f, 'o', 'u'),
+    compose(0x0170, '=', 'U'),
+    compose(0x0171, '=', 'u'),
+    compose(0x0179, '\'', 'Z'),
+    compose(0x017a, '\'', 'z'),
+    compose(0x017b, '.', 'Z'),
+    compose(0x017c, '.', 'z'),
+    compose(0x017d, 'c', 'Z'),
+    compose(0x017e, 'c', 'z'),
+    compose(0x2026, '.', '.'),
+    compose(0x20ac, '=', 'E'),
+    compose(0x2122, 'T', 'M'),
+};
+
+const size_t kNumEntries = sizeof(kEntries) / sizeof(kEntries[0]);
+
+// ids looked up directly, as index + 1 into kEntries
+const KeyID kLatin1Base = 0x0000;
+const KeyID kSpecialBase = 0xEF00;
+const size_t kDenseSize = 0x100;
+
+struct DenseTable {
+    UInt16 m_index[kDenseSize];
+};
+
+constexpr bool inRange(KeyID id, KeyID base)
+{
+    return id >= base && id - base < kDenseSize;
+}
+
+constexpr bool isDense(KeyID id)
+{
+    return inRange(id, kLatin1Base) || inRange(id, kSpecialBase);
+}
+
+constexpr DenseTable makeDenseTable(KeyID base)
+{
+    DenseTable table{};
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        if (inRange(kEntries[i].m_id, base)) {
+            table.m_index[kEntries[i].m_id - base] = static_cast<UInt16>(i + 1);
+        }
+    }
+    return table;
+}
+
+constexpr size_t countSparse()
+{
+    size_t n = 0;
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        if (!isDense(kEntries[i].m_id)) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+const size_t kNumSparse = countSparse();
+
+// indices into kEntries of the ids outside the dense ranges, by id
+struct SparseTable {
+    UInt16 m_index[kNumSparse];
+};
+
+constexpr SparseTable makeSparseTable()
+{
+    SparseTable table{};
+    size_t n = 0;
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        if (!isDense(kEntries[i].m_id)) {
+            size_t j = n++;
+            for (; j > 0 && kEntries[table.m_index[j - 1]].m_id > kEntries[i].m_id; --j) {
+                table.m_index[j] = table.m_index[j - 1];
+            }
+            table.m_index[j] = static_cast<UInt16>(i);
+        }
+    }
+    return table;
+}
+
+constexpr bool hasUniqueIds()
+{
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        for (size_t j = i + 1; j < kNumEntries; ++j) {
+            if (kEntries[i].m_id == kEntries[j].m_id) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr bool isTypedAsKey(char c)
+{
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        if (kEntries[i].m_id == static_cast<KeyID>(c)) {
+            return kEntries[i].m_kind == UhidKeyMap::kKey;
+        }
+    }
+    return false;
+}
+
+constexpr bool hasTypeableSequences()
+{
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        if (kEntries[i].m_kind == UhidKeyMap::kCompose &&
+                (!isTypedAsKey(kEntries[i].m_compose[0]) ||
+                 !isTypedAsKey(kEntries[i].m_compose[1]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(kNumEntries < 0xFFFF, "too many entries for the dense tables");
+static_assert(hasUniqueIds(), "a KeyID is mapped twice");
+static_assert(hasTypeableSequences(), "a Compose sequence has a character that isn't a key");
+
+constexpr DenseTable kLatin1Table = makeDenseTable(kLatin1Base);
+constexpr DenseTable kSpecialTable = makeDenseTable(kSpecialBase);
+constexpr SparseTable kSparseTable = makeSparseTable();
+
+// characters that can be entered as a code point.  barrier's own key ids
+// are in the private use area and dead keys are combining marks, which
+// mean nothing on their own.
+bool isCharacter(KeyID id)
+{
+    return id >= 0x20 && id <= 0x10FFFF && id != 0x7F &&
+           !(id >= 0x80 && id < 0xA0) &&
+           !(id >= 0x0300 && id < 0x0370) &&
+           !(id >= 0xD800 && id < 0xF900);
+}
+
+} // namespace
+
+const UInt8 UhidKeyMap::kLeftControl;
+const UInt8 UhidKeyMap::kLeftShift;
+const UInt8 UhidKeyMap::kLeftAlt;
+const UInt8 UhidKeyMap::kLeftGui;
+const UInt8 UhidKeyMap::kRightControl;
+const UInt8 UhidKeyMap::kRightShift;
+const UInt8 UhidKeyMap::kRightAlt;
+const UInt8 UhidKeyMap::kRightGui;
+const size_t UhidKeyMap::kMaxStrokes;
+
+UhidKeyMap::Entry UhidKeyMap::lookup(KeyID id)
+{
+    size_t index = 0;
+    if (inRange(id, kLatin1Base)) {
+        index = kLatin1Table.m_index[id - kLatin1Base];
+    }
+    else if (inRange(id, kSpecialBase)) {
+        index = kSpecialTable.m_index[id - kSpecialBase];
+    }
+    else {
+        const UInt16* begin = kSparseTable.m_index;
+        const UInt16* end = begin + kNumSparse;
+        const UInt16* i = std::lower_bound(begin, end, id,
+            [](UInt16 entry, KeyID value) { return kEntries[entry].m_id < value; });
+        if (i != end && kEntries[*i].m_id == id) {
+            index = *i + 1;
+        }
+    }
+
+    if (index != 0) {
+        return kEntries[index - 1];
+    }
+
+    Entry entry = { id, isCharacter(id) ? kUnicode : kUnmapped, 0, 0, { 0, 0 } };
+    return entry;
+}
+
+UInt8 UhidKeyMap::getModifiers(KeyModifierMask mask)
+{
+    UInt8 modifiers = 0;
+    if ((mask & KeyModifierControl) != 0) {
+        modifiers |= kLeftControl;
+    }
+    if ((mask & KeyModifierShift) != 0) {
+        modifiers |= kLeftShift;
+    }
+    if ((mask & KeyModifierAlt) != 0) {
+        modifiers |= kLeftAlt;
+    }
+    if ((mask & KeyModifierMeta) != 0 || (mask & KeyModifierSuper) != 0) {
+        modifiers |= kLeftGui;
+    }
+    if ((mask & KeyModifierAltGr) != 0) {
+        modifiers |= kRightAlt;
+    }
+    return modifiers;
+}
+
+size_t UhidKeyMap::getStrokes(const Entry& entry, KeyID composeKey, Stroke* strokes)
+{
+    size_t n = 0;
+    const Entry compose = lookup(composeKey);
+    if (entry.m_kind == kCompose && (compose.m_kind == kKey || compose.m_kind == kModifier)) {
+        // a modifier has no usage so only its bit is tapped
+        strokes[n].m_usage = compose.m_usage;
+        strokes[n++].m_modifiers = compose.m_modifiers;
+        for (size_t i = 0; i < 2; ++i) {
+            const Entry key = lookup(static_cast<KeyID>(entry.m_compose[i]));
+            strokes[n].m_usage = key.m_usage;
+            strokes[n++].m_modifiers = key.m_modifiers;
+        }
+        return n;
+    }
+
+    if (entry.m_kind != kCompose && entry.m_kind != kUnicode) {
+        return 0;
+    }
+
+    // without a Compose key anything but ASCII is entered as its code
+    // point, which GTK and IBus take after Ctrl+Shift+U
+    char hex[16];
+    snprintf(hex, sizeof(hex), "u%x ", static_cast<unsigned int>(entry.m_id));
+    for (const char* c = hex; *c != '\0' && n < kMaxStrokes; ++c) {
+        const Entry key = lookup(static_cast<KeyID>(*c));
+        strokes[n].m_usage = key.m_usage;
+        strokes[n++].m_modifiers = key.m_modifiers;
+    }
+    strokes[0].m_modifiers = kLeftControl | kLeftShift;
+    return n;
+}
+
+size_t UhidKeyMap::getNumEntries()
+{
+    return kNumEntries;
+}
+
+const UhidKeyMap::Entry& UhidKeyMap::getEntry(size_t index)
+{
+    return kEntries[index];
+}
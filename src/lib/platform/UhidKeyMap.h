@@ -0,0 +1,65 @@
+#pragma once
+
+#include "barrier/key_types.h"
+
+#include <cstddef>
+
+// how each KeyID is typed on a keyboard whose host uses a US layout.
+// ASCII and the special keys are a single key.  other characters are
+// composed, either with the host's Compose key or, for any character
+// without a Compose sequence, by entering the code point in hex after
+// Ctrl+Shift+U.
+//
+// the tables are built at compile time.  Latin-1 and the 0xEFxx special
+// keys are looked up directly and everything else by binary search.
+class UhidKeyMap {
+public:
+    enum Kind {
+        kUnmapped,
+        kKey,           // m_usage with the m_modifiers it needs
+        kModifier,      // the modifier with bit m_modifiers
+        kCompose,       // Compose then the two characters in m_compose
+        kUnicode        // the code point in hex
+    };
+
+    struct Entry {
+        KeyID m_id;
+        UInt8 m_kind;
+        UInt8 m_usage;
+        UInt8 m_modifiers;
+        char m_compose[2];
+    };
+
+    // a key pressed and released on its own
+    struct Stroke {
+        UInt8 m_usage;
+        UInt8 m_modifiers;
+    };
+
+    // the most strokes a character takes
+    static const size_t kMaxStrokes = 8;
+
+    // the modifier bits of the keyboard report
+    static const UInt8 kLeftControl = 0x01;
+    static const UInt8 kLeftShift = 0x02;
+    static const UInt8 kLeftAlt = 0x04;
+    static const UInt8 kLeftGui = 0x08;
+    static const UInt8 kRightControl = 0x10;
+    static const UInt8 kRightShift = 0x20;
+    static const UInt8 kRightAlt = 0x40;
+    static const UInt8 kRightGui = 0x80;
+
+    static Entry lookup(KeyID id);
+
+    // the modifier bits for the modifiers in mask
+    static UInt8 getModifiers(KeyModifierMask mask);
+
+    // fills strokes with the keys tapped to type a kCompose or kUnicode
+    // entry, using composeKey if it isn't kKeyNone, and returns how
+    // many there are
+    static size_t getStrokes(const Entry& entry, KeyID composeKey, Stroke* strokes);
+
+    // every entry of the tables, in no particular order
+    static size_t getNumEntries();
+    static const Entry& getEntry(size_t index);
+};
@@ -1,5 +1,6 @@
 #include "platform/UhidServer.h"
 
+#include "platform/UhidKeyMap.h"
 #include "base/Log.h"
 
 #if defined(__linux__)
@@ -7,6 +8,8 @@
 #include <linux/uhid.h>
 
 #include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <cstring>
 
 #include <errno.h>
@@ -14,17 +17,44 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/select.h>
-#include <sys/time.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace {
 
 static const char* kUhidPath = "/dev/uhid";
 static const size_t kKeyboardSlots = 6;
-static const int kStartTimeoutMs = 3000;
+static const SInt32 kAbsoluteMax = 32767;
 
-static const uint8_t kHidReportDesc[] = {
+// uhid handles each iovec of a writev() as a separate event, so a whole
+// batch goes down in one call
+static const size_t kMaxBatch = 64;
+
+// the kernel zero fills the rest of a short event so input events are
+// sent with only the bytes up to the end of the report
+static const size_t kInputHeaderSize =
+    offsetof(struct uhid_event, u) + offsetof(struct uhid_input2_req, data);
+static const size_t kMaxReportSize = 64;
+
+// reports held while the kernel brings the device up.  only the latest
+// state matters so the oldest are dropped past this.
+static const size_t kMaxEarlyReports = 256;
+
+// keyboard LED output report bits
+static const UInt8 kLedNumLock = 0x01;
+static const UInt8 kLedCapsLock = 0x02;
+static const UInt8 kLedScrollLock = 0x04;
+
+// wheel units per detent, same as barrier's wheel deltas
+static const SInt32 kWheelDetent = 120;
+
+// bits of the resolution multiplier feature report
+static const UInt8 kWheelMultiplier = 0x03;
+static const UInt8 kPanMultiplier = 0x0C;
+
+// relative pointer, report 1, 8 bit axes
+static const uint8_t kHidMouse8Desc[] = {
     0x05, 0x01,
     0x09, 0x02,
     0xA1, 0x01,
@@ -54,8 +84,106 @@ static const uint8_t kHidReportDesc[] = {
     0x95, 0x04,
     0x81, 0x06,
     0xC0,
+    0xC0
+};
+
+// relative pointer, report 1, 16 bit axes so a move of any realistic
+// size fits in a single report.  the wheel and pan each sit in a
+// logical collection with a resolution multiplier (feature report 1)
+// that the host can set to 120, making a wheel unit 1/120 of a detent.
+static const uint8_t kHidMouse16Desc[] = {
+    0x05, 0x01,
+    0x09, 0x02,
+    0xA1, 0x01,
+    0x85, 0x01,
+    0x09, 0x01,
+    0xA1, 0x00,
+    0x05, 0x09,
+    0x19, 0x01,
+    0x29, 0x05,
+    0x15, 0x00,
+    0x25, 0x01,
+    0x95, 0x05,
+    0x75, 0x01,
+    0x81, 0x02,
+    0x95, 0x01,
+    0x75, 0x03,
+    0x81, 0x03,
+    0x05, 0x01,
+    0x09, 0x30,
+    0x09, 0x31,
+    0x16, 0x01, 0x80,
+    0x26, 0xFF, 0x7F,
+    0x75, 0x10,
+    0x95, 0x02,
+    0x81, 0x06,
+    0xA1, 0x02,
+    0x09, 0x48,
+    0x15, 0x00,
+    0x25, 0x01,
+    0x35, 0x01,
+    0x45, 0x78,
+    0x75, 0x02,
+    0x95, 0x01,
+    0xB1, 0x02,
+    0x35, 0x00,
+    0x45, 0x00,
+    0x09, 0x38,
+    0x16, 0x01, 0x80,
+    0x26, 0xFF, 0x7F,
+    0x75, 0x10,
+    0x95, 0x01,
+    0x81, 0x06,
+    0xC0,
+    0xA1, 0x02,
+    0x09, 0x48,
+    0x15, 0x00,
+    0x25, 0x01,
+    0x35, 0x01,
+    0x45, 0x78,
+    0x75, 0x02,
+    0x95, 0x01,
+    0xB1, 0x02,
+    0x35, 0x00,
+    0x45, 0x00,
+    0x05, 0x0C,
+    0x0A, 0x38, 0x02,
+    0x16, 0x01, 0x80,
+    0x26, 0xFF, 0x7F,
+    0x75, 0x10,
+    0x95, 0x01,
+    0x81, 0x06,
+    0xC0,
+    0x75, 0x04,
+    0x95, 0x01,
+    0xB1, 0x03,
+    0xC0,
+    0xC0
+};
+
+// absolute pointer, report 3.  like a tablet the logical range is
+// mapped onto the screen.
+static const uint8_t kHidAbsoluteDesc[] = {
+    0x05, 0x01,
+    0x09, 0x02,
+    0xA1, 0x01,
+    0x85, 0x03,
+    0x09, 0x01,
+    0xA1, 0x00,
+    0x05, 0x01,
+    0x09, 0x30,
+    0x09, 0x31,
+    0x15, 0x00,
+    0x26, 0xFF, 0x7F,
+    0x75, 0x10,
+    0x95, 0x02,
+    0x81, 0x02,
     0xC0,
+    0xC0
+};
 
+// boot keyboard, report 2, with the lock LEDs as its output report
+static const uint8_t kHidBootKeyboardDesc[] = {
     0x05, 0x01,
     0x09, 0x06,
     0xA1, 0x01,
@@ -79,6 +207,44 @@ static const uint8_t kHidReportDesc[] = {
     0x19, 0x00,
     0x29, 0x65,
     0x81, 0x00,
+    0x25, 0x01,
+    0x95, 0x03,
+    0x75, 0x01,
+    0x05, 0x08,
+    0x19, 0x01,
+    0x29, 0x03,
+    0x91, 0x02,
+    0x95, 0x01,
+    0x75, 0x05,
+    0x91, 0x03,
+    0xC0
+};
+
+// n-key rollover keyboard, report 2.  one bit for each usage up to the
+// last modifier, so the modifiers are the bits of the final byte.
+// the LEDs are the same output report as the boot keyboard's.
+static const uint8_t kHidNkroKeyboardDesc[] = {
+    0x05, 0x01,
+    0x09, 0x06,
+    0xA1, 0x01,
+    0x85, 0x02,
+    0x05, 0x07,
+    0x19, 0x00,
+    0x29, 0xE7,
+    0x15, 0x00,
+    0x25, 0x01,
+    0x75, 0x01,
+    0x95, 0xE8,
+    0x81, 0x02,
+    0x95, 0x03,
+    0x75, 0x01,
+    0x05, 0x08,
+    0x19, 0x01,
+    0x29, 0x03,
+    0x91, 0x02,
+    0x95, 0x01,
+    0x75, 0x05,
+    0x91, 0x03,
     0xC0
 };
 
@@ -88,7 +254,10 @@ static int uhid_write(int fd, const struct uhid_event* ev)
     return (ret < 0) ? -1 : 0;
 }
 
-static int uhid_create(int fd, const String& deviceName)
+static int uhid_create(int fd, const String& deviceName,
+                       UhidServer::PointerReport pointerReport,
+                       UhidServer::KeyboardReport keyboardReport,
+                       bool absolutePointer)
 {
     struct uhid_event ev;
     memset(&ev, 0, sizeof(ev));
@@ -103,340 +272,91 @@ static int uhid_create(int fd, const String& deviceName)
     c->product = 0x5678;
     c->version = 1;
     c->country = 0;
-    memcpy(c->rd_data, kHidReportDesc, sizeof(kHidReportDesc));
-    c->rd_size = sizeof(kHidReportDesc);
+    const uint8_t* mouseDesc = kHidMouse16Desc;
+    size_t mouseDescSize = sizeof(kHidMouse16Desc);
+    if (pointerReport == UhidServer::kPointerReport8) {
+        mouseDesc = kHidMouse8Desc;
+        mouseDescSize = sizeof(kHidMouse8Desc);
+    }
+    size_t size = 0;
+    memcpy(c->rd_data + size, mouseDesc, mouseDescSize);
+    size += mouseDescSize;
+    if (keyboardReport == UhidServer::kKeyboardReportBoot) {
+        memcpy(c->rd_data + size, kHidBootKeyboardDesc, sizeof(kHidBootKeyboardDesc));
+        size += sizeof(kHidBootKeyboardDesc);
+    }
+    else {
+        memcpy(c->rd_data + size, kHidNkroKeyboardDesc, sizeof(kHidNkroKeyboardDesc));
+        size += sizeof(kHidNkroKeyboardDesc);
+    }
+    if (absolutePointer) {
+        memcpy(c->rd_data + size, kHidAbsoluteDesc, sizeof(kHidAbsoluteDesc));
+        size += sizeof(kHidAbsoluteDesc);
+    }
+    c->rd_size = static_cast<uint16_t>(size);
 
     return uhid_write(fd, &ev);
 }
 
-static void uhid_destroy(int fd)
+static void uhid_reply_set_report(int fd, UInt32 id, UInt16 err)
 {
     struct uhid_event ev;
     memset(&ev, 0, sizeof(ev));
-    ev.type = UHID_DESTROY;
+    ev.type = UHID_SET_REPORT_REPLY;
+    ev.u.set_report_reply.id = id;
+    ev.u.set_report_reply.err = err;
     uhid_write(fd, &ev);
 }
 
-static bool wait_for_start(int uhidFd)
+static void uhid_reply_get_report(int fd, UInt32 id, UInt16 err,
+                                  const UInt8* data, size_t size)
 {
-    int remainingMs = kStartTimeoutMs;
-    while (remainingMs > 0) {
-        struct timeval tv;
-        tv.tv_sec = remainingMs / 1000;
-        tv.tv_usec = (remainingMs % 1000) * 1000;
-
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        FD_SET(uhidFd, &rfds);
-
-        int ret = select(uhidFd + 1, &rfds, NULL, NULL, &tv);
-        if (ret < 0) {
-            if (errno == EINTR) {
-                continue;
-            }
-            return false;
-        }
-        if (ret == 0) {
-            return false;
-        }
-
-        struct uhid_event ev;
-        ssize_t n = read(uhidFd, &ev, sizeof(ev));
-        if (n > 0 && ev.type == UHID_START) {
-            return true;
-        }
-
-        remainingMs -= 50;
-    }
-
-    return false;
-}
-
-struct KeyMapResult {
-    uint8_t usage;
-    uint8_t requiredModifiers;
-    uint8_t modifierBit;
-    bool isModifier;
-};
-
-static uint8_t modifier_from_mask(KeyModifierMask mask)
-{
-    uint8_t mods = 0;
-    if ((mask & KeyModifierControl) != 0) {
-        mods |= 0x01;
-    }
-    if ((mask & KeyModifierShift) != 0) {
-        mods |= 0x02;
-    }
-    if ((mask & KeyModifierAlt) != 0) {
-        mods |= 0x04;
-    }
-    if ((mask & KeyModifierMeta) != 0 || (mask & KeyModifierSuper) != 0) {
-        mods |= 0x08;
-    }
-    if ((mask & KeyModifierAltGr) != 0) {
-        mods |= 0x40;
-    }
-    return mods;
-}
-
-static KeyMapResult map_ascii(KeyID id)
-{
-    KeyMapResult out = {0, 0, 0, false};
-    if (id > 0x7f) {
-        return out;
-    }
-
-    const char c = static_cast<char>(id);
-
-    if (c >= 'a' && c <= 'z') {
-        out.usage = static_cast<uint8_t>(0x04 + (c - 'a'));
-        return out;
-    }
-
-    if (c >= 'A' && c <= 'Z') {
-        out.usage = static_cast<uint8_t>(0x04 + (c - 'A'));
-        out.requiredModifiers = 0x02;
-        return out;
-    }
-
-    if (c >= '1' && c <= '9') {
-        out.usage = static_cast<uint8_t>(0x1e + (c - '1'));
-        return out;
-    }
-
-    if (c == '0') {
-        out.usage = 0x27;
-        return out;
-    }
-
-    switch (c) {
-    case '!': out.usage = 0x1e; out.requiredModifiers = 0x02; break;
-    case '@': out.usage = 0x1f; out.requiredModifiers = 0x02; break;
-    case '#': out.usage = 0x20; out.requiredModifiers = 0x02; break;
-    case '$': out.usage = 0x21; out.requiredModifiers = 0x02; break;
-    case '%': out.usage = 0x22; out.requiredModifiers = 0x02; break;
-    case '^': out.usage = 0x23; out.requiredModifiers = 0x02; break;
-    case '&': out.usage = 0x24; out.requiredModifiers = 0x02; break;
-    case '*': out.usage = 0x25; out.requiredModifiers = 0x02; break;
-    case '(': out.usage = 0x26; out.requiredModifiers = 0x02; break;
-    case ')': out.usage = 0x27; out.requiredModifiers = 0x02; break;
-    case '-': out.usage = 0x2d; break;
-    case '_': out.usage = 0x2d; out.requiredModifiers = 0x02; break;
-    case '=': out.usage = 0x2e; break;
-    case '+': out.usage = 0x2e; out.requiredModifiers = 0x02; break;
-    case '[': out.usage = 0x2f; break;
-    case '{': out.usage = 0x2f; out.requiredModifiers = 0x02; break;
-    case ']': out.usage = 0x30; break;
-    case '}': out.usage = 0x30; out.requiredModifiers = 0x02; break;
-    case '\\': out.usage = 0x31; break;
-    case '|': out.usage = 0x31; out.requiredModifiers = 0x02; break;
-    case ';': out.usage = 0x33; break;
-    case ':': out.usage = 0x33; out.requiredModifiers = 0x02; break;
-    case '\'': out.usage = 0x34; break;
-    case '"': out.usage = 0x34; out.requiredModifiers = 0x02; break;
-    case '`': out.usage = 0x35; break;
-    case '~': out.usage = 0x35; out.requiredModifiers = 0x02; break;
-    case ',': out.usage = 0x36; break;
-    case '<': out.usage = 0x36; out.requiredModifiers = 0x02; break;
-    case '.': out.usage = 0x37; break;
-    case '>': out.usage = 0x37; out.requiredModifiers = 0x02; break;
-    case '/': out.usage = 0x38; break;
-    case '?': out.usage = 0x38; out.requiredModifiers = 0x02; break;
-    case ' ': out.usage = 0x2c; break;
-    default: break;
-    }
-
-    return out;
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_GET_REPORT_REPLY;
+    ev.u.get_report_reply.id = id;
+    ev.u.get_report_reply.err = err;
+    ev.u.get_report_reply.size = static_cast<uint16_t>(size);
+    memcpy(ev.u.get_report_reply.data, data, size);
+    uhid_write(fd, &ev);
 }
 
-static KeyMapResult map_key(KeyID id)
+static void uhid_destroy(int fd)
 {
-    KeyMapResult out = map_ascii(id);
-    if (out.usage != 0 || out.isModifier) {
-        return out;
-    }
-
-    switch (id) {
-    case kKeyReturn:
-    case kKeyKP_Enter:
-        out.usage = 0x28;
-        break;
-    case kKeyEscape:
-        out.usage = 0x29;
-        break;
-    case kKeyBackSpace:
-        out.usage = 0x2a;
-        break;
-    case kKeyTab:
-    case kKeyLeftTab:
-        out.usage = 0x2b;
-        break;
-    case kKeyDelete:
-        out.usage = 0x4c;
-        break;
-    case kKeyInsert:
-        out.usage = 0x49;
-        break;
-    case kKeyHome:
-        out.usage = 0x4a;
-        break;
-    case kKeyEnd:
-        out.usage = 0x4d;
-        break;
-    case kKeyPageUp:
-        out.usage = 0x4b;
-        break;
-    case kKeyPageDown:
-        out.usage = 0x4e;
-        break;
-    case kKeyRight:
-        out.usage = 0x4f;
-        break;
-    case kKeyLeft:
-        out.usage = 0x50;
-        break;
-    case kKeyDown:
-        out.usage = 0x51;
-        break;
-    case kKeyUp:
-        out.usage = 0x52;
-        break;
-    case kKeyNumLock:
-        out.usage = 0x53;
-        break;
-    case kKeyKP_Divide:
-        out.usage = 0x54;
-        break;
-    case kKeyKP_Multiply:
-        out.usage = 0x55;
-        break;
-    case kKeyKP_Subtract:
-        out.usage = 0x56;
-        break;
-    case kKeyKP_Add:
-        out.usage = 0x57;
-        break;
-    case kKeyKP_Decimal:
-    case kKeyKP_Delete:
-        out.usage = 0x63;
-        break;
-    case kKeyKP_0:
-    case kKeyKP_Insert:
-        out.usage = 0x62;
-        break;
-    case kKeyKP_1:
-    case kKeyKP_End:
-        out.usage = 0x59;
-        break;
-    case kKeyKP_2:
-    case kKeyKP_Down:
-        out.usage = 0x5a;
-        break;
-    case kKeyKP_3:
-    case kKeyKP_PageDown:
-        out.usage = 0x5b;
-        break;
-    case kKeyKP_4:
-    case kKeyKP_Left:
-        out.usage = 0x5c;
-        break;
-    case kKeyKP_5:
-    case kKeyKP_Begin:
-        out.usage = 0x5d;
-        break;
-    case kKeyKP_6:
-    case kKeyKP_Right:
-        out.usage = 0x5e;
-        break;
-    case kKeyKP_7:
-    case kKeyKP_Home:
-        out.usage = 0x5f;
-        break;
-    case kKeyKP_8:
-    case kKeyKP_Up:
-        out.usage = 0x60;
-        break;
-    case kKeyKP_9:
-    case kKeyKP_PageUp:
-        out.usage = 0x61;
-        break;
-    case kKeyCapsLock:
-        out.usage = 0x39;
-        break;
-    case kKeyPrint:
-        out.usage = 0x46;
-        break;
-    case kKeyScrollLock:
-        out.usage = 0x47;
-        break;
-    case kKeyPause:
-        out.usage = 0x48;
-        break;
-    case kKeyMenu:
-        out.usage = 0x65;
-        break;
-    case kKeyShift_L:
-        out.isModifier = true;
-        out.modifierBit = 0x02;
-        break;
-    case kKeyShift_R:
-        out.isModifier = true;
-        out.modifierBit = 0x20;
-        break;
-    case kKeyControl_L:
-        out.isModifier = true;
-        out.modifierBit = 0x01;
-        break;
-    case kKeyControl_R:
-        out.isModifier = true;
-        out.modifierBit = 0x10;
-        break;
-    case kKeyAlt_L:
-        out.isModifier = true;
-        out.modifierBit = 0x04;
-        break;
-    case kKeyAlt_R:
-    case kKeyAltGr:
-        out.isModifier = true;
-        out.modifierBit = 0x40;
-        break;
-    case kKeyMeta_L:
-    case kKeySuper_L:
-        out.isModifier = true;
-        out.modifierBit = 0x08;
-        break;
-    case kKeyMeta_R:
-    case kKeySuper_R:
-        out.isModifier = true;
-        out.modifierBit = 0x80;
-        break;
-    default:
-        break;
-    }
-
-    if (out.usage == 0 && id >= kKeyF1 && id <= kKeyF12) {
-        out.usage = static_cast<uint8_t>(0x3a + (id - kKeyF1));
-    }
-    else if (out.usage == 0 && id >= kKeyF13 && id <= kKeyF24) {
-        out.usage = static_cast<uint8_t>(0x68 + (id - kKeyF13));
-    }
-
-    return out;
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_DESTROY;
+    uhid_write(fd, &ev);
 }
 
 } // namespace
 
 UhidServer::UhidServer()
     : m_running(false)
+    , m_started(false)
+    , m_opened(false)
+    , m_ledState(0)
     , m_uhidFd(-1)
+    , m_buffered(false)
+    , m_pointerReport(kPointerReport16)
+    , m_keyboardReport(kKeyboardReportNkro)
+    , m_absolutePointer(true)
+    , m_screenX(0)
+    , m_screenY(0)
+    , m_screenW(0)
+    , m_screenH(0)
     , m_hasLastAbsolute(false)
     , m_lastAbsX(0)
     , m_lastAbsY(0)
     , m_mouseButtons(0)
+    , m_resolutionMultiplier(0)
+    , m_wheelRemainder(0)
+    , m_panRemainder(0)
     , m_keyboardModifiers(0)
+    , m_composeKey(kKeyNone)
 {
     m_keyboardKeys.fill(0);
+    m_keyboardBitmap.fill(0);
 }
 
 UhidServer::~UhidServer()
@@ -444,35 +364,80 @@ UhidServer::~UhidServer()
     stop();
 }
 
+void UhidServer::setPointerReport(PointerReport report)
+{
+    m_pointerReport = report;
+}
+
+void UhidServer::setKeyboardReport(KeyboardReport report)
+{
+    m_keyboardReport = report;
+}
+
+void UhidServer::setAbsolutePointer(bool enabled)
+{
+    m_absolutePointer = enabled;
+}
+
+void UhidServer::setComposeKey(KeyID id)
+{
+    m_composeKey = id;
+}
+
+void UhidServer::setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h)
+{
+    m_screenX = x;
+    m_screenY = y;
+    m_screenW = w;
+    m_screenH = h;
+}
+
+void UhidServer::setBuffered(bool buffered)
+{
+    if (m_buffered && !buffered) {
+        flush();
+    }
+    m_buffered = buffered;
+}
+
 bool UhidServer::start(const String& deviceName)
 {
     if (m_running) {
         return true;
     }
 
-    int fd = open(kUhidPath, O_RDWR | O_CLOEXEC);
+    int fd = open(kUhidPath, O_RDWR | O_CLOEXEC | O_NONBLOCK);
     if (fd < 0) {
         LOG((CLOG_WARN "uhid: open %s failed (%s)", kUhidPath, strerror(errno)));
         return false;
     }
 
-    if (uhid_create(fd, deviceName) < 0) {
-        LOG((CLOG_WARN "uhid: create failed (%s)", strerror(errno)));
+    return start(fd, deviceName);
+}
+
+bool UhidServer::start(int fd, const String& deviceName)
+{
+    if (m_running) {
         close(fd);
-        return false;
+        return true;
     }
 
-    if (!wait_for_start(fd)) {
-        LOG((CLOG_WARN "uhid: timed out waiting for UHID_START"));
-        uhid_destroy(fd);
+    if (uhid_create(fd, deviceName, m_pointerReport, m_keyboardReport, m_absolutePointer) < 0) {
+        LOG((CLOG_WARN "uhid: create failed (%s)", strerror(errno)));
         close(fd);
         return false;
     }
 
+    // the kernel answers with UHID_START once a driver has bound the
+    // device.  until processEvents() sees it reports are held.
     m_uhidFd = fd;
     m_running = true;
+    m_started = false;
+    m_opened = false;
+    m_ledState = 0;
+    m_resolutionMultiplier = 0;
     clearInputState();
-    LOG((CLOG_NOTE "uhid: connected to Barrier input stream"));
+    LOG((CLOG_DEBUG "uhid: device created, waiting for the kernel to start it"));
     return true;
 }
 
@@ -482,11 +447,18 @@ void UhidServer::stop()
         return;
     }
 
-    clearInputState();
+    if (m_started) {
+        clearInputState();
+        flush();
+    }
     uhid_destroy(m_uhidFd);
     close(m_uhidFd);
     m_uhidFd = -1;
     m_running = false;
+    m_started = false;
+    m_opened = false;
+    m_pending.clear();
+    m_pendingSizes.clear();
 }
 
 bool UhidServer::running() const
@@ -494,14 +466,42 @@ bool UhidServer::running() const
     return m_running;
 }
 
+bool UhidServer::isStarted() const
+{
+    return m_started;
+}
+
+int UhidServer::getFd() const
+{
+    return m_uhidFd;
+}
+
+KeyModifierMask UhidServer::getLockState() const
+{
+    KeyModifierMask mask = 0;
+    if ((m_ledState & kLedNumLock) != 0) {
+        mask |= KeyModifierNumLock;
+    }
+    if ((m_ledState & kLedCapsLock) != 0) {
+        mask |= KeyModifierCapsLock;
+    }
+    if ((m_ledState & kLedScrollLock) != 0) {
+        mask |= KeyModifierScrollLock;
+    }
+    return mask;
+}
+
 void UhidServer::clearInputState()
 {
     m_hasLastAbsolute = false;
     m_lastAbsX = 0;
     m_lastAbsY = 0;
     m_mouseButtons = 0;
+    m_wheelRemainder = 0;
+    m_panRemainder = 0;
     m_keyboardModifiers = 0;
     m_keyboardKeys.fill(0);
+    m_keyboardBitmap.fill(0);
 
     if (m_running) {
         sendKeyboardReport();
@@ -509,15 +509,177 @@ void UhidServer::clearInputState()
     }
 }
 
-bool UhidServer::sendKeyboardReport()
+bool UhidServer::flush()
+{
+    if (!m_started || m_pendingSizes.empty()) {
+        return true;
+    }
+
+    bool result = true;
+    struct iovec iov[kMaxBatch];
+    size_t offset = 0;
+    for (size_t i = 0; i < m_pendingSizes.size(); ) {
+        const size_t first = offset;
+        size_t n = 0;
+        for (; n < kMaxBatch && i < m_pendingSizes.size(); ++n, ++i) {
+            iov[n].iov_base = &m_pending[offset];
+            iov[n].iov_len = m_pendingSizes[i];
+            offset += m_pendingSizes[i];
+        }
+
+        ssize_t ret = writev(m_uhidFd, iov, static_cast<int>(n));
+        if (ret != static_cast<ssize_t>(offset - first)) {
+            LOG((CLOG_DEBUG "uhid: write failed (%s)", strerror(errno)));
+            result = false;
+            break;
+        }
+    }
+
+    m_pending.clear();
+    m_pendingSizes.clear();
+    return result;
+}
+
+bool UhidServer::processEvents()
 {
     if (!m_running) {
         return false;
     }
 
-    struct uhid_event ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.type = UHID_INPUT2;
+    for (;;) {
+        struct pollfd pfd;
+        pfd.fd = m_uhidFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG((CLOG_WARN "uhid: poll failed (%s)", strerror(errno)));
+            return false;
+        }
+        if (ret == 0 || (pfd.revents & POLLIN) == 0) {
+            return (ret == 0 || (pfd.revents & (POLLERR | POLLHUP)) == 0);
+        }
+
+        struct uhid_event ev;
+        ssize_t n = read(m_uhidFd, &ev, sizeof(ev));
+        if (n <= 0) {
+            return (n < 0 && (errno == EINTR || errno == EAGAIN));
+        }
+        handleEvent(ev);
+    }
+}
+
+void UhidServer::handleEvent(const struct uhid_event& ev)
+{
+    const bool hasMultiplier = (m_pointerReport == kPointerReport16);
+
+    switch (ev.type) {
+    case UHID_START:
+        m_started = true;
+        LOG((CLOG_NOTE "uhid: connected to Barrier input stream"));
+        if (!m_buffered) {
+            flush();
+        }
+        break;
+
+    case UHID_STOP:
+        m_started = false;
+        LOG((CLOG_NOTE "uhid: device stopped by the kernel"));
+        break;
+
+    case UHID_OPEN:
+        m_opened = true;
+        LOG((CLOG_DEBUG "uhid: device opened"));
+        break;
+
+    case UHID_CLOSE:
+        m_opened = false;
+        LOG((CLOG_DEBUG "uhid: device closed"));
+        break;
+
+    case UHID_OUTPUT: {
+        const struct uhid_output_req& req = ev.u.output;
+        if (req.rtype == UHID_OUTPUT_REPORT && req.size >= 2 && req.data[0] == 0x02) {
+            m_ledState = req.data[1] & (kLedNumLock | kLedCapsLock | kLedScrollLock);
+            LOG((CLOG_DEBUG1 "uhid: keyboard LEDs set to 0x%02x", m_ledState));
+        }
+        break;
+    }
+
+    case UHID_SET_REPORT: {
+        const struct uhid_set_report_req& req = ev.u.set_report;
+        if (hasMultiplier && req.rtype == UHID_FEATURE_REPORT &&
+                req.rnum == 1 && req.size >= 2) {
+            m_resolutionMultiplier = req.data[1] & (kWheelMultiplier | kPanMultiplier);
+            m_wheelRemainder = 0;
+            m_panRemainder = 0;
+            LOG((CLOG_DEBUG "uhid: resolution multiplier set to 0x%02x", m_resolutionMultiplier));
+            uhid_reply_set_report(m_uhidFd, req.id, 0);
+        }
+        else {
+            uhid_reply_set_report(m_uhidFd, req.id, EIO);
+        }
+        break;
+    }
+
+    case UHID_GET_REPORT: {
+        const struct uhid_get_report_req& req = ev.u.get_report;
+        if (hasMultiplier && req.rtype == UHID_FEATURE_REPORT && req.rnum == 1) {
+            const UInt8 report[2] = { 0x01, m_resolutionMultiplier };
+            uhid_reply_get_report(m_uhidFd, req.id, 0, report, sizeof(report));
+        }
+        else {
+            uhid_reply_get_report(m_uhidFd, req.id, EIO, NULL, 0);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+bool UhidServer::submitReport(const UInt8* report, size_t size)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    assert(size <= kMaxReportSize);
+
+    UInt8 event[kInputHeaderSize + kMaxReportSize];
+    const uint32_t type = UHID_INPUT2;
+    const uint16_t reportSize = static_cast<uint16_t>(size);
+    memcpy(event + offsetof(struct uhid_event, type), &type, sizeof(type));
+    memcpy(event + offsetof(struct uhid_event, u), &reportSize, sizeof(reportSize));
+    memcpy(event + kInputHeaderSize, report, size);
+    const size_t eventSize = kInputHeaderSize + size;
+
+    if (!m_buffered && m_started) {
+        return (write(m_uhidFd, event, eventSize) == static_cast<ssize_t>(eventSize));
+    }
+
+    if (!m_started && m_pendingSizes.size() >= kMaxEarlyReports) {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + m_pendingSizes.front());
+        m_pendingSizes.erase(m_pendingSizes.begin());
+    }
+    m_pending.insert(m_pending.end(), event, event + eventSize);
+    m_pendingSizes.push_back(eventSize);
+    return true;
+}
+
+bool UhidServer::sendKeyboardReport()
+{
+    if (m_keyboardReport == kKeyboardReportNkro) {
+        uint8_t report[1 + sizeof(m_keyboardBitmap)];
+        report[0] = 0x02;
+        memcpy(report + 1, m_keyboardBitmap.data(), sizeof(m_keyboardBitmap));
+        report[sizeof(report) - 1] = m_keyboardModifiers;
+        return submitReport(report, sizeof(report));
+    }
 
     uint8_t report[9];
     memset(report, 0, sizeof(report));
@@ -527,32 +689,97 @@ bool UhidServer::sendKeyboardReport()
         report[3 + i] = m_keyboardKeys[i];
     }
 
-    memcpy(ev.u.input2.data, report, sizeof(report));
-    ev.u.input2.size = sizeof(report);
-    return (uhid_write(m_uhidFd, &ev) == 0);
+    return submitReport(report, sizeof(report));
 }
 
-bool UhidServer::sendMouseReport(SInt8 dx, SInt8 dy, SInt8 wheel, SInt8 pan)
+void UhidServer::setKeyPressed(UInt8 usage, bool pressed)
 {
-    if (!m_running) {
-        return false;
+    if (m_keyboardReport == kKeyboardReportNkro) {
+        const UInt8 bit = static_cast<UInt8>(1u << (usage & 7));
+        if (pressed) {
+            m_keyboardBitmap[usage >> 3] |= bit;
+        }
+        else {
+            m_keyboardBitmap[usage >> 3] &= static_cast<UInt8>(~bit);
+        }
+        return;
     }
 
-    struct uhid_event ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.type = UHID_INPUT2;
+    if (!pressed) {
+        for (size_t i = 0; i < kKeyboardSlots; ++i) {
+            if (m_keyboardKeys[i] == usage) {
+                m_keyboardKeys[i] = 0;
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < kKeyboardSlots; ++i) {
+        if (m_keyboardKeys[i] == usage) {
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < kKeyboardSlots; ++i) {
+        if (m_keyboardKeys[i] == 0) {
+            m_keyboardKeys[i] = usage;
+            return;
+        }
+    }
+
+    // the boot report is full so the newest key replaces the last one
+    m_keyboardKeys[kKeyboardSlots - 1] = usage;
+}
 
-    uint8_t report[6];
-    report[0] = 0x01;
-    report[1] = m_mouseButtons;
-    report[2] = static_cast<uint8_t>(dx);
-    report[3] = static_cast<uint8_t>(dy);
-    report[4] = static_cast<uint8_t>(wheel);
-    report[5] = static_cast<uint8_t>(pan);
+bool UhidServer::sendMouseReport(SInt32 dx, SInt32 dy, SInt32 wheel, SInt32 pan)
+{
+    uint8_t report[10];
+    size_t size = 0;
+    report[size++] = 0x01;
+    report[size++] = m_mouseButtons;
+    if (m_pointerReport == kPointerReport16) {
+        report[size++] = static_cast<uint8_t>(dx & 0xff);
+        report[size++] = static_cast<uint8_t>((dx >> 8) & 0xff);
+        report[size++] = static_cast<uint8_t>(dy & 0xff);
+        report[size++] = static_cast<uint8_t>((dy >> 8) & 0xff);
+        report[size++] = static_cast<uint8_t>(wheel & 0xff);
+        report[size++] = static_cast<uint8_t>((wheel >> 8) & 0xff);
+        report[size++] = static_cast<uint8_t>(pan & 0xff);
+        report[size++] = static_cast<uint8_t>((pan >> 8) & 0xff);
+    }
+    else {
+        report[size++] = static_cast<uint8_t>(dx);
+        report[size++] = static_cast<uint8_t>(dy);
+        report[size++] = static_cast<uint8_t>(wheel);
+        report[size++] = static_cast<uint8_t>(pan);
+    }
+
+    return submitReport(report, size);
+}
+
+bool UhidServer::sendAbsoluteReport(SInt32 x, SInt32 y)
+{
+    if (!m_running) {
+        return false;
+    }
 
-    memcpy(ev.u.input2.data, report, sizeof(report));
-    ev.u.input2.size = sizeof(report);
-    return (uhid_write(m_uhidFd, &ev) == 0);
+    // map the screen onto the logical range so the far edges land on
+    // 0 and kAbsoluteMax
+    const SInt32 w = std::max<SInt32>(m_screenW, 2);
+    const SInt32 h = std::max<SInt32>(m_screenH, 2);
+    x = std::max<SInt32>(0, std::min<SInt32>(w - 1, x - m_screenX));
+    y = std::max<SInt32>(0, std::min<SInt32>(h - 1, y - m_screenY));
+    const SInt32 ax = static_cast<SInt32>((static_cast<int64_t>(x) * kAbsoluteMax + (w - 1) / 2) / (w - 1));
+    const SInt32 ay = static_cast<SInt32>((static_cast<int64_t>(y) * kAbsoluteMax + (h - 1) / 2) / (h - 1));
+
+    uint8_t report[5];
+    report[0] = 0x03;
+    report[1] = static_cast<uint8_t>(ax & 0xff);
+    report[2] = static_cast<uint8_t>((ax >> 8) & 0xff);
+    report[3] = static_cast<uint8_t>(ay & 0xff);
+    report[4] = static_cast<uint8_t>((ay >> 8) & 0xff);
+
+    return submitReport(report, sizeof(report));
 }
 
 bool UhidServer::updateMouseButtons(ButtonID id, bool pressed)
@@ -594,11 +821,13 @@ bool UhidServer::sendRelativeMotion(SInt32 dx, SInt32 dy)
         return false;
     }
 
+    // only moves larger than the report can hold are split
+    const SInt32 limit = (m_pointerReport == kPointerReport16) ? 32767 : 127;
     while (dx != 0 || dy != 0) {
-        const SInt32 stepX = std::max<SInt32>(-127, std::min<SInt32>(127, dx));
-        const SInt32 stepY = std::max<SInt32>(-127, std::min<SInt32>(127, dy));
+        const SInt32 stepX = std::max<SInt32>(-limit, std::min<SInt32>(limit, dx));
+        const SInt32 stepY = std::max<SInt32>(-limit, std::min<SInt32>(limit, dy));
 
-        if (!sendMouseReport(static_cast<SInt8>(stepX), static_cast<SInt8>(stepY), 0, 0)) {
+        if (!sendMouseReport(stepX, stepY, 0, 0)) {
             return false;
         }
 
@@ -615,33 +844,54 @@ bool UhidServer::sendWheelMotion(SInt32 xDelta, SInt32 yDelta)
         return false;
     }
 
-    SInt32 wheelSteps = 0;
-    SInt32 panSteps = 0;
-
-    if (yDelta != 0) {
-        wheelSteps = yDelta / 120;
-        if (wheelSteps == 0) {
-            wheelSteps = (yDelta > 0) ? 1 : -1;
+    SInt32 wheel = 0;
+    SInt32 pan = 0;
+    SInt32 limit = 32767;
+
+    if (m_pointerReport == kPointerReport8) {
+        // whole detents only, and any movement is at least one
+        limit = 127;
+        if (yDelta != 0) {
+            wheel = yDelta / kWheelDetent;
+            if (wheel == 0) {
+                wheel = (yDelta > 0) ? 1 : -1;
+            }
+        }
+        if (xDelta != 0) {
+            pan = xDelta / kWheelDetent;
+            if (pan == 0) {
+                pan = (xDelta > 0) ? 1 : -1;
+            }
         }
     }
-
-    if (xDelta != 0) {
-        panSteps = xDelta / 120;
-        if (panSteps == 0) {
-            panSteps = (xDelta > 0) ? 1 : -1;
+    else {
+        // with the multiplier set deltas go through unchanged.  without
+        // it the part of a detent left over is kept for the next delta
+        // so fine scrolling still adds up.
+        wheel = yDelta;
+        if ((m_resolutionMultiplier & kWheelMultiplier) == 0) {
+            m_wheelRemainder += yDelta;
+            wheel = m_wheelRemainder / kWheelDetent;
+            m_wheelRemainder -= wheel * kWheelDetent;
+        }
+        pan = xDelta;
+        if ((m_resolutionMultiplier & kPanMultiplier) == 0) {
+            m_panRemainder += xDelta;
+            pan = m_panRemainder / kWheelDetent;
+            m_panRemainder -= pan * kWheelDetent;
         }
     }
 
-    while (wheelSteps != 0 || panSteps != 0) {
-        const SInt32 stepWheel = std::max<SInt32>(-127, std::min<SInt32>(127, wheelSteps));
-        const SInt32 stepPan = std::max<SInt32>(-127, std::min<SInt32>(127, panSteps));
+    while (wheel != 0 || pan != 0) {
+        const SInt32 stepWheel = std::max<SInt32>(-limit, std::min<SInt32>(limit, wheel));
+        const SInt32 stepPan = std::max<SInt32>(-limit, std::min<SInt32>(limit, pan));
 
-        if (!sendMouseReport(0, 0, static_cast<SInt8>(stepWheel), static_cast<SInt8>(stepPan))) {
+        if (!sendMouseReport(0, 0, stepWheel, stepPan)) {
             return false;
         }
 
-        wheelSteps -= stepWheel;
-        panSteps -= stepPan;
+        wheel -= stepWheel;
+        pan -= stepPan;
     }
 
     return true;
@@ -653,35 +903,31 @@ bool UhidServer::keyDown(KeyID id, KeyModifierMask mask)
         return false;
     }
 
-    const KeyMapResult key = map_key(id);
-    m_keyboardModifiers = modifier_from_mask(mask);
+    const UhidKeyMap::Entry key = UhidKeyMap::lookup(id);
+    m_keyboardModifiers = UhidKeyMap::getModifiers(mask);
 
-    if (key.isModifier) {
-        m_keyboardModifiers |= key.modifierBit;
+    switch (key.m_kind) {
+    case UhidKeyMap::kModifier:
+        m_keyboardModifiers |= key.m_modifiers;
         return sendKeyboardReport();
-    }
-
-    if (key.usage == 0) {
-        return true;
-    }
 
-    m_keyboardModifiers |= key.requiredModifiers;
+    case UhidKeyMap::kKey:
+        m_keyboardModifiers |= key.m_modifiers;
+        setKeyPressed(key.m_usage, true);
+        return sendKeyboardReport();
 
-    for (size_t i = 0; i < kKeyboardSlots; ++i) {
-        if (m_keyboardKeys[i] == key.usage) {
-            return sendKeyboardReport();
-        }
+    case UhidKeyMap::kCompose:
+    case UhidKeyMap::kUnicode: {
+        // the whole sequence is typed on the press and the modifiers
+        // held on the primary are put back afterwards
+        const bool typed = typeCharacter(key);
+        m_keyboardModifiers = UhidKeyMap::getModifiers(mask);
+        return sendKeyboardReport() && typed;
     }
 
-    for (size_t i = 0; i < kKeyboardSlots; ++i) {
-        if (m_keyboardKeys[i] == 0) {
-            m_keyboardKeys[i] = key.usage;
-            return sendKeyboardReport();
-        }
+    default:
+        return true;
     }
-
-    m_keyboardKeys[kKeyboardSlots - 1] = key.usage;
-    return sendKeyboardReport();
 }
 
 bool UhidServer::keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count)
@@ -690,8 +936,8 @@ bool UhidServer::keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count)
         return false;
     }
 
-    const KeyMapResult key = map_key(id);
-    if (key.isModifier || key.usage == 0) {
+    const UhidKeyMap::Entry key = UhidKeyMap::lookup(id);
+    if (key.m_kind == UhidKeyMap::kUnmapped || key.m_kind == UhidKeyMap::kModifier) {
         return true;
     }
 
@@ -709,25 +955,47 @@ bool UhidServer::keyUp(KeyID id, KeyModifierMask mask)
         return false;
     }
 
-    const KeyMapResult key = map_key(id);
-    m_keyboardModifiers = modifier_from_mask(mask);
+    const UhidKeyMap::Entry key = UhidKeyMap::lookup(id);
+    m_keyboardModifiers = UhidKeyMap::getModifiers(mask);
 
-    if (key.isModifier) {
-        m_keyboardModifiers &= static_cast<uint8_t>(~key.modifierBit);
+    switch (key.m_kind) {
+    case UhidKeyMap::kModifier:
+        m_keyboardModifiers &= static_cast<uint8_t>(~key.m_modifiers);
         return sendKeyboardReport();
-    }
 
-    if (key.usage == 0) {
+    case UhidKeyMap::kKey:
+        setKeyPressed(key.m_usage, false);
+        return sendKeyboardReport();
+
+    default:
         return true;
     }
+}
 
-    for (size_t i = 0; i < kKeyboardSlots; ++i) {
-        if (m_keyboardKeys[i] == key.usage) {
-            m_keyboardKeys[i] = 0;
-        }
+bool UhidServer::typeCharacter(const UhidKeyMap::Entry& key)
+{
+    UhidKeyMap::Stroke strokes[UhidKeyMap::kMaxStrokes];
+    const size_t n = UhidKeyMap::getStrokes(key, m_composeKey, strokes);
+    bool result = (n > 0);
+    for (size_t i = 0; i < n && result; ++i) {
+        result = tapKey(strokes[i].m_usage, strokes[i].m_modifiers);
     }
+    return result;
+}
 
-    return sendKeyboardReport();
+bool UhidServer::tapKey(UInt8 usage, UInt8 modifiers)
+{
+    m_keyboardModifiers = modifiers;
+    if (usage != 0) {
+        setKeyPressed(usage, true);
+    }
+    bool result = sendKeyboardReport();
+
+    m_keyboardModifiers = 0;
+    if (usage != 0) {
+        setKeyPressed(usage, false);
+    }
+    return sendKeyboardReport() && result;
 }
 
 bool UhidServer::mouseDown(ButtonID id)
@@ -754,6 +1022,10 @@ bool UhidServer::mouseMoveAbsolute(SInt32 x, SInt32 y)
         return false;
     }
 
+    if (m_absolutePointer && m_screenW > 0 && m_screenH > 0) {
+        return sendAbsoluteReport(x, y);
+    }
+
     if (!m_hasLastAbsolute) {
         m_lastAbsX = x;
         m_lastAbsY = y;
@@ -786,25 +1058,79 @@ bool UhidServer::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 
 UhidServer::UhidServer()
     : m_running(false)
+    , m_started(false)
+    , m_opened(false)
+    , m_ledState(0)
     , m_uhidFd(-1)
+    , m_buffered(false)
+    , m_pointerReport(kPointerReport16)
+    , m_keyboardReport(kKeyboardReportNkro)
+    , m_absolutePointer(true)
+    , m_screenX(0)
+    , m_screenY(0)
+    , m_screenW(0)
+    , m_screenH(0)
     , m_hasLastAbsolute(false)
     , m_lastAbsX(0)
     , m_lastAbsY(0)
     , m_mouseButtons(0)
+    , m_resolutionMultiplier(0)
+    , m_wheelRemainder(0)
+    , m_panRemainder(0)
     , m_keyboardModifiers(0)
+    , m_composeKey(kKeyNone)
 {
     m_keyboardKeys.fill(0);
+    m_keyboardBitmap.fill(0);
 }
 
 UhidServer::~UhidServer()
 {
 }
 
+void UhidServer::setPointerReport(PointerReport report)
+{
+    m_pointerReport = report;
+}
+
+void UhidServer::setKeyboardReport(KeyboardReport report)
+{
+    m_keyboardReport = report;
+}
+
+void UhidServer::setAbsolutePointer(bool enabled)
+{
+    m_absolutePointer = enabled;
+}
+
+void UhidServer::setComposeKey(KeyID id)
+{
+    m_composeKey = id;
+}
+
+void UhidServer::setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h)
+{
+    m_screenX = x;
+    m_screenY = y;
+    m_screenW = w;
+    m_screenH = h;
+}
+
+void UhidServer::setBuffered(bool buffered)
+{
+    m_buffered = buffered;
+}
+
 bool UhidServer::start(const String&)
 {
     return false;
 }
 
+bool UhidServer::start(int, const String&)
+{
+    return false;
+}
+
 void UhidServer::stop()
 {
 }
@@ -814,10 +1140,35 @@ bool UhidServer::running() const
     return false;
 }
 
+bool UhidServer::isStarted() const
+{
+    return false;
+}
+
+int UhidServer::getFd() const
+{
+    return -1;
+}
+
+KeyModifierMask UhidServer::getLockState() const
+{
+    return 0;
+}
+
 void UhidServer::clearInputState()
 {
 }
 
+bool UhidServer::flush()
+{
+    return true;
+}
+
+bool UhidServer::processEvents()
+{
+    return false;
+}
+
 bool UhidServer::keyDown(KeyID, KeyModifierMask)
 {
     return false;
@@ -858,12 +1209,40 @@ bool UhidServer::mouseWheel(SInt32, SInt32)
     return false;
 }
 
+bool UhidServer::submitReport(const UInt8*, size_t)
+{
+    return false;
+}
+
 bool UhidServer::sendKeyboardReport()
 {
     return false;
 }
 
-bool UhidServer::sendMouseReport(SInt8, SInt8, SInt8, SInt8)
+void UhidServer::setKeyPressed(UInt8, bool)
+{
+}
+
+bool UhidServer::typeCharacter(const UhidKeyMap::Entry&)
+{
+    return false;
+}
+
+bool UhidServer::tapKey(UInt8, UInt8)
+{
+    return false;
+}
+
+bool UhidServer::sendMouseReport(SInt32, SInt32, SInt32, SInt32)
+{
+    return false;
+}
+
+void UhidServer::handleEvent(const struct uhid_event&)
+{
+}
+
+bool UhidServer::sendAbsoluteReport(SInt32, SInt32)
 {
     return false;
 }
@@ -1,21 +1,85 @@
 #pragma once
 
+#include "platform/UhidKeyMap.h"
 #include "barrier/key_types.h"
 #include "barrier/mouse_types.h"
 #include "base/String.h"
 
 #include <array>
+#include <vector>
+
+struct uhid_event;
 
 class UhidServer {
 public:
+    // layout of the relative pointer report
+    enum PointerReport {
+        kPointerReport8,    // -127..127 per axis, wheel in whole detents
+        kPointerReport16    // -32767..32767 per axis, high resolution wheel
+    };
+
+    // layout of the keyboard report
+    enum KeyboardReport {
+        kKeyboardReportBoot,    // six key slots, for compatibility
+        kKeyboardReportNkro     // a bit per usage, any number of keys
+    };
+
     UhidServer();
     ~UhidServer();
 
+    // selects the pointer report.  takes effect on the next start().
+    void setPointerReport(PointerReport report);
+
+    // selects the keyboard report.  takes effect on the next start().
+    void setKeyboardReport(KeyboardReport report);
+
+    // enables the absolute pointer collection, which places the cursor
+    // in a single report.  without it absolute moves are sent as the
+    // difference from the last position.  takes effect on the next
+    // start().
+    void setAbsolutePointer(bool enabled);
+
+    // the key the host has bound to Compose, used to type characters
+    // that aren't on a US layout.  without one they're entered as code
+    // points with Ctrl+Shift+U.
+    void setComposeKey(KeyID id);
+
+    // sets the screen area that the absolute pointer's range covers
+    void setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h);
+
+    // while buffered, reports are held until flush() and then written
+    // with a single writev().  otherwise each report is written at once.
+    void setBuffered(bool buffered);
+
+    // creates the device without waiting for the kernel to start it.
+    // reports made before then are held and written once it has, which
+    // processEvents() notices.
     bool start(const String& deviceName);
+
+    // starts on an already open uhid file descriptor, which is adopted.
+    // lets tests stand in for /dev/uhid.
+    bool start(int fd, const String& deviceName);
     void stop();
     bool running() const;
+
+    // true once the kernel has started the device
+    bool isStarted() const;
+
+    // the uhid file descriptor, readable when processEvents() has work
+    int getFd() const;
+
+    // the lock keys whose LEDs the host has turned on
+    KeyModifierMask getLockState() const;
     void clearInputState();
 
+    // writes every buffered report
+    bool flush();
+
+    // handles any events the kernel has sent the device and answers its
+    // requests without waiting for more.  returns false if the device
+    // failed.
+    bool processEvents();
+
     bool keyDown(KeyID id, KeyModifierMask mask);
     bool keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count);
     bool keyUp(KeyID id, KeyModifierMask mask);
@@ -27,19 +91,54 @@ public:
     bool mouseWheel(SInt32 xDelta, SInt32 yDelta);
 
 private:
+    bool submitReport(const UInt8* report, size_t size);
     bool sendKeyboardReport();
-    bool sendMouseReport(SInt8 dx, SInt8 dy, SInt8 wheel, SInt8 pan);
+    void setKeyPressed(UInt8 usage, bool pressed);
+
+    // type a character that has no key of its own
+    bool typeCharacter(const UhidKeyMap::Entry& key);
+
+    // press and release a key on its own
+    bool tapKey(UInt8 usage, UInt8 modifiers);
+    bool sendMouseReport(SInt32 dx, SInt32 dy, SInt32 wheel, SInt32 pan);
+    void handleEvent(const struct uhid_event& ev);
+    bool sendAbsoluteReport(SInt32 x, SInt32 y);
     bool updateMouseButtons(ButtonID id, bool pressed);
     bool sendRelativeMotion(SInt32 dx, SInt32 dy);
     bool sendWheelMotion(SInt32 xDelta, SInt32 yDelta);
 
 private:
     bool m_running;
+    bool m_started;
+    bool m_opened;
+    UInt8 m_ledState;
     int m_uhidFd;
+    bool m_buffered;
+
+    // buffered UHID_INPUT2 events, each cut short after its report
+    std::vector<UInt8> m_pending;
+    std::vector<size_t> m_pendingSizes;
+    PointerReport m_pointerReport;
+    KeyboardReport m_keyboardReport;
+    bool m_absolutePointer;
+    SInt32 m_screenX;
+    SInt32 m_screenY;
+    SInt32 m_screenW;
+    SInt32 m_screenH;
     bool m_hasLastAbsolute;
     SInt32 m_lastAbsX;
     SInt32 m_lastAbsY;
     UInt8 m_mouseButtons;
+
+    // resolution multiplier feature report set by the host, and the
+    // part of a detent not sent yet while it isn't
+    UInt8 m_resolutionMultiplier;
+    SInt32 m_wheelRemainder;
+    SInt32 m_panRemainder;
     UInt8 m_keyboardModifiers;
+    KeyID m_composeKey;
     std::array<UInt8, 6> m_keyboardKeys;
+
+    // pressed usages 0x00..0xE7 for the NKRO report
+    std::array<UInt8, 29> m_keyboardBitmap;
 };
@@ -0,0 +1,751 @@
+#include "platform/UinputDevice.h"
+
+#include "platform/UhidKeyMap.h"
+#include "base/Log.h"
+
+#if defined(__linux__)
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+static const char* kUinputPath = "/dev/uinput";
+static const SInt32 kAbsoluteMax = 32767;
+
+// wheel units per detent, same as barrier's wheel deltas
+static const SInt32 kWheelDetent = 120;
+
+struct KeyCode {
+    UInt8 m_usage;
+    UInt16 m_code;
+};
+
+// the kernel's HID keyboard usage to key code table, hid_keyboard[] in
+// drivers/hid/hid-input.c, plus the two keys it leaves out
+constexpr KeyCode kKeyCodes[] = {
+    { 0x04, KEY_A }, { 0x05, KEY_B }, { 0x06, KEY_C }, { 0x07, KEY_D },
+    { 0x08, KEY_E }, { 0x09, KEY_F }, { 0x0a, KEY_G }, { 0x0b, KEY_H },
+    { 0x0c, KEY_I }, { 0x0d, KEY_J }, { 0x0e, KEY_K }, { 0x0f, KEY_L },
+    { 0x10, KEY_M }, { 0x11, KEY_N }, { 0x12, KEY_O }, { 0x13, KEY_P },
+    { 0x14, KEY_Q }, { 0x15, KEY_R }, { 0x16, KEY_S }, { 0x17, KEY_T },
+    { 0x18, KEY_U }, { 0x19, KEY_V }, { 0x1a, KEY_W }, { 0x1b, KEY_X },
+    { 0x1c, KEY_Y }, { 0x1d, KEY_Z }, { 0x1e, KEY_1 }, { 0x1f, KEY_2 },
+    { 0x20, KEY_3 }, { 0x21, KEY_4 }, { 0x22, KEY_5 }, { 0x23, KEY_6 },
+    { 0x24, KEY_7 }, { 0x25, KEY_8 }, { 0x26, KEY_9 }, { 0x27, KEY_0 },
+    { 0x28, KEY_ENTER }, { 0x29, KEY_ESC }, { 0x2a, KEY_BACKSPACE }, { 0x2b, KEY_TAB },
+    { 0x2c, KEY_SPACE }, { 0x2d, KEY_MINUS }, { 0x2e, KEY_EQUAL }, { 0x2f, KEY_LEFTBRACE },
+    { 0x30, KEY_RIGHTBRACE }, { 0x31, KEY_BACKSLASH }, { 0x32, KEY_BACKSLASH }, { 0x33, KEY_SEMICOLON },
+    { 0x34, KEY_APOSTROPHE }, { 0x35, KEY_GRAVE }, { 0x36, KEY_COMMA }, { 0x37, KEY_DOT },
+    { 0x38, KEY_SLASH }, { 0x39, KEY_CAPSLOCK }, { 0x3a, KEY_F1 }, { 0x3b, KEY_F2 },
+    { 0x3c, KEY_F3 }, { 0x3d, KEY_F4 }, { 0x3e, KEY_F5 }, { 0x3f, KEY_F6 },
+    { 0x40, KEY_F7 }, { 0x41, KEY_F8 }, { 0x42, KEY_F9 }, { 0x43, KEY_F10 },
+    { 0x44, KEY_F11 }, { 0x45, KEY_F12 }, { 0x46, KEY_SYSRQ }, { 0x47, KEY_SCROLLLOCK },
+    { 0x48, KEY_PAUSE }, { 0x49, KEY_INSERT }, { 0x4a, KEY_HOME }, { 0x4b, KEY_PAGEUP },
+    { 0x4c, KEY_DELETE }, { 0x4d, KEY_END }, { 0x4e, KEY_PAGEDOWN }, { 0x4f, KEY_RIGHT },
+    { 0x50, KEY_LEFT }, { 0x51, KEY_DOWN }, { 0x52, KEY_UP }, { 0x53, KEY_NUMLOCK },
+    { 0x54, KEY_KPSLASH }, { 0x55, KEY_KPASTERISK }, { 0x56, KEY_KPMINUS }, { 0x57, KEY_KPPLUS },
+    { 0x58, KEY_KPENTER }, { 0x59, KEY_KP1 }, { 0x5a, KEY_KP2 }, { 0x5b, KEY_KP3 },
+    { 0x5c, KEY_KP4 }, { 0x5d, KEY_KP5 }, { 0x5e, KEY_KP6 }, { 0x5f, KEY_KP7 },
+    { 0x60, KEY_KP8 }, { 0x61, KEY_KP9 }, { 0x62, KEY_KP0 }, { 0x63, KEY_KPDOT },
+    { 0x64, KEY_102ND }, { 0x65, KEY_COMPOSE }, { 0x66, KEY_POWER }, { 0x67, KEY_KPEQUAL },
+    { 0x68, KEY_F13 }, { 0x69, KEY_F14 }, { 0x6a, KEY_F15 }, { 0x6b, KEY_F16 },
+    { 0x6c, KEY_F17 }, { 0x6d, KEY_F18 }, { 0x6e, KEY_F19 }, { 0x6f, KEY_F20 },
+    { 0x70, KEY_F21 }, { 0x71, KEY_F22 }, { 0x72, KEY_F23 }, { 0x73, KEY_F24 },
+    { 0x74, KEY_OPEN }, { 0x75, KEY_HELP }, { 0x76, KEY_PROPS }, { 0x77, KEY_FRONT },
+    { 0x78, KEY_STOP }, { 0x79, KEY_AGAIN }, { 0x7a, KEY_UNDO }, { 0x7b, KEY_CUT },
+    { 0x7c, KEY_COPY }, { 0x7d, KEY_PASTE }, { 0x7e, KEY_FIND }, { 0x7f, KEY_MUTE },
+    { 0x80, KEY_VOLUMEUP }, { 0x81, KEY_VOLUMEDOWN }, { 0x85, KEY_KPCOMMA }, { 0x87, KEY_RO },
+    { 0x88, KEY_KATAKANAHIRAGANA }, { 0x89, KEY_YEN }, { 0x8a, KEY_HENKAN }, { 0x8b, KEY_MUHENKAN },
+    { 0x8c, KEY_KPJPCOMMA }, { 0x90, KEY_HANGEUL }, { 0x91, KEY_HANJA }, { 0x92, KEY_KATAKANA },
+    { 0x93, KEY_HIRAGANA }, { 0x94, KEY_ZENKAKUHANKAKU }, { 0x9a, KEY_SYSRQ }, { 0x9b, KEY_CANCEL },
+    { 0x9c, KEY_DELETE },
+    { 0xe0, KEY_LEFTCTRL }, { 0xe1, KEY_LEFTSHIFT }, { 0xe2, KEY_LEFTALT }, { 0xe3, KEY_LEFTMETA },
+    { 0xe4, KEY_RIGHTCTRL }, { 0xe5, KEY_RIGHTSHIFT }, { 0xe6, KEY_RIGHTALT }, { 0xe7, KEY_RIGHTMETA }
+};
+
+struct KeyCodeTable {
+    UInt16 m_code[256];
+};
+
+constexpr KeyCodeTable makeKeyCodeTable()
+{
+    KeyCodeTable table{};
+    for (size_t i = 0; i < sizeof(kKeyCodes) / sizeof(kKeyCodes[0]); ++i) {
+        table.m_code[kKeyCodes[i].m_usage] = kKeyCodes[i].m_code;
+    }
+    return table;
+}
+
+constexpr KeyCodeTable kKeyCodeTable = makeKeyCodeTable();
+
+// the modifier bits of UhidKeyMap are the usages from 0xe0 in order
+static const UInt8 kFirstModifierUsage = 0xe0;
+
+static const UInt16 kButtonCodes[] = { BTN_LEFT, BTN_RIGHT, BTN_MIDDLE, BTN_SIDE, BTN_EXTRA };
+
+static UInt16 button_code(ButtonID id)
+{
+    switch (id) {
+    case kButtonLeft:
+        return BTN_LEFT;
+    case kButtonRight:
+        return BTN_RIGHT;
+    case kButtonMiddle:
+        return BTN_MIDDLE;
+    case kButtonExtra0:
+        return BTN_SIDE;
+    case kButtonExtra1:
+        return BTN_EXTRA;
+    default:
+        return 0;
+    }
+}
+
+static bool set_bit(int fd, unsigned long request, int bit)
+{
+    if (ioctl(fd, request, bit) < 0) {
+        LOG((CLOG_DEBUG "uinput: cannot enable event code %d (%s)", bit, strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+UinputDevice::UinputDevice()
+    : m_running(false)
+    , m_keyboardFd(-1)
+    , m_absoluteFd(-1)
+    , m_absolutePointer(true)
+    , m_composeKey(kKeyNone)
+    , m_screenX(0)
+    , m_screenY(0)
+    , m_screenW(0)
+    , m_screenH(0)
+    , m_hasLastAbsolute(false)
+    , m_lastAbsX(0)
+    , m_lastAbsY(0)
+    , m_wheelRemainder(0)
+    , m_panRemainder(0)
+    , m_lastMoveAbsolute(false)
+    , m_modifiers(0)
+    , m_pressed(KEY_MAX + 1, false)
+{
+}
+
+UinputDevice::~UinputDevice()
+{
+    stop();
+}
+
+void UinputDevice::setAbsolutePointer(bool enabled)
+{
+    m_absolutePointer = enabled;
+}
+
+void UinputDevice::setComposeKey(KeyID id)
+{
+    m_composeKey = id;
+}
+
+void UinputDevice::setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h)
+{
+    m_screenX = x;
+    m_screenY = y;
+    m_screenW = w;
+    m_screenH = h;
+}
+
+bool UinputDevice::start(const String& deviceName)
+{
+    if (m_running) {
+        return true;
+    }
+
+    const String name = deviceName.empty() ? "BarrierVirtual Input" : deviceName;
+    m_keyboardFd = createDevice(name, false);
+    if (m_keyboardFd < 0) {
+        return false;
+    }
+
+    if (m_absolutePointer) {
+        m_absoluteFd = createDevice(name + " Absolute", true);
+        if (m_absoluteFd < 0) {
+            LOG((CLOG_WARN "uinput: no absolute pointer, sending cursor moves as motion"));
+        }
+    }
+
+    m_running = true;
+    clearInputState();
+    flush();
+    LOG((CLOG_NOTE "uinput: connected to Barrier input stream"));
+    return true;
+}
+
+int UinputDevice::createDevice(const String& name, bool absolute)
+{
+    int fd = open(kUinputPath, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        LOG((CLOG_WARN "uinput: open %s failed (%s)", kUinputPath, strerror(errno)));
+        return -1;
+    }
+
+    bool ok = set_bit(fd, UI_SET_EVBIT, EV_SYN) && set_bit(fd, UI_SET_EVBIT, EV_KEY);
+    for (size_t i = 0; ok && i < sizeof(kButtonCodes) / sizeof(kButtonCodes[0]); ++i) {
+        ok = set_bit(fd, UI_SET_KEYBIT, kButtonCodes[i]);
+    }
+
+    if (absolute) {
+        ok = ok && set_bit(fd, UI_SET_EVBIT, EV_ABS) &&
+             set_bit(fd, UI_SET_ABSBIT, ABS_X) && set_bit(fd, UI_SET_ABSBIT, ABS_Y);
+    }
+    else {
+        for (size_t i = 0; ok && i < sizeof(kKeyCodes) / sizeof(kKeyCodes[0]); ++i) {
+            ok = set_bit(fd, UI_SET_KEYBIT, kKeyCodes[i].m_code);
+        }
+        ok = ok && set_bit(fd, UI_SET_EVBIT, EV_REL) &&
+             set_bit(fd, UI_SET_RELBIT, REL_X) && set_bit(fd, UI_SET_RELBIT, REL_Y) &&
+             set_bit(fd, UI_SET_RELBIT, REL_WHEEL) && set_bit(fd, UI_SET_RELBIT, REL_HWHEEL);
+#if defined(REL_WHEEL_HI_RES)
+        // older kernels don't know these and scroll in whole detents
+        set_bit(fd, UI_SET_RELBIT, REL_WHEEL_HI_RES);
+        set_bit(fd, UI_SET_RELBIT, REL_HWHEEL_HI_RES);
+#endif
+    }
+
+    struct uinput_user_dev dev;
+    memset(&dev, 0, sizeof(dev));
+    strncpy(dev.name, name.c_str(), UINPUT_MAX_NAME_SIZE - 1);
+    dev.id.bustype = BUS_VIRTUAL;
+    dev.id.vendor = 0x1209;
+    dev.id.product = absolute ? 0x0002 : 0x0001;
+    dev.id.version = 1;
+    if (absolute) {
+        dev.absmin[ABS_X] = 0;
+        dev.absmax[ABS_X] = kAbsoluteMax;
+        dev.absmin[ABS_Y] = 0;
+        dev.absmax[ABS_Y] = kAbsoluteMax;
+    }
+
+    if (!ok || ::write(fd, &dev, sizeof(dev)) != static_cast<ssize_t>(sizeof(dev)) ||
+            ioctl(fd, UI_DEV_CREATE) < 0) {
+        LOG((CLOG_WARN "uinput: create failed (%s)", strerror(errno)));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void UinputDevice::stop()
+{
+    if (!m_running) {
+        return;
+    }
+
+    clearInputState();
+    flush();
+    ioctl(m_keyboardFd, UI_DEV_DESTROY);
+    close(m_keyboardFd);
+    m_keyboardFd = -1;
+    if (m_absoluteFd >= 0) {
+        ioctl(m_absoluteFd, UI_DEV_DESTROY);
+        close(m_absoluteFd);
+        m_absoluteFd = -1;
+    }
+    m_running = false;
+}
+
+bool UinputDevice::running() const
+{
+    return m_running;
+}
+
+void UinputDevice::clearInputState()
+{
+    m_hasLastAbsolute = false;
+    m_wheelRemainder = 0;
+    m_panRemainder = 0;
+    m_modifiers = 0;
+    if (!m_running) {
+        std::fill(m_pressed.begin(), m_pressed.end(), false);
+        return;
+    }
+
+    // buttons may be held on either device
+    for (size_t i = 0; i < sizeof(kButtonCodes) / sizeof(kButtonCodes[0]); ++i) {
+        if (m_pressed[kButtonCodes[i]] && m_absoluteFd >= 0) {
+            queue(true, EV_KEY, kButtonCodes[i], 0);
+        }
+    }
+    for (size_t code = 0; code < m_pressed.size(); ++code) {
+        setKey(static_cast<UInt16>(code), false);
+    }
+    sync(false);
+    if (m_absoluteFd >= 0) {
+        sync(true);
+    }
+}
+
+bool UinputDevice::flush()
+{
+    if (!m_running) {
+        m_keyboardEvents.clear();
+        m_absoluteEvents.clear();
+        return false;
+    }
+
+    bool result = write(m_keyboardFd, m_keyboardEvents);
+    if (m_absoluteFd >= 0) {
+        result = write(m_absoluteFd, m_absoluteEvents) && result;
+    }
+    return result;
+}
+
+bool UinputDevice::write(int fd, std::vector<Event>& events)
+{
+    if (events.empty()) {
+        return true;
+    }
+
+    std::vector<struct input_event> buffer(events.size());
+    memset(&buffer[0], 0, buffer.size() * sizeof(buffer[0]));
+    for (size_t i = 0; i < events.size(); ++i) {
+        buffer[i].type = events[i].m_type;
+        buffer[i].code = events[i].m_code;
+        buffer[i].value = events[i].m_value;
+    }
+    events.clear();
+
+    const ssize_t size = static_cast<ssize_t>(buffer.size() * sizeof(buffer[0]));
+    if (::write(fd, &buffer[0], size) != size) {
+        LOG((CLOG_DEBUG "uinput: write failed (%s)", strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void UinputDevice::queue(bool absolute, UInt16 type, UInt16 code, SInt32 value)
+{
+    Event event;
+    event.m_type = type;
+    event.m_code = code;
+    event.m_value = value;
+    (absolute ? m_absoluteEvents : m_keyboardEvents).push_back(event);
+}
+
+void UinputDevice::sync(bool absolute)
+{
+    std::vector<Event>& events = absolute ? m_absoluteEvents : m_keyboardEvents;
+    if (!events.empty() && events.back().m_type != EV_SYN) {
+        queue(absolute, EV_SYN, SYN_REPORT, 0);
+    }
+}
+
+void UinputDevice::setKey(UInt16 code, bool pressed)
+{
+    if (code == 0 || m_pressed[code] == pressed) {
+        return;
+    }
+    m_pressed[code] = pressed;
+    queue(false, EV_KEY, code, pressed ? 1 : 0);
+}
+
+void UinputDevice::setModifiers(UInt8 modifiers)
+{
+    for (UInt8 i = 0; i < 8; ++i) {
+        const UInt8 bit = static_cast<UInt8>(1u << i);
+        if (((m_modifiers ^ modifiers) & bit) != 0) {
+            setKey(getKeyCode(static_cast<UInt8>(kFirstModifierUsage + i)), (modifiers & bit) != 0);
+        }
+    }
+    m_modifiers = modifiers;
+}
+
+void UinputDevice::tapKey(UInt8 usage, UInt8 modifiers)
+{
+    const UInt16 code = getKeyCode(usage);
+    setModifiers(modifiers);
+    setKey(code, true);
+    sync(false);
+    setKey(code, false);
+    setModifiers(0);
+    sync(false);
+}
+
+bool UinputDevice::keyDown(KeyID id, KeyModifierMask mask)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    const UhidKeyMap::Entry key = UhidKeyMap::lookup(id);
+    switch (key.m_kind) {
+    case UhidKeyMap::kModifier:
+        setModifiers(UhidKeyMap::getModifiers(mask) | key.m_modifiers);
+        break;
+
+    case UhidKeyMap::kKey:
+        setModifiers(UhidKeyMap::getModifiers(mask) | key.m_modifiers);
+        setKey(getKeyCode(key.m_usage), true);
+        break;
+
+    case UhidKeyMap::kCompose:
+    case UhidKeyMap::kUnicode: {
+        UhidKeyMap::Stroke strokes[UhidKeyMap::kMaxStrokes];
+        const size_t n = UhidKeyMap::getStrokes(key, m_composeKey, strokes);
+        for (size_t i = 0; i < n; ++i) {
+            tapKey(strokes[i].m_usage, strokes[i].m_modifiers);
+        }
+        setModifiers(UhidKeyMap::getModifiers(mask));
+        break;
+    }
+
+    default:
+        return true;
+    }
+
+    sync(false);
+    return true;
+}
+
+bool UinputDevice::keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count)
+{
+    if (!m_running || count <= 0) {
+        return false;
+    }
+
+    const UhidKeyMap::Entry key = UhidKeyMap::lookup(id);
+    if (key.m_kind == UhidKeyMap::kUnmapped || key.m_kind == UhidKeyMap::kModifier) {
+        return true;
+    }
+
+    for (SInt32 i = 0; i < count; ++i) {
+        keyDown(id, mask);
+        keyUp(id, mask);
+    }
+    return true;
+}
+
+bool UinputDevice::keyUp(KeyID id, KeyModifierMask mask)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    const UhidKeyMap::Entry key = UhidKeyMap::lookup(id);
+    switch (key.m_kind) {
+    case UhidKeyMap::kModifier:
+        setModifiers(UhidKeyMap::getModifiers(mask) & static_cast<UInt8>(~key.m_modifiers));
+        break;
+
+    case UhidKeyMap::kKey:
+        setKey(getKeyCode(key.m_usage), false);
+        setModifiers(UhidKeyMap::getModifiers(mask));
+        break;
+
+    default:
+        return true;
+    }
+
+    sync(false);
+    return true;
+}
+
+bool UinputDevice::mouseDown(ButtonID id)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    const UInt16 code = button_code(id);
+    if (code == 0 || m_pressed[code]) {
+        return true;
+    }
+
+    const bool absolute = (m_lastMoveAbsolute && m_absoluteFd >= 0);
+    m_pressed[code] = true;
+    queue(absolute, EV_KEY, code, 1);
+    sync(absolute);
+    return true;
+}
+
+bool UinputDevice::mouseUp(ButtonID id)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    const UInt16 code = button_code(id);
+    if (code == 0 || !m_pressed[code]) {
+        return true;
+    }
+
+    // the release can't tell which device the press went to so it goes
+    // to both.  a release of a button that isn't down is ignored.
+    m_pressed[code] = false;
+    queue(false, EV_KEY, code, 0);
+    sync(false);
+    if (m_absoluteFd >= 0) {
+        queue(true, EV_KEY, code, 0);
+        sync(true);
+    }
+    return true;
+}
+
+bool UinputDevice::mouseMoveAbsolute(SInt32 x, SInt32 y)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    if (m_absoluteFd >= 0 && m_screenW > 0 && m_screenH > 0) {
+        // map the screen onto the axis range so the far edges land on
+        // 0 and kAbsoluteMax
+        const SInt32 w = std::max<SInt32>(m_screenW, 2);
+        const SInt32 h = std::max<SInt32>(m_screenH, 2);
+        x = std::max<SInt32>(0, std::min<SInt32>(w - 1, x - m_screenX));
+        y = std::max<SInt32>(0, std::min<SInt32>(h - 1, y - m_screenY));
+        queue(true, EV_ABS, ABS_X,
+              static_cast<SInt32>((static_cast<int64_t>(x) * kAbsoluteMax + (w - 1) / 2) / (w - 1)));
+        queue(true, EV_ABS, ABS_Y,
+              static_cast<SInt32>((static_cast<int64_t>(y) * kAbsoluteMax + (h - 1) / 2) / (h - 1)));
+        sync(true);
+        m_lastMoveAbsolute = true;
+        return true;
+    }
+
+    if (!m_hasLastAbsolute) {
+        m_lastAbsX = x;
+        m_lastAbsY = y;
+        m_hasLastAbsolute = true;
+        return true;
+    }
+
+    const SInt32 dx = x - m_lastAbsX;
+    const SInt32 dy = y - m_lastAbsY;
+    m_lastAbsX = x;
+    m_lastAbsY = y;
+    return sendRelativeMotion(dx, dy);
+}
+
+bool UinputDevice::mouseRelativeMove(SInt32 dx, SInt32 dy)
+{
+    if (!m_running) {
+        return false;
+    }
+    return sendRelativeMotion(dx, dy);
+}
+
+bool UinputDevice::sendRelativeMotion(SInt32 dx, SInt32 dy)
+{
+    m_lastMoveAbsolute = false;
+    if (dx != 0) {
+        queue(false, EV_REL, REL_X, dx);
+    }
+    if (dy != 0) {
+        queue(false, EV_REL, REL_Y, dy);
+    }
+    sync(false);
+    return true;
+}
+
+bool UinputDevice::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    // the high resolution axes take barrier's deltas as they are and the
+    // legacy ones are sent once a whole detent has built up, as the
+    // kernel does for HID mice
+    if (yDelta != 0) {
+#if defined(REL_WHEEL_HI_RES)
+        queue(false, EV_REL, REL_WHEEL_HI_RES, yDelta);
+#endif
+        m_wheelRemainder += yDelta;
+        const SInt32 detents = m_wheelRemainder / kWheelDetent;
+        if (detents != 0) {
+            queue(false, EV_REL, REL_WHEEL, detents);
+            m_wheelRemainder -= detents * kWheelDetent;
+        }
+    }
+    if (xDelta != 0) {
+#if defined(REL_HWHEEL_HI_RES)
+        queue(false, EV_REL, REL_HWHEEL_HI_RES, xDelta);
+#endif
+        m_panRemainder += xDelta;
+        const SInt32 detents = m_panRemainder / kWheelDetent;
+        if (detents != 0) {
+            queue(false, EV_REL, REL_HWHEEL, detents);
+            m_panRemainder -= detents * kWheelDetent;
+        }
+    }
+    sync(false);
+    return true;
+}
+
+UInt16 UinputDevice::getKeyCode(UInt8 usage)
+{
+    return kKeyCodeTable.m_code[usage];
+}
+
+#else
+
+UinputDevice::UinputDevice()
+    : m_running(false)
+    , m_keyboardFd(-1)
+    , m_absoluteFd(-1)
+    , m_absolutePointer(true)
+    , m_composeKey(kKeyNone)
+    , m_screenX(0)
+    , m_screenY(0)
+    , m_screenW(0)
+    , m_screenH(0)
+    , m_hasLastAbsolute(false)
+    , m_lastAbsX(0)
+    , m_lastAbsY(0)
+    , m_wheelRemainder(0)
+    , m_panRemainder(0)
+    , m_lastMoveAbsolute(false)
+    , m_modifiers(0)
+{
+}
+
+UinputDevice::~UinputDevice()
+{
+}
+
+void UinputDevice::setAbsolutePointer(bool enabled)
+{
+    m_absolutePointer = enabled;
+}
+
+void UinputDevice::setComposeKey(KeyID id)
+{
+    m_composeKey = id;
+}
+
+void UinputDevice::setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h)
+{
+    m_screenX = x;
+    m_screenY = y;
+    m_screenW = w;
+    m_screenH = h;
+}
+
+bool UinputDevice::start(const String&)
+{
+    LOG((CLOG_WARN "uinput: not supported on this platform"));
+    return false;
+}
+
+int UinputDevice::createDevice(const String&, bool)
+{
+    return -1;
+}
+
+void UinputDevice::stop()
+{
+}
+
+bool UinputDevice::running() const
+{
+    return false;
+}
+
+void UinputDevice::clearInputState()
+{
+}
+
+bool UinputDevice::flush()
+{
+    return false;
+}
+
+bool UinputDevice::write(int, std::vector<Event>&)
+{
+    return false;
+}
+
+void UinputDevice::queue(bool, UInt16, UInt16, SInt32)
+{
+}
+
+void UinputDevice::sync(bool)
+{
+}
+
+void UinputDevice::setKey(UInt16, bool)
+{
+}
+
+void UinputDevice::setModifiers(UInt8)
+{
+}
+
+void UinputDevice::tapKey(UInt8, UInt8)
+{
+}
+
+bool UinputDevice::keyDown(KeyID, KeyModifierMask)
+{
+    return false;
+}
+
+bool UinputDevice::keyRepeat(KeyID, KeyModifierMask, SInt32)
+{
+    return false;
+}
+
+bool UinputDevice::keyUp(KeyID, KeyModifierMask)
+{
+    return false;
+}
+
+bool UinputDevice::mouseDown(ButtonID)
+{
+    return false;
+}
+
+bool UinputDevice::mouseUp(ButtonID)
+{
+    return false;
+}
+
+bool UinputDevice::mouseMoveAbsolute(SInt32, SInt32)
+{
+    return false;
+}
+
+bool UinputDevice::mouseRelativeMove(SInt32, SInt32)
+{
+    return false;
+}
+
+bool UinputDevice::sendRelativeMotion(SInt32, SInt32)
+{
+    return false;
+}
+
+bool UinputDevice::mouseWheel(SInt32, SInt32)
+{
+    return false;
+}
+
+UInt16 UinputDevice::getKeyCode(UInt8)
+{
+    return 0;
+}
+
+#endif
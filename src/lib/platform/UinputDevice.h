@@ -0,0 +1,107 @@
+#pragma once
+
+#include "barrier/key_types.h"
+#include "barrier/mouse_types.h"
+#include "base/String.h"
+
+#include <vector>
+
+// injects input as evdev events through /dev/uinput.  unlike uhid there
+// is no HID report for the kernel to parse and unlike XTest no X server
+// is needed, so it also works on headless and Wayland hosts.
+//
+// every call ends its events with a SYN_REPORT and the events are held
+// until flush() writes them all at once.
+class UinputDevice {
+public:
+    UinputDevice();
+    ~UinputDevice();
+
+    // adds a second device that places the cursor directly.  without it
+    // absolute moves are sent as the difference from the last position.
+    // takes effect on the next start().
+    void setAbsolutePointer(bool enabled);
+
+    // the key the host has bound to Compose.  see UhidServer.
+    void setComposeKey(KeyID id);
+
+    // sets the screen area that the absolute pointer's range covers
+    void setScreenShape(SInt32 x, SInt32 y, SInt32 w, SInt32 h);
+
+    bool start(const String& deviceName);
+    void stop();
+    bool running() const;
+
+    // releases everything held down
+    void clearInputState();
+
+    // writes every event made since the last flush
+    bool flush();
+
+    bool keyDown(KeyID id, KeyModifierMask mask);
+    bool keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count);
+    bool keyUp(KeyID id, KeyModifierMask mask);
+
+    bool mouseDown(ButtonID id);
+    bool mouseUp(ButtonID id);
+    bool mouseMoveAbsolute(SInt32 x, SInt32 y);
+    bool mouseRelativeMove(SInt32 dx, SInt32 dy);
+    bool mouseWheel(SInt32 xDelta, SInt32 yDelta);
+
+    // the evdev key code the kernel gives a HID keyboard usage, or 0
+    static UInt16 getKeyCode(UInt8 usage);
+
+#ifdef BARRIER_TEST_ENV
+    // runs on descriptors the test opened instead of new devices.  they
+    // are closed by stop().
+    void startForTest(int keyboardFd, int absoluteFd)
+    {
+        m_keyboardFd = keyboardFd;
+        m_absoluteFd = absoluteFd;
+        m_running = true;
+    }
+#endif
+
+private:
+    struct Event {
+        UInt16 m_type;
+        UInt16 m_code;
+        SInt32 m_value;
+    };
+
+    int createDevice(const String& name, bool absolute);
+    void queue(bool absolute, UInt16 type, UInt16 code, SInt32 value);
+    void sync(bool absolute);
+    bool write(int fd, std::vector<Event>& events);
+    void setKey(UInt16 code, bool pressed);
+    void setModifiers(UInt8 modifiers);
+    void tapKey(UInt8 usage, UInt8 modifiers);
+    bool sendRelativeMotion(SInt32 dx, SInt32 dy);
+
+private:
+    bool m_running;
+    int m_keyboardFd;
+    int m_absoluteFd;
+    bool m_absolutePointer;
+    KeyID m_composeKey;
+    SInt32 m_screenX;
+    SInt32 m_screenY;
+    SInt32 m_screenW;
+    SInt32 m_screenH;
+    bool m_hasLastAbsolute;
+    SInt32 m_lastAbsX;
+    SInt32 m_lastAbsY;
+    SInt32 m_wheelRemainder;
+    SInt32 m_panRemainder;
+
+    // buttons go to whichever device last moved the cursor
+    bool m_lastMoveAbsolute;
+    UInt8 m_modifiers;
+
+    // pressed evdev key and button codes
+    std::vector<bool> m_pressed;
+
+    // events not written yet, for each device
+    std::vector<Event> m_keyboardEvents;
+    std::vector<Event> m_absoluteEvents;
+};
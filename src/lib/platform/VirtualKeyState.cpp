@@ -0,0 +1,74 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/VirtualKeyState.h"
+
+//
+// VirtualKeyState
+//
+
+VirtualKeyState::VirtualKeyState(IEventQueue* events) :
+    KeyState(events)
+{
+    // do nothing
+}
+
+VirtualKeyState::~VirtualKeyState()
+{
+    // do nothing
+}
+
+bool
+VirtualKeyState::fakeCtrlAltDel()
+{
+    return false;
+}
+
+KeyModifierMask
+VirtualKeyState::pollActiveModifiers() const
+{
+    // the shadowed state is the real state
+    return getActiveModifiers();
+}
+
+SInt32
+VirtualKeyState::pollActiveGroup() const
+{
+    return 0;
+}
+
+void
+VirtualKeyState::pollPressedKeys(KeyButtonSet& pressedKeys) const
+{
+    for (KeyButton button = 1; button < IKeyState::kNumButtons; ++button) {
+        if (isKeyDown(button)) {
+            pressedKeys.insert(button);
+        }
+    }
+}
+
+void
+VirtualKeyState::getKeyMap(barrier::KeyMap&)
+{
+    // no keyboard, no keys
+}
+
+void
+VirtualKeyState::fakeKey(const Keystroke&)
+{
+    // never called since the key map is empty
+}
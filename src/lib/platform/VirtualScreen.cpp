@@ -0,0 +1,405 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/VirtualScreen.h"
+
+#include "platform/VirtualKeyState.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+
+#include <algorithm>
+
+//
+// VirtualScreen
+//
+
+VirtualScreen::VirtualScreen(SInt32 x, SInt32 y, SInt32 w, SInt32 h,
+                IEventQueue* events) :
+    PlatformScreen(events),
+    m_x(x),
+    m_y(y),
+    m_w(w),
+    m_h(h),
+    m_xCenter(x + w / 2),
+    m_yCenter(y + h / 2),
+    m_xCursor(m_xCenter),
+    m_yCursor(m_yCenter),
+    m_isOnScreen(true),
+    m_nextHotKeyID(1),
+    m_keyState(new VirtualKeyState(events)),
+    m_events(events)
+{
+    std::fill(m_buttons, m_buttons + NumButtonIDs, false);
+    LOG((CLOG_DEBUG "virtual screen shape=%d,%d %dx%d", m_x, m_y, m_w, m_h));
+}
+
+VirtualScreen::~VirtualScreen()
+{
+    delete m_keyState;
+}
+
+bool
+VirtualScreen::isOnScreen() const
+{
+    return m_isOnScreen;
+}
+
+void*
+VirtualScreen::getEventTarget() const
+{
+    return const_cast<VirtualScreen*>(this);
+}
+
+bool
+VirtualScreen::getClipboard(ClipboardID id, IClipboard* clipboard) const
+{
+    if (id >= kClipboardEnd) {
+        return false;
+    }
+    return IClipboard::copy(clipboard, &m_clipboard[id]);
+}
+
+void
+VirtualScreen::getShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h) const
+{
+    x = m_x;
+    y = m_y;
+    w = m_w;
+    h = m_h;
+}
+
+void
+VirtualScreen::getCursorPos(SInt32& x, SInt32& y) const
+{
+    x = m_xCursor;
+    y = m_yCursor;
+}
+
+void
+VirtualScreen::reconfigure(UInt32)
+{
+    // do nothing
+}
+
+void
+VirtualScreen::warpCursor(SInt32 x, SInt32 y)
+{
+    m_xCursor = x;
+    m_yCursor = y;
+}
+
+UInt32
+VirtualScreen::registerHotKey(KeyID key, KeyModifierMask mask)
+{
+    // fail if no keys
+    if (key == kKeyNone && mask == 0) {
+        return 0;
+    }
+
+    HotKeyItem item(key, mask);
+    if (m_hotKeyToIDMap.count(item) > 0) {
+        LOG((CLOG_WARN "hotkey id=%04x mask=%04x is already registered", key, mask));
+        return 0;
+    }
+
+    UInt32 id = m_nextHotKeyID++;
+    m_hotKeyToIDMap[item] = id;
+    LOG((CLOG_DEBUG "registered hotkey id=%04x mask=%04x as id=%d", key, mask, id));
+    return id;
+}
+
+void
+VirtualScreen::unregisterHotKey(UInt32 id)
+{
+    for (HotKeyToIDMap::iterator i = m_hotKeyToIDMap.begin();
+                                i != m_hotKeyToIDMap.end(); ++i) {
+        if (i->second == id) {
+            m_hotKeyToIDMap.erase(i);
+            LOG((CLOG_DEBUG "unregistered hotkey id=%d", id));
+            return;
+        }
+    }
+}
+
+void
+VirtualScreen::fakeInputBegin()
+{
+    // do nothing
+}
+
+void
+VirtualScreen::fakeInputEnd()
+{
+    // do nothing
+}
+
+SInt32
+VirtualScreen::getJumpZoneSize() const
+{
+    return 1;
+}
+
+bool
+VirtualScreen::isAnyMouseButtonDown(UInt32& buttonID) const
+{
+    for (UInt32 i = 1; i < NumButtonIDs; ++i) {
+        if (m_buttons[i]) {
+            buttonID = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+VirtualScreen::getCursorCenter(SInt32& x, SInt32& y) const
+{
+    x = m_xCenter;
+    y = m_yCenter;
+}
+
+void
+VirtualScreen::fakeMouseButton(ButtonID, bool)
+{
+    // a primary screen doesn't fake input
+}
+
+void
+VirtualScreen::fakeMouseMove(SInt32 x, SInt32 y)
+{
+    warpCursor(x, y);
+}
+
+void
+VirtualScreen::fakeMouseRelativeMove(SInt32, SInt32) const
+{
+    // a primary screen doesn't fake input
+}
+
+void
+VirtualScreen::fakeMouseWheel(SInt32, SInt32) const
+{
+    // a primary screen doesn't fake input
+}
+
+void
+VirtualScreen::enable()
+{
+    // nothing to capture
+}
+
+void
+VirtualScreen::disable()
+{
+    // nothing to release
+}
+
+void
+VirtualScreen::enter()
+{
+    m_isOnScreen = true;
+}
+
+bool
+VirtualScreen::leave()
+{
+    // park the cursor in the center, as a screen that captures input
+    // would, so motion is reported relative to it
+    warpCursor(m_xCenter, m_yCenter);
+    m_isOnScreen = false;
+    return true;
+}
+
+bool
+VirtualScreen::setClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    if (id >= kClipboardEnd) {
+        return false;
+    }
+    if (clipboard == NULL) {
+        m_clipboard[id].open(0);
+        m_clipboard[id].empty();
+        m_clipboard[id].close();
+        return true;
+    }
+    return IClipboard::copy(&m_clipboard[id], clipboard);
+}
+
+void
+VirtualScreen::checkClipboards()
+{
+    // nothing else can own the clipboards
+}
+
+void
+VirtualScreen::openScreensaver(bool)
+{
+    // no screen saver
+}
+
+void
+VirtualScreen::closeScreensaver()
+{
+    // no screen saver
+}
+
+void
+VirtualScreen::screensaver(bool)
+{
+    // no screen saver
+}
+
+void
+VirtualScreen::resetOptions()
+{
+    // no options
+}
+
+void
+VirtualScreen::setOptions(const OptionsList&)
+{
+    // no options
+}
+
+void
+VirtualScreen::setSequenceNumber(UInt32)
+{
+    // clipboards are never grabbed here so the number isn't needed
+}
+
+bool
+VirtualScreen::isPrimary() const
+{
+    return true;
+}
+
+void
+VirtualScreen::injectMouseMove(SInt32 x, SInt32 y)
+{
+    onMouseMove(x, y);
+}
+
+void
+VirtualScreen::injectMouseRelativeMove(SInt32 dx, SInt32 dy)
+{
+    onMouseMove(m_xCursor + dx, m_yCursor + dy);
+}
+
+void
+VirtualScreen::injectMouseButton(ButtonID id, bool press)
+{
+    if (id == kButtonNone || id >= NumButtonIDs) {
+        LOG((CLOG_DEBUG "ignored injected button %d", id));
+        return;
+    }
+
+    m_buttons[id] = press;
+    KeyModifierMask mask = m_keyState->getActiveModifiers();
+    if (press) {
+        sendEvent(m_events->forIPrimaryScreen().buttonDown(),
+                            ButtonInfo::alloc(id, mask));
+    }
+    else {
+        sendEvent(m_events->forIPrimaryScreen().buttonUp(),
+                            ButtonInfo::alloc(id, mask));
+    }
+}
+
+void
+VirtualScreen::injectMouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+    if (xDelta != 0 || yDelta != 0) {
+        sendEvent(m_events->forIPrimaryScreen().wheel(),
+                            WheelInfo::alloc(xDelta, yDelta));
+    }
+}
+
+void
+VirtualScreen::injectKey(KeyID id, KeyModifierMask mask,
+                KeyButton button, bool press)
+{
+    if (onHotKey(id, mask, press)) {
+        return;
+    }
+
+    m_keyState->onKey(button, press, mask);
+    m_keyState->sendKeyEvent(getEventTarget(), press, false,
+                            id, mask, 1, button);
+}
+
+void
+VirtualScreen::handleSystemEvent(const Event&, void*)
+{
+    // there are no system events
+}
+
+void
+VirtualScreen::updateButtons()
+{
+    // do nothing
+}
+
+IKeyState*
+VirtualScreen::getKeyState() const
+{
+    return m_keyState;
+}
+
+void
+VirtualScreen::sendEvent(Event::Type type, void* data)
+{
+    m_events->addEvent(Event(type, getEventTarget(), data));
+}
+
+void
+VirtualScreen::onMouseMove(SInt32 x, SInt32 y)
+{
+    if (m_isOnScreen) {
+        // the cursor can't leave the screen but the server is told
+        // where it was headed.  that's past the edge when it should
+        // switch to the screen beyond.
+        m_xCursor = std::max(m_x, std::min(x, m_x + m_w - 1));
+        m_yCursor = std::max(m_y, std::min(y, m_y + m_h - 1));
+        sendEvent(m_events->forIPrimaryScreen().motionOnPrimary(),
+                            MotionInfo::alloc(x, y));
+    }
+    else {
+        // the cursor stays in the center and the server is sent how far
+        // it would have moved
+        SInt32 dx = x - m_xCursor;
+        SInt32 dy = y - m_yCursor;
+        if (dx != 0 || dy != 0) {
+            sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(),
+                            MotionInfo::alloc(dx, dy));
+        }
+    }
+}
+
+bool
+VirtualScreen::onHotKey(KeyID id, KeyModifierMask mask, bool press)
+{
+    HotKeyToIDMap::const_iterator i =
+        m_hotKeyToIDMap.find(HotKeyItem(id, mask));
+    if (i == m_hotKeyToIDMap.end()) {
+        return false;
+    }
+
+    Event::Type type = press ? m_events->forIPrimaryScreen().hotKeyDown() :
+                                m_events->forIPrimaryScreen().hotKeyUp();
+    sendEvent(type, HotKeyInfo::alloc(i->second));
+    return true;
+}
@@ -0,0 +1,138 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/PlatformScreen.h"
+#include "barrier/IInputInjector.h"
+#include "barrier/Clipboard.h"
+#include "common/stdmap.h"
+
+class VirtualKeyState;
+
+//! Primary screen without a display
+/*!
+A primary screen that isn't backed by any display or input device.  It
+has a fixed shape, captures nothing and its only input is what's given
+to the IInputInjector methods.  This lets the server run as an input
+router on a machine without a window system.
+*/
+class VirtualScreen : public PlatformScreen, public IInputInjector {
+public:
+    VirtualScreen(SInt32 x, SInt32 y, SInt32 w, SInt32 h,
+                            IEventQueue* events);
+    virtual ~VirtualScreen();
+
+    //! @name accessors
+    //@{
+
+    //! Check if the cursor is on this screen
+    bool                isOnScreen() const;
+
+    //@}
+
+    // IScreen overrides
+    virtual void*        getEventTarget() const;
+    virtual bool        getClipboard(ClipboardID id, IClipboard*) const;
+    virtual void        getShape(SInt32& x, SInt32& y,
+                            SInt32& width, SInt32& height) const;
+    virtual void        getCursorPos(SInt32& x, SInt32& y) const;
+
+    // IPrimaryScreen overrides
+    virtual void        reconfigure(UInt32 activeSides);
+    virtual void        warpCursor(SInt32 x, SInt32 y);
+    virtual UInt32        registerHotKey(KeyID key, KeyModifierMask mask);
+    virtual void        unregisterHotKey(UInt32 id);
+    virtual void        fakeInputBegin();
+    virtual void        fakeInputEnd();
+    virtual SInt32        getJumpZoneSize() const;
+    virtual bool        isAnyMouseButtonDown(UInt32& buttonID) const;
+    virtual void        getCursorCenter(SInt32& x, SInt32& y) const;
+
+    // ISecondaryScreen overrides
+    virtual void        fakeMouseButton(ButtonID id, bool press);
+    virtual void        fakeMouseMove(SInt32 x, SInt32 y);
+    virtual void        fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const;
+    virtual void        fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const;
+
+    // IPlatformScreen overrides
+    virtual void        enable();
+    virtual void        disable();
+    virtual void        enter();
+    virtual bool        leave();
+    virtual bool        setClipboard(ClipboardID, const IClipboard*);
+    virtual void        checkClipboards();
+    virtual void        openScreensaver(bool notify);
+    virtual void        closeScreensaver();
+    virtual void        screensaver(bool activate);
+    virtual void        resetOptions();
+    virtual void        setOptions(const OptionsList& options);
+    virtual void        setSequenceNumber(UInt32);
+    virtual bool        isPrimary() const;
+
+    // IInputInjector overrides
+    virtual void        injectMouseMove(SInt32 x, SInt32 y);
+    virtual void        injectMouseRelativeMove(SInt32 dx, SInt32 dy);
+    virtual void        injectMouseButton(ButtonID id, bool press);
+    virtual void        injectMouseWheel(SInt32 xDelta, SInt32 yDelta);
+    virtual void        injectKey(KeyID id, KeyModifierMask mask,
+                            KeyButton button, bool press);
+
+protected:
+    // IPlatformScreen overrides
+    virtual void        handleSystemEvent(const Event& event, void*);
+    virtual void        updateButtons();
+    virtual IKeyState*    getKeyState() const;
+
+private:
+    void                sendEvent(Event::Type, void* = NULL);
+
+    // report motion to (x,y).  while on the screen the cursor stays on
+    // it, otherwise the motion is taken relative to the center.
+    void                onMouseMove(SInt32 x, SInt32 y);
+
+    // post a hot key event if (id, mask) is a registered hot key
+    bool                onHotKey(KeyID id, KeyModifierMask mask, bool press);
+
+private:
+    typedef std::pair<KeyID, KeyModifierMask> HotKeyItem;
+    typedef std::map<HotKeyItem, UInt32> HotKeyToIDMap;
+
+    // screen shape
+    SInt32                m_x, m_y;
+    SInt32                m_w, m_h;
+    SInt32                m_xCenter, m_yCenter;
+
+    // last cursor position
+    SInt32                m_xCursor, m_yCursor;
+
+    // true if the cursor is on this screen
+    bool                m_isOnScreen;
+
+    // mouse button state
+    bool                m_buttons[NumButtonIDs];
+
+    // clipboards
+    Clipboard            m_clipboard[kClipboardEnd];
+
+    // hot keys
+    HotKeyToIDMap        m_hotKeyToIDMap;
+    UInt32                m_nextHotKeyID;
+
+    VirtualKeyState*    m_keyState;
+    IEventQueue*        m_events;
+};
@@ -490,6 +490,17 @@ int XWindowsImpl::XISelectEvents(Display* display, Window w, XIEventMask* masks,
     return ::XISelectEvents(display, w, masks, num_masks);
 }
 
+XIDeviceInfo* XWindowsImpl::XIQueryDevice(Display* display, int deviceid,
+                                          int* ndevices_return)
+{
+    return ::XIQueryDevice(display, deviceid, ndevices_return);
+}
+
+void XWindowsImpl::XIFreeDeviceInfo(XIDeviceInfo* info)
+{
+    ::XIFreeDeviceInfo(info);
+}
+
 Atom XWindowsImpl::XInternAtom(Display* display, _Xconst char* atom_name,
                                Bool only_if_exists)
 {
@@ -147,6 +147,9 @@ public:
     virtual int XRefreshKeyboardMapping(XMappingEvent* event_map);
     virtual int XISelectEvents(Display* display, Window w, XIEventMask* masks,
                                int num_masks);
+    virtual XIDeviceInfo* XIQueryDevice(Display* display, int deviceid,
+                                        int* ndevices_return);
+    virtual void XIFreeDeviceInfo(XIDeviceInfo* info);
     virtual Atom XInternAtom(Display* display, _Xconst char* atom_name,
                              Bool only_if_exists);
     virtual int XGetScreenSaver(Display* display, int* timeout_return,
@@ -35,12 +35,31 @@
 
 static const size_t ModifiersFromXDefaultSize = 32;
 
+// how many key maps for other XKB maps are kept
+static const size_t s_keyMapCacheSize = 8;
+
+// folds value into an FNV-1a hash
+template <typename T>
+static void
+hashValue(std::uint64_t& hash, const T& value)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0; i < sizeof(value); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
 XWindowsKeyState::XWindowsKeyState(IXWindowsImpl* impl,
         Display* display, bool useXKB,
         IEventQueue* events) :
     KeyState(events),
     m_display(display),
-    m_modifierFromX(ModifiersFromXDefaultSize)
+    m_modifierFromX(ModifiersFromXDefaultSize),
+    m_keyMapIdentity(0),
+    m_numGroups(0),
+    m_usedLastGoodModifiers(false),
+    m_deferFlush(false)
 {
      m_impl = impl;
 
@@ -52,7 +71,11 @@ XWindowsKeyState::XWindowsKeyState(IXWindowsImpl* impl,
     IEventQueue* events, barrier::KeyMap& keyMap) :
     KeyState(events, keyMap),
     m_display(display),
-    m_modifierFromX(ModifiersFromXDefaultSize)
+    m_modifierFromX(ModifiersFromXDefaultSize),
+    m_keyMapIdentity(0),
+    m_numGroups(0),
+    m_usedLastGoodModifiers(false),
+    m_deferFlush(false)
 {
     m_impl = impl;
     init(display, useXKB);
@@ -70,7 +93,7 @@ XWindowsKeyState::~XWindowsKeyState()
 void
 XWindowsKeyState::init(Display* display, bool useXKB)
 {
-    XGetKeyboardControl(m_display, &m_keyboardState);
+    m_impl->XGetKeyboardControl(m_display, &m_keyboardState);
 #if HAVE_XKB_EXTENSION
     if (useXKB) {
         m_xkb = m_impl->XkbGetMap(m_display,
@@ -84,6 +107,12 @@ XWindowsKeyState::init(Display* display, bool useXKB)
     setActiveGroup(kGroupPollAndSet);
 }
 
+void
+XWindowsKeyState::setDeferFlush(bool defer)
+{
+    m_deferFlush = defer;
+}
+
 void
 XWindowsKeyState::setActiveGroup(SInt32 group)
 {
@@ -217,26 +246,133 @@ XWindowsKeyState::pollPressedKeys(KeyButtonSet& pressedKeys) const
     }
 }
 
+void
+XWindowsKeyState::updateKeyMap()
+{
+    updateKeyMap(0, 0);
+}
+
+void
+XWindowsKeyState::updateKeyMap(KeyCode first, UInt32 count)
+{
+#if HAVE_XKB_EXTENSION
+    if (refreshKeyboardMap()) {
+        // switching layouts usually goes back to a map we've seen before
+        // so we keep the key maps built for the last few and use them
+        // again rather than build them again.
+        std::uint64_t identity = getKeyMapIdentityXKB();
+        if (identity == m_keyMapIdentity) {
+            LOG((CLOG_DEBUG1 "XKB mapping unchanged"));
+            return;
+        }
+        if (restoreKeyMap(identity)) {
+            LOG((CLOG_DEBUG1 "XKB mapping from cache"));
+            m_keyMapIdentity = identity;
+            return;
+        }
+
+        barrier::KeyMap keyMap;
+        if (count != 0 && updateKeycodesXKB(first, count)) {
+            // the rest of the map is unchanged.  it's not worth keeping
+            // the old map for a remapped key.
+            LOG((CLOG_DEBUG1 "XKB mapping for keycodes %d-%d", first, first + count - 1));
+            buildKeyMapXKB(keyMap);
+            setKeyMap(keyMap);
+        }
+        else {
+            // set the current map aside and build a new one
+            m_keyMapCache.emplace_front();
+            CachedKeyMap& old = m_keyMapCache.front();
+            old.m_identity = m_keyMapIdentity;
+            exchangeKeyMap(old);
+
+            updateKeysymMapXKB();
+            buildKeyMapXKB(keyMap);
+            setKeyMap(keyMap);
+            old.m_keyMap.swap(keyMap);
+
+            if (old.m_identity == 0) {
+                m_keyMapCache.pop_front();
+            }
+            else if (m_keyMapCache.size() > s_keyMapCacheSize) {
+                m_keyMapCache.pop_back();
+            }
+        }
+        m_keyMapIdentity = identity;
+        return;
+    }
+#endif
+
+    barrier::KeyMap keyMap;
+    updateKeysymMap(keyMap);
+    setKeyMap(keyMap);
+    m_keyMapIdentity = 0;
+    m_keycodeEntries.clear();
+}
+
 void
 XWindowsKeyState::getKeyMap(barrier::KeyMap& keyMap)
+{
+#if HAVE_XKB_EXTENSION
+    if (refreshKeyboardMap()) {
+        updateKeysymMapXKB();
+        buildKeyMapXKB(keyMap);
+        return;
+    }
+#endif
+    updateKeysymMap(keyMap);
+}
+
+bool
+XWindowsKeyState::refreshKeyboardMap()
 {
     // get autorepeat info.  we must use the global_auto_repeat told to
     // us because it may have modified by barrier.
     int oldGlobalAutoRepeat = m_keyboardState.global_auto_repeat;
-    XGetKeyboardControl(m_display, &m_keyboardState);
+    m_impl->XGetKeyboardControl(m_display, &m_keyboardState);
     m_keyboardState.global_auto_repeat = oldGlobalAutoRepeat;
 
 #if HAVE_XKB_EXTENSION
     if (m_xkb != NULL) {
         unsigned mask = XkbKeyActionsMask | XkbKeyBehaviorsMask |
                         XkbAllClientInfoMask;
-        if (m_impl->XkbGetUpdatedMap(m_display, mask, m_xkb) == Success) {
-            updateKeysymMapXKB(keyMap);
-            return;
-        }
+        return (m_impl->XkbGetUpdatedMap(m_display, mask, m_xkb) == Success);
     }
 #endif
-    updateKeysymMap(keyMap);
+    return false;
+}
+
+bool
+XWindowsKeyState::restoreKeyMap(std::uint64_t identity)
+{
+    for (std::list<CachedKeyMap>::iterator i = m_keyMapCache.begin();
+                                i != m_keyMapCache.end(); ++i) {
+        if (i->m_identity == identity) {
+            // the current map takes the cached map's place
+            i->m_identity = m_keyMapIdentity;
+            exchangeKeyMap(*i);
+            swapKeyMap(i->m_keyMap);
+            if (i->m_identity == 0) {
+                m_keyMapCache.erase(i);
+            }
+            else {
+                m_keyMapCache.splice(m_keyMapCache.begin(), m_keyMapCache, i);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+XWindowsKeyState::exchangeKeyMap(CachedKeyMap& cached)
+{
+    m_modifierFromX.swap(cached.m_modifierFromX);
+    m_modifierToX.swap(cached.m_modifierToX);
+    m_keyCodeFromKey.swap(cached.m_keyCodeFromKey);
+    m_keycodeEntries.swap(cached.m_keycodeEntries);
+    std::swap(m_numGroups, cached.m_numGroups);
+    std::swap(m_usedLastGoodModifiers, cached.m_usedLastGoodModifiers);
 }
 
 void
@@ -296,7 +432,9 @@ XWindowsKeyState::fakeKey(const Keystroke& keystroke)
         }
         break;
     }
-    XFlush(m_display);
+    if (!m_deferFlush) {
+        XFlush(m_display);
+    }
 }
 
 void
@@ -546,28 +684,12 @@ XWindowsKeyState::updateKeysymMap(barrier::KeyMap& keyMap)
 
 #if HAVE_XKB_EXTENSION
 void
-XWindowsKeyState::updateKeysymMapXKB(barrier::KeyMap& keyMap)
+XWindowsKeyState::updateKeysymMapXKB()
 {
-    static const XkbKTMapEntryRec defMapEntry = {
-        True,        // active
-        0,            // level
-        {
-            0,        // mods.mask
-            0,        // mods.real_mods
-            0        // mods.vmods
-        }
-    };
-
     LOG((CLOG_DEBUG1 "XKB mapping"));
 
     // find the number of groups
-    int maxNumGroups = 0;
-    for (int i = m_xkb->min_key_code; i <= m_xkb->max_key_code; ++i) {
-        int numGroups = m_impl->do_XkbKeyNumGroups(m_xkb, static_cast<KeyCode>(i));
-        if (numGroups > maxNumGroups) {
-            maxNumGroups = numGroups;
-        }
-    }
+    int maxNumGroups = getNumGroupsXKB();
 
     // prepare map from X modifier to KeyModifierMask
     std::vector<int> modifierLevel(maxNumGroups * 8, 4);
@@ -592,190 +714,275 @@ XWindowsKeyState::updateKeysymMapXKB(barrier::KeyMap& keyMap)
 
     // check every button.  on this pass we save all modifiers as native
     // X modifier masks.
-    barrier::KeyMap::KeyItem item;
+    m_keycodeEntries.clear();
+    m_keycodeEntries.resize(m_xkb->max_key_code + 1);
     for (int i = m_xkb->min_key_code; i <= m_xkb->max_key_code; ++i) {
-        KeyCode keycode = static_cast<KeyCode>(i);
-        item.m_button   = static_cast<KeyButton>(keycode);
-        item.m_client   = 0;
+        addKeycodeXKB(static_cast<KeyCode>(i), maxNumGroups,
+                                modifierLevel, useLastGoodModifiers);
+    }
+    m_numGroups             = maxNumGroups;
+    m_usedLastGoodModifiers = useLastGoodModifiers;
+}
 
-        // skip keys with no groups (they generate no symbols)
-        if (m_impl->do_XkbKeyNumGroups(m_xkb, keycode) == 0) {
-            continue;
+void
+XWindowsKeyState::addKeycodeXKB(KeyCode keycode, int maxNumGroups,
+                std::vector<int>& modifierLevel, bool useLastGoodModifiers)
+{
+    static const XkbKTMapEntryRec defMapEntry = {
+        True,        // active
+        0,            // level
+        {
+            0,        // mods.mask
+            0,        // mods.real_mods
+            0        // mods.vmods
         }
+    };
 
-        // note half-duplex keys
-        const XkbBehavior& b = m_xkb->server->behaviors[keycode];
-        if ((b.type & XkbKB_OpMask) == XkbKB_Lock) {
-            keyMap.addHalfDuplexButton(item.m_button);
-        }
+    KeycodeEntries& entries = m_keycodeEntries[keycode];
+    entries.m_halfDuplex = false;
+    entries.m_modifier   = false;
+    entries.m_items.clear();
 
-        // iterate over all groups
-        for (int group = 0; group < maxNumGroups; ++group) {
-            item.m_group = group;
-            int eGroup   = getEffectiveGroup(keycode, group);
+    barrier::KeyMap::KeyItem item;
+    item.m_button = static_cast<KeyButton>(keycode);
+    item.m_client = 0;
+    item.m_dead   = false;
 
-            // get key info
-            XkbKeyTypePtr type = m_impl->do_XkbKeyKeyType(m_xkb, keycode,
-                                                          eGroup);
+    // skip keys with no groups (they generate no symbols)
+    if (m_impl->do_XkbKeyNumGroups(m_xkb, keycode) == 0) {
+        return;
+    }
 
-            // set modifiers the item is sensitive to
-            item.m_sensitive = type->mods.mask;
+    // note half-duplex keys
+    const XkbBehavior& b = m_xkb->server->behaviors[keycode];
+    if ((b.type & XkbKB_OpMask) == XkbKB_Lock) {
+        entries.m_halfDuplex = true;
+    }
 
-            // iterate over all shift levels for the button (including none)
-            for (int j = -1; j < type->map_count; ++j) {
-                const XkbKTMapEntryRec* mapEntry =
-                    ((j == -1) ? &defMapEntry : type->map + j);
-                if (!mapEntry->active) {
-                    continue;
-                }
-                int level = mapEntry->level;
-
-                // set required modifiers for this item
-                item.m_required = mapEntry->mods.mask;
-                if ((item.m_required & LockMask) != 0 &&
-                    j != -1 && type->preserve != NULL &&
-                    (type->preserve[j].mask & LockMask) != 0) {
-                    // sensitive caps lock and we preserve caps-lock.
-                    // preserving caps-lock means we Xlib functions would
-                    // yield the capitialized KeySym so we'll adjust the
-                    // level accordingly.
-                    if ((level ^ 1) < type->num_levels) {
-                        level ^= 1;
-                    }
-                }
+    // iterate over all groups
+    for (int group = 0; group < maxNumGroups; ++group) {
+        item.m_group = group;
+        int eGroup   = getEffectiveGroup(keycode, group);
 
-                // get the keysym for this item
-                KeySym keysym = m_impl->do_XkbKeySymEntry(m_xkb, keycode, level,
-                                                          eGroup);
+        // get key info
+        XkbKeyTypePtr type = m_impl->do_XkbKeyKeyType(m_xkb, keycode,
+                                                      eGroup);
 
-                // check for group change actions, locking modifiers, and
-                // modifier masks.
-                item.m_lock         = false;
-                bool isModifier     = false;
-                UInt32 modifierMask = m_xkb->map->modmap[keycode];
-                if (m_impl->do_XkbKeyHasActions(m_xkb, keycode) == True) {
-                    XkbAction* action =
-                        m_impl->do_XkbKeyActionEntry(m_xkb, keycode, level,
-                                                     eGroup);
-                    if (action->type == XkbSA_SetMods ||
-                        action->type == XkbSA_LockMods) {
-                        isModifier  = true;
+        // set modifiers the item is sensitive to
+        item.m_sensitive = type->mods.mask;
 
-                        // note toggles
-                        item.m_lock = (action->type == XkbSA_LockMods);
+        // iterate over all shift levels for the button (including none)
+        for (int j = -1; j < type->map_count; ++j) {
+            const XkbKTMapEntryRec* mapEntry =
+                ((j == -1) ? &defMapEntry : type->map + j);
+            if (!mapEntry->active) {
+                continue;
+            }
+            int level = mapEntry->level;
+
+            // set required modifiers for this item
+            item.m_required = mapEntry->mods.mask;
+            if ((item.m_required & LockMask) != 0 &&
+                j != -1 && type->preserve != NULL &&
+                (type->preserve[j].mask & LockMask) != 0) {
+                // sensitive caps lock and we preserve caps-lock.
+                // preserving caps-lock means we Xlib functions would
+                // yield the capitialized KeySym so we'll adjust the
+                // level accordingly.
+                if ((level ^ 1) < type->num_levels) {
+                    level ^= 1;
+                }
+            }
 
-                        // maybe use action's mask
-                        if ((action->mods.flags & XkbSA_UseModMapMods) == 0) {
-                            modifierMask = action->mods.mask;
-                        }
-                    }
-                    else if (action->type == XkbSA_SetGroup ||
-                            action->type == XkbSA_LatchGroup ||
-                            action->type == XkbSA_LockGroup) {
-                        // ignore group change key
-                        continue;
+            // get the keysym for this item
+            KeySym keysym = m_impl->do_XkbKeySymEntry(m_xkb, keycode, level,
+                                                      eGroup);
+
+            // check for group change actions, locking modifiers, and
+            // modifier masks.
+            item.m_lock         = false;
+            bool isModifier     = false;
+            UInt32 modifierMask = m_xkb->map->modmap[keycode];
+            if (m_impl->do_XkbKeyHasActions(m_xkb, keycode) == True) {
+                XkbAction* action =
+                    m_impl->do_XkbKeyActionEntry(m_xkb, keycode, level,
+                                                 eGroup);
+                if (action->type == XkbSA_SetMods ||
+                    action->type == XkbSA_LockMods) {
+                    isModifier  = true;
+
+                    // note toggles
+                    item.m_lock = (action->type == XkbSA_LockMods);
+
+                    // maybe use action's mask
+                    if ((action->mods.flags & XkbSA_UseModMapMods) == 0) {
+                        modifierMask = action->mods.mask;
                     }
                 }
-                level = mapEntry->level;
-
-                // VMware modifier hack
-                if (useLastGoodModifiers) {
-                    XKBModifierMap::const_iterator k =
-                        m_lastGoodXKBModifiers.find(eGroup * 256 + keycode);
-                    if (k != m_lastGoodXKBModifiers.end()) {
-                        // Use last known good modifier
-                        isModifier   = true;
-                        level        = k->second.m_level;
-                        modifierMask = k->second.m_mask;
-                        item.m_lock  = k->second.m_lock;
-                    }
+                else if (action->type == XkbSA_SetGroup ||
+                        action->type == XkbSA_LatchGroup ||
+                        action->type == XkbSA_LockGroup) {
+                    // ignore group change key
+                    continue;
                 }
-                else if (isModifier) {
-                    // Save known good modifier
-                    XKBModifierInfo& info =
-                        m_lastGoodXKBModifiers[eGroup * 256 + keycode];
-                    info.m_level = level;
-                    info.m_mask  = modifierMask;
-                    info.m_lock  = item.m_lock;
+            }
+            level = mapEntry->level;
+
+            // VMware modifier hack
+            if (useLastGoodModifiers) {
+                XKBModifierMap::const_iterator k =
+                    m_lastGoodXKBModifiers.find(eGroup * 256 + keycode);
+                if (k != m_lastGoodXKBModifiers.end()) {
+                    // Use last known good modifier
+                    isModifier   = true;
+                    level        = k->second.m_level;
+                    modifierMask = k->second.m_mask;
+                    item.m_lock  = k->second.m_lock;
                 }
+            }
+            else if (isModifier) {
+                // Save known good modifier
+                XKBModifierInfo& info =
+                    m_lastGoodXKBModifiers[eGroup * 256 + keycode];
+                info.m_level = level;
+                info.m_mask  = modifierMask;
+                info.m_lock  = item.m_lock;
+            }
+            if (isModifier) {
+                entries.m_modifier = true;
+            }
 
-                // record the modifier mask for this key.  don't bother
-                // for keys that change the group.
-                item.m_generates = 0;
-                UInt32 modifierBit =
-                    XWindowsUtil::getModifierBitForKeySym(keysym);
-                if (isModifier && modifierBit != kKeyModifierBitNone) {
-                    item.m_generates = (1u << modifierBit);
-                    for (SInt32 j = 0; j < 8; ++j) {
-                        // skip modifiers this key doesn't generate
-                        if ((modifierMask & (1u << j)) == 0) {
-                            continue;
-                        }
-
-                        // skip keys that map to a modifier that we've
-                        // already seen using fewer modifiers.  that is
-                        // if this key must combine with other modifiers
-                        // and we know of a key that combines with fewer
-                        // modifiers (or no modifiers) then prefer the
-                        // other key.
-                        if (level >= modifierLevel[8 * group + j]) {
-                            continue;
-                        }
-                        modifierLevel[8 * group + j] = level;
-
-                        // save modifier
-                        m_modifierFromX[8 * group + j] |= (1u << modifierBit);
-                        m_modifierToX.insert(std::make_pair(
-                                1u << modifierBit, 1u << j));
+            // record the modifier mask for this key.  don't bother
+            // for keys that change the group.
+            item.m_generates = 0;
+            UInt32 modifierBit =
+                XWindowsUtil::getModifierBitForKeySym(keysym);
+            if (isModifier && modifierBit != kKeyModifierBitNone) {
+                item.m_generates = (1u << modifierBit);
+                for (SInt32 j = 0; j < 8; ++j) {
+                    // skip modifiers this key doesn't generate
+                    if ((modifierMask & (1u << j)) == 0) {
+                        continue;
                     }
-                }
 
-                // handle special cases of just one keysym for the keycode
-                if (type->num_levels == 1) {
-                    // if there are upper- and lowercase versions of the
-                    // keysym then add both.
-                    KeySym lKeysym, uKeysym;
-                    XConvertCase(keysym, &lKeysym, &uKeysym);
-                    if (lKeysym != uKeysym) {
-                        if (j != -1) {
-                            continue;
-                        }
-
-                        item.m_sensitive |= ShiftMask | LockMask;
-
-                        KeyID lKeyID = XWindowsUtil::mapKeySymToKeyID(lKeysym);
-                        KeyID uKeyID = XWindowsUtil::mapKeySymToKeyID(uKeysym);
-                        if (lKeyID == kKeyNone || uKeyID == kKeyNone) {
-                            continue;
-                        }
-
-                        item.m_id       = lKeyID;
-                        item.m_required = 0;
-                        keyMap.addKeyEntry(item);
-
-                        item.m_id       = uKeyID;
-                        item.m_required = ShiftMask;
-                        keyMap.addKeyEntry(item);
-                        item.m_required = LockMask;
-                        keyMap.addKeyEntry(item);
-
-                        if (group == 0) {
-                            m_keyCodeFromKey.insert(
-                                    std::make_pair(lKeyID, keycode));
-                            m_keyCodeFromKey.insert(
-                                    std::make_pair(uKeyID, keycode));
-                        }
+                    // skip keys that map to a modifier that we've
+                    // already seen using fewer modifiers.  that is
+                    // if this key must combine with other modifiers
+                    // and we know of a key that combines with fewer
+                    // modifiers (or no modifiers) then prefer the
+                    // other key.
+                    if (level >= modifierLevel[8 * group + j]) {
                         continue;
                     }
+                    modifierLevel[8 * group + j] = level;
+
+                    // save modifier
+                    m_modifierFromX[8 * group + j] |= (1u << modifierBit);
+                    m_modifierToX.insert(std::make_pair(
+                            1u << modifierBit, 1u << j));
                 }
+            }
+
+            // handle special cases of just one keysym for the keycode
+            if (type->num_levels == 1) {
+                // if there are upper- and lowercase versions of the
+                // keysym then add both.
+                KeySym lKeysym, uKeysym;
+                XConvertCase(keysym, &lKeysym, &uKeysym);
+                if (lKeysym != uKeysym) {
+                    if (j != -1) {
+                        continue;
+                    }
 
-                // add entry
-                item.m_id = XWindowsUtil::mapKeySymToKeyID(keysym);
-                keyMap.addKeyEntry(item);
-                if (group == 0) {
-                    m_keyCodeFromKey.insert(std::make_pair(item.m_id, keycode));
+                    item.m_sensitive |= ShiftMask | LockMask;
+
+                    KeyID lKeyID = XWindowsUtil::mapKeySymToKeyID(lKeysym);
+                    KeyID uKeyID = XWindowsUtil::mapKeySymToKeyID(uKeysym);
+                    if (lKeyID == kKeyNone || uKeyID == kKeyNone) {
+                        continue;
+                    }
+
+                    item.m_id       = lKeyID;
+                    item.m_required = 0;
+                    entries.m_items.push_back(item);
+
+                    item.m_id       = uKeyID;
+                    item.m_required = ShiftMask;
+                    entries.m_items.push_back(item);
+                    item.m_required = LockMask;
+                    entries.m_items.push_back(item);
+
+                    if (group == 0) {
+                        m_keyCodeFromKey.insert(
+                                std::make_pair(lKeyID, keycode));
+                        m_keyCodeFromKey.insert(
+                                std::make_pair(uKeyID, keycode));
+                    }
+                    continue;
                 }
             }
+
+            // add entry
+            item.m_id = XWindowsUtil::mapKeySymToKeyID(keysym);
+            entries.m_items.push_back(item);
+            if (group == 0) {
+                m_keyCodeFromKey.insert(std::make_pair(item.m_id, keycode));
+            }
+        }
+    }
+}
+
+bool
+XWindowsKeyState::updateKeycodesXKB(KeyCode first, UInt32 count)
+{
+    // we can only patch a map built from XKB with the same groups and
+    // modifiers.  keys with actions may change the modifiers or group
+    // and the VMware hack depends on every key.
+    UInt32 last = first + count - 1;
+    if (m_keycodeEntries.empty() || m_usedLastGoodModifiers ||
+        first < m_xkb->min_key_code || last > m_xkb->max_key_code ||
+        last >= m_keycodeEntries.size() ||
+        getNumGroupsXKB() != m_numGroups) {
+        return false;
+    }
+    for (UInt32 i = first; i <= last; ++i) {
+        KeyCode keycode = static_cast<KeyCode>(i);
+        if (m_keycodeEntries[keycode].m_modifier ||
+            m_xkb->map->modmap[keycode] != 0 ||
+            m_impl->do_XkbKeyHasActions(m_xkb, keycode) == True) {
+            return false;
+        }
+    }
+
+    // forget the keys and check them again.  they're not modifiers so
+    // the modifier levels aren't used.
+    for (KeyToKeyCodeMap::iterator i = m_keyCodeFromKey.begin();
+                                i != m_keyCodeFromKey.end(); ) {
+        if (i->second >= first && i->second <= last) {
+            m_keyCodeFromKey.erase(i++);
+        }
+        else {
+            ++i;
+        }
+    }
+    std::vector<int> modifierLevel(m_numGroups * 8, 4);
+    for (UInt32 i = first; i <= last; ++i) {
+        addKeycodeXKB(static_cast<KeyCode>(i), m_numGroups,
+                                modifierLevel, false);
+    }
+    return true;
+}
+
+void
+XWindowsKeyState::buildKeyMapXKB(barrier::KeyMap& keyMap)
+{
+    for (size_t i = 0; i < m_keycodeEntries.size(); ++i) {
+        const KeycodeEntries& entries = m_keycodeEntries[i];
+        if (entries.m_halfDuplex) {
+            keyMap.addHalfDuplexButton(static_cast<KeyButton>(i));
+        }
+        for (size_t j = 0; j < entries.m_items.size(); ++j) {
+            keyMap.addKeyEntry(entries.m_items[j]);
         }
     }
 
@@ -785,6 +992,69 @@ XWindowsKeyState::updateKeysymMapXKB(barrier::KeyMap& keyMap)
     // allow composition across groups
     keyMap.allowGroupSwitchDuringCompose();
 }
+
+std::uint64_t
+XWindowsKeyState::getKeyMapIdentityXKB() const
+{
+    // hash everything updateKeysymMapXKB() reads
+    std::uint64_t hash = 14695981039346656037ull;
+    hashValue(hash, m_xkb->min_key_code);
+    hashValue(hash, m_xkb->max_key_code);
+
+    XkbClientMapPtr map = m_xkb->map;
+    hashValue(hash, map->num_types);
+    for (int i = 0; i < map->num_types; ++i) {
+        const XkbKeyTypeRec& type = map->types[i];
+        hashValue(hash, type.mods.mask);
+        hashValue(hash, type.num_levels);
+        hashValue(hash, type.map_count);
+        for (int j = 0; j < type.map_count; ++j) {
+            hashValue(hash, type.map[j].active);
+            hashValue(hash, type.map[j].level);
+            hashValue(hash, type.map[j].mods.mask);
+            if (type.preserve != NULL) {
+                hashValue(hash, type.preserve[j].mask);
+            }
+        }
+    }
+
+    for (int i = m_xkb->min_key_code; i <= m_xkb->max_key_code; ++i) {
+        KeyCode keycode = static_cast<KeyCode>(i);
+        const XkbSymMapRec& symMap = map->key_sym_map[keycode];
+        hashValue(hash, symMap.kt_index);
+        hashValue(hash, symMap.group_info);
+        hashValue(hash, symMap.width);
+        const KeySym* syms = XkbKeySymsPtr(m_xkb, keycode);
+        for (int j = 0, n = XkbKeyNumSyms(m_xkb, keycode); j < n; ++j) {
+            hashValue(hash, syms[j]);
+        }
+        hashValue(hash, map->modmap[keycode]);
+        hashValue(hash, m_xkb->server->behaviors[keycode].type);
+        hashValue(hash, m_xkb->server->behaviors[keycode].data);
+        if (XkbKeyHasActions(m_xkb, keycode)) {
+            const XkbAction* actions = XkbKeyActionsPtr(m_xkb, keycode);
+            for (int j = 0, n = XkbKeyNumActions(m_xkb, keycode); j < n; ++j) {
+                hashValue(hash, actions[j]);
+            }
+        }
+    }
+
+    // 0 means the key map isn't from XKB
+    return (hash != 0) ? hash : 1;
+}
+
+int
+XWindowsKeyState::getNumGroupsXKB() const
+{
+    int maxNumGroups = 0;
+    for (int i = m_xkb->min_key_code; i <= m_xkb->max_key_code; ++i) {
+        int numGroups = m_impl->do_XkbKeyNumGroups(m_xkb, static_cast<KeyCode>(i));
+        if (numGroups > maxNumGroups) {
+            maxNumGroups = numGroups;
+        }
+    }
+    return maxNumGroups;
+}
 #endif
 
 void
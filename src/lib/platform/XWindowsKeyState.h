@@ -19,10 +19,13 @@
 #pragma once
 
 #include "barrier/KeyState.h"
+#include "common/stdlist.h"
 #include "common/stdmap.h"
 #include "common/stdvector.h"
 #include "XWindowsImpl.h"
 
+#include <cstdint>
+
 #include <X11/Xlib.h>
 #include <X11/extensions/XTest.h>
 #if HAVE_XKB_EXTENSION
@@ -68,6 +71,22 @@ public:
     */
     void                setAutoRepeat(const XKeyboardState&);
 
+    //! Defer flushes of faked keys
+    /*!
+    If \p defer is true then faked keys are left in Xlib's buffer for
+    the caller to flush, otherwise each is flushed as it's faked.
+    */
+    void                setDeferFlush(bool defer);
+
+    //! Update the keyboard map for changed keys
+    /*!
+    Like \c updateKeyMap() except that only the \p count keycodes from
+    \p first are known to have changed.  If they don't involve any
+    modifiers then only their entries are rebuilt.  If \p count is 0
+    then any key may have changed.
+    */
+    void                updateKeyMap(KeyCode first, UInt32 count);
+
     //@}
     //! @name accessors
     //@{
@@ -98,6 +117,7 @@ public:
     //@}
 
     // IKeyState overrides
+    virtual void        updateKeyMap();
     virtual bool        fakeCtrlAltDel();
     virtual KeyModifierMask
                         pollActiveModifiers() const;
@@ -111,8 +131,16 @@ protected:
 
 private:
     void                init(Display* display, bool useXKB);
+    bool                refreshKeyboardMap();
     void                updateKeysymMap(barrier::KeyMap&);
-    void                updateKeysymMapXKB(barrier::KeyMap&);
+    void                updateKeysymMapXKB();
+    void                addKeycodeXKB(KeyCode, int maxNumGroups,
+                            std::vector<int>& modifierLevel,
+                            bool useLastGoodModifiers);
+    bool                updateKeycodesXKB(KeyCode first, UInt32 count);
+    void                buildKeyMapXKB(barrier::KeyMap&);
+    std::uint64_t        getKeyMapIdentityXKB() const;
+    int                    getNumGroupsXKB() const;
     bool                hasModifiersXKB() const;
     int                    getEffectiveGroup(KeyCode, int group) const;
     UInt32                getGroupFromState(unsigned int state) const;
@@ -120,6 +148,10 @@ private:
     static void            remapKeyModifiers(KeyID, SInt32,
                             barrier::KeyMap::KeyItem&, void*);
 
+    struct CachedKeyMap;
+    bool                restoreKeyMap(std::uint64_t identity);
+    void                exchangeKeyMap(CachedKeyMap&);
+
 private:
     struct XKBModifierInfo {
     public:
@@ -139,6 +171,30 @@ private:
     typedef std::map<KeyCode, unsigned int> NonXKBModifierMap;
     typedef std::map<UInt32, XKBModifierInfo> XKBModifierMap;
 
+    // the entries for a keycode before the modifiers are mapped to
+    // barrier's.  indexed by keycode.
+    struct KeycodeEntries {
+    public:
+        bool            m_halfDuplex;
+        bool            m_modifier;
+        std::vector<barrier::KeyMap::KeyItem> m_items;
+    };
+    typedef std::vector<KeycodeEntries> KeycodeEntriesList;
+
+    // a key map set aside for when the XKB map it was built from is
+    // used again, with the tables built along with it
+    struct CachedKeyMap {
+    public:
+        std::uint64_t    m_identity;
+        barrier::KeyMap    m_keyMap;
+        KeyModifierMaskList    m_modifierFromX;
+        KeyModifierToXMask    m_modifierToX;
+        KeyToKeyCodeMap        m_keyCodeFromKey;
+        KeycodeEntriesList    m_keycodeEntries;
+        int                m_numGroups;
+        bool            m_usedLastGoodModifiers;
+    };
+
     IXWindowsImpl* m_impl;
 
     Display*            m_display;
@@ -158,13 +214,29 @@ private:
     // map KeyID to all keycodes that can synthesize that KeyID
     KeyToKeyCodeMap        m_keyCodeFromKey;
 
+    // the XKB map the key map was built from, with the number of groups
+    // and each keycode's entries.  the identity is 0 if the key map
+    // wasn't built from XKB.
+    std::uint64_t        m_keyMapIdentity;
+    int                    m_numGroups;
+    KeycodeEntriesList    m_keycodeEntries;
+    bool                m_usedLastGoodModifiers;
+
+    // key maps for other XKB maps, most recently used first
+    std::list<CachedKeyMap>    m_keyMapCache;
+
     // autorepeat state
     XKeyboardState        m_keyboardState;
 
+    bool                m_deferFlush;
+
 #ifdef BARRIER_TEST_ENV
 public:
     SInt32                  group() const { return m_group; }
     void                    group(const SInt32& group) { m_group = group; }
     KeyModifierMaskList& modifierFromX() { return m_modifierFromX; }
+    const KeyModifierToXMask& modifierToX() const { return m_modifierToX; }
+    const KeyToKeyCodeMap& keyCodeFromKey() const { return m_keyCodeFromKey; }
+    size_t                  keyMapCacheSize() const { return m_keyMapCache.size(); }
 #endif
 };
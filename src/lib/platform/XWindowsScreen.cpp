@@ -88,8 +88,16 @@ XWindowsScreen::XWindowsScreen(
 	m_screensaverNotify(false),
 	m_xtestIsXineramaUnaware(true),
 	m_preserveFocus(false),
+	m_deferFlush(!isPrimary),
 	m_xkb(false),
 	m_xi2detected(false),
+	m_xiRawMotion(false),
+	m_xiRawActive(false),
+	m_xRawMotion(0.0),
+	m_yRawMotion(0.0),
+	m_secondaryMotions(0),
+	m_secondaryRoundTrips(0),
+	m_secondaryMotionTime(true),
 	m_xrandr(false),
 	m_events(events),
 	PlatformScreen(events)
@@ -120,6 +128,7 @@ XWindowsScreen::XWindowsScreen(
 								m_window, getEventTarget(), events);
         m_keyState    = new XWindowsKeyState(m_impl, m_display, m_xkb, events,
                                              m_keyMap);
+		m_keyState->setDeferFlush(m_deferFlush);
 		LOG((CLOG_DEBUG "screen shape: %d,%d %dx%d %s", m_x, m_y, m_w, m_h, m_xinerama ? "(xinerama)" : ""));
 		LOG((CLOG_DEBUG "window is 0x%08x", m_window));
 	}
@@ -294,6 +303,7 @@ XWindowsScreen::enter()
 
 	// now on screen
 	m_isOnScreen = true;
+	m_xiRawActive = false;
 }
 
 bool
@@ -347,6 +357,18 @@ XWindowsScreen::leave()
 		m_filtered.clear();
 	}
 
+#ifdef HAVE_XI2
+	// take motion from raw events while off screen, if asked to.
+	// devices may have changed since the last time.
+	m_xiRawActive = (m_isPrimary && m_xi2detected && m_xiRawMotion);
+	m_xiRelativeDevices.clear();
+	m_xRawMotion = 0.0;
+	m_yRawMotion = 0.0;
+#endif
+	m_secondaryMotions = 0;
+	m_secondaryRoundTrips = 0;
+	m_secondaryMotionTime.reset();
+
 	// now off screen
 	m_isOnScreen = false;
 
@@ -419,6 +441,7 @@ XWindowsScreen::resetOptions()
 {
 	m_xtestIsXineramaUnaware = true;
 	m_preserveFocus = false;
+	m_xiRawMotion = false;
 }
 
 void
@@ -433,6 +456,10 @@ XWindowsScreen::setOptions(const OptionsList& options)
 			m_preserveFocus = (options[i + 1] != 0);
 			LOG((CLOG_DEBUG1 "Preserve Focus = %s", m_preserveFocus ? "true" : "false"));
 		}
+		else if (options[i] == kOptionXIRawMotion) {
+			m_xiRawMotion = (options[i + 1] != 0);
+			LOG((CLOG_DEBUG1 "XI2 raw motion %s", m_xiRawMotion ? "true" : "false"));
+		}
 	}
 }
 
@@ -832,7 +859,7 @@ XWindowsScreen::fakeMouseButton(ButtonID button, bool press)
 	if (xButton > 0 && xButton < 11) {
         m_impl->XTestFakeButtonEvent(m_display, xButton,
 							press ? True : False, CurrentTime);
-        m_impl->XFlush(m_display);
+        flushFakeEvent();
 	}
 }
 
@@ -846,7 +873,7 @@ XWindowsScreen::fakeMouseMove(SInt32 x, SInt32 y)
 		XTestFakeMotionEvent(m_display, DefaultScreen(m_display),
 							x, y, CurrentTime);
 	}
-    m_impl->XFlush(m_display);
+    flushFakeEvent();
 }
 
 void
@@ -859,7 +886,7 @@ XWindowsScreen::fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const
 	else {
         m_impl->XTestFakeRelativeMotionEvent(m_display, dx, dy, CurrentTime);
 	}
-    m_impl->XFlush(m_display);
+    flushFakeEvent();
 }
 
 void
@@ -903,9 +930,23 @@ XWindowsScreen::fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const
         m_impl->XTestFakeButtonEvent(m_display, xButton, False, CurrentTime);
 	}
 
+    flushFakeEvent();
+}
+
+void
+XWindowsScreen::flushFakeInput()
+{
     m_impl->XFlush(m_display);
 }
 
+void
+XWindowsScreen::flushFakeEvent() const
+{
+	if (!m_deferFlush) {
+        m_impl->XFlush(m_display);
+	}
+}
+
 Display*
 XWindowsScreen::openDisplay(const char* displayName)
 {
@@ -1258,6 +1299,12 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 				cookie->type == GenericEvent &&
 				cookie->extension == xi_opcode) {
 			if (cookie->evtype == XI_RawMotion) {
+				if (m_xiRawActive && onRawMotion(
+						static_cast<const XIRawEvent*>(cookie->data))) {
+                    m_impl->XFreeEventData(m_display, cookie);
+					return;
+				}
+
 				// Get current pointer's position
 				Window root, child;
 				XMotionEvent xmotion;
@@ -1274,6 +1321,9 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 						&xmotion.x,
 						&xmotion.y,
 						&msk);
+					if (!m_isOnScreen) {
+						++m_secondaryRoundTrips;
+					}
 					onMouseMove(xmotion);
                     m_impl->XFreeEventData(m_display, cookie);
 					return;
@@ -1386,7 +1436,9 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 		return;
 
 	case MotionNotify:
-		if (m_isPrimary) {
+		// core motion is ignored while raw events drive the secondary
+		// screen.  it's either from the cursor or our own warp.
+		if (m_isPrimary && !m_xiRawActive) {
 			onMouseMove(xevent->xmotion);
 		}
 		return;
@@ -1635,13 +1687,20 @@ XWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 		// pixel) but the latter is a PITA.  to work around
 		// it we only warp when the mouse has moved more
 		// than s_size pixels from the center.
+		//
+		// there's no warping when taking raw motion.  this motion is
+		// then from an absolute device, which puts the cursor where it
+		// wants anyway.
 		static const SInt32 s_size = 32;
-		if (xmotion.x_root - m_xCenter < -s_size ||
+		if (!m_xiRawActive &&
+			(xmotion.x_root - m_xCenter < -s_size ||
 			xmotion.x_root - m_xCenter >  s_size ||
 			xmotion.y_root - m_yCenter < -s_size ||
-			xmotion.y_root - m_yCenter >  s_size) {
+			xmotion.y_root - m_yCenter >  s_size)) {
 			warpCursorNoFlush(m_xCenter, m_yCenter);
+			++m_secondaryRoundTrips;
 		}
+		countSecondaryMotion();
 
 		// send event if mouse moved.  do this after warping
 		// back to center in case the motion takes us onto
@@ -2052,18 +2111,51 @@ XWindowsScreen::refreshKeyboard(XEvent* event)
 		}
 	}
 
-	// keyboard mapping changed
+	// keyboard mapping changed.  when only some keys changed the key
+	// state may be able to update just those.
+	KeyCode first = 0;
+	UInt32 count  = 0;
 #if HAVE_XKB_EXTENSION
 	if (m_xkb && event->type == m_xkbEventBase) {
-        m_impl->XkbRefreshKeyboardMapping((XkbMapNotifyEvent*)event);
+		XkbMapNotifyEvent* mapEvent = (XkbMapNotifyEvent*)event;
+        m_impl->XkbRefreshKeyboardMapping(mapEvent);
+
+		static const unsigned int keyMasks = XkbKeySymsMask |
+							XkbKeyActionsMask | XkbKeyBehaviorsMask |
+							XkbExplicitComponentsMask;
+		if ((mapEvent->changed & ~keyMasks) == 0) {
+			int begin = 256, end = 0;
+			if ((mapEvent->changed & XkbKeySymsMask) != 0) {
+				begin = std::min(begin, (int)mapEvent->first_key_sym);
+				end   = std::max(end, mapEvent->first_key_sym +
+										mapEvent->num_key_syms);
+			}
+			if ((mapEvent->changed & XkbKeyActionsMask) != 0) {
+				begin = std::min(begin, (int)mapEvent->first_key_act);
+				end   = std::max(end, mapEvent->first_key_act +
+										mapEvent->num_key_acts);
+			}
+			if ((mapEvent->changed & XkbKeyBehaviorsMask) != 0) {
+				begin = std::min(begin, (int)mapEvent->first_key_behavior);
+				end   = std::max(end, mapEvent->first_key_behavior +
+										mapEvent->num_key_behaviors);
+			}
+			if (begin < end) {
+				first = static_cast<KeyCode>(begin);
+				count = static_cast<UInt32>(end - begin);
+			}
+		}
 	}
 	else
-#else
+#endif
 	{
         m_impl->XRefreshKeyboardMapping(&event->xmapping);
+		if (event->xmapping.request == MappingKeyboard) {
+			first = static_cast<KeyCode>(event->xmapping.first_keycode);
+			count = static_cast<UInt32>(event->xmapping.count);
+		}
 	}
-#endif
-	m_keyState->updateKeyMap();
+	m_keyState->updateKeyMap(first, count);
 	m_keyState->updateKeyState();
 }
 
@@ -2110,4 +2202,87 @@ XWindowsScreen::selectXIRawMotion()
     m_impl->XISelectEvents(m_display, DefaultRootWindow(m_display), &mask, 1);
 	free(mask.mask);
 }
+
+bool
+XWindowsScreen::onRawMotion(const XIRawEvent* xevent)
+{
+	// an absolute device gives positions, not motion
+	if (!isRelativePointer(xevent->sourceid)) {
+		return false;
+	}
+
+	// the values are packed, one for each valuator in the mask.  x and
+	// y are valuators 0 and 1.  these are the accelerated values so the
+	// motion matches what the cursor would have done.
+	double dx = 0.0;
+	double dy = 0.0;
+	const double* value = xevent->valuators.values;
+	for (int i = 0; i < 2 && i < xevent->valuators.mask_len * 8; ++i) {
+		if (XIMaskIsSet(xevent->valuators.mask, i)) {
+			(i == 0 ? dx : dy) = *value++;
+		}
+	}
+
+	// keep the fractions for the next event
+	m_xRawMotion += dx;
+	m_yRawMotion += dy;
+	SInt32 x = static_cast<SInt32>(m_xRawMotion);
+	SInt32 y = static_cast<SInt32>(m_yRawMotion);
+	m_xRawMotion -= x;
+	m_yRawMotion -= y;
+
+	LOG((CLOG_DEBUG2 "event: RawMotion %+d,%+d", x, y));
+	countSecondaryMotion();
+	if (x != 0 || y != 0) {
+		sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(), MotionInfo::alloc(x, y));
+	}
+	return true;
+}
+
+bool
+XWindowsScreen::isRelativePointer(int deviceid)
+{
+	std::map<int, bool>::const_iterator i = m_xiRelativeDevices.find(deviceid);
+	if (i != m_xiRelativeDevices.end()) {
+		return i->second;
+	}
+
+	// look for the x axis.  this is a round trip but only once for each
+	// device each time we leave the screen.
+	bool relative = false;
+	int count = 0;
+	XIDeviceInfo* info = m_impl->XIQueryDevice(m_display, deviceid, &count);
+	++m_secondaryRoundTrips;
+	for (int j = 0; info != NULL && j < info->num_classes; ++j) {
+		const XIAnyClassInfo* any = info->classes[j];
+		if (any->type == XIValuatorClass) {
+			const XIValuatorClassInfo* valuator =
+				reinterpret_cast<const XIValuatorClassInfo*>(any);
+			if (valuator->number == 0) {
+				relative = (valuator->mode == XIModeRelative);
+			}
+		}
+	}
+	if (info != NULL) {
+        m_impl->XIFreeDeviceInfo(info);
+	}
+
+	LOG((CLOG_DEBUG1 "XI2 device %d is %s", deviceid, relative ? "relative" : "absolute"));
+	m_xiRelativeDevices[deviceid] = relative;
+	return relative;
+}
 #endif
+
+void
+XWindowsScreen::countSecondaryMotion()
+{
+	++m_secondaryMotions;
+	double elapsed = m_secondaryMotionTime.getTime();
+	if (elapsed >= 1.0) {
+		LOG((CLOG_DEBUG1 "motion on secondary: %.0f events/s, %.1f round trips/s",
+			m_secondaryMotions / elapsed, m_secondaryRoundTrips / elapsed));
+		m_secondaryMotions = 0;
+		m_secondaryRoundTrips = 0;
+		m_secondaryMotionTime.reset();
+	}
+}
@@ -20,9 +20,11 @@
 
 #include "barrier/PlatformScreen.h"
 #include "barrier/KeyMap.h"
+#include "common/stdmap.h"
 #include "common/stdset.h"
 #include "common/stdvector.h"
 #include "XWindowsImpl.h"
+#include "base/Stopwatch.h"
 
 #include <X11/Xlib.h>
 
@@ -67,6 +69,7 @@ public:
     virtual void        fakeMouseMove(SInt32 x, SInt32 y);
     virtual void        fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const;
     virtual void        fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const;
+    virtual void        flushFakeInput();
 
     // IPlatformScreen overrides
     virtual void        enable();
@@ -142,7 +145,10 @@ private:
     bool                detectXI2();
 #ifdef HAVE_XI2
     void                selectXIRawMotion();
+    bool                onRawMotion(const XIRawEvent*);
+    bool                isRelativePointer(int deviceid);
 #endif
+    void                countSecondaryMotion();
     void                selectEvents(Window) const;
     void                doSelectEvents(Window) const;
 
@@ -152,6 +158,9 @@ private:
 
     void                warpCursorNoFlush(SInt32 x, SInt32 y);
 
+    // flushes a faked event unless flushes are deferred
+    void                flushFakeEvent() const;
+
     void                refreshKeyboard(XEvent*);
 
     static Bool            findKeyEvent(Display*, XEvent* xevent, XPointer arg);
@@ -246,12 +255,31 @@ private:
     // (ie: a MythTV front-end).
     bool                m_preserveFocus;
 
+    // true if faked input is left in Xlib's buffer until flushFakeInput()
+    // rather than flushed after each event.  the event queue flushes it
+    // anyway before waiting, so it can't be held for long.
+    bool                m_deferFlush;
+
     // XKB extension stuff
     bool                m_xkb;
     int                    m_xkbEventBase;
 
     bool                m_xi2detected;
 
+    // XI2 raw motion stuff.  when enabled the primary screen takes motion
+    // on secondary screens from the raw events of relative devices and
+    // never warps the cursor.  m_xiRawActive is true while doing that.
+    bool                m_xiRawMotion;
+    bool                m_xiRawActive;
+    double                m_xRawMotion, m_yRawMotion;
+    std::map<int, bool>    m_xiRelativeDevices;
+
+    // motion on secondary screens and the X server round trips it took,
+    // logged once a second
+    UInt32                m_secondaryMotions;
+    UInt32                m_secondaryRoundTrips;
+    Stopwatch            m_secondaryMotionTime;
+
     // XRandR extension stuff
     bool                m_xrandr;
     int                 m_xrandrEventBase;
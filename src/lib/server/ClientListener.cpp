@@ -40,7 +40,8 @@ ClientListener::ClientListener(const NetworkAddress& address,
     m_socketFactory(socketFactory),
     m_server(NULL),
     m_events(events),
-    security_level_{security_level}
+    security_level_{security_level},
+    m_shards(NULL)
 {
     assert(m_socketFactory != NULL);
 
@@ -108,6 +109,12 @@ ClientListener::setServer(Server* server)
     m_server = server;
 }
 
+void
+ClientListener::setSocketShards(SocketMultiplexerShards* shards)
+{
+    m_shards = shards;
+}
+
 ClientProxy*
 ClientListener::getNextClient()
 {
@@ -124,7 +131,7 @@ void
 ClientListener::handleClientConnecting(const Event&, void*)
 {
     // accept client connection
-    IDataSocket* socket = m_listen->accept();
+    IDataSocket* socket = m_listen->accept(m_shards);
 
     if (socket == NULL) {
         return;
@@ -33,6 +33,7 @@ class ISocketFactory;
 class Server;
 class IEventQueue;
 class IDataSocket;
+class SocketMultiplexerShards;
 
 class ClientListener {
 public:
@@ -46,6 +47,13 @@ public:
 
     void                setServer(Server* server);
 
+    //! Set socket shards
+    /*!
+    Accepted clients are spread over \p shards, which is not adopted.
+    Pass NULL to service them all on the listen socket's multiplexer.
+    */
+    void                setSocketShards(SocketMultiplexerShards* shards);
+
     //@}
 
     //! @name accessors
@@ -87,4 +95,5 @@ private:
     IEventQueue*        m_events;
     ConnectionSecurityLevel security_level_;
     ClientSockets      m_clientSockets;
+    SocketMultiplexerShards* m_shards;
 };
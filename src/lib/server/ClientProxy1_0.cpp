@@ -253,6 +253,9 @@ ClientProxy1_0::parseMessage(const UInt8* code)
     else if (memcmp(code, kMsgDScreenList, 4) == 0) {
         return recvScreenList();
     }
+    else if (memcmp(code, kMsgDLockState, 4) == 0) {
+        return recvLockState();
+    }
     return false;
 }
 
@@ -548,6 +551,22 @@ ClientProxy1_0::recvScreenList()
     return true;
 }
 
+bool
+ClientProxy1_0::recvLockState()
+{
+    KeyModifierMask mask;
+    if (!ProtocolUtil::readf(getStream(), kMsgDLockState + 4, &mask)) {
+        return false;
+    }
+    LOG((CLOG_DEBUG "received client \"%s\" lock state %04x", getName().c_str(), mask));
+
+    KeyModifierMask* data = (KeyModifierMask*)malloc(sizeof(KeyModifierMask));
+    *data = mask;
+    m_events->addEvent(Event(m_events->forClientProxy().lockStateChanged(),
+                            getEventTarget(), data));
+    return true;
+}
+
 bool
 ClientProxy1_0::recvGrabClipboard()
 {
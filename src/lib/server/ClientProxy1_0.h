@@ -85,6 +85,7 @@ private:
 
     bool                recvInfo();
     bool                recvScreenList();
+    bool                recvLockState();
     bool                recvGrabClipboard();
 
 protected:
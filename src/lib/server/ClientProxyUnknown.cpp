@@ -239,6 +239,7 @@ ClientProxyUnknown::handleData(const Event&, void*)
                 break;
 
             case 7:
+            case 8:
                 m_proxy = new ClientProxy1_6(name, m_stream, m_server, m_events);
                 break;
             }
@@ -537,6 +537,63 @@ Config::hasLockToScreenAction() const
 	return m_hasLockToScreenAction;
 }
 
+Config::Delta
+Config::diff(const Config& newer) const
+{
+	Delta delta;
+
+	// screens, their links and their options
+	for (CellMap::const_iterator index = m_map.begin();
+								index != m_map.end(); ++index) {
+		if (newer.m_map.count(index->first) == 0) {
+			delta.m_removedScreens.insert(index->first);
+		}
+	}
+	for (CellMap::const_iterator index = newer.m_map.begin();
+								index != newer.m_map.end(); ++index) {
+		CellMap::const_iterator old = m_map.find(index->first);
+		if (old == m_map.end()) {
+			delta.m_addedScreens.insert(index->first);
+			delta.m_changedLinks.insert(index->first);
+			delta.m_changedOptions.insert(index->first);
+			continue;
+		}
+		if (!old->second.hasSameLinks(index->second)) {
+			delta.m_changedLinks.insert(index->first);
+		}
+		if (old->second.m_options != index->second.m_options) {
+			delta.m_changedOptions.insert(index->first);
+		}
+	}
+
+	// aliases
+	if (m_nameToCanonicalName.size() != newer.m_nameToCanonicalName.size()) {
+		delta.m_aliasesChanged = true;
+	}
+	else {
+		for (NameMap::const_iterator index1 = m_nameToCanonicalName.begin(),
+								index2 = newer.m_nameToCanonicalName.begin();
+								index1 != m_nameToCanonicalName.end();
+								++index1, ++index2) {
+			if (!CaselessCmp::equal(index1->first,  index2->first) ||
+				!CaselessCmp::equal(index1->second, index2->second)) {
+				delta.m_aliasesChanged = true;
+				break;
+			}
+		}
+	}
+
+	delta.m_globalOptionsChanged = (m_globalOptions != newer.m_globalOptions);
+	// unresolved addresses can't be compared
+	delta.m_addressChanged       =
+		(m_barrierAddress.isValid() != newer.m_barrierAddress.isValid() ||
+		 (m_barrierAddress.isValid() &&
+		  m_barrierAddress != newer.m_barrierAddress));
+	delta.m_filterChanged        = (m_inputFilter != newer.m_inputFilter);
+
+	return delta;
+}
+
 bool
 Config::operator==(const Config& x) const
 {
@@ -900,6 +957,10 @@ Config::readSectionScreens(ConfigReadContext& s)
 				addOption(screen, kOptionScreenPreserveFocus,
 					s.parseBoolean(value));
 			}
+			else if (name == "xi2RawMotion") {
+				addOption(screen, kOptionXIRawMotion,
+					s.parseBoolean(value));
+			}
 			else {
 				// unknown argument
 				throw XConfigRead(s, "unknown argument \"%{1}\"", name);
@@ -1360,6 +1421,9 @@ Config::getOptionName(OptionID id)
 	if (id == kOptionClipboardSharing) {
 		return "clipboardSharing";
 	}
+	if (id == kOptionXIRawMotion) {
+		return "xi2RawMotion";
+	}
 	return NULL;
 }
 
@@ -1376,7 +1440,8 @@ std::string Config::getOptionValue(OptionID id, OptionValue value)
 		id == kOptionRelativeMouseMoves ||
 		id == kOptionWin32KeepForeground ||
 		id == kOptionScreenPreserveFocus ||
-		id == kOptionClipboardSharing) {
+		id == kOptionClipboardSharing ||
+		id == kOptionXIRawMotion) {
 		return (value != 0) ? "true" : "false";
 	}
 	if (id == kOptionModifierMapForShift ||
@@ -1575,6 +1640,33 @@ Config::CellEdge::operator!=(const CellEdge& x) const
 }
 
 
+//
+// Config::Delta
+//
+
+Config::Delta::Delta() :
+	m_aliasesChanged(false),
+	m_globalOptionsChanged(false),
+	m_addressChanged(false),
+	m_filterChanged(false)
+{
+	// do nothing
+}
+
+bool
+Config::Delta::isEmpty() const
+{
+	return (m_addedScreens.empty() &&
+			m_removedScreens.empty() &&
+			m_changedLinks.empty() &&
+			m_changedOptions.empty() &&
+			!m_aliasesChanged &&
+			!m_globalOptionsChanged &&
+			!m_addressChanged &&
+			!m_filterChanged);
+}
+
+
 //
 // Config::Cell
 //
@@ -1689,6 +1781,12 @@ Config::Cell::operator==(const Cell& x) const
 	}
 
 	// compare links
+	return hasSameLinks(x);
+}
+
+bool
+Config::Cell::hasSameLinks(const Cell& x) const
+{
 	if (m_neighbors.size() != x.m_neighbors.size()) {
 		return false;
 	}
@@ -95,6 +95,34 @@ public:
         Interval        m_interval;
     };
 
+    typedef std::set<std::string, barrier::string::CaselessCmp> ScreenSet;
+
+    //! Configuration differences
+    /*!
+    Describes what changed between two configurations.  See diff().
+    */
+    class Delta {
+    public:
+        Delta();
+
+        //! Returns true iff nothing changed
+        bool            isEmpty() const;
+
+    public:
+        //! Screens only in the newer configuration
+        ScreenSet        m_addedScreens;
+        //! Screens only in the older configuration
+        ScreenSet        m_removedScreens;
+        //! Screens, including added ones, whose links changed
+        ScreenSet        m_changedLinks;
+        //! Screens, including added ones, whose options changed
+        ScreenSet        m_changedOptions;
+        bool            m_aliasesChanged;
+        bool            m_globalOptionsChanged;
+        bool            m_addressChanged;
+        bool            m_filterChanged;
+    };
+
 private:
     class Name {
     public:
@@ -126,6 +154,9 @@ private:
         bool            getLink(EDirection side, float position,
                             const CellEdge*& src, const CellEdge*& dst) const;
 
+        // compares links but not options
+        bool            hasSameLinks(const Cell&) const;
+
         bool            operator==(const Cell&) const;
         bool            operator!=(const Cell&) const;
 
@@ -398,6 +429,14 @@ public:
     */
     bool                hasLockToScreenAction() const;
 
+    //! Get configuration differences
+    /*!
+    Returns the structural differences between this configuration and
+    \c newer:  screens, aliases, links, options, the server address and
+    the input filter.
+    */
+    Delta                diff(const Config& newer) const;
+
     //! Compare configurations
     bool                operator==(const Config&) const;
     //! Compare configurations
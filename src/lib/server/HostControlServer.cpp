@@ -0,0 +1,681 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/HostControlServer.h"
+
+#include "server/Server.h"
+#include "barrier/IInputInjector.h"
+#include "net/ConnectionSecurityLevel.h"
+#include "net/IDataSocket.h"
+#include "net/IListenSocket.h"
+#include "net/ISocketFactory.h"
+#include "net/NetworkAddress.h"
+#include "net/XSocket.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "base/String.h"
+#include "base/TMethodEventJob.h"
+#include "arch/Arch.h"
+#include "common/stdvector.h"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+std::string
+trim(const std::string& s)
+{
+    std::string::size_type begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    std::string::size_type end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+// reads a decimal or 0x prefixed hex number
+bool
+readNumber(std::istream& in, long& value)
+{
+    std::string token;
+    if (!(in >> token)) {
+        return false;
+    }
+    char* end;
+    long result = std::strtol(token.c_str(), &end, 0);
+    if (end == token.c_str() || *end != '\0') {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+// reads a number if there's anything left to read
+bool
+readOptionalNumber(std::istream& in, long& value)
+{
+    return (in >> std::ws).eof() || readNumber(in, value);
+}
+
+// reads "down" or "up"
+bool
+readPress(std::istream& in, bool& press)
+{
+    std::string token;
+    if (!(in >> token)) {
+        return false;
+    }
+    press = (token == "down");
+    return press || token == "up";
+}
+
+// true if there's nothing but whitespace left to read
+bool
+isEnd(std::istream& in)
+{
+    return (in >> std::ws).eof();
+}
+
+// one parsed line of an input command body
+struct InputCommand {
+    enum EType { kMove, kRelativeMove, kButton, kWheel, kKey };
+
+    EType                m_type;
+    long                m_a;
+    long                m_b;
+    long                m_mask;
+    long                m_button;
+    bool                m_press;
+};
+
+const char*
+statusText(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    default:  return "Error";
+    }
+}
+
+} // namespace
+
+//
+// HostControlServer::Request
+//
+
+HostControlServer::Request::Request() :
+    m_keepAlive(true)
+{
+    // do nothing
+}
+
+//
+// HostControlServer::Response
+//
+
+HostControlServer::Response::Response() :
+    m_status(200),
+    m_contentType("text/plain"),
+    m_stream(false)
+{
+    // do nothing
+}
+
+//
+// HostControlServer::Connection
+//
+
+HostControlServer::Connection::Connection(IDataSocket* socket) :
+    m_socket(socket),
+    m_closing(false),
+    m_flushed(true),
+    m_subscriber(false)
+{
+    // do nothing
+}
+
+//
+// HostControlServer
+//
+
+HostControlServer::HostControlServer(const NetworkAddress& address,
+                ISocketFactory* socketFactory, IEventQueue* events) :
+    m_socketFactory(socketFactory),
+    m_listen(NULL),
+    m_events(events),
+    m_server(NULL),
+    m_closedType(Event::kUnknown)
+{
+    assert(m_socketFactory != NULL);
+
+    m_events->registerTypeOnce(m_closedType, "HostControlServer::closed");
+    m_events->adoptHandler(m_closedType, this,
+                new TMethodEventJob<HostControlServer>(this,
+                        &HostControlServer::handleClosed));
+
+    try {
+        m_listen = m_socketFactory->createListen(
+                            ARCH->getAddrFamily(address.getAddress()),
+                            ConnectionSecurityLevel::PLAINTEXT);
+        m_events->adoptHandler(m_events->forIListenSocket().connecting(),
+                    m_listen,
+                    new TMethodEventJob<HostControlServer>(this,
+                            &HostControlServer::handleConnecting));
+        m_listen->bind(address);
+    }
+    catch (XBase&) {
+        if (m_listen != NULL) {
+            m_events->removeHandler(m_events->forIListenSocket().connecting(),
+                            m_listen);
+            delete m_listen;
+        }
+        m_events->removeHandler(m_closedType, this);
+        delete m_socketFactory;
+        throw;
+    }
+    LOG((CLOG_DEBUG1 "host control api listening on %s:%d",
+                            address.getHostname().c_str(), address.getPort()));
+}
+
+HostControlServer::~HostControlServer()
+{
+    while (!m_connections.empty()) {
+        removeConnection(*m_connections.begin());
+    }
+    for (Connections::iterator i = m_closed.begin(); i != m_closed.end(); ++i) {
+        delete (*i)->m_socket;
+        delete *i;
+    }
+
+    m_events->removeHandler(m_closedType, this);
+    m_events->removeHandler(m_events->forIListenSocket().connecting(), m_listen);
+    delete m_listen;
+    delete m_socketFactory;
+}
+
+void
+HostControlServer::setServer(Server* server)
+{
+    m_server = server;
+}
+
+void
+HostControlServer::publish(const std::string& name, const std::string& data)
+{
+    const std::string event = formatEvent(name, data);
+
+    std::vector<Connection*> lagging;
+    for (Connections::iterator i = m_connections.begin();
+                            i != m_connections.end(); ++i) {
+        Connection* connection = *i;
+        if (connection->m_subscriber && !connection->m_closing &&
+            !sendEvent(connection, event)) {
+            lagging.push_back(connection);
+        }
+    }
+
+    for (size_t i = 0; i < lagging.size(); ++i) {
+        LOG((CLOG_WARN "host control api subscriber fell behind, disconnecting"));
+        removeConnection(lagging[i]);
+    }
+}
+
+size_t
+HostControlServer::getNumConnections() const
+{
+    return m_connections.size();
+}
+
+size_t
+HostControlServer::getNumSubscribers() const
+{
+    size_t n = 0;
+    for (Connections::const_iterator i = m_connections.begin();
+                            i != m_connections.end(); ++i) {
+        if ((*i)->m_subscriber) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+HostControlServer::EParseResult
+HostControlServer::parseRequest(std::string& buffer, Request& request)
+{
+    // clients may send empty lines between requests
+    std::string::size_type first = buffer.find_first_not_of("\r\n");
+    if (first == std::string::npos) {
+        buffer.clear();
+        return kIncomplete;
+    }
+    buffer.erase(0, first);
+
+    // find the end of the head.  bare newlines are tolerated.
+    std::string::size_type headEnd = buffer.find("\r\n\r\n");
+    std::string::size_type separator = 4;
+    std::string::size_type bareEnd = buffer.find("\n\n");
+    if (bareEnd != std::string::npos &&
+        (headEnd == std::string::npos || bareEnd < headEnd)) {
+        headEnd = bareEnd;
+        separator = 2;
+    }
+    if (headEnd == std::string::npos) {
+        return (buffer.size() > kMaxHeaderSize) ? kBadRequest : kIncomplete;
+    }
+    if (headEnd > kMaxHeaderSize) {
+        return kBadRequest;
+    }
+
+    // split into lines
+    std::vector<std::string> lines;
+    std::string::size_type start = 0;
+    while (start < headEnd) {
+        std::string::size_type end = buffer.find('\n', start);
+        if (end == std::string::npos || end > headEnd) {
+            end = headEnd;
+        }
+        std::string line = buffer.substr(start, end - start);
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        lines.push_back(line);
+        start = end + 1;
+    }
+    if (lines.empty()) {
+        return kBadRequest;
+    }
+
+    // request line
+    const std::string& requestLine = lines[0];
+    std::string::size_type sp1 = requestLine.find(' ');
+    std::string::size_type sp2 = (sp1 == std::string::npos) ?
+                            std::string::npos : requestLine.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) {
+        return kBadRequest;
+    }
+    Request parsed;
+    parsed.m_method  = requestLine.substr(0, sp1);
+    parsed.m_path    = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    parsed.m_version = requestLine.substr(sp2 + 1);
+    if (parsed.m_method.empty() || parsed.m_path.empty() ||
+        parsed.m_version.compare(0, 5, "HTTP/") != 0) {
+        return kBadRequest;
+    }
+
+    // HTTP/1.1 connections persist by default, HTTP/1.0 ones don't
+    parsed.m_keepAlive = (parsed.m_version != "HTTP/1.0");
+
+    // headers
+    size_t contentLength = 0;
+    for (size_t i = 1; i < lines.size(); ++i) {
+        std::string::size_type colon = lines[i].find(':');
+        if (colon == std::string::npos) {
+            return kBadRequest;
+        }
+        std::string name  = lines[i].substr(0, colon);
+        std::string value = trim(lines[i].substr(colon + 1));
+        if (barrier::string::CaselessCmp::equal(name, "Content-Length")) {
+            char* end;
+            unsigned long length = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0') {
+                return kBadRequest;
+            }
+            contentLength = static_cast<size_t>(length);
+        }
+        else if (barrier::string::CaselessCmp::equal(name, "Connection")) {
+            if (barrier::string::CaselessCmp::equal(value, "close")) {
+                parsed.m_keepAlive = false;
+            }
+            else if (barrier::string::CaselessCmp::equal(value, "keep-alive")) {
+                parsed.m_keepAlive = true;
+            }
+        }
+        else if (barrier::string::CaselessCmp::equal(name, "Transfer-Encoding")) {
+            // chunked bodies aren't supported
+            return kBadRequest;
+        }
+    }
+    if (contentLength > kMaxBodySize) {
+        return kBadRequest;
+    }
+
+    // body
+    const std::string::size_type bodyStart = headEnd + separator;
+    if (buffer.size() - bodyStart < contentLength) {
+        return kIncomplete;
+    }
+    parsed.m_body = buffer.substr(bodyStart, contentLength);
+    buffer.erase(0, bodyStart + contentLength);
+
+    request = parsed;
+    return kComplete;
+}
+
+std::string
+HostControlServer::formatResponse(const Response& response, bool keepAlive)
+{
+    if (response.m_stream) {
+        return barrier::string::sprintf(
+                "HTTP/1.1 %d %s\r\n"
+                "Content-Type: text/event-stream\r\n"
+                "Cache-Control: no-cache\r\n"
+                "Connection: keep-alive\r\n"
+                "\r\n",
+                response.m_status, statusText(response.m_status)) +
+                response.m_body;
+    }
+
+    return barrier::string::sprintf(
+                "HTTP/1.1 %d %s\r\n"
+                "Content-Type: %s\r\n"
+                "Content-Length: %u\r\n"
+                "Connection: %s\r\n"
+                "\r\n",
+                response.m_status, statusText(response.m_status),
+                response.m_contentType.c_str(),
+                static_cast<unsigned int>(response.m_body.size()),
+                keepAlive ? "keep-alive" : "close") + response.m_body;
+}
+
+std::string
+HostControlServer::formatEvent(const std::string& name, const std::string& data)
+{
+    return "event: " + name + "\ndata: " + data + "\n\n";
+}
+
+bool
+HostControlServer::injectInput(const std::string& commands,
+                IInputInjector& injector)
+{
+    // parse everything first so a bad line doesn't leave the input
+    // before it half applied, e.g. a key held down
+    std::vector<InputCommand> parsed;
+    std::istringstream lines(commands);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream in(line);
+        std::string command;
+        if (!(in >> command)) {
+            continue;
+        }
+
+        InputCommand input = { InputCommand::kMove, 0, 0, 0, 0, false };
+        bool ok = false;
+        if (command == "move") {
+            ok = readNumber(in, input.m_a) && readNumber(in, input.m_b);
+        }
+        else if (command == "rmove") {
+            input.m_type = InputCommand::kRelativeMove;
+            ok = readNumber(in, input.m_a) && readNumber(in, input.m_b);
+        }
+        else if (command == "button") {
+            input.m_type = InputCommand::kButton;
+            ok = readNumber(in, input.m_a) && readPress(in, input.m_press);
+        }
+        else if (command == "wheel") {
+            input.m_type = InputCommand::kWheel;
+            ok = readNumber(in, input.m_a) && readNumber(in, input.m_b);
+        }
+        else if (command == "key") {
+            input.m_type = InputCommand::kKey;
+            ok = readNumber(in, input.m_a) && readPress(in, input.m_press) &&
+                 readOptionalNumber(in, input.m_mask) &&
+                 readOptionalNumber(in, input.m_button);
+        }
+        if (!ok || !isEnd(in)) {
+            LOG((CLOG_DEBUG "host control: bad input command \"%s\"", line.c_str()));
+            return false;
+        }
+        parsed.push_back(input);
+    }
+
+    for (const InputCommand& input : parsed) {
+        switch (input.m_type) {
+        case InputCommand::kMove:
+            injector.injectMouseMove(input.m_a, input.m_b);
+            break;
+
+        case InputCommand::kRelativeMove:
+            injector.injectMouseRelativeMove(input.m_a, input.m_b);
+            break;
+
+        case InputCommand::kButton:
+            injector.injectMouseButton(static_cast<ButtonID>(input.m_a),
+                            input.m_press);
+            break;
+
+        case InputCommand::kWheel:
+            injector.injectMouseWheel(input.m_a, input.m_b);
+            break;
+
+        case InputCommand::kKey:
+            injector.injectKey(static_cast<KeyID>(input.m_a),
+                            static_cast<KeyModifierMask>(input.m_mask),
+                            static_cast<KeyButton>(input.m_button),
+                            input.m_press);
+            break;
+        }
+    }
+    return true;
+}
+
+void
+HostControlServer::handleConnecting(const Event&, void*)
+{
+    IDataSocket* socket = m_listen->accept();
+    if (socket == NULL) {
+        return;
+    }
+
+    Connection* connection = new Connection(socket);
+    m_connections.insert(connection);
+    LOG((CLOG_DEBUG1 "host control api connection opened, %d open",
+                            static_cast<int>(m_connections.size())));
+
+    void* target = socket->getEventTarget();
+    m_events->adoptHandler(m_events->forIStream().inputReady(), target,
+                new TMethodEventJob<HostControlServer>(this,
+                        &HostControlServer::handleInputReady, connection));
+    m_events->adoptHandler(m_events->forIStream().outputFlushed(), target,
+                new TMethodEventJob<HostControlServer>(this,
+                        &HostControlServer::handleOutputFlushed, connection));
+    m_events->adoptHandler(m_events->forIStream().inputShutdown(), target,
+                new TMethodEventJob<HostControlServer>(this,
+                        &HostControlServer::handleInputShutdown, connection));
+    m_events->adoptHandler(m_events->forIStream().outputError(), target,
+                new TMethodEventJob<HostControlServer>(this,
+                        &HostControlServer::handleDisconnected, connection));
+    m_events->adoptHandler(m_events->forISocket().disconnected(), target,
+                new TMethodEventJob<HostControlServer>(this,
+                        &HostControlServer::handleDisconnected, connection));
+}
+
+void
+HostControlServer::handleInputReady(const Event&, void* vconnection)
+{
+    Connection* connection = static_cast<Connection*>(vconnection);
+
+    // drain the socket
+    char buffer[4096];
+    UInt32 n;
+    while ((n = connection->m_socket->read(buffer, sizeof(buffer))) > 0) {
+        if (!connection->m_closing) {
+            connection->m_input.append(buffer, n);
+        }
+    }
+
+    processInput(connection);
+}
+
+void
+HostControlServer::handleOutputFlushed(const Event&, void* vconnection)
+{
+    Connection* connection = static_cast<Connection*>(vconnection);
+    connection->m_flushed = true;
+    if (connection->m_closing) {
+        removeConnection(connection);
+        return;
+    }
+
+    // send everything that queued up while the socket was busy
+    if (!connection->m_queue.empty()) {
+        std::string data;
+        for (size_t i = 0; i < connection->m_queue.size(); ++i) {
+            data += connection->m_queue[i];
+        }
+        connection->m_queue.clear();
+        connection->m_flushed = false;
+        connection->m_socket->write(data.data(), static_cast<UInt32>(data.size()));
+    }
+}
+
+void
+HostControlServer::handleInputShutdown(const Event& event, void* vconnection)
+{
+    // the client is done sending.  answer what it sent then close.
+    Connection* connection = static_cast<Connection*>(vconnection);
+    handleInputReady(event, connection);
+    closeWhenFlushed(connection);
+}
+
+void
+HostControlServer::handleDisconnected(const Event&, void* vconnection)
+{
+    removeConnection(static_cast<Connection*>(vconnection));
+}
+
+void
+HostControlServer::processInput(Connection* connection)
+{
+    // subscribers only listen
+    if (connection->m_subscriber) {
+        connection->m_input.clear();
+        return;
+    }
+
+    while (!connection->m_closing) {
+        Request request;
+        EParseResult result = parseRequest(connection->m_input, request);
+        if (result == kIncomplete) {
+            break;
+        }
+
+        if (result == kBadRequest) {
+            Response response;
+            response.m_status = 400;
+            response.m_body   = "bad request";
+            send(connection, response, false);
+            break;
+        }
+
+        Response response;
+        if (m_server != NULL) {
+            m_server->handleHostControlRequest(request, response);
+        }
+        else {
+            response.m_status = 404;
+            response.m_body   = "false";
+        }
+        send(connection, response, request.m_keepAlive);
+
+        if (response.m_stream && !connection->m_closing) {
+            connection->m_subscriber = true;
+            connection->m_input.clear();
+            LOG((CLOG_DEBUG1 "host control api subscriber added"));
+            break;
+        }
+    }
+}
+
+void
+HostControlServer::send(Connection* connection, const Response& response,
+                            bool keepAlive)
+{
+    std::string data = formatResponse(response, keepAlive);
+    connection->m_flushed = false;
+    connection->m_socket->write(data.data(), static_cast<UInt32>(data.size()));
+    if (!keepAlive) {
+        closeWhenFlushed(connection);
+    }
+}
+
+bool
+HostControlServer::sendEvent(Connection* connection, const std::string& event)
+{
+    // only hand the socket more data once it has sent what it has so
+    // its buffer can't grow without bound.
+    if (connection->m_flushed) {
+        connection->m_flushed = false;
+        connection->m_socket->write(event.data(), static_cast<UInt32>(event.size()));
+        return true;
+    }
+    if (connection->m_queue.size() >= kMaxQueuedEvents) {
+        return false;
+    }
+    connection->m_queue.push_back(event);
+    return true;
+}
+
+void
+HostControlServer::closeWhenFlushed(Connection* connection)
+{
+    // anything after this request is ignored.  the connection goes
+    // away when the output flushed event arrives.
+    connection->m_closing = true;
+    connection->m_input.clear();
+    if (connection->m_flushed) {
+        removeConnection(connection);
+    }
+}
+
+void
+HostControlServer::removeConnection(Connection* connection)
+{
+    if (m_connections.erase(connection) == 0) {
+        return;
+    }
+
+    void* target = connection->m_socket->getEventTarget();
+    m_events->removeHandler(m_events->forIStream().inputReady(), target);
+    m_events->removeHandler(m_events->forIStream().outputFlushed(), target);
+    m_events->removeHandler(m_events->forIStream().inputShutdown(), target);
+    m_events->removeHandler(m_events->forIStream().outputError(), target);
+    m_events->removeHandler(m_events->forISocket().disconnected(), target);
+
+    // events for the socket may still be queued.  if it were deleted now
+    // a new socket could get the same address and receive them, so close
+    // it now and delete it once the queue has caught up.
+    connection->m_socket->close();
+    m_closed.insert(connection);
+    m_events->addEvent(Event(m_closedType, this, connection,
+                            Event::kDontFreeData));
+    LOG((CLOG_DEBUG1 "host control api connection closed, %d open",
+                            static_cast<int>(m_connections.size())));
+}
+
+void
+HostControlServer::handleClosed(const Event& event, void*)
+{
+    Connection* connection = static_cast<Connection*>(event.getData());
+    if (m_closed.erase(connection) != 0) {
+        delete connection->m_socket;
+        delete connection;
+    }
+}
@@ -0,0 +1,217 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/Event.h"
+#include "common/stdset.h"
+
+#include <deque>
+#include <string>
+
+class IDataSocket;
+class IEventQueue;
+class IInputInjector;
+class IListenSocket;
+class ISocketFactory;
+class NetworkAddress;
+class Server;
+
+//! Host Control API endpoint
+/*!
+A small HTTP/1.1 server that lets scripts query and switch the active
+screen and get or set the configuration.  Sockets are non-blocking and
+driven by the event queue so requests are handled on the main thread.
+Any number of clients may be connected at once, connections are kept
+alive and pipelined requests are answered in order.
+
+When the primary screen is virtual, input for it is posted to the API
+as lines of text (see injectInput()).
+
+A request answered with a streaming response turns its connection into
+a subscriber that receives every event passed to publish() as a
+Server-Sent Event.  Each subscriber has a bounded queue;  a subscriber
+that falls too far behind is disconnected rather than slowing the
+server down.
+*/
+class HostControlServer {
+public:
+    //! Default port
+    static const int    kDefaultPort = 24802;
+
+    //! Parsed request
+    class Request {
+    public:
+        Request();
+
+    public:
+        std::string        m_method;
+        std::string        m_path;
+        std::string        m_version;
+        std::string        m_body;
+        bool            m_keepAlive;
+    };
+
+    //! Response to a request
+    class Response {
+    public:
+        Response();
+
+    public:
+        int                m_status;
+        std::string        m_contentType;
+        std::string        m_body;
+
+        // if true the connection becomes an event stream and m_body
+        // holds the first events to send (see formatEvent())
+        bool            m_stream;
+    };
+
+    //! Result of parseRequest()
+    enum EParseResult {
+        kIncomplete,
+        kComplete,
+        kBadRequest
+    };
+
+    //! Largest request head accepted
+    static const size_t    kMaxHeaderSize = 64 * 1024;
+
+    //! Largest request body accepted
+    static const size_t    kMaxBodySize = 2 * 1024 * 1024;
+
+    //! Most events queued for a subscriber before it's dropped
+    static const size_t    kMaxQueuedEvents = 256;
+
+    // The socket factory is adopted.
+    HostControlServer(const NetworkAddress&, ISocketFactory*,
+                            IEventQueue* events);
+    ~HostControlServer();
+
+    //! @name manipulators
+    //@{
+
+    //! Set the server that handles requests
+    void                setServer(Server* server);
+
+    //! Publish an event
+    /*!
+    Sends event \c name with \c data to every subscriber.  \c data must
+    not contain newlines.
+    */
+    void                publish(const std::string& name, const std::string& data);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get number of connected clients
+    size_t                getNumConnections() const;
+
+    //! Get number of connected event subscribers
+    size_t                getNumSubscribers() const;
+
+    //! Parse a request
+    /*!
+    Parses the request at the start of \c buffer into \c request and
+    removes it from \c buffer.  Returns kIncomplete if \c buffer
+    doesn't hold a whole request yet.  Returns kBadRequest if the
+    request is malformed or too large.
+    */
+    static EParseResult    parseRequest(std::string& buffer, Request& request);
+
+    //! Format a response
+    /*!
+    Formats the status line, headers and body of \c response.  For a
+    streaming response there's no Content-Length and the body is the
+    start of the stream.
+    */
+    static std::string    formatResponse(const Response&, bool keepAlive);
+
+    //! Format an event
+    static std::string    formatEvent(const std::string& name,
+                            const std::string& data);
+
+    //! Inject input
+    /*!
+    Passes the input described by \c commands to \c injector.  There's
+    one command per line:
+    \code
+    move <x> <y>
+    rmove <dx> <dy>
+    button <id> down|up
+    wheel <xDelta> <yDelta>
+    key <id> down|up [<mask> [<button>]]
+    \endcode
+    Numbers may be decimal or hex with a 0x prefix.  Blank lines are
+    skipped.  Returns false without injecting anything if any line is
+    malformed.
+    */
+    static bool            injectInput(const std::string& commands,
+                            IInputInjector& injector);
+
+    //@}
+
+private:
+    class Connection {
+    public:
+        Connection(IDataSocket* socket);
+
+    public:
+        IDataSocket*    m_socket;
+        std::string        m_input;
+        bool            m_closing;
+        bool            m_flushed;
+        bool            m_subscriber;
+
+        // events waiting for the socket to flush
+        std::deque<std::string>    m_queue;
+    };
+
+    void                handleConnecting(const Event&, void*);
+    void                handleInputReady(const Event&, void*);
+    void                handleOutputFlushed(const Event&, void*);
+    void                handleInputShutdown(const Event&, void*);
+    void                handleDisconnected(const Event&, void*);
+    void                handleClosed(const Event&, void*);
+
+    // answer every complete request buffered on the connection
+    void                processInput(Connection*);
+
+    // send a response on the connection
+    void                send(Connection*, const Response&, bool keepAlive);
+
+    // queue an event for a subscriber.  returns false if the subscriber
+    // is too far behind.
+    bool                sendEvent(Connection*, const std::string& event);
+
+    // close once everything written has been sent
+    void                closeWhenFlushed(Connection*);
+
+    void                removeConnection(Connection*);
+
+private:
+    typedef std::set<Connection*> Connections;
+
+    ISocketFactory*        m_socketFactory;
+    IListenSocket*        m_listen;
+    IEventQueue*        m_events;
+    Server*                m_server;
+    Connections            m_connections;
+    Connections            m_closed;
+    Event::Type            m_closedType;
+};
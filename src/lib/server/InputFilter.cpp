@@ -89,6 +89,12 @@ InputFilter::KeystrokeCondition::getMask() const
     return m_mask;
 }
 
+UInt32
+InputFilter::KeystrokeCondition::getId() const
+{
+    return m_id;
+}
+
 InputFilter::Condition*
 InputFilter::KeystrokeCondition::clone() const
 {
@@ -141,6 +147,10 @@ InputFilter::KeystrokeCondition::disablePrimary(PrimaryClient* primary)
     m_id = 0;
 }
 
+const KeyModifierMask InputFilter::MouseButtonCondition::s_ignoreMask =
+    KeyModifierAltGr | KeyModifierCapsLock |
+    KeyModifierNumLock | KeyModifierScrollLock;
+
 InputFilter::MouseButtonCondition::MouseButtonCondition(
         IEventQueue* events, IPlatformScreen::ButtonInfo* info) :
     m_button(info->m_button),
@@ -194,10 +204,6 @@ std::string InputFilter::MouseButtonCondition::format() const
 InputFilter::EFilterStatus
 InputFilter::MouseButtonCondition::match(const Event& event)
 {
-    static const KeyModifierMask s_ignoreMask =
-        KeyModifierAltGr | KeyModifierCapsLock |
-        KeyModifierNumLock | KeyModifierScrollLock;
-
     EFilterStatus status;
 
     // check for hotkey events
@@ -901,7 +907,8 @@ InputFilter::Rule::getAction(bool onActivation, UInt32 index) const
 // -----------------------------------------------------------------------------
 InputFilter::InputFilter(IEventQueue* events) :
     m_primaryClient(NULL),
-    m_events(events)
+    m_events(events),
+    m_indexValid(false)
 {
     // do nothing
 }
@@ -909,7 +916,8 @@ InputFilter::InputFilter(IEventQueue* events) :
 InputFilter::InputFilter(const InputFilter& x) :
     m_ruleList(x.m_ruleList),
     m_primaryClient(NULL),
-    m_events(x.m_events)
+    m_events(x.m_events),
+    m_indexValid(false)
 {
     setPrimaryClient(x.m_primaryClient);
 }
@@ -927,6 +935,7 @@ InputFilter::operator=(const InputFilter& x)
         setPrimaryClient(NULL);
 
         m_ruleList = x.m_ruleList;
+        m_indexValid = false;
 
         setPrimaryClient(oldClient);
     }
@@ -940,6 +949,7 @@ InputFilter::addFilterRule(const Rule& rule)
     if (m_primaryClient != NULL) {
         m_ruleList.back().enable(m_primaryClient);
     }
+    m_indexValid = false;
 }
 
 void
@@ -949,11 +959,13 @@ InputFilter::removeFilterRule(UInt32 index)
         m_ruleList[index].disable(m_primaryClient);
     }
     m_ruleList.erase(m_ruleList.begin() + index);
+    m_indexValid = false;
 }
 
 InputFilter::Rule&
 InputFilter::getRule(UInt32 index)
 {
+    m_indexValid = false;
     return m_ruleList[index];
 }
 
@@ -989,6 +1001,7 @@ InputFilter::setPrimaryClient(PrimaryClient* client)
     }
 
     m_primaryClient = client;
+    m_indexValid    = false;
 
     if (m_primaryClient != NULL) {
         m_events->adoptHandler(m_events->forIKeyState().keyDown(),
@@ -1087,10 +1100,52 @@ InputFilter::handleEvent(const Event& event, void*)
                                 event.getFlags() | Event::kDontFreeData |
                                 Event::kDeliverImmediately);
 
-    // let each rule try to match the event until one does
-    for (RuleList::iterator rule  = m_ruleList.begin();
-                             rule != m_ruleList.end(); ++rule) {
-        if (rule->handleEvent(myEvent)) {
+    if (!m_indexValid) {
+        buildIndex();
+    }
+
+    // find the rules whose condition could match this event
+    static const RuleIndexList s_noRules;
+    const RuleIndexList* candidates = &s_noRules;
+    Event::Type type = event.getType();
+    if (type == m_events->forIPrimaryScreen().hotKeyDown() ||
+        type == m_events->forIPrimaryScreen().hotKeyUp()) {
+        const IPlatformScreen::HotKeyInfo* kinfo =
+            static_cast<IPlatformScreen::HotKeyInfo*>(event.getData());
+        HotKeyIndex::const_iterator i = m_hotKeyIndex.find(kinfo->m_id);
+        if (i != m_hotKeyIndex.end()) {
+            candidates = &i->second;
+        }
+    }
+    else if (type == m_events->forIPrimaryScreen().buttonDown() ||
+             type == m_events->forIPrimaryScreen().buttonUp()) {
+        const IPlatformScreen::ButtonInfo* minfo =
+            static_cast<IPlatformScreen::ButtonInfo*>(event.getData());
+        ButtonIndex::const_iterator i = m_buttonIndex.find(ButtonKey(
+            minfo->m_button, minfo->m_mask & ~MouseButtonCondition::s_ignoreMask));
+        if (i != m_buttonIndex.end()) {
+            candidates = &i->second;
+        }
+    }
+    else if (type == m_events->forServer().connected()) {
+        candidates = &m_connectedRules;
+    }
+
+    // let each candidate rule try to match the event until one does.
+    // walk both lists in rule order so the first matching rule wins,
+    // just as if every rule were tried.
+    RuleIndexList::const_iterator i = candidates->begin();
+    RuleIndexList::const_iterator j = m_otherRules.begin();
+    while (i != candidates->end() || j != m_otherRules.end()) {
+        UInt32 index;
+        if (j == m_otherRules.end() ||
+            (i != candidates->end() && *i < *j)) {
+            index = *i++;
+        }
+        else {
+            index = *j++;
+        }
+        if (m_ruleList[index].handleEvent(myEvent)) {
             // handled
             return;
         }
@@ -1099,3 +1154,38 @@ InputFilter::handleEvent(const Event& event, void*)
     // not handled so pass through
     m_events->addEvent(myEvent);
 }
+
+void
+InputFilter::buildIndex()
+{
+    m_hotKeyIndex.clear();
+    m_buttonIndex.clear();
+    m_connectedRules.clear();
+    m_otherRules.clear();
+
+    for (UInt32 index = 0; index < m_ruleList.size(); ++index) {
+        const Condition* condition = m_ruleList[index].getCondition();
+        if (condition == NULL) {
+            // NULL condition never matches
+            continue;
+        }
+
+        if (const KeystrokeCondition* keystroke =
+                dynamic_cast<const KeystrokeCondition*>(condition)) {
+            m_hotKeyIndex[keystroke->getId()].push_back(index);
+        }
+        else if (const MouseButtonCondition* button =
+                dynamic_cast<const MouseButtonCondition*>(condition)) {
+            m_buttonIndex[ButtonKey(button->getButton(),
+                                    button->getMask())].push_back(index);
+        }
+        else if (dynamic_cast<const ScreenConnectedCondition*>(condition) != NULL) {
+            m_connectedRules.push_back(index);
+        }
+        else {
+            m_otherRules.push_back(index);
+        }
+    }
+
+    m_indexValid = true;
+}
@@ -64,6 +64,9 @@ public:
         KeyID                    getKey() const;
         KeyModifierMask            getMask() const;
 
+        // get the hot key id registered with the primary, 0 if none
+        UInt32                    getId() const;
+
         // Condition overrides
         virtual Condition*        clone() const;
         virtual std::string format() const;
@@ -88,6 +91,9 @@ public:
         ButtonID                getButton() const;
         KeyModifierMask            getMask() const;
 
+        // modifiers that are ignored when matching a button event
+        static const KeyModifierMask s_ignoreMask;
+
         // Condition overrides
         virtual Condition*        clone() const;
         virtual std::string format() const;
@@ -334,7 +340,8 @@ public:
     virtual ~InputFilter();
 
 #ifdef BARRIER_TEST_ENV
-    InputFilter() : m_primaryClient(NULL) { }
+    InputFilter() : m_primaryClient(NULL), m_indexValid(false) { }
+    void                handleEventForTest(const Event& event) { handleEvent(event, NULL); }
 #endif
 
     InputFilter&        operator=(const InputFilter&);
@@ -345,7 +352,8 @@ public:
     // remove a rule
     void                removeFilterRule(UInt32 index);
 
-    // get rule by index
+    // get rule by index.  the rule may be modified through the result
+    // so this also discards the rule index.
     Rule&                getRule(UInt32 index);
 
     // enable event filtering using the given primary client.  disable
@@ -367,8 +375,28 @@ private:
     // event handling
     void                handleEvent(const Event&, void*);
 
+    // rebuild the rule index from m_ruleList.  must be done after the
+    // rules change and after the primary assigned hot key ids.
+    void                buildIndex();
+
 private:
+    // indices into m_ruleList, in ascending order
+    typedef std::vector<UInt32> RuleIndexList;
+    typedef std::map<UInt32, RuleIndexList> HotKeyIndex;
+    typedef std::pair<ButtonID, KeyModifierMask> ButtonKey;
+    typedef std::map<ButtonKey, RuleIndexList> ButtonIndex;
+
     RuleList            m_ruleList;
     PrimaryClient*        m_primaryClient;
     IEventQueue*        m_events;
+
+    // rules indexed by the only events their condition can match.
+    // keystroke rules are keyed by hot key id because that's all a hot
+    // key event carries.  rules with any other kind of condition are
+    // candidates for every event.
+    bool                m_indexValid;
+    HotKeyIndex            m_hotKeyIndex;
+    ButtonIndex            m_buttonIndex;
+    RuleIndexList        m_connectedRules;
+    RuleIndexList        m_otherRules;
 };
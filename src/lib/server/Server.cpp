@@ -23,6 +23,7 @@
 #include "server/PrimaryClient.h"
 #include "server/ClientListener.h"
 #include "barrier/FileChunk.h"
+#include "barrier/IInputInjector.h"
 #include "barrier/IPlatformScreen.h"
 #include "barrier/DropHelper.h"
 #include "barrier/option_types.h"
@@ -42,6 +43,7 @@
 #include "arch/Arch.h"
 #include "base/IEventQueue.h"
 #include "base/Log.h"
+#include "base/String.h"
 #include "base/TMethodEventJob.h"
 #include "core/layout/LayoutLoader.h"
 
@@ -117,6 +119,7 @@ Server::Server(
 	m_yDelta2(0),
 	m_config(&config),
 	m_inputFilter(config.getInputFilter()),
+	m_appliedConfig(events),
 	m_activeSaver(NULL),
 	m_switchDir(kNoDirection),
 	m_switchScreen(NULL),
@@ -140,10 +143,13 @@ Server::Server(
 	m_enableClipboard(true),
 	m_sendDragInfoThread(NULL),
 	m_waitDragInfoThread(true),
+	m_clientListener(NULL),
+	m_hostControl(NULL),
+	m_inputInjector(NULL),
 	m_args(args),
 	m_activeLayoutScreenId(primaryClient != NULL ? primaryClient->getName() : std::string()),
-	m_httpListener(NULL),
-	m_running(false)
+	m_activeLayoutScreen(NULL),
+	m_activeLayoutScreenValid(false)
 {
 	// must have a primary client and it must have a canonical name
 	assert(m_primaryClient != NULL);
@@ -264,27 +270,8 @@ Server::Server(
 		m_lockedToScreen = true;
 	}
 
-// Initialize current host to server's own name
+	// Initialize current host to server's own name
     m_currentHost = m_primaryClient->getName();
-
-    // Start the HTTP endpoint
-    try {
-        NetworkAddress addr("0.0.0.0", 24802);  // Listen on all interfaces, port 24801
-        addr.resolve();
-
-    
-	m_httpListener = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
-        ARCH->bindSocket(m_httpListener, addr.getAddress());
-        ARCH->listenOnSocket(m_httpListener);  // Backlog 5
-
-        m_running = true;
-        m_httpThread = std::thread(&Server::httpLoop, this);
-
-    } catch (XBase& e) {
-        LOG((CLOG_ERR "Failed to start HTTP endpoint: %s", e.what()));
-    }
-
-
 }
 
 Server::~Server()
@@ -329,6 +316,7 @@ Server::~Server()
 		m_events->deleteTimer(index->second);
 		m_events->removeHandler(Event::kTimer, client);
 		m_events->removeHandler(m_events->forClientProxy().disconnected(), client);
+		m_events->removeHandler(m_events->forClientProxy().lockStateChanged(), client);
 		delete client;
 	}
 
@@ -338,12 +326,6 @@ Server::~Server()
 	// disable and disconnect primary client
 	m_primaryClient->disable();
 	removeClient(m_primaryClient);
-
-    if (m_httpListener) {
-        m_running = false;
-        ARCH->closeSocket(m_httpListener);
-        m_httpThread.join();
-    }
 }
 
 bool
@@ -354,12 +336,37 @@ Server::setConfig(const Config& config)
 		return false;
 	}
 
+	// only apply what changed since the last time.  the first time
+	// through everything is new.
+	const bool firstConfig = (m_appliedConfig.begin() == m_appliedConfig.end());
+	const Config::Delta delta = recordAppliedConfig(config);
+	LOG((CLOG_DEBUG "configuration changes: %d added, %d removed, %d relinked, %d with new options%s%s%s",
+		static_cast<int>(delta.m_addedScreens.size()),
+		static_cast<int>(delta.m_removedScreens.size()),
+		static_cast<int>(delta.m_changedLinks.size()),
+		static_cast<int>(delta.m_changedOptions.size()),
+		delta.m_aliasesChanged ? ", aliases" : "",
+		delta.m_globalOptionsChanged ? ", global options" : "",
+		delta.m_filterChanged ? ", hotkeys" : ""));
+
+	// the listener is bound once at startup
+	if (delta.m_addressChanged && !firstConfig) {
+		LOG((CLOG_WARN "the listen address changed, restart the server to use it"));
+	}
+
 	// close clients that are connected but being dropped from the
 	// configuration.
-	closeClients(config);
+	const bool screensChanged = (!delta.m_addedScreens.empty() ||
+								 !delta.m_removedScreens.empty() ||
+								 delta.m_aliasesChanged);
+	if (!delta.m_removedScreens.empty() || delta.m_aliasesChanged) {
+		closeClients(config);
+	}
 
 	// cut over
-	processOptions();
+	if (delta.m_globalOptionsChanged) {
+		processOptions();
+	}
 
 	// add ScrollLock as a hotkey to lock to the screen.  this was a
 	// built-in feature in earlier releases and is now supported via
@@ -368,28 +375,65 @@ Server::setConfig(const Config& config)
 	// we will unfortunately generate a warning.  if the user has
 	// configured a LockCursorToScreenAction then we don't add
 	// ScrollLock as a hotkey.
-	if (!m_config->hasLockToScreenAction()) {
-		IPlatformScreen::KeyInfo* key =
-			IPlatformScreen::KeyInfo::alloc(kKeyScrollLock, 0, 0, 0);
-		InputFilter::Rule rule(new InputFilter::KeystrokeCondition(m_events, key));
-		rule.adoptAction(new InputFilter::LockCursorToScreenAction(m_events), true);
-		m_inputFilter->addFilterRule(rule);
-	}
+	addLockToScreenHotkey();
 
-	// tell primary screen about reconfiguration
+	// the object layout lives in its own file so reload it every time.
+	// this keeps the active screen.
 	reloadScreenLayout();
-	m_primaryClient->reconfigure(getActivePrimarySides());
 
-	// tell all (connected) clients about current options
+	// tell primary screen about reconfiguration
+	if (screensChanged || !delta.m_changedLinks.empty()) {
+		m_primaryClient->reconfigure(getActivePrimarySides());
+	}
+
+	// tell (connected) clients about options that changed for them
 	for (ClientList::const_iterator index = m_clients.begin();
 								index != m_clients.end(); ++index) {
-		BaseClientProxy* client = index->second;
-		sendOptions(client);
+		if (delta.m_globalOptionsChanged ||
+			delta.m_changedOptions.count(index->first) != 0) {
+			sendOptions(index->second);
+		}
 	}
 
+	publishHostControlEvent("config",
+		delta.isEmpty() ? "{\"changed\":false}" : "{\"changed\":true}");
+
 	return true;
 }
 
+Config::Delta
+Server::recordAppliedConfig(const Config& config)
+{
+	// remember what we're applying before the built-in hotkey goes into
+	// the filter, so reloading the same file compares equal.  assignment
+	// keeps the copy's input filter detached from the primary.
+	const Config::Delta delta = m_appliedConfig.diff(config);
+	m_appliedConfig = config;
+	return delta;
+}
+
+void
+Server::addLockToScreenHotkey()
+{
+	if (m_config->hasLockToScreenAction()) {
+		return;
+	}
+
+	IPlatformScreen::KeyInfo* key =
+		IPlatformScreen::KeyInfo::alloc(kKeyScrollLock, 0, 0, 0);
+	InputFilter::Rule rule(new InputFilter::KeystrokeCondition(m_events, key));
+	rule.adoptAction(new InputFilter::LockCursorToScreenAction(m_events), true);
+
+	// an unchanged filter still has it from last time
+	const std::string format = rule.format();
+	for (UInt32 i = 0; i < m_inputFilter->getNumRules(); ++i) {
+		if (m_inputFilter->getRule(i).format() == format) {
+			return;
+		}
+	}
+	m_inputFilter->addFilterRule(rule);
+}
+
 void
 Server::adoptClient(BaseClientProxy* client)
 {
@@ -399,6 +443,9 @@ Server::adoptClient(BaseClientProxy* client)
 	m_events->adoptHandler(m_events->forClientProxy().disconnected(), client,
 							new TMethodEventJob<Server>(this,
 								&Server::handleClientDisconnected, client));
+	m_events->adoptHandler(m_events->forClientProxy().lockStateChanged(), client,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClientLockStateChanged, client));
 
 	// name must be in our configuration
 	if (!m_config->isScreen(client->getName())) {
@@ -430,6 +477,8 @@ Server::adoptClient(BaseClientProxy* client)
 		new Server::ScreenConnectedInfo(getName(client));
 	m_events->addEvent(Event(m_events->forServer().connected(),
 								m_primaryClient->getEventTarget(), info));
+	publishHostControlEvent("connected",
+		"{\"screen\":\"" + getName(client) + "\"}");
 }
 
 void
@@ -498,13 +547,14 @@ Server::getActiveLayoutScreen() const
         return NULL;
     }
 
-    const etherwaver::layout::Screen* screen =
-        m_screenLayout.getScreen(m_activeLayoutScreenId);
-    if (screen != NULL) {
-        return screen;
+    if (!m_activeLayoutScreenValid) {
+        m_activeLayoutScreen = m_screenLayout.getScreen(m_activeLayoutScreenId);
+        if (m_activeLayoutScreen == NULL) {
+            m_activeLayoutScreen = getGeometry(m_active).m_layoutScreen;
+        }
+        m_activeLayoutScreenValid = true;
     }
-
-    return m_screenLayout.getFirstScreenForHost(getName(m_active));
+    return m_activeLayoutScreen;
 }
 
 const etherwaver::layout::Screen*
@@ -526,6 +576,41 @@ Server::getClientForLayoutScreen(const etherwaver::layout::Screen& screen) const
     return it->second;
 }
 
+Server::ScreenGeometry::ScreenGeometry() :
+    m_x(0),
+    m_y(0),
+    m_w(0),
+    m_h(0),
+    m_jumpZone(0),
+    m_layoutScreen(NULL)
+{
+}
+
+const Server::ScreenGeometry&
+Server::getGeometry(const BaseClientProxy* client) const
+{
+    GeometryCache::const_iterator i = m_geometry.find(client);
+    if (i != m_geometry.end()) {
+        return i->second;
+    }
+
+    ScreenGeometry& geometry = m_geometry[client];
+    client->getShape(geometry.m_x, geometry.m_y, geometry.m_w, geometry.m_h);
+    geometry.m_jumpZone =
+        (client == m_primaryClient) ? m_primaryClient->getJumpZoneSize() : 0;
+    geometry.m_name = getName(client);
+    geometry.m_layoutScreen = getLayoutScreenForHost(geometry.m_name);
+    return geometry;
+}
+
+void
+Server::invalidateGeometry()
+{
+    m_geometry.clear();
+    m_activeLayoutScreen = NULL;
+    m_activeLayoutScreenValid = false;
+}
+
 void
 Server::reloadScreenLayout()
 {
@@ -563,6 +648,9 @@ Server::reloadScreenLayout()
     if (activeScreen != NULL) {
         m_activeLayoutScreenId = activeScreen->m_id;
     }
+
+    // shapes, names and layout screens may all have changed
+    invalidateGeometry();
 }
 
 bool
@@ -573,8 +661,11 @@ Server::trySwitchUsingObjectLayout(SInt32 x, SInt32 y, bool absoluteMotion)
         return false;
     }
 
-    SInt32 ax, ay, aw, ah;
-    m_active->getShape(ax, ay, aw, ah);
+    const ScreenGeometry& active = getGeometry(m_active);
+    const SInt32 ax = active.m_x;
+    const SInt32 ay = active.m_y;
+    const SInt32 aw = active.m_w;
+    const SInt32 ah = active.m_h;
 
     const int globalX = toGlobalCoordinate(x, ax, aw, sourceScreen->m_x, sourceScreen->m_width);
     const int globalY = toGlobalCoordinate(y, ay, ah, sourceScreen->m_y, sourceScreen->m_height);
@@ -606,16 +697,18 @@ Server::trySwitchUsingObjectLayout(SInt32 x, SInt32 y, bool absoluteMotion)
     const SInt32 xActive = clampInt(x, ax, ax + aw - 1);
     const SInt32 yActive = clampInt(y, ay, ay + ah - 1);
 
-    SInt32 dx = 0;
-    SInt32 dy = 0;
-    destinationClient->getShape(dx, dy, aw, ah);
+    const ScreenGeometry& destination = getGeometry(destinationClient);
+    const SInt32 dx = destination.m_x;
+    const SInt32 dy = destination.m_y;
+    const SInt32 dw = destination.m_w;
+    const SInt32 dh = destination.m_h;
 
     SInt32 targetX = toClientCoordinate(globalX, destinationScreen->m_x, destinationScreen->m_width,
-                                        dx, aw);
+                                        dx, dw);
     SInt32 targetY = toClientCoordinate(globalY, destinationScreen->m_y, destinationScreen->m_height,
-                                        dy, ah);
-    targetX = clampInt(targetX, dx, dx + aw - 1);
-    targetY = clampInt(targetY, dy, dy + ah - 1);
+                                        dy, dh);
+    targetX = clampInt(targetX, dx, dx + dw - 1);
+    targetY = clampInt(targetY, dy, dy + dh - 1);
 
     if (!isSwitchOkay(destinationClient, direction, targetX, targetY, xActive, yActive)) {
         return false;
@@ -739,20 +832,18 @@ Server::switchScreen(BaseClientProxy* dst,
 
 		// cut over
 		m_active = dst;
-		{ 
-			std::lock_guard<std::mutex> lock(m_mutex); 
-			m_currentHost = dst->getName(); 
-			m_current_ip.clear();
-		}
+		m_currentHost = dst->getName();
+		m_current_ip.clear();
 		if (!layoutScreenId.empty()) {
 			m_activeLayoutScreenId = layoutScreenId;
 		}
 		else if (usingObjectLayout()) {
-			const etherwaver::layout::Screen* screen = getLayoutScreenForHost(getName(dst));
+			const etherwaver::layout::Screen* screen = getGeometry(dst).m_layoutScreen;
 			if (screen != NULL) {
 				m_activeLayoutScreenId = screen->m_id;
 			}
 		}
+		m_activeLayoutScreenValid = false;
 
 		// increment enter sequence number
 		++m_seqNum;
@@ -772,10 +863,12 @@ Server::switchScreen(BaseClientProxy* dst,
 		Server::SwitchToScreenInfo* info =
 			Server::SwitchToScreenInfo::alloc(m_active->getName());
 		m_events->addEvent(Event(m_events->forServer().screenSwitched(), this, info));
+		publishHostControlEvent("screen", getHostControlState());
 	}
 	else {
 		if (!layoutScreenId.empty()) {
 			m_activeLayoutScreenId = layoutScreenId;
+			m_activeLayoutScreenValid = false;
 		}
 		m_active->mouseMove(x, y);
 	}
@@ -1286,14 +1379,15 @@ Server::armSwitchTwoTap(SInt32 x, SInt32 y)
 		else if (!m_switchTwoTapArmed) {
 			// still time for a double tap.  see if we left the tap
 			// zone and, if so, arm the two tap.
-			SInt32 ax, ay, aw, ah;
-			m_active->getShape(ax, ay, aw, ah);
-			SInt32 tapZone = m_primaryClient->getJumpZoneSize();
+			const ScreenGeometry& active = getGeometry(m_active);
+			SInt32 tapZone = getGeometry(m_primaryClient).m_jumpZone;
 			if (tapZone < m_switchTwoTapZone) {
 				tapZone = m_switchTwoTapZone;
 			}
-			if (x >= ax + tapZone && x < ax + aw - tapZone &&
-				y >= ay + tapZone && y < ay + ah - tapZone) {
+			if (x >= active.m_x + tapZone &&
+				x < active.m_x + active.m_w - tapZone &&
+				y >= active.m_y + tapZone &&
+				y < active.m_y + active.m_h - tapZone) {
 				// win32 can generate bogus mouse events that appear to
 				// move in the opposite direction that the mouse actually
 				// moved.  try to ignore that crap here.
@@ -1376,8 +1470,11 @@ Server::getCorner(BaseClientProxy* client,
 	assert(client != NULL);
 
 	// get client screen shape
-	SInt32 ax, ay, aw, ah;
-	client->getShape(ax, ay, aw, ah);
+	const ScreenGeometry& geometry = getGeometry(client);
+	const SInt32 ax = geometry.m_x;
+	const SInt32 ay = geometry.m_y;
+	const SInt32 aw = geometry.m_w;
+	const SInt32 ah = geometry.m_h;
 
 	// check for x,y on the left or right
 	SInt32 xSide;
@@ -1599,6 +1696,9 @@ Server::handleClipboardGrabbed(const Event& event, void* vclient)
 	LOG((CLOG_INFO "screen \"%s\" grabbed clipboard %d from \"%s\"", getName(grabber).c_str(), info->m_id, clipboard.m_clipboardOwner.c_str()));
 	clipboard.m_clipboardOwner  = getName(grabber);
 	clipboard.m_clipboardSeqNum = info->m_sequenceNumber;
+	publishHostControlEvent("clipboard", barrier::string::sprintf(
+		"{\"owner\":\"%s\", \"id\":%d}",
+		clipboard.m_clipboardOwner.c_str(), info->m_id));
 
 	// clear the clipboard data (since it's not known at this point)
 	if (clipboard.m_clipboard.open(0)) {
@@ -1736,6 +1836,25 @@ Server::handleClientDisconnected(const Event&, void* vclient)
 	delete client;
 }
 
+void
+Server::handleClientLockStateChanged(const Event& event, void* vclient)
+{
+	BaseClientProxy* client = static_cast<BaseClientProxy*>(vclient);
+	KeyModifierMask mask = *static_cast<KeyModifierMask*>(event.getData());
+	LOG((CLOG_DEBUG "client \"%s\" lock state caps=%d num=%d scroll=%d",
+		getName(client).c_str(),
+		(mask & KeyModifierCapsLock) != 0 ? 1 : 0,
+		(mask & KeyModifierNumLock) != 0 ? 1 : 0,
+		(mask & KeyModifierScrollLock) != 0 ? 1 : 0));
+
+	publishHostControlEvent("locks", barrier::string::sprintf(
+		"{\"screen\":\"%s\",\"capsLock\":%s,\"numLock\":%s,\"scrollLock\":%s}",
+		getName(client).c_str(),
+		(mask & KeyModifierCapsLock) != 0 ? "true" : "false",
+		(mask & KeyModifierNumLock) != 0 ? "true" : "false",
+		(mask & KeyModifierScrollLock) != 0 ? "true" : "false"));
+}
+
 void
 Server::handleClientCloseTimeout(const Event&, void* vclient)
 {
@@ -2161,9 +2280,12 @@ Server::onMouseMovePrimary(SInt32 x, SInt32 y)
 	}
 
 	// get screen shape
-	SInt32 ax, ay, aw, ah;
-	m_active->getShape(ax, ay, aw, ah);
-	SInt32 zoneSize = getJumpZoneSize(m_active);
+	const ScreenGeometry& active = getGeometry(m_active);
+	const SInt32 ax = active.m_x;
+	const SInt32 ay = active.m_y;
+	const SInt32 aw = active.m_w;
+	const SInt32 ah = active.m_h;
+	const SInt32 zoneSize = active.m_jumpZone;
 
 	// clamp position to screen
 	SInt32 xc = x, yc = y;
@@ -2309,7 +2431,7 @@ Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 	// program on the secondary screen to warp the mouse on us, so we
 	// have no idea where it really is.
 	if (m_relativeMoves && isLockedToScreenServer()) {
-		LOG((CLOG_DEBUG2 "relative move on %s by %d,%d", getName(m_active).c_str(), dx, dy));
+		LOG((CLOG_DEBUG2 "relative move on %s by %d,%d", getGeometry(m_active).m_name.c_str(), dx, dy));
 		m_active->mouseRelativeMove(dx, dy);
 		return;
 	}
@@ -2335,8 +2457,11 @@ Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 	}
 
 	// get screen shape
-	SInt32 ax, ay, aw, ah;
-	m_active->getShape(ax, ay, aw, ah);
+	const ScreenGeometry& active = getGeometry(m_active);
+	const SInt32 ax = active.m_x;
+	const SInt32 ay = active.m_y;
+	const SInt32 aw = active.m_w;
+	const SInt32 ah = active.m_h;
 
 	// find direction of neighbor and get the neighbor
 	bool jump = true;
@@ -2380,7 +2505,7 @@ Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 			// then arm the double tap.
 			if (m_switchScreen != NULL) {
 				bool clearWait;
-				SInt32 zoneSize = m_primaryClient->getJumpZoneSize();
+				SInt32 zoneSize = getGeometry(m_primaryClient).m_jumpZone;
 				switch (m_switchDir) {
 				case kLeft:
 					clearWait = (m_x >= ax + zoneSize);
@@ -2440,24 +2565,24 @@ Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 		m_y = yOld + dy;
 		if (m_x < ax) {
 			m_x = ax;
-			LOG((CLOG_DEBUG2 "clamp to left of \"%s\"", getName(m_active).c_str()));
+			LOG((CLOG_DEBUG2 "clamp to left of \"%s\"", active.m_name.c_str()));
 		}
 		else if (m_x > ax + aw - 1) {
 			m_x = ax + aw - 1;
-			LOG((CLOG_DEBUG2 "clamp to right of \"%s\"", getName(m_active).c_str()));
+			LOG((CLOG_DEBUG2 "clamp to right of \"%s\"", active.m_name.c_str()));
 		}
 		if (m_y < ay) {
 			m_y = ay;
-			LOG((CLOG_DEBUG2 "clamp to top of \"%s\"", getName(m_active).c_str()));
+			LOG((CLOG_DEBUG2 "clamp to top of \"%s\"", active.m_name.c_str()));
 		}
 		else if (m_y > ay + ah - 1) {
 			m_y = ay + ah - 1;
-			LOG((CLOG_DEBUG2 "clamp to bottom of \"%s\"", getName(m_active).c_str()));
+			LOG((CLOG_DEBUG2 "clamp to bottom of \"%s\"", active.m_name.c_str()));
 		}
 
 		// warp cursor if it moved.
 		if (m_x != xOld || m_y != yOld) {
-			LOG((CLOG_DEBUG2 "move on %s to %d,%d", getName(m_active).c_str(), m_x, m_y));
+			LOG((CLOG_DEBUG2 "move on %s to %d,%d", active.m_name.c_str(), m_x, m_y));
 			m_active->mouseMove(m_x, m_y);
 		}
 	}
@@ -2565,6 +2690,11 @@ Server::removeClient(BaseClientProxy* client)
 	m_clientSet.erase(i);
 	reloadScreenLayout();
 
+	if (client != m_primaryClient) {
+		publishHostControlEvent("disconnected",
+			"{\"screen\":\"" + getName(client) + "\"}");
+	}
+
 	return true;
 }
 
@@ -2635,6 +2765,7 @@ Server::removeActiveClient(BaseClientProxy* client)
 	if (removeClient(client)) {
 		forceLeaveClient(client);
 		m_events->removeHandler(m_events->forClientProxy().disconnected(), client);
+		m_events->removeHandler(m_events->forClientProxy().lockStateChanged(), client);
 		if (m_clients.size() == 1 && m_oldClients.empty()) {
 			m_events->addEvent(Event(m_events->forServer().disconnected(), this));
 		}
@@ -2647,6 +2778,7 @@ Server::removeOldClient(BaseClientProxy* client)
 	OldClients::iterator i = m_oldClients.find(client);
 	if (i != m_oldClients.end()) {
 		m_events->removeHandler(m_events->forClientProxy().disconnected(), client);
+		m_events->removeHandler(m_events->forClientProxy().lockStateChanged(), client);
 		m_events->removeHandler(Event::kTimer, i->second);
 		m_events->deleteTimer(i->second);
 		m_oldClients.erase(i);
@@ -2676,11 +2808,14 @@ Server::forceLeaveClient(BaseClientProxy* client)
 
 		// cut over
 		m_active = m_primaryClient;
+		m_currentHost = m_primaryClient->getName();
+		m_current_ip.clear();
 		const etherwaver::layout::Screen* primaryScreen =
 			getLayoutScreenForHost(getName(m_primaryClient));
 		if (primaryScreen != NULL) {
 			m_activeLayoutScreenId = primaryScreen->m_id;
 		}
+		m_activeLayoutScreenValid = false;
 
 		// enter new screen (unless we already have because of the
 		// screen saver)
@@ -2692,6 +2827,7 @@ Server::forceLeaveClient(BaseClientProxy* client)
 		Server::SwitchToScreenInfo* info =
 			Server::SwitchToScreenInfo::alloc(m_active->getName());
 		m_events->addEvent(Event(m_events->forServer().screenSwitched(), this, info));
+		publishHostControlEvent("screen", getHostControlState());
 	}
 
 	// if this screen had the cursor when the screen saver activated
@@ -2829,206 +2965,116 @@ Server::dragInfoReceived(UInt32 fileNum, std::string content)
 	m_screen->startDraggingFiles(m_fakeDragFileList);
 }
 
-void Server::httpLoop()
+void
+Server::handleHostControlRequest(const HostControlServer::Request& request,
+                            HostControlServer::Response& response)
 {
-    while (m_running) {
-        ArchSocket socket = ARCH->acceptSocket(m_httpListener, nullptr);
-
-        if (!socket) {
-            // prevent 100% CPU when no clients connect
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
-        }
-
-        try {
-            std::string request;
-            char requestBuf[4096];
-            size_t bytesRead = ARCH->readSocket(socket, requestBuf, sizeof(requestBuf));
-            if (bytesRead == 0) {
-                ARCH->closeSocket(socket);
-                continue;
-            }
-            request.append(requestBuf, bytesRead);
+    const std::string& method = request.m_method;
+    const std::string& body   = request.m_body;
+    std::string path          = request.m_path;
 
-            size_t headerEnd = request.find("\r\n\r\n");
-            size_t headerSize = 4;
-            if (headerEnd == std::string::npos) {
-                headerEnd = request.find("\n\n");
-                headerSize = 2;
-            }
-
-            while (headerEnd == std::string::npos && request.size() < 1024 * 1024) {
-                bytesRead = ARCH->readSocket(socket, requestBuf, sizeof(requestBuf));
-                if (bytesRead == 0) {
-                    break;
-                }
-                request.append(requestBuf, bytesRead);
-                headerEnd = request.find("\r\n\r\n");
-                headerSize = 4;
-                if (headerEnd == std::string::npos) {
-                    headerEnd = request.find("\n\n");
-                    headerSize = 2;
-                }
-            }
-
-            std::string method;
-            std::string path;
-            std::string requestLine;
-            std::string headers;
-            std::string body;
-
-            if (headerEnd != std::string::npos) {
-                headers = request.substr(0, headerEnd);
-                body = request.substr(headerEnd + headerSize);
-            }
-            else {
-                headers = request;
-            }
-
-            size_t lineEnd = headers.find("\r\n");
-            if (lineEnd == std::string::npos) {
-                lineEnd = headers.find('\n');
-            }
-            if (lineEnd != std::string::npos) {
-                requestLine = headers.substr(0, lineEnd);
-                std::istringstream iss(requestLine);
-                iss >> method >> path;
-            }
-
-            size_t contentLength = 0;
-            {
-                std::istringstream hs(headers);
-                std::string line;
-                // skip request line
-                std::getline(hs, line);
-                while (std::getline(hs, line)) {
-                    if (!line.empty() && line[line.size() - 1] == '\r') {
-                        line.erase(line.size() - 1);
-                    }
-                    std::string lowerLine = line;
-                    for (size_t i = 0; i < lowerLine.size(); ++i) {
-                        lowerLine[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(lowerLine[i])));
-                    }
-                    if (lowerLine.compare(0, 15, "content-length:") == 0) {
-                        std::string lenStr = line.substr(15);
-                        size_t firstNotSpace = lenStr.find_first_not_of(" \t");
-                        if (firstNotSpace != std::string::npos) {
-                            lenStr = lenStr.substr(firstNotSpace);
-                            contentLength = static_cast<size_t>(std::strtoul(lenStr.c_str(), NULL, 10));
-                        }
-                        break;
-                    }
-                }
-            }
-
-            while (body.size() < contentLength && request.size() < 2 * 1024 * 1024) {
-                bytesRead = ARCH->readSocket(socket, requestBuf, sizeof(requestBuf));
-                if (bytesRead == 0) {
-                    break;
-                }
-                body.append(requestBuf, bytesRead);
-            }
+    // remove query string if present
+    size_t queryPos = path.find('?');
+    if (queryPos != std::string::npos) {
+        path = path.substr(0, queryPos);
+    }
 
-            if (contentLength < body.size()) {
-                body.resize(contentLength);
+    const std::string switchPrefix = "/set/screen/";
+    const bool isConfigRequest = (path == "/get/config" || path == "/config");
+    const bool isSetConfigRequest = (path == "/set/config" && method == "POST");
+    const bool isInputRequest = (path == "/input" && method == "POST");
+    bool isSwitchRequest = (path.compare(0, switchPrefix.size(), switchPrefix) == 0);
+    std::string responseBody;
+    std::string contentType;
+
+    if (isSwitchRequest) {
+        std::string requestedScreen = path.substr(switchPrefix.size());
+        bool found = false;
+
+        if (!requestedScreen.empty()) {
+            std::string canonical = m_config->getCanonicalName(requestedScreen);
+            if (!canonical.empty()) {
+                requestedScreen = canonical;
             }
 
-            // remove query string if present
-            size_t queryPos = path.find('?');
-            if (queryPos != std::string::npos) {
-                path = path.substr(0, queryPos);
+            ClientList::const_iterator index = m_clients.find(requestedScreen);
+            if (index != m_clients.end()) {
+                jumpToScreen(index->second);
+                found = true;
             }
+        }
 
-            const std::string switchPrefix = "/set/screen/";
-            const bool isConfigRequest = (path == "/get/config" || path == "/config");
-            const bool isSetConfigRequest = (path == "/set/config" && method == "POST");
-            bool isSwitchRequest = (path.compare(0, switchPrefix.size(), switchPrefix) == 0);
-            std::string responseBody;
-            std::string contentType;
-
-            if (isSwitchRequest) {
-                std::string requestedScreen = path.substr(switchPrefix.size());
-                bool found = false;
-
-                if (!requestedScreen.empty()) {
-                    std::string canonical = m_config->getCanonicalName(requestedScreen);
-                    if (!canonical.empty()) {
-                        requestedScreen = canonical;
-                    }
-
-                    ClientList::const_iterator index = m_clients.find(requestedScreen);
-                    if (index != m_clients.end()) {
-                        jumpToScreen(index->second);
-                        found = true;
+        responseBody = found ? "ok" : "false";
+        contentType = "text/plain";
+    }
+    else if (isSetConfigRequest) {
+        bool ok = false;
+        try {
+            Config validatedConfig(m_events);
+            std::istringstream testStream(body);
+            testStream >> validatedConfig;
+
+            if (validatedConfig.isScreen(m_primaryClient->getName())) {
+                std::string configPath = m_args.m_configFile.empty() ? "http_set_config.conf" : m_args.m_configFile;
+                std::ofstream configOut(configPath.c_str(), std::ios::binary | std::ios::trunc);
+                if (configOut.is_open()) {
+                    configOut.write(body.data(), static_cast<std::streamsize>(body.size()));
+                    configOut.close();
+
+                    if (!configOut.fail()) {
+                        // already parsed above so just adopt it
+                        *m_config = validatedConfig;
+                        ok = setConfig(*m_config);
                     }
                 }
-
-                responseBody = found ? "ok" : "false";
-                contentType = "text/plain";
             }
-            else if (isSetConfigRequest) {
-                bool ok = false;
-                try {
-                    Config validatedConfig(m_events);
-                    std::istringstream testStream(body);
-                    testStream >> validatedConfig;
-
-                    if (validatedConfig.isScreen(m_primaryClient->getName())) {
-                        std::string configPath = m_args.m_configFile.empty() ? "http_set_config.conf" : m_args.m_configFile;
-                        std::ofstream configOut(configPath.c_str(), std::ios::binary | std::ios::trunc);
-                        if (configOut.is_open()) {
-                            configOut.write(body.data(), static_cast<std::streamsize>(body.size()));
-                            configOut.close();
-
-                            if (!configOut.fail()) {
-                                std::istringstream applyStream(body);
-                                applyStream >> *m_config;
-                                ok = setConfig(*m_config);
-                            }
-                        }
-                    }
-                }
-                catch (...) {
-                    ok = false;
-                }
-
-                responseBody = ok ? "ok" : "false";
-                contentType = "text/plain";
-            }
-            else if (isConfigRequest) {
-                std::ostringstream out;
-                out << *m_config;
-                responseBody = out.str();
-                contentType = "text/plain";
-            }
-            else {
-                std::string current;
-                std::string currentIp;
-
-                {
-                    std::lock_guard<std::mutex> lock(m_mutex);
-                    current = m_currentHost;
-                    currentIp = m_current_ip;
-                }
-
-                responseBody = "{\"server\": {\"current\":\"" + current + "\", \"ip\":\"" + currentIp + "\"}}";
-                contentType = "application/json";
-            }
-
-            std::string response =
-                "HTTP/1.1 200 OK\r\n"
-                "Content-Type: " + contentType + "\r\n"
-                "Content-Length: " + std::to_string(responseBody.size()) + "\r\n"
-                "Connection: close\r\n\r\n" + responseBody;
-
-            ARCH->writeSocket(socket,
-                              (const UInt8*)response.data(),
-                              response.size());
         }
         catch (...) {
-            // Ignore errors
+            ok = false;
         }
 
-        ARCH->closeSocket(socket);
+        responseBody = ok ? "ok" : "false";
+        contentType = "text/plain";
+    }
+    else if (isInputRequest) {
+        // only a virtual primary screen takes input this way
+        bool ok = (m_inputInjector != NULL &&
+                   HostControlServer::injectInput(body, *m_inputInjector));
+        responseBody = ok ? "ok" : "false";
+        contentType = "text/plain";
+    }
+    else if (isConfigRequest) {
+        std::ostringstream out;
+        out << *m_config;
+        responseBody = out.str();
+        contentType = "text/plain";
+    }
+    else if (path == "/events") {
+        // start with the current state so a reconnecting subscriber
+        // doesn't miss anything
+        response.m_stream = true;
+        responseBody = HostControlServer::formatEvent("screen", getHostControlState());
+        contentType = "text/event-stream";
     }
+    else {
+        responseBody = "{\"server\": " + getHostControlState() + "}";
+        contentType = "application/json";
+    }
+
+    response.m_contentType = contentType;
+    response.m_body        = responseBody;
+}
+
+void
+Server::publishHostControlEvent(const char* name, const std::string& data)
+{
+    if (m_hostControl != NULL) {
+        m_hostControl->publish(name, data);
+    }
+}
+
+std::string
+Server::getHostControlState() const
+{
+    return "{\"current\":\"" + m_currentHost + "\", \"ip\":\"" + m_current_ip + "\"}";
 }
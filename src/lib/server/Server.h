@@ -33,9 +33,7 @@
 #include "common/stdset.h"
 #include "common/stdvector.h"
 #include "core/layout/ScreenManager.h"
-
-#include <mutex>
-#include <thread>
+#include "server/HostControlServer.h"
 
 class BaseClientProxy;
 class EventQueueTimer;
@@ -43,6 +41,7 @@ class PrimaryClient;
 class InputFilter;
 namespace barrier { class Screen; }
 class IEventQueue;
+class IInputInjector;
 class Thread;
 class ClientListener;
 
@@ -116,7 +115,36 @@ public:
 
 #ifdef BARRIER_TEST_ENV
     Server() : m_mock(true), m_config(NULL) { }
+    Server(Config& config, PrimaryClient* primaryClient) :
+        m_mock(true), m_primaryClient(primaryClient), m_active(NULL),
+        m_seqNum(0), m_x(0), m_y(0),
+        m_xDelta(0), m_yDelta(0), m_xDelta2(0), m_yDelta2(0),
+        m_config(&config), m_inputFilter(NULL), m_activeSaver(NULL),
+        m_switchDir(kNoDirection), m_switchScreen(NULL),
+        m_switchWaitDelay(0.0), m_switchWaitTimer(NULL),
+        m_switchTwoTapDelay(0.0), m_switchTwoTapEngaged(false),
+        m_switchTwoTapArmed(false), m_switchTwoTapZone(3),
+        m_switchNeedsShift(false), m_switchNeedsControl(false),
+        m_switchNeedsAlt(false), m_relativeMoves(false),
+        m_keyboardBroadcasting(false), m_lockedToScreen(false),
+        m_screen(NULL), m_events(NULL), m_expectedFileSize(0),
+        m_sendFileThread(NULL), m_writeToDropDirThread(NULL),
+        m_ignoreFileTransfer(false), m_enableClipboard(true),
+        m_sendDragInfoThread(NULL), m_waitDragInfoThread(true),
+        m_clientListener(NULL), m_hostControl(NULL),
+        m_inputInjector(NULL), m_activeLayoutScreen(NULL),
+        m_activeLayoutScreenValid(false) { }
     void setActive(BaseClientProxy* active) {    m_active = active; }
+    void mouseMoveSecondaryForTest(SInt32 dx, SInt32 dy) { onMouseMoveSecondary(dx, dy); }
+    Config::Delta recordAppliedConfigForTest(const Config& config)
+    {
+        return recordAppliedConfig(config);
+    }
+    void addLockToScreenHotkeyForTest()
+    {
+        m_inputFilter = m_config->getInputFilter();
+        addLockToScreenHotkey();
+    }
 #endif
 
     //! @name manipulators
@@ -155,6 +183,30 @@ public:
     //! Store ClientListener pointer
     void                setListener(ClientListener* p) { m_clientListener = p; }
 
+    //! Store HostControlServer pointer
+    /*!
+    Screen switches, client connects and disconnects, clipboard grabs and
+    configuration changes are published to \p p.  May be NULL.
+    */
+    void                setHostControl(HostControlServer* p) { m_hostControl = p; }
+
+    //! Store the primary screen's input injector
+    /*!
+    Input posted to \c /input on the host control API is given to \p p,
+    which is the primary screen when it's virtual.  May be NULL.
+    */
+    void                setInputInjector(IInputInjector* p) { m_inputInjector = p; }
+
+    //! Handle a host control API request
+    /*!
+    Answers a request received by the HostControlServer: query or switch
+    the active screen, get or set the configuration, subscribe to
+    events at \c /events or inject input at \c /input.
+    */
+    void                handleHostControlRequest(
+                            const HostControlServer::Request& request,
+                            HostControlServer::Response& response);
+
     //@}
     //! @name accessors
     //@{
@@ -295,6 +347,38 @@ private:
     // process options from configuration
     void                processOptions();
 
+    // compare \c config with the last applied configuration and make
+    // it the last applied one
+    Config::Delta        recordAppliedConfig(const Config& config);
+
+    // add the built-in ScrollLock hotkey unless it's already there or
+    // the configuration locks to the screen some other way
+    void                addLockToScreenHotkey();
+
+    // cached geometry of a connected screen.  see getGeometry().
+    class ScreenGeometry {
+    public:
+        ScreenGeometry();
+
+    public:
+        SInt32            m_x, m_y, m_w, m_h;
+        SInt32            m_jumpZone;
+        std::string m_name;
+        const etherwaver::layout::Screen*
+                        m_layoutScreen;
+    };
+
+    // return the shape, jump zone, canonical name and first layout
+    // screen of \p client.  the result is computed on first use and
+    // kept until invalidateGeometry() so the motion handlers don't have
+    // to query the proxy and the layout on every event.
+    const ScreenGeometry&
+                        getGeometry(const BaseClientProxy* client) const;
+
+    // discard cached geometry.  must be called whenever a client's
+    // shape, the configuration or the object layout changes.
+    void                invalidateGeometry();
+
     void                reloadScreenLayout();
     std::string         getLayoutPath() const;
     bool                usingObjectLayout() const;
@@ -321,6 +405,7 @@ private:
     void                handleScreensaverDeactivatedEvent(const Event&, void*);
     void                handleSwitchWaitTimeout(const Event&, void*);
     void                handleClientDisconnected(const Event&, void*);
+    void                handleClientLockStateChanged(const Event&, void*);
     void                handleClientCloseTimeout(const Event&, void*);
     void                handleSwitchToScreenEvent(const Event&, void*);
     void                handleToggleScreenEvent(const Event&, void*);
@@ -372,6 +457,13 @@ private:
     // force the cursor off of \p client
     void                forceLeaveClient(BaseClientProxy* client);
 
+    // publish an event to host control API subscribers
+    void                publishHostControlEvent(const char* name,
+                            const std::string& data);
+
+    // current screen as reported by the host control API
+    std::string         getHostControlState() const;
+
     // thread function for sending file
     void send_file_thread(const char* filename);
 
@@ -435,6 +527,10 @@ private:
     // input filter (from m_config);
     InputFilter*        m_inputFilter;
 
+    // configuration as of the last setConfig(), used to apply only
+    // what changed.  its input filter is never enabled.
+    Config                m_appliedConfig;
+
     // clipboard cache
     ClipboardInfo        m_clipboards[kClipboardEnd];
 
@@ -495,16 +591,21 @@ private:
     bool                m_waitDragInfoThread;
 
     ClientListener*        m_clientListener;
+    HostControlServer*    m_hostControl;
+    IInputInjector*        m_inputInjector;
     ServerArgs            m_args;
     etherwaver::layout::ScreenManager m_screenLayout;
     std::string         m_activeLayoutScreenId;
 
-    ArchSocket          m_httpListener;
-    std::thread         m_httpThread;
-    bool                m_running;
-    mutable std::mutex  m_mutex;
+    // geometry cache (see getGeometry()).  the active layout screen is
+    // resolved from m_activeLayoutScreenId lazily and must be marked
+    // invalid whenever that id or m_active changes.
+    typedef std::map<const BaseClientProxy*, ScreenGeometry> GeometryCache;
+    mutable GeometryCache m_geometry;
+    mutable const etherwaver::layout::Screen* m_activeLayoutScreen;
+    mutable bool        m_activeLayoutScreenValid;
+
+    // state reported by the host control API
     std::string         m_currentHost;
     std::string         m_current_ip;
-
-    void                httpLoop();
 };
@@ -0,0 +1,64 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "barrier/Clipboard.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// fills \p clipboard with \p size bytes of text and of HTML
+void
+fillClipboard(Clipboard& clipboard, size_t size)
+{
+    clipboard.open(0);
+    clipboard.empty();
+    clipboard.add(IClipboard::kText, String(size, 'x'));
+    clipboard.add(IClipboard::kHTML, "<p>" + String(size, 'x') + "</p>");
+    clipboard.close();
+}
+
+} // namespace
+
+static void
+BM_Clipboard_marshall(benchmark::State& state)
+{
+    Clipboard clipboard;
+    fillClipboard(clipboard, static_cast<size_t>(state.range(0)));
+    size_t size = 0;
+    for (auto _ : state) {
+        String data = clipboard.marshall();
+        size = data.size();
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_Clipboard_marshall)->Arg(1024)->Arg(1024 * 1024);
+
+static void
+BM_Clipboard_unmarshall(benchmark::State& state)
+{
+    Clipboard source;
+    fillClipboard(source, static_cast<size_t>(state.range(0)));
+    String data = source.marshall();
+
+    Clipboard clipboard;
+    for (auto _ : state) {
+        clipboard.unmarshall(data, 0);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Clipboard_unmarshall)->Arg(1024)->Arg(1024 * 1024);
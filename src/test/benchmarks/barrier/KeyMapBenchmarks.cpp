@@ -0,0 +1,166 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/KeyMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using barrier::KeyMap;
+
+namespace {
+
+const KeyButton s_shiftButton = 50;
+const KeyButton s_capsButton  = 66;
+
+void
+addKey(KeyMap& keyMap, KeyID id, KeyButton button,
+                KeyModifierMask required, KeyModifierMask sensitive)
+{
+    KeyMap::KeyItem item;
+    item.m_id        = id;
+    item.m_group     = 0;
+    item.m_button    = button;
+    item.m_required  = required;
+    item.m_sensitive = sensitive;
+    item.m_generates = 0;
+    item.m_dead      = false;
+    item.m_lock      = false;
+    item.m_client    = 0;
+    KeyMap::initModifierKey(item);
+    keyMap.addKeyEntry(item);
+}
+
+// fills \p keyMap with a US keyboard: letters, digits, the shifted
+// symbols, space and return, and shift and caps lock
+void
+addUSKeyboard(KeyMap& keyMap)
+{
+    static const char s_unshifted[] = "`1234567890-=[]\\;',./";
+    static const char s_shifted[]   = "~!@#$%^&*()_+{}|:\"<>?";
+
+    KeyButton button = 10;
+    for (const char* c = s_unshifted, *s = s_shifted; *c != 0; ++c, ++s) {
+        addKey(keyMap, *c, button, 0, KeyModifierShift);
+        addKey(keyMap, *s, button, KeyModifierShift, KeyModifierShift);
+        ++button;
+    }
+    for (KeyID c = 'a'; c <= 'z'; ++c) {
+        KeyModifierMask sensitive = KeyModifierShift | KeyModifierCapsLock;
+        addKey(keyMap, c, button, 0, sensitive);
+        addKey(keyMap, c - 'a' + 'A', button, KeyModifierShift, sensitive);
+        addKey(keyMap, c - 'a' + 'A', button, KeyModifierCapsLock, sensitive);
+        ++button;
+    }
+    addKey(keyMap, ' ', button++, 0, 0);
+    addKey(keyMap, kKeyReturn, button++, 0, 0);
+    addKey(keyMap, kKeyShift_L, s_shiftButton, 0, 0);
+    addKey(keyMap, kKeyCapsLock, s_capsButton, 0, 0);
+    keyMap.finish();
+}
+
+// fills \p keyMap with \p numKeys KeyIDs from the Unicode range, each
+// in two groups, so it's about as big as a map with several layouts
+void
+addLargeKeyboard(KeyMap& keyMap, KeyID numKeys)
+{
+    for (KeyID i = 0; i < numKeys; ++i) {
+        KeyMap::KeyItem item;
+        item.m_id        = 0x4e00 + i;
+        item.m_button    = static_cast<KeyButton>(8 + (i / 2) % 248);
+        item.m_required  = (i % 2 == 0) ? 0 : KeyModifierShift;
+        item.m_sensitive = KeyModifierShift;
+        item.m_generates = 0;
+        item.m_dead      = false;
+        item.m_lock      = false;
+        item.m_client    = 0;
+        for (SInt32 g = 0; g < 2; ++g) {
+            item.m_group = g;
+            keyMap.addKeyEntry(item);
+        }
+    }
+    addKey(keyMap, kKeyShift_L, s_shiftButton, 0, 0);
+    keyMap.finish();
+}
+
+// some prose, as a paste typed out as keystrokes would be
+std::string
+makeText(size_t length)
+{
+    static const char s_sentence[] =
+        "The quick brown fox jumps over the lazy dog; "
+        "PACK MY BOX WITH FIVE DOZEN LIQUOR JUGS! "
+        "Sphinx of black quartz, judge my vow (1234567890). ";
+    std::string text;
+    while (text.size() < length) {
+        text += s_sentence;
+    }
+    text.resize(length);
+    return text;
+}
+
+} // namespace
+
+// types a long paste, one character at a time
+static void
+BM_KeyMap_mapKeyPaste(benchmark::State& state)
+{
+    KeyMap keyMap;
+    addUSKeyboard(keyMap);
+    std::string text = makeText(static_cast<size_t>(state.range(0)));
+
+    KeyMap::Keystrokes keys;
+    KeyMap::ModifierToKeys activeModifiers;
+    KeyModifierMask currentState = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < text.size(); ++i) {
+            keys.clear();
+            const KeyMap::KeyItem* item =
+                keyMap.mapKey(keys, static_cast<unsigned char>(text[i]), 0,
+                                activeModifiers, currentState, 0, false);
+            benchmark::DoNotOptimize(item);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_KeyMap_mapKeyPaste)->Arg(64 * 1024)->Unit(benchmark::kMillisecond);
+
+// maps every key of a large map once, which is more keys than mapKey()
+// remembers, so each is looked up
+static void
+BM_KeyMap_mapKeyLookup(benchmark::State& state)
+{
+    KeyMap keyMap;
+    KeyID numKeys = static_cast<KeyID>(state.range(0));
+    addLargeKeyboard(keyMap, numKeys);
+
+    KeyMap::Keystrokes keys;
+    KeyMap::ModifierToKeys activeModifiers;
+    KeyModifierMask currentState = 0;
+    for (auto _ : state) {
+        for (KeyID i = 0; i < numKeys; ++i) {
+            keys.clear();
+            const KeyMap::KeyItem* item =
+                keyMap.mapKey(keys, 0x4e00 + i, 1,
+                                activeModifiers, currentState, 0, false);
+            benchmark::DoNotOptimize(item);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numKeys);
+}
+BENCHMARK(BM_KeyMap_mapKeyLookup)->Arg(4096)->Unit(benchmark::kMicrosecond);
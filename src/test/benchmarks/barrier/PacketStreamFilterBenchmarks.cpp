@@ -0,0 +1,74 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "barrier/PacketStreamFilter.h"
+#include "barrier/ProtocolUtil.h"
+#include "barrier/protocol_types.h"
+#include "base/EventQueue.h"
+#include "test/benchmarks/io/BufferStream.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// packets of range(0) bytes framed, delivered by an input ready event
+// and read back through the filter
+static void
+BM_PacketStreamFilter_roundTrip(benchmark::State& state)
+{
+    EventQueue events;
+    BufferStream stream;
+    PacketStreamFilter filter(&events, &stream, false);
+    Event inputReady(events.forIStream().inputReady(),
+                                stream.getEventTarget());
+
+    UInt32 size = static_cast<UInt32>(state.range(0));
+    std::vector<UInt8> packet(size, 'x');
+    std::vector<UInt8> result(size);
+    for (auto _ : state) {
+        filter.write(packet.data(), size);
+        events.dispatchEvent(inputReady);
+        UInt32 n = filter.read(result.data(), size);
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_PacketStreamFilter_roundTrip)->Arg(8)->Arg(4096)->Arg(64 * 1024);
+
+// a burst of motion messages arriving at once and read one by one
+static void
+BM_PacketStreamFilter_mouseMoveBurst(benchmark::State& state)
+{
+    EventQueue events;
+    BufferStream stream;
+    PacketStreamFilter filter(&events, &stream, false);
+    Event inputReady(events.forIStream().inputReady(),
+                                stream.getEventTarget());
+
+    const int numMessages = 256;
+    char message[8];
+    for (auto _ : state) {
+        for (int i = 0; i < numMessages; ++i) {
+            ProtocolUtil::writef(&filter, kMsgDMouseMove, i, i);
+        }
+        events.dispatchEvent(inputReady);
+        while (filter.read(message, sizeof(message)) > 0) {
+            benchmark::DoNotOptimize(message);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numMessages);
+}
+BENCHMARK(BM_PacketStreamFilter_mouseMoveBurst);
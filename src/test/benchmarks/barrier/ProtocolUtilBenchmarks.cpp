@@ -0,0 +1,95 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ProtocolUtil.h"
+#include "barrier/protocol_types.h"
+#include "test/benchmarks/io/BufferStream.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+// the message sent for every motion event on a secondary screen
+static void
+BM_ProtocolUtil_writefMouseMove(benchmark::State& state)
+{
+    BufferStream stream;
+    SInt32 x = 0;
+    for (auto _ : state) {
+        ProtocolUtil::writef(&stream, kMsgDMouseMove, x, 1080 - x);
+        x = (x + 1) % 1920;
+        stream.close();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProtocolUtil_writefMouseMove);
+
+// the same message written and read back, with the message code
+static void
+BM_ProtocolUtil_mouseMoveRoundTrip(benchmark::State& state)
+{
+    BufferStream stream;
+    char code[4];
+    SInt16 x, y;
+    for (auto _ : state) {
+        ProtocolUtil::writef(&stream, kMsgDMouseMove, 960, 540);
+        stream.read(code, sizeof(code));
+        bool ok = ProtocolUtil::readf(&stream, kMsgDMouseMove + 4, &x, &y);
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProtocolUtil_mouseMoveRoundTrip);
+
+// a key press written and read back
+static void
+BM_ProtocolUtil_keyDownRoundTrip(benchmark::State& state)
+{
+    BufferStream stream;
+    char code[4];
+    UInt16 id, mask, button;
+    for (auto _ : state) {
+        ProtocolUtil::writef(&stream, kMsgDKeyDown, 'a', 0, 38);
+        stream.read(code, sizeof(code));
+        bool ok = ProtocolUtil::readf(&stream, kMsgDKeyDown + 4,
+                                &id, &mask, &button);
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProtocolUtil_keyDownRoundTrip);
+
+// a clipboard chunk of range(0) bytes written and read back
+static void
+BM_ProtocolUtil_clipboardRoundTrip(benchmark::State& state)
+{
+    BufferStream stream;
+    std::string data(static_cast<size_t>(state.range(0)), 'x');
+    std::string result;
+    char code[4];
+    UInt8 id, mark;
+    UInt32 seqNum;
+    for (auto _ : state) {
+        ProtocolUtil::writef(&stream, kMsgDClipboard, 0, 1, 2, &data);
+        stream.read(code, sizeof(code));
+        bool ok = ProtocolUtil::readf(&stream, kMsgDClipboard + 4,
+                                &id, &seqNum, &mark, &result);
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ProtocolUtil_clipboardRoundTrip)->Arg(1024)->Arg(32 * 1024);
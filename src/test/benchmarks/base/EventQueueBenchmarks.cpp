@@ -0,0 +1,80 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "base/EventQueue.h"
+#include "base/FunctionEventJob.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+void
+countEvent(const Event&, void* count)
+{
+    ++*static_cast<int*>(count);
+}
+
+} // namespace
+
+// an event added, taken off the queue and sent to its handler, which
+// is what every input event on either end goes through
+static void
+BM_EventQueue_addGetDispatch(benchmark::State& state)
+{
+    EventQueue events;
+    Event::Type type = Event::kUnknown;
+    events.registerTypeOnce(type, "BM_EventQueue");
+    int target = 0;
+    int count  = 0;
+    events.adoptHandler(type, &target, new FunctionEventJob(&countEvent, &count));
+
+    Event event;
+    for (auto _ : state) {
+        events.addEvent(Event(type, &target));
+        events.getEvent(event, 0.0);
+        events.dispatchEvent(event);
+    }
+    benchmark::DoNotOptimize(count);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EventQueue_addGetDispatch);
+
+// range(0) events queued before any is handled, as in a burst of input
+static void
+BM_EventQueue_burst(benchmark::State& state)
+{
+    EventQueue events;
+    Event::Type type = Event::kUnknown;
+    events.registerTypeOnce(type, "BM_EventQueue");
+    int target = 0;
+    int count  = 0;
+    events.adoptHandler(type, &target, new FunctionEventJob(&countEvent, &count));
+
+    int numEvents = static_cast<int>(state.range(0));
+    Event event;
+    for (auto _ : state) {
+        for (int i = 0; i < numEvents; ++i) {
+            events.addEvent(Event(type, &target));
+        }
+        for (int i = 0; i < numEvents; ++i) {
+            events.getEvent(event, 0.0);
+            events.dispatchEvent(event);
+        }
+    }
+    benchmark::DoNotOptimize(count);
+    state.SetItemsProcessed(state.iterations() * numEvents);
+}
+BENCHMARK(BM_EventQueue_burst)->Arg(256);
@@ -0,0 +1,80 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "base/Unicode.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace {
+
+// up to \p length bytes of UTF-8 mixing ASCII with two and three byte
+// characters, as clipboard text in most languages has
+std::string
+makeUTF8(size_t length)
+{
+    static const char s_sample[] =
+        "plain ascii text, "
+        "\xc3\xa9\xc3\xa8\xc3\xbc\xc3\x9f "
+        "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+        "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e ";
+    // whole samples only so no character is cut in half
+    std::string text;
+    while (text.size() + sizeof(s_sample) - 1 <= length) {
+        text += s_sample;
+    }
+    return text;
+}
+
+} // namespace
+
+static void
+BM_Unicode_UTF8ToUTF16(benchmark::State& state)
+{
+    std::string text = makeUTF8(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string result = Unicode::UTF8ToUTF16(text);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Unicode_UTF8ToUTF16)->Arg(64 * 1024);
+
+static void
+BM_Unicode_UTF16ToUTF8(benchmark::State& state)
+{
+    std::string text = Unicode::UTF8ToUTF16(
+                            makeUTF8(static_cast<size_t>(state.range(0))));
+    for (auto _ : state) {
+        std::string result = Unicode::UTF16ToUTF8(text);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Unicode_UTF16ToUTF8)->Arg(64 * 1024);
+
+static void
+BM_Unicode_UTF8ToText(benchmark::State& state)
+{
+    std::string text = makeUTF8(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string result = Unicode::UTF8ToText(text);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Unicode_UTF8ToText)->Arg(64 * 1024);
@@ -0,0 +1,205 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/DirectInputDispatcher.h"
+#include "client/IInputBackend.h"
+#include "base/EventQueue.h"
+#include "base/FunctionEventJob.h"
+#include "io/StreamBuffer.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// notes how long each motion took to arrive
+class TimingBackend : public IInputBackend {
+public:
+    TimingBackend() : m_done(false) {}
+
+    void enter(SInt32, SInt32) override {}
+    void leave() override {}
+    void keyDown(KeyID, KeyModifierMask, KeyButton) override {}
+    void keyRepeat(KeyID, KeyModifierMask, SInt32, KeyButton) override {}
+    void keyUp(KeyID, KeyModifierMask, KeyButton) override {}
+    void mouseDown(ButtonID) override {}
+    void mouseUp(ButtonID) override {}
+    void mouseMove(SInt32, SInt32) override
+    {
+        m_latencies.push_back(std::chrono::duration<double, std::micro>(
+            Clock::now() - m_sent).count());
+    }
+    void mouseRelativeMove(SInt32, SInt32) override {}
+    void mouseWheel(SInt32, SInt32) override {}
+    void flush() override { m_done.store(true, std::memory_order_release); }
+    bool isThreadSafe() const override { return true; }
+
+    Clock::time_point m_sent;
+    std::atomic<bool> m_done;
+    std::vector<double> m_latencies;
+};
+
+// what TCPSocket and ServerProxy do for input without the dispatcher:
+// the socket thread buffers the data and posts input ready, then the
+// event loop reads the packets and injects them
+class QueuedPath {
+public:
+    QueuedPath(IEventQueue* events, IInputBackend* backend) :
+        m_events(events),
+        m_backend(backend)
+    {
+        m_events->adoptHandler(m_events->forIStream().inputReady(), this,
+                               new FunctionEventJob(&QueuedPath::handleData, this));
+    }
+
+    ~QueuedPath()
+    {
+        m_events->removeHandler(m_events->forIStream().inputReady(), this);
+    }
+
+    void receive(const UInt8* data, UInt32 n)
+    {
+        Lock lock(&m_mutex);
+        bool wasEmpty = (m_buffer.getSize() == 0);
+        m_buffer.write(data, n);
+        if (wasEmpty) {
+            m_events->addEvent(Event(m_events->forIStream().inputReady(), this));
+        }
+    }
+
+private:
+    static void handleData(const Event&, void* self)
+    {
+        static_cast<QueuedPath*>(self)->handleData();
+    }
+
+    void handleData()
+    {
+        std::vector<UInt8> data;
+        {
+            Lock lock(&m_mutex);
+            UInt32 size = m_buffer.getSize();
+            const UInt8* bytes = static_cast<const UInt8*>(m_buffer.peek(size));
+            data.assign(bytes, bytes + size);
+            m_buffer.pop(size);
+        }
+
+        // every packet is a 12 byte motion message
+        for (size_t i = 0; i + 12 <= data.size(); i += 12) {
+            m_backend->mouseMove(static_cast<SInt16>((data[i + 8] << 8) | data[i + 9]),
+                                 static_cast<SInt16>((data[i + 10] << 8) | data[i + 11]));
+        }
+        m_backend->flush();
+    }
+
+private:
+    IEventQueue* m_events;
+    IInputBackend* m_backend;
+    Mutex m_mutex;
+    StreamBuffer m_buffer;
+};
+
+const UInt8 kMouseMovePacket[] = {
+    0, 0, 0, 8, 'D', 'M', 'M', 'V', 0x03, 0xc0, 0x02, 0x1c
+};
+
+// sends one motion at a time and waits for it to be injected, the way
+// a user moving the mouse slowly sees each one
+template <typename Send>
+void
+measureLatency(benchmark::State& state, TimingBackend& backend, Send send)
+{
+    for (auto _ : state) {
+        backend.m_done.store(false, std::memory_order_relaxed);
+        backend.m_sent = Clock::now();
+        send(kMouseMovePacket, static_cast<UInt32>(sizeof(kMouseMovePacket)));
+        while (!backend.m_done.load(std::memory_order_acquire)) {
+            // let the event loop run on machines with one core
+            std::this_thread::yield();
+        }
+    }
+
+    // report the spread of the latencies rather than just the mean
+    std::vector<double>& latencies = backend.m_latencies;
+    std::sort(latencies.begin(), latencies.end());
+    if (!latencies.empty()) {
+        const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+        const char* names[] = { "p50_us", "p90_us", "p99_us", "p999_us" };
+        for (size_t i = 0; i < 4; ++i) {
+            size_t index = static_cast<size_t>(percentiles[i] * (latencies.size() - 1));
+            state.counters[names[i]] = latencies[index];
+        }
+        state.counters["max_us"] = latencies.back();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+// a motion read on the socket thread and injected from the event loop
+static void
+BM_DirectInput_queuedLatency(benchmark::State& state)
+{
+    EventQueue events;
+    TimingBackend backend;
+    QueuedPath path(&events, &backend);
+
+    // a first motion, held until the loop starts, tells us it's running
+    path.receive(kMouseMovePacket, static_cast<UInt32>(sizeof(kMouseMovePacket)));
+    Thread loop([&events] { events.loop(); });
+    while (!backend.m_done.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    backend.m_latencies.clear();
+
+    measureLatency(state, backend, [&path](const UInt8* data, UInt32 n) {
+        path.receive(data, n);
+    });
+
+    events.addEvent(Event(Event::kQuit));
+    loop.wait();
+}
+BENCHMARK(BM_DirectInput_queuedLatency)->UseRealTime();
+
+// the same motion injected on the socket thread by the dispatcher
+static void
+BM_DirectInput_directLatency(benchmark::State& state)
+{
+    TimingBackend backend;
+    KeyModifierID table[kKeyModifierIDLast];
+    for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id) {
+        table[id] = id;
+    }
+    DirectInputDispatcher dispatcher(&backend);
+    dispatcher.setModifierTranslation(table);
+    StreamBuffer input;
+
+    measureLatency(state, backend, [&dispatcher, &input](const UInt8* data, UInt32 n) {
+        dispatcher.onSocketInput(data, n, input);
+    });
+}
+BENCHMARK(BM_DirectInput_directLatency)->UseRealTime();
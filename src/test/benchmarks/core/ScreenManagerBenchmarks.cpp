@@ -0,0 +1,85 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "core/layout/ScreenManager.h"
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <vector>
+
+using etherwaver::layout::Screen;
+using etherwaver::layout::ScreenManager;
+
+namespace {
+
+const int s_width   = 1920;
+const int s_height  = 1080;
+const int s_columns = 4;
+
+// lays out \p numScreens screens in rows of s_columns, two per host
+void
+setGrid(ScreenManager& manager, int numScreens)
+{
+    std::vector<Screen> screens;
+    for (int i = 0; i < numScreens; ++i) {
+        std::ostringstream id, host;
+        id << "screen" << i;
+        host << "host" << i / 2;
+        screens.push_back(Screen(id.str(), host.str(), id.str(),
+                                (i % s_columns) * s_width,
+                                (i / s_columns) * s_height,
+                                s_width, s_height));
+    }
+    manager.setScreens(screens);
+}
+
+} // namespace
+
+// points spread over every screen of the layout
+static void
+BM_ScreenManager_findScreenAt(benchmark::State& state)
+{
+    ScreenManager manager;
+    int numScreens = static_cast<int>(state.range(0));
+    setGrid(manager, numScreens);
+
+    int i = 0;
+    for (auto _ : state) {
+        int x = (i % s_columns) * s_width + s_width / 2;
+        int y = (i / s_columns) * s_height + s_height / 2;
+        const Screen* screen = manager.findScreenAt(x, y);
+        benchmark::DoNotOptimize(screen);
+        i = (i + 1) % numScreens;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScreenManager_findScreenAt)->Arg(4)->Arg(16)->Arg(64);
+
+// a point outside the layout, which checks every screen
+static void
+BM_ScreenManager_findScreenAtMiss(benchmark::State& state)
+{
+    ScreenManager manager;
+    setGrid(manager, static_cast<int>(state.range(0)));
+
+    for (auto _ : state) {
+        const Screen* screen = manager.findScreenAt(-1, -1);
+        benchmark::DoNotOptimize(screen);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScreenManager_findScreenAtMiss)->Arg(4)->Arg(64);
@@ -0,0 +1,60 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "io/IStream.h"
+#include "io/StreamBuffer.h"
+
+#include <cstring>
+
+// a stream that reads back whatever was written to it, standing in for
+// a socket so the benchmarks measure the code above it
+class BufferStream : public barrier::IStream {
+public:
+    BufferStream() { }
+
+    // IStream overrides
+    virtual void        close() { m_buffer.pop(m_buffer.getSize()); }
+    virtual UInt32        read(void* buffer, UInt32 n)
+    {
+        if (n > m_buffer.getSize()) {
+            n = m_buffer.getSize();
+        }
+        if (buffer != NULL && n > 0) {
+            std::memcpy(buffer, m_buffer.peek(n), n);
+        }
+        m_buffer.pop(n);
+        return n;
+    }
+    virtual void        write(const void* buffer, UInt32 n)
+    {
+        m_buffer.write(buffer, n);
+    }
+    virtual void        flush() { }
+    virtual void        shutdownInput() { }
+    virtual void        shutdownOutput() { }
+    virtual void*        getEventTarget() const
+    {
+        return const_cast<BufferStream*>(this);
+    }
+    virtual bool        isReady() const { return m_buffer.getSize() > 0; }
+    virtual UInt32        getSize() const { return m_buffer.getSize(); }
+
+private:
+    StreamBuffer        m_buffer;
+};
@@ -0,0 +1,67 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/StreamBuffer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// messages of range(0) bytes written then consumed one at a time, the
+// way a connection's input buffer is used
+static void
+BM_StreamBuffer_writePeekPop(benchmark::State& state)
+{
+    StreamBuffer buffer;
+    UInt32 size = static_cast<UInt32>(state.range(0));
+    std::vector<char> data(size, 'x');
+    for (auto _ : state) {
+        buffer.write(data.data(), size);
+        const void* bytes = buffer.peek(size);
+        benchmark::DoNotOptimize(bytes);
+        buffer.pop(size);
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_StreamBuffer_writePeekPop)->Arg(8)->Arg(4096)->Arg(64 * 1024);
+
+// a backlog of small messages consumed in pieces that don't line up
+// with the writes
+static void
+BM_StreamBuffer_drainBacklog(benchmark::State& state)
+{
+    StreamBuffer buffer;
+    const UInt32 messageSize = 12;
+    const UInt32 readSize    = 20;
+    const int numMessages    = 1000;
+    char data[messageSize] = { 0 };
+    for (auto _ : state) {
+        for (int i = 0; i < numMessages; ++i) {
+            buffer.write(data, messageSize);
+        }
+        while (buffer.getSize() > 0) {
+            UInt32 n = readSize;
+            if (n > buffer.getSize()) {
+                n = buffer.getSize();
+            }
+            const void* bytes = buffer.peek(n);
+            benchmark::DoNotOptimize(bytes);
+            buffer.pop(n);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * numMessages * messageSize);
+}
+BENCHMARK(BM_StreamBuffer_drainBacklog);
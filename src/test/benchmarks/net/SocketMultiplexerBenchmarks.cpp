@@ -0,0 +1,154 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/ISocketInputHook.h"
+#include "net/NetworkAddress.h"
+#include "net/SocketMultiplexer.h"
+#include "net/SocketMultiplexerShards.h"
+#include "net/TCPListenSocket.h"
+#include "net/TCPSocket.h"
+#include "net/XSocket.h"
+#include "arch/Arch.h"
+#include "base/EventQueue.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kNumClients = 500;
+const int kBasePort   = 34500;
+
+// counts what the server sockets read and drops it, so the benchmark
+// measures the multiplexers rather than the event queue
+class CountingHook : public ISocketInputHook {
+public:
+    CountingHook() : m_bytes(0) {}
+
+    void onSocketInput(const UInt8*, UInt32 n, StreamBuffer&) override
+    {
+        m_bytes.fetch_add(n, std::memory_order_release);
+    }
+
+    std::atomic<size_t> m_bytes;
+};
+
+// a listen socket that can wait for a connection to be ready to accept
+class WaitingListenSocket : public TCPListenSocket {
+public:
+    WaitingListenSocket(IEventQueue* events, SocketMultiplexer* multiplexer) :
+        TCPListenSocket(events, multiplexer, IArchNetwork::kINET) {}
+
+    void waitForClient()
+    {
+        IArchNetwork::PollEntry entry = { m_socket, IArchNetwork::kPOLLIN, 0 };
+        ARCH->pollSocket(&entry, 1, 5.0);
+    }
+};
+
+// kNumClients loopback clients accepted onto numShards shards
+class ShardedServer {
+public:
+    ShardedServer(size_t numShards) :
+        m_shards(&m_multiplexer, numShards,
+                 SocketMultiplexerShards::kRoundRobin),
+        m_listen(&m_events, &m_multiplexer)
+    {
+        NetworkAddress address = bind();
+        for (int i = 0; i < kNumClients; ++i) {
+            ArchSocket client = ARCH->newSocket(IArchNetwork::kINET,
+                                                IArchNetwork::kSTREAM);
+            ARCH->connectSocket(client, address.getAddress());
+            m_clients.push_back(client);
+
+            IDataSocket* socket = NULL;
+            while (socket == NULL) {
+                m_listen.waitForClient();
+                socket = m_listen.accept(&m_shards);
+            }
+            m_servers.emplace_back(socket);
+            static_cast<TCPSocket*>(socket)->setInputHook(&m_hook);
+        }
+    }
+
+    ~ShardedServer()
+    {
+        m_servers.clear();
+        for (ArchSocket client : m_clients) {
+            ARCH->closeSocket(client);
+        }
+    }
+
+    // send a message from every client and wait for all of them
+    void round()
+    {
+        static const UInt8 kMessage[12] = { 'D', 'M', 'M', 'V', 0, 0, 0, 0 };
+        for (ArchSocket client : m_clients) {
+            ARCH->writeSocket(client, kMessage, sizeof(kMessage));
+        }
+        m_expected += sizeof(kMessage) * m_clients.size();
+        while (m_hook.m_bytes.load(std::memory_order_acquire) < m_expected) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    NetworkAddress bind()
+    {
+        for (int port = kBasePort; ; ++port) {
+            NetworkAddress address("127.0.0.1", port);
+            address.resolve();
+            try {
+                m_listen.bind(address);
+                return address;
+            }
+            catch (XSocketAddressInUse&) {
+                // try the next port
+            }
+        }
+    }
+
+private:
+    EventQueue            m_events;
+    SocketMultiplexer    m_multiplexer;
+    SocketMultiplexerShards m_shards;
+    WaitingListenSocket    m_listen;
+    CountingHook        m_hook;
+    std::vector<ArchSocket> m_clients;
+    std::vector<std::unique_ptr<IDataSocket>> m_servers;
+    size_t                m_expected = 0;
+};
+
+} // namespace
+
+// a round of one message from each of 500 clients, serviced by range(0)
+// socket multiplexer shards
+static void
+BM_SocketMultiplexer_shardedRound(benchmark::State& state)
+{
+    ShardedServer server(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        server.round();
+    }
+    state.SetItemsProcessed(state.iterations() * kNumClients);
+}
+BENCHMARK(BM_SocketMultiplexer_shardedRound)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
@@ -0,0 +1,90 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if WINAPI_XWINDOWS
+
+#include "platform/XWindowsKeyState.h"
+#include "base/EventQueue.h"
+
+#if HAVE_XKB_EXTENSION
+
+#include "test/mock/platform/NullXWindowsImpl.h"
+
+#include <benchmark/benchmark.h>
+
+// a layout not seen before, which builds the whole key map
+static void
+BM_XWindowsKeyState_newLayout(benchmark::State& state)
+{
+    EventQueue events;
+    NullXWindowsImpl impl(createKeyboard());
+    XWindowsKeyState keyState(&impl, NULL, true, &events);
+
+    // more layouts than the key state keeps
+    int layout = 0;
+    for (auto _ : state) {
+        setLayout(impl.XkbGetMap(NULL, 0, 0), layout++ % 64);
+        keyState.updateKeyMap();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_XWindowsKeyState_newLayout)->Unit(benchmark::kMicrosecond);
+
+// switching between two layouts
+static void
+BM_XWindowsKeyState_switchLayout(benchmark::State& state)
+{
+    EventQueue events;
+    NullXWindowsImpl impl(createKeyboard());
+    XWindowsKeyState keyState(&impl, NULL, true, &events);
+
+    int layout = 0;
+    for (auto _ : state) {
+        setLayout(impl.XkbGetMap(NULL, 0, 0), layout++ % 2);
+        keyState.updateKeyMap();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_XWindowsKeyState_switchLayout)->Unit(benchmark::kMicrosecond);
+
+// remapping one key, as xmodmap does
+static void
+BM_XWindowsKeyState_remapKey(benchmark::State& state)
+{
+    EventQueue events;
+    XkbDescPtr xkb = createKeyboard();
+    NullXWindowsImpl impl(xkb);
+    XWindowsKeyState keyState(&impl, NULL, true, &events);
+    setLayout(xkb, 0);
+    keyState.updateKeyMap();
+
+    const KeyCode keycode = 38;
+    int letter = 0;
+    for (auto _ : state) {
+        KeySym* syms = XkbKeySymsPtr(xkb, keycode);
+        syms[0] = XK_a + letter % 26;
+        syms[1] = XK_A + letter % 26;
+        ++letter;
+        keyState.updateKeyMap(keycode, 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_XWindowsKeyState_remapKey)->Unit(benchmark::kMicrosecond);
+
+#endif // HAVE_XKB_EXTENSION
+
+#endif // WINAPI_XWINDOWS
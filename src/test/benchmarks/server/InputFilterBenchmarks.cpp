@@ -0,0 +1,90 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "server/InputFilter.h"
+#include "base/EventQueue.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+
+namespace {
+
+// fill \p filter with \p count button rules, each with a distinct
+// button and modifier combination, and no actions.
+void
+addButtonRules(IEventQueue* events, InputFilter& filter, int count)
+{
+    static const KeyModifierMask s_masks[] = {
+        0, KeyModifierShift, KeyModifierControl, KeyModifierAlt,
+        KeyModifierShift | KeyModifierControl, KeyModifierShift | KeyModifierAlt,
+        KeyModifierControl | KeyModifierAlt, KeyModifierSuper
+    };
+    static const int s_numMasks = sizeof(s_masks) / sizeof(s_masks[0]);
+
+    for (int i = 0; i < count; ++i) {
+        ButtonID button = static_cast<ButtonID>(1 + i / s_numMasks);
+        InputFilter::Rule rule(new InputFilter::MouseButtonCondition(
+            events, button, s_masks[i % s_numMasks]));
+        filter.addFilterRule(rule);
+    }
+}
+
+} // namespace
+
+// a button event that matches the last of 1000 rules
+static void
+BM_InputFilter_buttonLastRule(benchmark::State& state)
+{
+    EventQueue events;
+    InputFilter filter(&events);
+    addButtonRules(&events, filter, static_cast<int>(state.range(0)));
+
+    int last = static_cast<int>(state.range(0)) - 1;
+    IPlatformScreen::ButtonInfo* info = IPlatformScreen::ButtonInfo::alloc(
+        static_cast<ButtonID>(1 + last / 8), KeyModifierSuper);
+    Event event(events.forIPrimaryScreen().buttonDown(), NULL, info);
+
+    for (auto _ : state) {
+        filter.handleEventForTest(event);
+    }
+    state.SetItemsProcessed(state.iterations());
+    free(info);
+}
+BENCHMARK(BM_InputFilter_buttonLastRule)->Arg(1000);
+
+// a key event, which no button rule can match
+static void
+BM_InputFilter_keyNoMatch(benchmark::State& state)
+{
+    EventQueue events;
+    InputFilter filter(&events);
+    addButtonRules(&events, filter, static_cast<int>(state.range(0)));
+
+    IPlatformScreen::KeyInfo* info = IPlatformScreen::KeyInfo::alloc(
+        'a', 0, 38, 1);
+    Event event(events.forIKeyState().keyDown(), NULL, info);
+
+    for (auto _ : state) {
+        filter.handleEventForTest(event);
+    }
+    state.SetItemsProcessed(state.iterations());
+    free(info);
+}
+BENCHMARK(BM_InputFilter_keyNoMatch)->Arg(1000);
@@ -0,0 +1,101 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "server/Server.h"
+#include "server/Config.h"
+#include "server/PrimaryClient.h"
+#include "server/BaseClientProxy.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// secondary screen that does nothing but report a fixed shape
+class NullClientProxy : public BaseClientProxy {
+public:
+    NullClientProxy(const std::string& name) : BaseClientProxy(name) { }
+
+    // IScreen
+    virtual void*       getEventTarget() const { return const_cast<NullClientProxy*>(this); }
+    virtual bool        getClipboard(ClipboardID, IClipboard*) const { return false; }
+    virtual void        getShape(SInt32& x, SInt32& y,
+                            SInt32& width, SInt32& height) const
+    {
+        x = 0;
+        y = 0;
+        width = 1920;
+        height = 1080;
+    }
+    virtual void        getScreens(std::vector<ClientScreenInfo>&) const { }
+    virtual void        getCursorPos(SInt32& x, SInt32& y) const { x = y = 0; }
+
+    // IClient overrides
+    virtual void        enter(SInt32, SInt32, UInt32, KeyModifierMask, bool) { }
+    virtual bool        leave() { return true; }
+    virtual void        setClipboard(ClipboardID, const IClipboard*) { }
+    virtual void        grabClipboard(ClipboardID) { }
+    virtual void        setClipboardDirty(ClipboardID, bool) { }
+    virtual void        keyDown(KeyID, KeyModifierMask, KeyButton) { }
+    virtual void        keyRepeat(KeyID, KeyModifierMask, SInt32, KeyButton) { }
+    virtual void        keyUp(KeyID, KeyModifierMask, KeyButton) { }
+    virtual void        mouseDown(ButtonID) { }
+    virtual void        mouseUp(ButtonID) { }
+    virtual void        mouseMove(SInt32 x, SInt32 y)
+    {
+        benchmark::DoNotOptimize(x);
+        benchmark::DoNotOptimize(y);
+    }
+    virtual void        mouseRelativeMove(SInt32, SInt32) { }
+    virtual void        mouseWheel(SInt32, SInt32) { }
+    virtual void        screensaver(bool) { }
+    virtual void        resetOptions() { }
+    virtual void        setOptions(const OptionsList&) { }
+    virtual void        sendDragInfo(UInt32, const char*, size_t) { }
+    virtual void        fileChunkSending(UInt8, char*, size_t) { }
+    virtual barrier::IStream*
+                        getStream() const { return NULL; }
+};
+
+} // namespace
+
+// motion on a secondary screen that stays away from the edges, i.e. the
+// common case of the cursor moving around on a client.
+static void
+BM_Server_onMouseMoveSecondary(benchmark::State& state)
+{
+    Config config(NULL);
+    config.addScreen("server");
+    config.addScreen("client");
+
+    PrimaryClient primary;
+    NullClientProxy client("client");
+    Server server(config, &primary);
+    server.setActive(&client);
+
+    // move into the middle of the screen first
+    server.mouseMoveSecondaryForTest(960, 540);
+
+    SInt32 dx = 1;
+    for (auto _ : state) {
+        server.mouseMoveSecondaryForTest(dx, -dx);
+        dx = -dx;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Server_onMouseMoveSecondary);
@@ -0,0 +1,154 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "platform/XWindowsImpl.h"
+
+#include <X11/XKBlib.h>
+#define XK_LATIN1
+#define XK_MISCELLANY
+#include <X11/keysymdef.h>
+
+#include <cstring>
+
+// an XKB keyboard built in memory for testing XWindowsKeyState without
+// an X server.  each XWindowsKeyState frees its keyboard, so each needs
+// one of its own.
+
+const int s_firstKey  = 9;
+const int s_lastKey   = 135;
+const int s_numGroups = 2;
+
+// the modifier keys, which are the same in every layout
+struct ModifierKey {
+    KeyCode m_keycode;
+    KeySym m_keysym;
+    unsigned char m_mask;
+    unsigned char m_action;
+};
+const ModifierKey s_modifiers[] = {
+    { 37, XK_Control_L, ControlMask, XkbSA_SetMods },
+    { 50, XK_Shift_L, ShiftMask, XkbSA_SetMods },
+    { 62, XK_Shift_R, ShiftMask, XkbSA_SetMods },
+    { 64, XK_Alt_L, Mod1Mask, XkbSA_SetMods },
+    { 66, XK_Caps_Lock, LockMask, XkbSA_LockMods },
+    { 133, XK_Super_L, Mod4Mask, XkbSA_SetMods }
+};
+const int s_numModifiers = sizeof(s_modifiers) / sizeof(s_modifiers[0]);
+
+inline const ModifierKey*
+findModifier(int keycode)
+{
+    for (int i = 0; i < s_numModifiers; ++i) {
+        if (s_modifiers[i].m_keycode == keycode) {
+            return s_modifiers + i;
+        }
+    }
+    return NULL;
+}
+
+// builds a keyboard with two groups of letters in memory, the way
+// XkbGetMap() would return it
+inline XkbDescPtr
+createKeyboard()
+{
+    XkbDescPtr xkb = XkbAllocKeyboard();
+    xkb->min_key_code = s_firstKey;
+    xkb->max_key_code = s_lastKey;
+    XkbAllocClientMap(xkb, XkbKeyTypesMask | XkbKeySymsMask |
+                        XkbModifierMapMask, XkbNumRequiredTypes);
+    XkbAllocServerMap(xkb, XkbKeyActionsMask | XkbKeyBehaviorsMask, 0);
+    XkbInitCanonicalKeyTypes(xkb, XkbKeyTypesMask, XkbNoModifier);
+
+    for (int i = s_firstKey; i <= s_lastKey; ++i) {
+        KeyCode keycode = static_cast<KeyCode>(i);
+        const ModifierKey* modifier = findModifier(i);
+        int width = (modifier != NULL) ? 1 : 2;
+        XkbResizeKeySyms(xkb, keycode, s_numGroups * width);
+
+        XkbSymMapRec& symMap = xkb->map->key_sym_map[keycode];
+        for (int g = 0; g < s_numGroups; ++g) {
+            symMap.kt_index[g] = (modifier != NULL) ?
+                                    XkbOneLevelIndex : XkbAlphabeticIndex;
+        }
+        symMap.group_info = XkbSetNumGroups(0, s_numGroups);
+        symMap.width      = static_cast<unsigned char>(width);
+
+        if (modifier != NULL) {
+            KeySym* syms = XkbKeySymsPtr(xkb, keycode);
+            XkbAction* actions = XkbResizeKeyActions(xkb, keycode, s_numGroups);
+            for (int g = 0; g < s_numGroups; ++g) {
+                syms[g] = modifier->m_keysym;
+                actions[g].mods.type  = modifier->m_action;
+                actions[g].mods.flags = XkbSA_UseModMapMods;
+            }
+            xkb->map->modmap[keycode] = modifier->m_mask;
+        }
+    }
+    return xkb;
+}
+
+// fills the letter keys with the symbols of layout \p layout
+inline void
+setLayout(XkbDescPtr xkb, int layout)
+{
+    for (int i = s_firstKey; i <= s_lastKey; ++i) {
+        KeyCode keycode = static_cast<KeyCode>(i);
+        if (findModifier(i) != NULL) {
+            continue;
+        }
+        KeySym* syms = XkbKeySymsPtr(xkb, keycode);
+        for (int g = 0; g < s_numGroups; ++g) {
+            int letter = (i + 7 * layout + 3 * g) % 26;
+            syms[2 * g]     = XK_a + letter;
+            syms[2 * g + 1] = XK_A + letter;
+        }
+    }
+}
+
+// serves the keyboard without a display.  callers change the keyboard
+// in place so fetching the updated map does nothing.
+class NullXWindowsImpl : public XWindowsImpl {
+public:
+    NullXWindowsImpl(XkbDescPtr xkb) : m_xkb(xkb) { }
+
+    virtual int XGetKeyboardControl(Display*, XKeyboardState* value_return)
+    {
+        std::memset(value_return, 0, sizeof(*value_return));
+        return 0;
+    }
+
+    virtual XkbDescPtr XkbGetMap(Display*, unsigned int, unsigned int)
+    {
+        return m_xkb;
+    }
+
+    virtual Status XkbGetUpdatedMap(Display*, unsigned int, XkbDescPtr)
+    {
+        return Success;
+    }
+
+    virtual Status XkbGetState(Display*, unsigned int, XkbStatePtr state)
+    {
+        std::memset(state, 0, sizeof(*state));
+        return Success;
+    }
+
+private:
+    XkbDescPtr m_xkb;
+};
@@ -215,4 +215,78 @@ TEST(KeyMapTests, isCommand_superMask_returnTrue)
     EXPECT_EQ(true, keyMap.isCommand(mask));
 }
 
+static KeyMap::KeyItem
+makeKeyItem(KeyID id, KeyButton button, KeyModifierMask required,
+                KeyModifierMask sensitive)
+{
+    KeyMap::KeyItem item;
+    item.m_id        = id;
+    item.m_group     = 0;
+    item.m_button    = button;
+    item.m_required  = required;
+    item.m_sensitive = sensitive;
+    item.m_generates = 0;
+    item.m_dead      = false;
+    item.m_lock      = false;
+    item.m_client    = 0;
+    KeyMap::initModifierKey(item);
+    return item;
+}
+
+TEST(KeyMapTests, mapKey_sameKeyTwice_sameKeystrokes)
+{
+    KeyMap keyMap;
+    keyMap.addKeyEntry(makeKeyItem('A', 38, KeyModifierShift, KeyModifierShift));
+    keyMap.addKeyEntry(makeKeyItem(kKeyShift_L, 50, 0, 0));
+    keyMap.finish();
+
+    KeyMap::Keystrokes keys[2];
+    KeyMap::ModifierToKeys activeModifiers;
+    KeyModifierMask state = 0;
+    for (int i = 0; i < 2; ++i) {
+        const KeyMap::KeyItem* item =
+            keyMap.mapKey(keys[i], 'A', 0, activeModifiers, state, 0, false);
+        ASSERT_TRUE(item != NULL);
+        EXPECT_EQ(38, item->m_button);
+        EXPECT_EQ(0, state);
+        EXPECT_TRUE(activeModifiers.empty());
+    }
+
+    // shift down, A down, shift up
+    ASSERT_EQ(3, keys[0].size());
+    EXPECT_EQ(50, keys[0][0].m_data.m_button.m_button);
+    EXPECT_EQ(38, keys[0][1].m_data.m_button.m_button);
+    ASSERT_EQ(keys[0].size(), keys[1].size());
+    for (size_t i = 0; i < keys[0].size(); ++i) {
+        EXPECT_EQ(keys[0][i].m_data.m_button.m_button,
+                  keys[1][i].m_data.m_button.m_button);
+        EXPECT_EQ(keys[0][i].m_data.m_button.m_press,
+                  keys[1][i].m_data.m_button.m_press);
+    }
+}
+
+TEST(KeyMapTests, mapKey_mapChanged_newKeystrokes)
+{
+    KeyMap keyMap;
+    keyMap.addKeyEntry(makeKeyItem('a', 38, 0, KeyModifierShift));
+    keyMap.finish();
+
+    KeyMap::Keystrokes keys;
+    KeyMap::ModifierToKeys activeModifiers;
+    KeyModifierMask state = 0;
+    keyMap.mapKey(keys, 'a', 0, activeModifiers, state, 0, false);
+    ASSERT_EQ(1, keys.size());
+    EXPECT_EQ(38, keys[0].m_data.m_button.m_button);
+
+    KeyMap newKeyMap;
+    newKeyMap.addKeyEntry(makeKeyItem('a', 24, 0, KeyModifierShift));
+    newKeyMap.finish();
+    keyMap.swap(newKeyMap);
+
+    keys.clear();
+    keyMap.mapKey(keys, 'a', 0, activeModifiers, state, 0, false);
+    ASSERT_EQ(1, keys.size());
+    EXPECT_EQ(24, keys[0].m_data.m_button.m_button);
+}
+
 }
@@ -64,3 +64,75 @@ TEST(ServerArgsParsingTests, parseServerArgs_configArg_setConfigFile)
 
     EXPECT_EQ("mock_configFile", serverArgs.m_configFile);
 }
+
+TEST(ServerArgsParsingTests, parseServerArgs_virtualScreenArg_setShape)
+{
+    NiceMock<MockArgParser> argParser;
+    ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(server_stubParseGenericArgs));
+    ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(server_stubCheckUnexpectedArgs));
+    ServerArgs serverArgs;
+    const int argc = 3;
+    const char* kVirtualScreenCmd[argc] = { "stub", "--virtual-screen", "2560x1440" };
+
+    EXPECT_TRUE(argParser.parseServerArgs(serverArgs, argc, kVirtualScreenCmd));
+
+    EXPECT_TRUE(serverArgs.m_virtualScreen);
+    EXPECT_EQ(2560, serverArgs.m_virtualScreenWidth);
+    EXPECT_EQ(1440, serverArgs.m_virtualScreenHeight);
+}
+
+TEST(ServerArgsParsingTests, parseServerArgs_badVirtualScreenArg_fails)
+{
+    NiceMock<MockArgParser> argParser;
+    ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(server_stubParseGenericArgs));
+    ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(server_stubCheckUnexpectedArgs));
+    const int argc = 3;
+    const char* kBadCmds[][argc] = {
+        { "stub", "--virtual-screen", "1920" },
+        { "stub", "--virtual-screen", "0x1080" },
+        { "stub", "--virtual-screen", "1920x1080x2" }
+    };
+
+    for (const auto& cmd : kBadCmds) {
+        ServerArgs serverArgs;
+        EXPECT_FALSE(argParser.parseServerArgs(serverArgs, argc, cmd));
+        EXPECT_FALSE(serverArgs.m_virtualScreen);
+    }
+}
+
+TEST(ServerArgsParsingTests, parseServerArgs_socketShardArgs_setShards)
+{
+    NiceMock<MockArgParser> argParser;
+    ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(server_stubParseGenericArgs));
+    ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(server_stubCheckUnexpectedArgs));
+    ServerArgs serverArgs;
+    const int argc = 5;
+    const char* kSocketShardsCmd[argc] = {
+        "stub", "--socket-shards", "4", "--socket-shard-by", "address"
+    };
+
+    EXPECT_TRUE(argParser.parseServerArgs(serverArgs, argc, kSocketShardsCmd));
+
+    EXPECT_EQ(4, serverArgs.m_socketShards);
+    EXPECT_TRUE(serverArgs.m_socketShardByAddress);
+}
+
+TEST(ServerArgsParsingTests, parseServerArgs_badSocketShardArgs_fails)
+{
+    NiceMock<MockArgParser> argParser;
+    ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(server_stubParseGenericArgs));
+    ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(server_stubCheckUnexpectedArgs));
+    const int argc = 3;
+    const char* kBadCmds[][argc] = {
+        { "stub", "--socket-shards", "0" },
+        { "stub", "--socket-shards", "4x" },
+        { "stub", "--socket-shards", "65" },
+        { "stub", "--socket-shard-by", "hash" }
+    };
+
+    for (const auto& cmd : kBadCmds) {
+        ServerArgs serverArgs;
+        EXPECT_FALSE(argParser.parseServerArgs(serverArgs, argc, cmd));
+        EXPECT_EQ(1, serverArgs.m_socketShards);
+    }
+}
@@ -0,0 +1,215 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/DirectInputDispatcher.h"
+#include "client/IInputBackend.h"
+#include "base/String.h"
+#include "io/StreamBuffer.h"
+
+#include "test/global/gtest.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// keeps the calls it gets as strings
+class StringBackend : public IInputBackend {
+public:
+    StringBackend() : m_threadSafe(true) {}
+
+    void enter(SInt32 x, SInt32 y) override { add("enter %d,%d", x, y); }
+    void leave() override { add("leave"); }
+    void keyDown(KeyID id, KeyModifierMask mask, KeyButton button) override
+    {
+        add("keyDown %x %x %d", id, mask, button);
+    }
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton button) override
+    {
+        add("keyRepeat %x %x %d %d", id, mask, count, button);
+    }
+    void keyUp(KeyID id, KeyModifierMask mask, KeyButton button) override
+    {
+        add("keyUp %x %x %d", id, mask, button);
+    }
+    void mouseDown(ButtonID id) override { add("mouseDown %d", id); }
+    void mouseUp(ButtonID id) override { add("mouseUp %d", id); }
+    void mouseMove(SInt32 x, SInt32 y) override { add("mouseMove %d,%d", x, y); }
+    void mouseRelativeMove(SInt32 dx, SInt32 dy) override
+    {
+        add("mouseRelativeMove %d,%d", dx, dy);
+    }
+    void mouseWheel(SInt32 x, SInt32 y) override { add("mouseWheel %d,%d", x, y); }
+    void flush() override { add("flush"); }
+    bool isThreadSafe() const override { return m_threadSafe; }
+
+    template <typename... Args>
+    void add(const char* format, Args... args)
+    {
+        m_calls.push_back(barrier::string::sprintf(format, args...));
+    }
+
+public:
+    bool m_threadSafe;
+    std::vector<std::string> m_calls;
+};
+
+// a packet holding the message \p code followed by \p args
+std::string packet(const char* code, std::initializer_list<UInt8> args)
+{
+    std::string message(code, 4);
+    message.append(args.begin(), args.end());
+    UInt32 size = static_cast<UInt32>(message.size());
+    std::string result;
+    result.push_back(static_cast<char>(size >> 24));
+    result.push_back(static_cast<char>(size >> 16));
+    result.push_back(static_cast<char>(size >> 8));
+    result.push_back(static_cast<char>(size));
+    return result + message;
+}
+
+} // namespace
+
+class DirectInputDispatcherTests : public ::testing::Test {
+public:
+    DirectInputDispatcherTests() : m_dispatcher(&m_backend)
+    {
+        for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id) {
+            m_table[id] = id;
+        }
+        m_dispatcher.setModifierTranslation(m_table);
+    }
+
+    void receive(const std::string& data)
+    {
+        m_dispatcher.onSocketInput(reinterpret_cast<const UInt8*>(data.data()),
+                                   static_cast<UInt32>(data.size()), m_input);
+    }
+
+    // the data passed on to be read from the socket
+    std::string passedOn()
+    {
+        UInt32 size = m_input.getSize();
+        std::string result(static_cast<const char*>(m_input.peek(size)), size);
+        m_input.pop(size);
+        return result;
+    }
+
+protected:
+    StringBackend m_backend;
+    KeyModifierID m_table[kKeyModifierIDLast];
+    StreamBuffer m_input;
+    DirectInputDispatcher m_dispatcher;
+};
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_input_injectedAndFlushed)
+{
+    receive(packet("DMMV", { 0x01, 0x00, 0xff, 0xf6 }) +
+            packet("DKDN", { 0x00, 0x61, 0x00, 0x01, 0x00, 0x26 }) +
+            packet("DMDN", { 0x01 }));
+
+    std::vector<std::string> expected = {
+        "mouseMove 256,-10", "keyDown 61 1 38", "mouseDown 1", "flush"
+    };
+    EXPECT_EQ(expected, m_backend.m_calls);
+    EXPECT_EQ("", passedOn());
+    EXPECT_EQ(3u, m_dispatcher.getDirectCount());
+    EXPECT_EQ(0u, m_dispatcher.getQueuedCount());
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_splitPacket_injectedWhenComplete)
+{
+    std::string data = packet("DMWM", { 0x00, 0x00, 0x00, 0x78 });
+    for (size_t i = 0; i + 1 < data.size(); ++i) {
+        receive(data.substr(i, 1));
+    }
+    EXPECT_TRUE(m_backend.m_calls.empty());
+
+    receive(data.substr(data.size() - 1));
+    std::vector<std::string> expected = { "mouseWheel 0,120", "flush" };
+    EXPECT_EQ(expected, m_backend.m_calls);
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_afterControl_queuedUntilProcessed)
+{
+    std::string enter = packet("CINN", { 0, 0, 0, 0, 0, 0, 0, 1, 0, 0 });
+    std::string move = packet("DMMV", { 0x00, 0x0a, 0x00, 0x14 });
+    receive(enter + move);
+
+    // input behind the enter waits for it
+    EXPECT_TRUE(m_backend.m_calls.empty());
+    EXPECT_EQ(enter + move, passedOn());
+    EXPECT_EQ(1u, m_dispatcher.getQueuedCount());
+
+    m_dispatcher.processed(1);
+    receive(move);
+    EXPECT_TRUE(m_backend.m_calls.empty());
+    EXPECT_EQ(move, passedOn());
+
+    m_dispatcher.processed(2);
+    receive(move);
+    std::vector<std::string> expected = { "mouseMove 10,20", "flush" };
+    EXPECT_EQ(expected, m_backend.m_calls);
+    EXPECT_EQ("", passedOn());
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_held_passedOn)
+{
+    std::string move = packet("DMMV", { 0x00, 0x0a, 0x00, 0x14 });
+    m_dispatcher.setHeld(true);
+    receive(move);
+    EXPECT_TRUE(m_backend.m_calls.empty());
+    EXPECT_EQ(move, passedOn());
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_noTranslation_passedOn)
+{
+    std::string move = packet("DMMV", { 0x00, 0x0a, 0x00, 0x14 });
+    m_dispatcher.setModifierTranslation(NULL);
+    receive(move);
+    EXPECT_TRUE(m_backend.m_calls.empty());
+    EXPECT_EQ(move, passedOn());
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_backendNotThreadSafe_passedOn)
+{
+    std::string move = packet("DMMV", { 0x00, 0x0a, 0x00, 0x14 });
+    m_backend.m_threadSafe = false;
+    receive(move);
+    EXPECT_TRUE(m_backend.m_calls.empty());
+    EXPECT_EQ(move, passedOn());
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_wrongSize_passedOn)
+{
+    std::string bad = packet("DMMV", { 0x00, 0x0a });
+    receive(bad);
+    EXPECT_TRUE(m_backend.m_calls.empty());
+    EXPECT_EQ(bad, passedOn());
+}
+
+TEST_F(DirectInputDispatcherTests, onSocketInput_swappedModifiers_keyTranslated)
+{
+    m_table[kKeyModifierIDShift]   = kKeyModifierIDControl;
+    m_table[kKeyModifierIDControl] = kKeyModifierIDShift;
+
+    // left shift with shift held
+    receive(packet("DKDN", { 0xef, 0xe1, 0x00, 0x01, 0x00, 0x32 }));
+
+    std::vector<std::string> expected = { "keyDown efe3 2 50", "flush" };
+    EXPECT_EQ(expected, m_backend.m_calls);
+}
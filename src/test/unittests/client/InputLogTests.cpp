@@ -0,0 +1,175 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/InputLog.h"
+#include "client/RecordingInputBackend.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const char* kLogFilename = "InputLogTests.log";
+
+// keeps the calls it gets as records
+class CapturingBackend : public IInputBackend {
+public:
+    explicit CapturingBackend(std::vector<InputLogRecord>* calls) : m_calls(calls) {}
+
+    void enter(SInt32 x, SInt32 y) override { add(InputLogRecord::kEnter, x, y); }
+    void leave() override { add(InputLogRecord::kLeave); }
+    void keyDown(KeyID id, KeyModifierMask mask, KeyButton button) override
+    {
+        add(InputLogRecord::kKeyDown, id, mask, button);
+    }
+    void keyRepeat(KeyID id, KeyModifierMask mask, SInt32 count, KeyButton button) override
+    {
+        add(InputLogRecord::kKeyRepeat, id, mask, count, button);
+    }
+    void keyUp(KeyID id, KeyModifierMask mask, KeyButton button) override
+    {
+        add(InputLogRecord::kKeyUp, id, mask, button);
+    }
+    void mouseDown(ButtonID id) override { add(InputLogRecord::kMouseDown, id); }
+    void mouseUp(ButtonID id) override { add(InputLogRecord::kMouseUp, id); }
+    void mouseMove(SInt32 x, SInt32 y) override { add(InputLogRecord::kMouseMove, x, y); }
+    void mouseRelativeMove(SInt32 dx, SInt32 dy) override
+    {
+        add(InputLogRecord::kMouseRelativeMove, dx, dy);
+    }
+    void mouseWheel(SInt32 x, SInt32 y) override { add(InputLogRecord::kMouseWheel, x, y); }
+    void flush() override { add(InputLogRecord::kFlush); }
+
+private:
+    void add(UInt8 type, SInt32 a0 = 0, SInt32 a1 = 0, SInt32 a2 = 0, SInt32 a3 = 0)
+    {
+        InputLogRecord record;
+        record.m_time = 0;
+        record.m_type = type;
+        record.m_arg[0] = a0;
+        record.m_arg[1] = a1;
+        record.m_arg[2] = a2;
+        record.m_arg[3] = a3;
+        m_calls->push_back(record);
+    }
+
+private:
+    std::vector<InputLogRecord>* m_calls;
+};
+
+void playSession(IInputBackend& backend)
+{
+    backend.enter(100, 200);
+    backend.keyDown('a', KeyModifierShift, 38);
+    backend.keyRepeat('a', KeyModifierShift, 3, 38);
+    backend.keyUp('a', KeyModifierShift, 38);
+    backend.mouseDown(kButtonLeft);
+    backend.mouseUp(kButtonLeft);
+    backend.mouseMove(-5, 2147483647);
+    backend.mouseRelativeMove(-2147483647 - 1, 7);
+    backend.mouseWheel(0, -120);
+    backend.flush();
+    backend.leave();
+}
+
+void expectSameCalls(const std::vector<InputLogRecord>& expected,
+                     const std::vector<InputLogRecord>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].m_type, actual[i].m_type) << "record " << i;
+        for (size_t j = 0; j < InputLogRecord::getNumArgs(expected[i].m_type); ++j) {
+            EXPECT_EQ(expected[i].m_arg[j], actual[i].m_arg[j]) << "record " << i << " arg " << j;
+        }
+    }
+}
+
+} // namespace
+
+TEST(InputLogTests, writeThenRead_sameRecords)
+{
+    InputLogWriter writer;
+    ASSERT_TRUE(writer.open(kLogFilename));
+    const SInt32 args[][2] = { { 0, 0 }, { -1, 1 }, { 1000000, -1000000 } };
+    for (size_t i = 0; i < 3; ++i) {
+        InputLogRecord record;
+        record.m_time = 1000 * (i + 1);
+        record.m_type = InputLogRecord::kMouseMove;
+        record.m_arg[0] = args[i][0];
+        record.m_arg[1] = args[i][1];
+        writer.write(record);
+    }
+    writer.close();
+
+    InputLogReader reader;
+    ASSERT_TRUE(reader.open(kLogFilename));
+    InputLogRecord record;
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_TRUE(reader.read(record));
+        EXPECT_EQ(1000 * (i + 1), record.m_time);
+        EXPECT_EQ(InputLogRecord::kMouseMove, record.m_type);
+        EXPECT_EQ(args[i][0], record.m_arg[0]);
+        EXPECT_EQ(args[i][1], record.m_arg[1]);
+    }
+    EXPECT_FALSE(reader.read(record));
+    remove(kLogFilename);
+}
+
+TEST(InputLogTests, notALog_openFails)
+{
+    FILE* file = fopen(kLogFilename, "wb");
+    ASSERT_NE(nullptr, file);
+    fputs("not a log", file);
+    fclose(file);
+
+    InputLogReader reader;
+    EXPECT_FALSE(reader.open(kLogFilename));
+    remove(kLogFilename);
+}
+
+TEST(InputLogTests, recordingBackend_forwardsAndReplays)
+{
+    std::vector<InputLogRecord> forwarded;
+    {
+        std::unique_ptr<InputLogWriter> log(new InputLogWriter());
+        ASSERT_TRUE(log->open(kLogFilename));
+        RecordingInputBackend recorder(
+            std::unique_ptr<IInputBackend>(new CapturingBackend(&forwarded)), std::move(log));
+        playSession(recorder);
+    }
+
+    std::vector<InputLogRecord> expected;
+    CapturingBackend direct(&expected);
+    playSession(direct);
+    expectSameCalls(expected, forwarded);
+
+    std::vector<InputLogRecord> replayed;
+    CapturingBackend target(&replayed);
+    InputLogReader reader;
+    ASSERT_TRUE(reader.open(kLogFilename));
+    InputLogRecord record;
+    uint64_t lastTime = 0;
+    while (reader.read(record)) {
+        EXPECT_LE(lastTime, record.m_time);
+        lastTime = record.m_time;
+        record.dispatch(target);
+    }
+    expectSameCalls(expected, replayed);
+    remove(kLogFilename);
+}
@@ -0,0 +1,83 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mt/SpscRing.h"
+
+#include "test/global/gtest.h"
+
+#include <thread>
+
+TEST(SpscRingTests, push_full_returnsFalse)
+{
+    SpscRing<int> ring(3);
+    EXPECT_EQ(4u, ring.capacity());
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.push(i));
+    }
+    EXPECT_FALSE(ring.push(4));
+    EXPECT_EQ(4u, ring.size());
+
+    ASSERT_NE(nullptr, ring.front());
+    EXPECT_EQ(0, *ring.front());
+    ring.pop();
+    EXPECT_TRUE(ring.push(4));
+}
+
+TEST(SpscRingTests, pop_wrapsAround_keepsOrder)
+{
+    SpscRing<int> ring(4);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(ring.push(i));
+        ASSERT_NE(nullptr, ring.front());
+        EXPECT_EQ(i, *ring.front());
+        ring.pop();
+    }
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(nullptr, ring.front());
+}
+
+TEST(SpscRingTests, twoThreads_everyItemInOrder)
+{
+    const int count = 100000;
+    SpscRing<int> ring(64);
+
+    std::thread producer([&ring, count]() {
+        for (int i = 0; i < count; ++i) {
+            while (!ring.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < count) {
+        int* item = ring.front();
+        if (item == NULL) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (*item != expected) {
+            break;
+        }
+        ring.pop();
+        ++expected;
+    }
+    producer.join();
+
+    EXPECT_EQ(count, expected);
+}
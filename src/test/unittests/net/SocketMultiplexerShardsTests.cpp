@@ -0,0 +1,77 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/SocketMultiplexerShards.h"
+#include "net/SocketMultiplexer.h"
+#include "arch/Arch.h"
+
+#include "test/global/gtest.h"
+
+TEST(SocketMultiplexerShardsTests, getShard_firstShard_isGivenMultiplexer)
+{
+    SocketMultiplexer multiplexer;
+    SocketMultiplexerShards shards(&multiplexer, 3,
+                                   SocketMultiplexerShards::kRoundRobin);
+
+    EXPECT_EQ(3u, shards.getNumShards());
+    EXPECT_EQ(&multiplexer, shards.getShard(0));
+    EXPECT_NE(&multiplexer, shards.getShard(1));
+    EXPECT_NE(shards.getShard(1), shards.getShard(2));
+}
+
+TEST(SocketMultiplexerShardsTests, assign_roundRobin_cyclesShards)
+{
+    SocketMultiplexer multiplexer;
+    SocketMultiplexerShards shards(&multiplexer, 3,
+                                   SocketMultiplexerShards::kRoundRobin);
+    ArchNetAddress address = ARCH->nameToAddr("127.0.0.1");
+
+    EXPECT_EQ(shards.getShard(0), shards.assign(address));
+    EXPECT_EQ(shards.getShard(1), shards.assign(address));
+    EXPECT_EQ(shards.getShard(2), shards.assign(NULL));
+    EXPECT_EQ(shards.getShard(0), shards.assign(address));
+
+    ARCH->closeAddr(address);
+}
+
+TEST(SocketMultiplexerShardsTests, assign_byAddress_sameHostSameShard)
+{
+    SocketMultiplexer multiplexer;
+    SocketMultiplexerShards shards(&multiplexer, 4,
+                                   SocketMultiplexerShards::kByAddress);
+    ArchNetAddress first  = ARCH->nameToAddr("127.0.0.1");
+    ArchNetAddress second = ARCH->nameToAddr("127.0.0.1");
+    ARCH->setAddrPort(first, 40001);
+    ARCH->setAddrPort(second, 40002);
+
+    SocketMultiplexer* shard = shards.assign(first);
+    EXPECT_EQ(shard, shards.assign(first));
+    EXPECT_EQ(shard, shards.assign(second));
+
+    ARCH->closeAddr(first);
+    ARCH->closeAddr(second);
+}
+
+TEST(SocketMultiplexerShardsTests, assign_oneShard_alwaysFirst)
+{
+    SocketMultiplexer multiplexer;
+    SocketMultiplexerShards shards(&multiplexer, 1,
+                                   SocketMultiplexerShards::kRoundRobin);
+
+    EXPECT_EQ(&multiplexer, shards.assign(NULL));
+    EXPECT_EQ(&multiplexer, shards.assign(NULL));
+}
@@ -0,0 +1,94 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/UhidKeyMap.h"
+
+#include "test/global/gtest.h"
+
+#include <map>
+#include <utility>
+
+TEST(UhidKeyMapTests, everyEntry_lookup_roundTrips)
+{
+    ASSERT_LT(0u, UhidKeyMap::getNumEntries());
+    for (size_t i = 0; i < UhidKeyMap::getNumEntries(); ++i) {
+        const UhidKeyMap::Entry& entry = UhidKeyMap::getEntry(i);
+        const UhidKeyMap::Entry found = UhidKeyMap::lookup(entry.m_id);
+        EXPECT_EQ(entry.m_id, found.m_id) << "entry " << i;
+        EXPECT_EQ(entry.m_kind, found.m_kind) << "id 0x" << std::hex << entry.m_id;
+        EXPECT_EQ(entry.m_usage, found.m_usage) << "id 0x" << std::hex << entry.m_id;
+        EXPECT_EQ(entry.m_modifiers, found.m_modifiers) << "id 0x" << std::hex << entry.m_id;
+        EXPECT_EQ(entry.m_compose[0], found.m_compose[0]) << "id 0x" << std::hex << entry.m_id;
+        EXPECT_EQ(entry.m_compose[1], found.m_compose[1]) << "id 0x" << std::hex << entry.m_id;
+    }
+}
+
+TEST(UhidKeyMapTests, printableAscii_distinctKeys)
+{
+    // each character must come back as itself from the key typed for it
+    std::map<std::pair<UInt8, UInt8>, KeyID> typed;
+    for (KeyID id = 0x20; id < 0x7F; ++id) {
+        const UhidKeyMap::Entry entry = UhidKeyMap::lookup(id);
+        ASSERT_EQ(UhidKeyMap::kKey, entry.m_kind) << "id 0x" << std::hex << id;
+        const std::pair<UInt8, UInt8> key(entry.m_usage, entry.m_modifiers);
+        EXPECT_TRUE(typed.insert(std::make_pair(key, id)).second)
+            << "id 0x" << std::hex << id << " typed like 0x" << typed[key];
+    }
+}
+
+TEST(UhidKeyMapTests, latin1_allTypeable)
+{
+    for (KeyID id = 0xA0; id <= 0xFF; ++id) {
+        const UhidKeyMap::Entry entry = UhidKeyMap::lookup(id);
+        EXPECT_TRUE(entry.m_kind == UhidKeyMap::kCompose || entry.m_kind == UhidKeyMap::kUnicode)
+            << "id 0x" << std::hex << id;
+    }
+}
+
+TEST(UhidKeyMapTests, composeEntry_sequence)
+{
+    const UhidKeyMap::Entry entry = UhidKeyMap::lookup(0x0151);
+    EXPECT_EQ(UhidKeyMap::kCompose, entry.m_kind);
+    EXPECT_EQ('=', entry.m_compose[0]);
+    EXPECT_EQ('o', entry.m_compose[1]);
+}
+
+TEST(UhidKeyMapTests, characterWithoutEntry_unicode)
+{
+    const UhidKeyMap::Entry entry = UhidKeyMap::lookup(0x4E2D);
+    EXPECT_EQ(UhidKeyMap::kUnicode, entry.m_kind);
+    EXPECT_EQ(0x4E2Du, entry.m_id);
+}
+
+TEST(UhidKeyMapTests, specialKeys_mapped)
+{
+    EXPECT_EQ(0x28, UhidKeyMap::lookup(kKeyReturn).m_usage);
+    EXPECT_EQ(0x3a, UhidKeyMap::lookup(kKeyF1).m_usage);
+    EXPECT_EQ(0x73, UhidKeyMap::lookup(kKeyF24).m_usage);
+    EXPECT_EQ(0x7c, UhidKeyMap::lookup(kKeyCopy).m_usage);
+
+    const UhidKeyMap::Entry shift = UhidKeyMap::lookup(kKeyShift_R);
+    EXPECT_EQ(UhidKeyMap::kModifier, shift.m_kind);
+    EXPECT_EQ(UhidKeyMap::kRightShift, shift.m_modifiers);
+}
+
+TEST(UhidKeyMapTests, unknownOrDeadKey_unmapped)
+{
+    EXPECT_EQ(UhidKeyMap::kUnmapped, UhidKeyMap::lookup(kKeyHyper_L).m_kind);
+    EXPECT_EQ(UhidKeyMap::kUnmapped, UhidKeyMap::lookup(kKeyDeadAcute).m_kind);
+    EXPECT_EQ(UhidKeyMap::kUnmapped, UhidKeyMap::lookup(kKeyNone).m_kind);
+}
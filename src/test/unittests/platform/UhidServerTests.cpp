@@ -0,0 +1,651 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(__linux__)
+
+#include "platform/UhidInjector.h"
+#include "platform/UhidServer.h"
+
+#include "test/global/gtest.h"
+
+#include <linux/uhid.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// stands in for /dev/uhid.  the server gets one end of a socket pair
+// and the test reads the events it writes from the other.
+class FakeUhid {
+public:
+    FakeUhid() : m_serverFd(-1), m_fd(-1)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0) {
+            m_serverFd = fds[0];
+            m_fd = fds[1];
+            fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    ~FakeUhid()
+    {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    // start \p server on the fake device and discard the setup events
+    bool start(UhidServer& server)
+    {
+        send(UHID_START);
+        int fd = m_serverFd;
+        m_serverFd = -1;
+        if (!server.start(fd, "test") || !server.processEvents()) {
+            return false;
+        }
+        read();
+        return server.isStarted();
+    }
+
+    // create the device on \p server without starting it
+    bool create(UhidServer& server)
+    {
+        int fd = m_serverFd;
+        m_serverFd = -1;
+        if (!server.start(fd, "test")) {
+            return false;
+        }
+        read();
+        return true;
+    }
+
+    void send(UInt32 type)
+    {
+        struct uhid_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.type = type;
+        send(ev);
+    }
+
+    void send(const struct uhid_event& ev)
+    {
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(ev)), write(m_fd, &ev, sizeof(ev)));
+    }
+
+    // the reply to a feature report request with \p id
+    bool findReply(UInt32 type, UInt32 id, struct uhid_event& reply)
+    {
+        std::vector<struct uhid_event> events = read();
+        for (size_t i = 0; i < events.size(); ++i) {
+            if (events[i].type == type && events[i].u.set_report_reply.id == id) {
+                reply = events[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // everything the server has written since the last call.  input
+    // events may be cut short after the report, like the kernel allows.
+    std::vector<struct uhid_event> read()
+    {
+        std::vector<char> data;
+        char buffer[65536];
+        ssize_t n;
+        while ((n = ::read(m_fd, buffer, sizeof(buffer))) > 0) {
+            data.insert(data.end(), buffer, buffer + n);
+        }
+
+        const size_t inputHeaderSize =
+            offsetof(struct uhid_event, u) + offsetof(struct uhid_input2_req, data);
+        std::vector<struct uhid_event> events;
+        size_t offset = 0;
+        while (offset + inputHeaderSize <= data.size()) {
+            struct uhid_event ev;
+            memset(&ev, 0, sizeof(ev));
+            memcpy(&ev, &data[offset], inputHeaderSize);
+
+            size_t size = sizeof(ev);
+            if (ev.type == UHID_INPUT2) {
+                size = inputHeaderSize + ev.u.input2.size;
+            }
+            if (offset + size > data.size()) {
+                break;
+            }
+            memcpy(&ev, &data[offset], size);
+            events.push_back(ev);
+            offset += size;
+        }
+        return events;
+    }
+
+    // input reports with report id \p id not returned yet.  reports
+    // with other ids are kept for later calls.
+    std::vector<std::vector<UInt8> > readReports(UInt8 id)
+    {
+        std::vector<struct uhid_event> events = read();
+        for (size_t i = 0; i < events.size(); ++i) {
+            const struct uhid_input2_req& input = events[i].u.input2;
+            if (events[i].type == UHID_INPUT2 && input.size > 0) {
+                m_reports.push_back(std::vector<UInt8>(input.data,
+                                                       input.data + input.size));
+            }
+        }
+
+        std::vector<std::vector<UInt8> > reports;
+        std::vector<std::vector<UInt8> > others;
+        for (size_t i = 0; i < m_reports.size(); ++i) {
+            if (m_reports[i][0] == id) {
+                reports.push_back(m_reports[i]);
+            }
+            else {
+                others.push_back(m_reports[i]);
+            }
+        }
+        m_reports.swap(others);
+        return reports;
+    }
+
+private:
+    int m_serverFd;
+    int m_fd;
+    std::vector<std::vector<UInt8> > m_reports;
+};
+
+SInt16
+readInt16(const std::vector<UInt8>& report, size_t offset)
+{
+    return static_cast<SInt16>(report[offset] | (report[offset + 1] << 8));
+}
+
+// test if \p usage is pressed in an NKRO keyboard report
+bool
+isPressed(const std::vector<UInt8>& report, UInt8 usage)
+{
+    return (report[1 + (usage >> 3)] & (1u << (usage & 7))) != 0;
+}
+
+// the usages pressed in each NKRO keyboard report, with the modifiers
+std::vector<std::pair<UInt8, std::vector<UInt8> > >
+pressedKeys(const std::vector<std::vector<UInt8> >& reports)
+{
+    std::vector<std::pair<UInt8, std::vector<UInt8> > > keys;
+    for (size_t i = 0; i < reports.size(); ++i) {
+        std::vector<UInt8> usages;
+        for (int usage = 0; usage < 0xE0; ++usage) {
+            if (isPressed(reports[i], static_cast<UInt8>(usage))) {
+                usages.push_back(static_cast<UInt8>(usage));
+            }
+        }
+        keys.push_back(std::make_pair(reports[i].back(), usages));
+    }
+    return keys;
+}
+
+} // namespace
+
+TEST(UhidServerTests, mouseRelativeMove_largeDelta_singleReport)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseRelativeMove(3000, -2000);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_EQ(3000, readInt16(reports[0], 2));
+    EXPECT_EQ(-2000, readInt16(reports[0], 4));
+}
+
+TEST(UhidServerTests, mouseRelativeMove_hugeDelta_splitAtReportLimit)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseRelativeMove(40000, 0);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_EQ(32767, readInt16(reports[0], 2));
+    EXPECT_EQ(40000 - 32767, readInt16(reports[1], 2));
+}
+
+TEST(UhidServerTests, mouseRelativeMove_8bitReport_splitIntoSteps)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    server.setPointerReport(UhidServer::kPointerReport8);
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseRelativeMove(300, 0);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(3u, reports.size());
+    EXPECT_EQ(127, static_cast<SInt8>(reports[0][2]));
+    EXPECT_EQ(127, static_cast<SInt8>(reports[1][2]));
+    EXPECT_EQ(46, static_cast<SInt8>(reports[2][2]));
+}
+
+TEST(UhidServerTests, mouseMoveAbsolute_firstMove_placesCursorInOneReport)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    server.setScreenShape(0, 0, 1920, 1080);
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseMoveAbsolute(1919, 0);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(3);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_EQ(32767, readInt16(reports[0], 1));
+    EXPECT_EQ(0, readInt16(reports[0], 3));
+    EXPECT_TRUE(uhid.readReports(1).empty());
+}
+
+TEST(UhidServerTests, mouseMoveAbsolute_screenOffset_mapsToRange)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    server.setScreenShape(100, 200, 1001, 501);
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseMoveAbsolute(600, 450);
+    server.mouseMoveAbsolute(-50, 5000);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(3);
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_EQ(16384, readInt16(reports[0], 1));
+    EXPECT_EQ(16384, readInt16(reports[0], 3));
+    EXPECT_EQ(0, readInt16(reports[1], 1));
+    EXPECT_EQ(32767, readInt16(reports[1], 3));
+}
+
+TEST(UhidServerTests, mouseMoveAbsolute_absoluteDisabled_sendsDifference)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    server.setAbsolutePointer(false);
+    server.setScreenShape(0, 0, 1920, 1080);
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseMoveAbsolute(100, 100);
+    server.mouseMoveAbsolute(150, 80);
+
+    EXPECT_TRUE(uhid.readReports(3).empty());
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_EQ(50, readInt16(reports[0], 2));
+    EXPECT_EQ(-20, readInt16(reports[0], 4));
+}
+
+TEST(UhidServerTests, keyDown_manyKeys_allPressed)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    const char* keys = "qwertyuiop";
+    for (const char* key = keys; *key != '\0'; ++key) {
+        server.keyDown(*key, 0);
+    }
+    server.keyDown(kKeyShift_L, KeyModifierShift);
+    server.keyUp('e', KeyModifierShift);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(2);
+    ASSERT_EQ(12u, reports.size());
+    const std::vector<UInt8>& last = reports.back();
+    ASSERT_EQ(30u, last.size());
+    for (const char* key = keys; *key != '\0'; ++key) {
+        EXPECT_EQ(*key != 'e', isPressed(last, static_cast<UInt8>(0x04 + *key - 'a')));
+    }
+    EXPECT_EQ(0x02, last[29]);
+}
+
+TEST(UhidServerTests, keyDown_bootReport_sixSlots)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    server.setKeyboardReport(UhidServer::kKeyboardReportBoot);
+    ASSERT_TRUE(uhid.start(server));
+
+    server.keyDown('a', 0);
+    server.keyDown('b', KeyModifierControl);
+    server.keyUp('a', KeyModifierControl);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(2);
+    ASSERT_EQ(3u, reports.size());
+    ASSERT_EQ(9u, reports[2].size());
+    EXPECT_EQ(0x01, reports[2][1]);
+    EXPECT_EQ(0x00, reports[2][3]);
+    EXPECT_EQ(0x05, reports[2][4]);
+}
+
+TEST(UhidServerTests, keyDown_composeKeySet_typesSequence)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    server.setComposeKey(kKeyMenu);
+    ASSERT_TRUE(uhid.start(server));
+
+    // e acute is Compose ' e
+    server.keyDown(0x00E9, KeyModifierShift);
+    server.keyUp(0x00E9, KeyModifierShift);
+
+    std::vector<std::pair<UInt8, std::vector<UInt8> > > keys = pressedKeys(uhid.readReports(2));
+    ASSERT_EQ(7u, keys.size());
+    EXPECT_EQ(std::vector<UInt8>(1, 0x65), keys[0].second);
+    EXPECT_TRUE(keys[1].second.empty());
+    EXPECT_EQ(std::vector<UInt8>(1, 0x34), keys[2].second);
+    EXPECT_EQ(0, keys[2].first);
+    EXPECT_EQ(std::vector<UInt8>(1, 0x08), keys[4].second);
+    EXPECT_TRUE(keys[6].second.empty());
+    EXPECT_EQ(0x02, keys[6].first);
+}
+
+TEST(UhidServerTests, keyDown_noComposeKey_typesCodePoint)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    // Ctrl+Shift+U 4 e 2 d space
+    server.keyDown(0x4E2D, 0);
+
+    std::vector<std::pair<UInt8, std::vector<UInt8> > > keys = pressedKeys(uhid.readReports(2));
+    ASSERT_EQ(13u, keys.size());
+    EXPECT_EQ(std::vector<UInt8>(1, 0x18), keys[0].second);
+    EXPECT_EQ(0x03, keys[0].first);
+    EXPECT_EQ(std::vector<UInt8>(1, 0x21), keys[2].second);
+    EXPECT_EQ(std::vector<UInt8>(1, 0x08), keys[4].second);
+    EXPECT_EQ(std::vector<UInt8>(1, 0x1f), keys[6].second);
+    EXPECT_EQ(std::vector<UInt8>(1, 0x07), keys[8].second);
+    EXPECT_EQ(std::vector<UInt8>(1, 0x2c), keys[10].second);
+    EXPECT_TRUE(keys[12].second.empty());
+}
+
+TEST(UhidServerTests, mouseWheel_noMultiplier_keepsRemainder)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    server.mouseWheel(0, 60);
+    server.mouseWheel(0, 90);
+    server.mouseWheel(-240, 0);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_EQ(1, readInt16(reports[0], 6));
+    EXPECT_EQ(0, readInt16(reports[0], 8));
+    EXPECT_EQ(0, readInt16(reports[1], 6));
+    EXPECT_EQ(-2, readInt16(reports[1], 8));
+}
+
+TEST(UhidServerTests, mouseWheel_multiplierSet_fineDeltaInOneReport)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_SET_REPORT;
+    ev.u.set_report.id = 7;
+    ev.u.set_report.rnum = 1;
+    ev.u.set_report.rtype = UHID_FEATURE_REPORT;
+    ev.u.set_report.size = 2;
+    ev.u.set_report.data[0] = 0x01;
+    ev.u.set_report.data[1] = 0x05;
+    uhid.send(ev);
+    EXPECT_TRUE(server.processEvents());
+
+    struct uhid_event reply;
+    ASSERT_TRUE(uhid.findReply(UHID_SET_REPORT_REPLY, 7, reply));
+    EXPECT_EQ(0, reply.u.set_report_reply.err);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_GET_REPORT;
+    ev.u.get_report.id = 8;
+    ev.u.get_report.rnum = 1;
+    ev.u.get_report.rtype = UHID_FEATURE_REPORT;
+    uhid.send(ev);
+    EXPECT_TRUE(server.processEvents());
+
+    ASSERT_TRUE(uhid.findReply(UHID_GET_REPORT_REPLY, 8, reply));
+    EXPECT_EQ(0, reply.u.get_report_reply.err);
+    ASSERT_EQ(2, reply.u.get_report_reply.size);
+    EXPECT_EQ(0x05, reply.u.get_report_reply.data[1]);
+
+    server.mouseWheel(-15, 30);
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_EQ(30, readInt16(reports[0], 6));
+    EXPECT_EQ(-15, readInt16(reports[0], 8));
+}
+
+TEST(UhidServerTests, buffered_reportsWrittenOnFlush)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    server.setBuffered(true);
+    server.keyDown('a', KeyModifierShift);
+    server.keyUp('a', KeyModifierShift);
+    server.mouseRelativeMove(4, 2);
+    EXPECT_TRUE(uhid.read().empty());
+
+    EXPECT_TRUE(server.flush());
+    std::vector<std::vector<UInt8> > keys = uhid.readReports(2);
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_TRUE(isPressed(keys[0], 0x04));
+    EXPECT_FALSE(isPressed(keys[1], 0x04));
+    std::vector<std::vector<UInt8> > motion = uhid.readReports(1);
+    ASSERT_EQ(1u, motion.size());
+    EXPECT_EQ(4, readInt16(motion[0], 2));
+}
+
+TEST(UhidServerTests, start_beforeKernelStarts_reportsHeld)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.create(server));
+    EXPECT_FALSE(server.isStarted());
+
+    server.mouseRelativeMove(7, 0);
+    EXPECT_TRUE(uhid.readReports(1).empty());
+
+    uhid.send(UHID_START);
+    EXPECT_TRUE(server.processEvents());
+    EXPECT_TRUE(server.isStarted());
+
+    // the cleared state from start() comes first
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_EQ(0, readInt16(reports[0], 2));
+    EXPECT_EQ(7, readInt16(reports[1], 2));
+}
+
+TEST(UhidServerTests, outputReport_ledsSet_lockStateReported)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+    EXPECT_EQ(0u, server.getLockState());
+
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_OUTPUT;
+    ev.u.output.rtype = UHID_OUTPUT_REPORT;
+    ev.u.output.size = 2;
+    ev.u.output.data[0] = 0x02;
+    ev.u.output.data[1] = 0x03;
+    uhid.send(ev);
+    EXPECT_TRUE(server.processEvents());
+
+    EXPECT_EQ(static_cast<KeyModifierMask>(KeyModifierNumLock | KeyModifierCapsLock),
+              server.getLockState());
+}
+
+TEST(UhidInjectorTests, queuedRelativeMotion_coalesced)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    // everything queued before the thread starts is backed up
+    UhidInjector injector(&server);
+    for (int i = 0; i < 10; ++i) {
+        injector.mouseRelativeMove(3, -1);
+    }
+    injector.mouseDown(kButtonLeft);
+    injector.mouseRelativeMove(5, 5);
+    EXPECT_EQ(12u, injector.getQueueDepth());
+
+    injector.start(false);
+    injector.stop();
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(1);
+    ASSERT_EQ(3u, reports.size());
+    EXPECT_EQ(30, readInt16(reports[0], 2));
+    EXPECT_EQ(-10, readInt16(reports[0], 4));
+    EXPECT_EQ(0x01, reports[1][1]);
+    EXPECT_EQ(5, readInt16(reports[2], 2));
+    EXPECT_EQ(9u, injector.getNumCoalesced());
+    EXPECT_EQ(12u, injector.getPeakQueueDepth());
+    EXPECT_EQ(0u, injector.getQueueDepth());
+}
+
+TEST(UhidInjectorTests, started_injectsInOrder)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    UhidInjector injector(&server);
+    injector.start(false);
+    injector.keyDown('a', 0);
+    injector.keyUp('a', 0);
+    injector.stop();
+
+    std::vector<std::vector<UInt8> > reports = uhid.readReports(2);
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_TRUE(isPressed(reports[0], 0x04));
+    EXPECT_FALSE(isPressed(reports[1], 0x04));
+}
+
+TEST(UhidInjectorTests, queueFull_releasesStillInjected)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    // fill the ring before the thread starts
+    UhidInjector injector(&server);
+    for (size_t i = 0; i < UhidInjector::kQueueSize; ++i) {
+        injector.mouseMoveAbsolute(static_cast<SInt32>(i), 0);
+    }
+    injector.keyDown('a', 0);
+    injector.mouseRelativeMove(1, 1);
+    injector.mouseDown(kButtonLeft);
+    injector.mouseUp(kButtonLeft);
+    injector.keyUp('a', 0);
+    EXPECT_EQ(1u, injector.getNumDropped());
+    EXPECT_EQ(UhidInjector::kQueueSize + 4, injector.getQueueDepth());
+
+    injector.start(false);
+    injector.stop();
+
+    std::vector<std::vector<UInt8> > keys = uhid.readReports(2);
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_TRUE(isPressed(keys[0], 0x04));
+    EXPECT_FALSE(isPressed(keys[1], 0x04));
+
+    // the button goes down and comes back up after the motion
+    std::vector<std::vector<UInt8> > mouse = uhid.readReports(1);
+    ASSERT_LE(2u, mouse.size());
+    EXPECT_EQ(0x01, mouse[mouse.size() - 2][1]);
+    EXPECT_EQ(0x00, mouse[mouse.size() - 1][1]);
+    EXPECT_EQ(0u, injector.getQueueDepth());
+}
+
+TEST(UhidInjectorTests, kernelStartsDevice_heldReportsWritten)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.create(server));
+
+    UhidInjector injector(&server);
+    injector.start(false);
+    injector.mouseRelativeMove(9, 0);
+    injector.flush();
+    uhid.send(UHID_START);
+
+    // wait for the injection thread to see the device start
+    std::vector<std::vector<UInt8> > reports;
+    for (int i = 0; i < 200 && reports.size() < 2; ++i) {
+        usleep(5000);
+        std::vector<std::vector<UInt8> > more = uhid.readReports(1);
+        reports.insert(reports.end(), more.begin(), more.end());
+    }
+    injector.stop();
+
+    EXPECT_FALSE(injector.failed());
+    ASSERT_LE(2u, reports.size());
+    EXPECT_EQ(9, readInt16(reports[1], 2));
+}
+
+TEST(UhidInjectorTests, ledsSet_lockStateCallback)
+{
+    FakeUhid uhid;
+    UhidServer server;
+    ASSERT_TRUE(uhid.start(server));
+
+    std::atomic<KeyModifierMask> lockState(0);
+    UhidInjector injector(&server);
+    injector.setLockStateCallback([&lockState](KeyModifierMask mask) { lockState = mask; });
+    injector.start(false);
+
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_OUTPUT;
+    ev.u.output.rtype = UHID_OUTPUT_REPORT;
+    ev.u.output.size = 2;
+    ev.u.output.data[0] = 0x02;
+    ev.u.output.data[1] = 0x02;
+    uhid.send(ev);
+
+    for (int i = 0; i < 200 && lockState == 0; ++i) {
+        usleep(5000);
+    }
+    injector.stop();
+
+    EXPECT_EQ(static_cast<KeyModifierMask>(KeyModifierCapsLock), lockState.load());
+}
+
+#endif
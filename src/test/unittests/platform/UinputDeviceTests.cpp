@@ -0,0 +1,278 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "platform/UinputDevice.h"
+
+#include "platform/UhidKeyMap.h"
+
+#include "test/global/gtest.h"
+
+#if defined(__linux__)
+
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace {
+
+typedef std::vector<struct input_event> Events;
+
+// a device whose descriptors are datagram sockets so the test sees
+// every write() separately
+class CapturedDevice {
+public:
+    CapturedDevice()
+    {
+        int keyboard[2], absolute[2];
+        EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, keyboard));
+        EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, absolute));
+        m_keyboardFd = keyboard[0];
+        m_absoluteFd = absolute[0];
+        m_device.setScreenShape(0, 0, 1920, 1080);
+        m_device.startForTest(keyboard[1], absolute[1]);
+    }
+
+    ~CapturedDevice()
+    {
+        m_device.stop();
+        close(m_keyboardFd);
+        close(m_absoluteFd);
+    }
+
+    // the writes waiting on the keyboard or absolute device
+    std::vector<Events> keyboardWrites() { return readWrites(m_keyboardFd); }
+    std::vector<Events> absoluteWrites() { return readWrites(m_absoluteFd); }
+
+    UinputDevice        m_device;
+
+private:
+    static std::vector<Events> readWrites(int fd)
+    {
+        std::vector<Events> writes;
+        struct input_event buffer[256];
+        ssize_t n;
+        while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            writes.push_back(Events(buffer, buffer + n / sizeof(buffer[0])));
+        }
+        return writes;
+    }
+
+    int                 m_keyboardFd;
+    int                 m_absoluteFd;
+};
+
+// splits events at each SYN_REPORT, which must end the stream
+std::vector<Events>
+splitReports(const Events& events)
+{
+    std::vector<Events> reports(1);
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i].type == EV_SYN) {
+            EXPECT_EQ(SYN_REPORT, events[i].code);
+            reports.push_back(Events());
+        }
+        else {
+            reports.back().push_back(events[i]);
+        }
+    }
+    EXPECT_TRUE(reports.back().empty()) << "events after the last SYN_REPORT";
+    reports.pop_back();
+    return reports;
+}
+
+bool
+hasEvent(const Events& events, UInt16 type, UInt16 code, SInt32 value)
+{
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i].type == type && events[i].code == code &&
+            events[i].value == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the single flushed write on the keyboard device
+Events
+flushKeyboard(CapturedDevice& captured)
+{
+    EXPECT_TRUE(captured.m_device.flush());
+    std::vector<Events> writes = captured.keyboardWrites();
+    EXPECT_EQ(1u, writes.size());
+    return writes.empty() ? Events() : writes[0];
+}
+
+} // namespace
+
+TEST(UinputDeviceTests, everyMappedUsage_hasKeyCode)
+{
+    for (size_t i = 0; i < UhidKeyMap::getNumEntries(); ++i) {
+        const UhidKeyMap::Entry& entry = UhidKeyMap::getEntry(i);
+        if (entry.m_kind == UhidKeyMap::kKey) {
+            EXPECT_NE(0, UinputDevice::getKeyCode(entry.m_usage))
+                << "id 0x" << std::hex << entry.m_id << " usage 0x" << int(entry.m_usage);
+        }
+    }
+    for (int usage = 0xe0; usage <= 0xe7; ++usage) {
+        EXPECT_NE(0, UinputDevice::getKeyCode(static_cast<UInt8>(usage))) << "usage 0x" << std::hex << usage;
+    }
+}
+
+TEST(UinputDeviceTests, getKeyCode_matchesKernel)
+{
+    EXPECT_EQ(KEY_A, UinputDevice::getKeyCode(0x04));
+    EXPECT_EQ(KEY_Z, UinputDevice::getKeyCode(0x1d));
+    EXPECT_EQ(KEY_0, UinputDevice::getKeyCode(0x27));
+    EXPECT_EQ(KEY_ENTER, UinputDevice::getKeyCode(0x28));
+    EXPECT_EQ(KEY_F12, UinputDevice::getKeyCode(0x45));
+    EXPECT_EQ(KEY_F13, UinputDevice::getKeyCode(0x68));
+    EXPECT_EQ(KEY_KP0, UinputDevice::getKeyCode(0x62));
+    EXPECT_EQ(KEY_COMPOSE, UinputDevice::getKeyCode(0x65));
+    EXPECT_EQ(KEY_LEFTCTRL, UinputDevice::getKeyCode(0xe0));
+    EXPECT_EQ(KEY_RIGHTMETA, UinputDevice::getKeyCode(0xe7));
+    EXPECT_EQ(0, UinputDevice::getKeyCode(0x00));
+    EXPECT_EQ(0, UinputDevice::getKeyCode(0xff));
+}
+
+TEST(UinputDeviceTests, notStarted_inputRejected)
+{
+    UinputDevice device;
+    EXPECT_FALSE(device.running());
+    EXPECT_FALSE(device.keyDown('a', 0));
+    EXPECT_FALSE(device.mouseRelativeMove(1, 1));
+    EXPECT_FALSE(device.flush());
+}
+
+TEST(UinputDeviceTests, flush_eachCallOneReport_oneWritePerDevice)
+{
+    CapturedDevice captured;
+    UinputDevice& device = captured.m_device;
+
+    EXPECT_TRUE(device.keyDown('a', 0));
+    EXPECT_TRUE(device.mouseRelativeMove(3, -2));
+    EXPECT_TRUE(device.keyUp('a', 0));
+    EXPECT_TRUE(device.mouseMoveAbsolute(0, 0));
+    EXPECT_TRUE(device.mouseMoveAbsolute(1919, 1079));
+
+    // nothing goes out before the flush
+    EXPECT_TRUE(captured.keyboardWrites().empty());
+    EXPECT_TRUE(captured.absoluteWrites().empty());
+
+    EXPECT_TRUE(device.flush());
+    std::vector<Events> keyboard = captured.keyboardWrites();
+    std::vector<Events> absolute = captured.absoluteWrites();
+    ASSERT_EQ(1u, keyboard.size());
+    ASSERT_EQ(1u, absolute.size());
+
+    std::vector<Events> reports = splitReports(keyboard[0]);
+    ASSERT_EQ(3u, reports.size());
+    ASSERT_EQ(1u, reports[0].size());
+    EXPECT_TRUE(hasEvent(reports[0], EV_KEY, KEY_A, 1));
+    ASSERT_EQ(2u, reports[1].size());
+    EXPECT_TRUE(hasEvent(reports[1], EV_REL, REL_X, 3));
+    EXPECT_TRUE(hasEvent(reports[1], EV_REL, REL_Y, -2));
+    ASSERT_EQ(1u, reports[2].size());
+    EXPECT_TRUE(hasEvent(reports[2], EV_KEY, KEY_A, 0));
+
+    reports = splitReports(absolute[0]);
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_TRUE(hasEvent(reports[0], EV_ABS, ABS_X, 0));
+    EXPECT_TRUE(hasEvent(reports[0], EV_ABS, ABS_Y, 0));
+    EXPECT_TRUE(hasEvent(reports[1], EV_ABS, ABS_X, 32767));
+    EXPECT_TRUE(hasEvent(reports[1], EV_ABS, ABS_Y, 32767));
+
+    // an empty flush writes nothing
+    EXPECT_TRUE(device.flush());
+    EXPECT_TRUE(captured.keyboardWrites().empty());
+    EXPECT_TRUE(captured.absoluteWrites().empty());
+}
+
+TEST(UinputDeviceTests, mouseDown_followsDeviceThatLastMoved)
+{
+    CapturedDevice captured;
+    UinputDevice& device = captured.m_device;
+
+    // after an absolute move the press goes to the absolute device
+    device.mouseMoveAbsolute(100, 100);
+    device.mouseDown(kButtonLeft);
+    EXPECT_TRUE(device.flush());
+    std::vector<Events> absolute = captured.absoluteWrites();
+    ASSERT_EQ(1u, absolute.size());
+    EXPECT_TRUE(hasEvent(absolute[0], EV_KEY, BTN_LEFT, 1));
+    EXPECT_TRUE(captured.keyboardWrites().empty());
+
+    // after relative motion it goes to the relative one
+    device.mouseRelativeMove(1, 0);
+    device.mouseDown(kButtonRight);
+    Events keyboard = flushKeyboard(captured);
+    EXPECT_TRUE(hasEvent(keyboard, EV_KEY, BTN_RIGHT, 1));
+    EXPECT_TRUE(captured.absoluteWrites().empty());
+
+    // releases go to both
+    device.mouseUp(kButtonLeft);
+    keyboard = flushKeyboard(captured);
+    absolute = captured.absoluteWrites();
+    EXPECT_EQ(1u, splitReports(keyboard).size());
+    EXPECT_TRUE(hasEvent(keyboard, EV_KEY, BTN_LEFT, 0));
+    ASSERT_EQ(1u, absolute.size());
+    EXPECT_TRUE(hasEvent(absolute[0], EV_KEY, BTN_LEFT, 0));
+}
+
+TEST(UinputDeviceTests, mouseWheel_hiResRemainder_carriedIntoDetents)
+{
+    CapturedDevice captured;
+    UinputDevice& device = captured.m_device;
+
+    // half a detent scrolls smoothly but not by a whole detent
+    device.mouseWheel(0, 60);
+    Events events = flushKeyboard(captured);
+    EXPECT_EQ(1u, splitReports(events).size());
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_WHEEL_HI_RES, 60));
+    EXPECT_FALSE(hasEvent(events, EV_REL, REL_WHEEL, 1));
+
+    // the second half completes it
+    device.mouseWheel(0, 60);
+    events = flushKeyboard(captured);
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_WHEEL_HI_RES, 60));
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_WHEEL, 1));
+
+    // going back leaves part of a detent over
+    device.mouseWheel(0, -200);
+    events = flushKeyboard(captured);
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_WHEEL_HI_RES, -200));
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_WHEEL, -1));
+
+    device.mouseWheel(0, -40);
+    events = flushKeyboard(captured);
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_WHEEL, -1));
+
+    // horizontal is kept separately
+    device.mouseWheel(100, 0);
+    device.mouseWheel(20, 0);
+    events = flushKeyboard(captured);
+    EXPECT_EQ(2u, splitReports(events).size());
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_HWHEEL_HI_RES, 100));
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_HWHEEL_HI_RES, 20));
+    EXPECT_TRUE(hasEvent(events, EV_REL, REL_HWHEEL, 1));
+    EXPECT_FALSE(hasEvent(events, EV_REL, REL_WHEEL, -1));
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/VirtualScreen.h"
+#include "base/EventQueue.h"
+#include "base/String.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+#include <string>
+#include <vector>
+
+class VirtualScreenTests : public ::testing::Test {
+public:
+    VirtualScreenTests() : m_screen(0, 0, 1920, 1080, &m_events) { }
+
+    virtual void SetUp()
+    {
+        IPrimaryScreenEvents& primary = m_events.forIPrimaryScreen();
+        IKeyStateEvents& keys = m_events.forIKeyState();
+        Event::Type types[] = {
+            primary.motionOnPrimary(), primary.motionOnSecondary(),
+            primary.buttonDown(), primary.buttonUp(), primary.wheel(),
+            primary.hotKeyDown(), primary.hotKeyUp(),
+            keys.keyDown(), keys.keyUp()
+        };
+        for (Event::Type type : types) {
+            m_events.adoptHandler(type, m_screen.getEventTarget(),
+                new TMethodEventJob<VirtualScreenTests>(this,
+                    &VirtualScreenTests::handleEvent));
+        }
+    }
+
+    virtual void TearDown()
+    {
+        m_events.removeHandlers(m_screen.getEventTarget());
+    }
+
+    // dispatches the events the screen has posted and returns them
+    std::vector<std::string> takeEvents()
+    {
+        m_events.addEvent(Event(Event::kQuit));
+        m_events.loop();
+        std::vector<std::string> result;
+        result.swap(m_posted);
+        return result;
+    }
+
+    void handleEvent(const Event& event, void*)
+    {
+        IPrimaryScreenEvents& primary = m_events.forIPrimaryScreen();
+        IKeyStateEvents& keys = m_events.forIKeyState();
+        Event::Type type = event.getType();
+        if (type == primary.motionOnPrimary() || type == primary.motionOnSecondary()) {
+            IPlatformScreen::MotionInfo* info =
+                static_cast<IPlatformScreen::MotionInfo*>(event.getData());
+            m_posted.push_back(barrier::string::sprintf("%s %d,%d",
+                type == primary.motionOnPrimary() ? "primary" : "secondary",
+                info->m_x, info->m_y));
+        }
+        else if (type == primary.buttonDown() || type == primary.buttonUp()) {
+            IPlatformScreen::ButtonInfo* info =
+                static_cast<IPlatformScreen::ButtonInfo*>(event.getData());
+            m_posted.push_back(barrier::string::sprintf("button%s %d",
+                type == primary.buttonDown() ? "Down" : "Up", info->m_button));
+        }
+        else if (type == primary.wheel()) {
+            IPlatformScreen::WheelInfo* info =
+                static_cast<IPlatformScreen::WheelInfo*>(event.getData());
+            m_posted.push_back(barrier::string::sprintf("wheel %d,%d",
+                info->m_xDelta, info->m_yDelta));
+        }
+        else if (type == primary.hotKeyDown() || type == primary.hotKeyUp()) {
+            IPlatformScreen::HotKeyInfo* info =
+                static_cast<IPlatformScreen::HotKeyInfo*>(event.getData());
+            m_posted.push_back(barrier::string::sprintf("hotKey%s %d",
+                type == primary.hotKeyDown() ? "Down" : "Up", info->m_id));
+        }
+        else if (type == keys.keyDown() || type == keys.keyUp()) {
+            IKeyState::KeyInfo* info =
+                static_cast<IKeyState::KeyInfo*>(event.getData());
+            m_posted.push_back(barrier::string::sprintf("key%s %x %x %d",
+                type == keys.keyDown() ? "Down" : "Up",
+                info->m_key, info->m_mask, info->m_button));
+        }
+    }
+
+    EventQueue m_events;
+    VirtualScreen m_screen;
+    std::vector<std::string> m_posted;
+};
+
+typedef std::vector<std::string> Events;
+
+TEST_F(VirtualScreenTests, injectMouseMove_onScreen_cursorClampedToShape)
+{
+    m_screen.injectMouseMove(100, 200);
+    m_screen.injectMouseRelativeMove(-500, 5000);
+
+    // the motion past the edge is reported so the server can switch
+    EXPECT_EQ(Events({ "primary 100,200", "primary -400,5200" }), takeEvents());
+
+    SInt32 x, y;
+    m_screen.getCursorPos(x, y);
+    EXPECT_EQ(0, x);
+    EXPECT_EQ(1079, y);
+
+    m_screen.injectMouseRelativeMove(1, -1);
+    EXPECT_EQ(Events({ "primary 1,1078" }), takeEvents());
+}
+
+TEST_F(VirtualScreenTests, injectMouseMove_offScreen_relativeToCenter)
+{
+    ASSERT_TRUE(m_screen.leave());
+    EXPECT_FALSE(m_screen.isOnScreen());
+
+    m_screen.injectMouseRelativeMove(3, -4);
+
+    // the cursor stays in the center, and no motion means no event
+    m_screen.injectMouseMove(960 + 10, 540);
+    m_screen.injectMouseMove(960, 540);
+
+    m_screen.warpCursor(5, 6);
+    m_screen.enter();
+    m_screen.injectMouseRelativeMove(1, 1);
+
+    EXPECT_EQ(Events({ "secondary 3,-4", "secondary 10,0", "primary 6,7" }),
+              takeEvents());
+}
+
+TEST_F(VirtualScreenTests, injectMouseButton_pressed_buttonDown)
+{
+    UInt32 button = 0;
+    m_screen.injectMouseButton(kButtonRight, true);
+    EXPECT_TRUE(m_screen.isAnyMouseButtonDown(button));
+    EXPECT_EQ(kButtonRight, button);
+
+    m_screen.injectMouseButton(kButtonRight, false);
+    EXPECT_FALSE(m_screen.isAnyMouseButtonDown(button));
+    m_screen.injectMouseWheel(0, -120);
+
+    EXPECT_EQ(Events({ "buttonDown 3", "buttonUp 3", "wheel 0,-120" }),
+              takeEvents());
+}
+
+TEST_F(VirtualScreenTests, injectKey_pressed_keyDownAndState)
+{
+    m_screen.injectKey('a', KeyModifierShift, 38, true);
+    EXPECT_TRUE(m_screen.isKeyDown(38));
+    EXPECT_EQ(KeyModifierShift, m_screen.getActiveModifiers());
+
+    m_screen.injectKey('a', 0, 38, false);
+    EXPECT_FALSE(m_screen.isKeyDown(38));
+
+    EXPECT_EQ(Events({ "keyDown 61 1 38", "keyUp 61 0 38" }), takeEvents());
+}
+
+TEST_F(VirtualScreenTests, injectKey_registeredHotKey_hotKeyEvents)
+{
+    UInt32 id = m_screen.registerHotKey(kKeyF1, KeyModifierControl);
+    ASSERT_EQ(1u, id);
+
+    m_screen.injectKey(kKeyF1, KeyModifierControl, 67, true);
+    m_screen.injectKey(kKeyF1, KeyModifierControl, 67, false);
+
+    // without the modifier it's an ordinary key
+    m_screen.injectKey(kKeyF1, 0, 67, true);
+
+    m_screen.unregisterHotKey(id);
+    m_screen.injectKey(kKeyF1, KeyModifierControl, 67, false);
+
+    EXPECT_EQ(Events({ "hotKeyDown 1", "hotKeyUp 1",
+                       "keyDown efbe 0 67", "keyUp efbe 2 67" }), takeEvents());
+}
+
+TEST_F(VirtualScreenTests, setClipboard_getClipboard_sameData)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, "hello");
+    clipboard.close();
+    EXPECT_TRUE(m_screen.setClipboard(kClipboardClipboard, &clipboard));
+
+    Clipboard result;
+    EXPECT_TRUE(m_screen.getClipboard(kClipboardClipboard, &result));
+    EXPECT_EQ("hello", result.get(IClipboard::kText));
+}
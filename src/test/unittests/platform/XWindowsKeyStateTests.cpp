@@ -0,0 +1,202 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+// gtest first, Xlib's macros clash with it
+#include "test/global/gtest.h"
+
+#if WINAPI_XWINDOWS
+
+#include "platform/XWindowsKeyState.h"
+#include "base/EventQueue.h"
+#include "base/String.h"
+
+#if HAVE_XKB_EXTENSION
+
+#include "test/mock/platform/NullXWindowsImpl.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::string> Lines;
+
+void
+describeKey(KeyID id, SInt32 group, barrier::KeyMap::KeyItem& item, void* vlines)
+{
+    static_cast<Lines*>(vlines)->push_back(barrier::string::sprintf(
+        "key %x group %d button %d required %x sensitive %x generates %x%s%s",
+        id, group, item.m_button, item.m_required, item.m_sensitive,
+        item.m_generates, item.m_dead ? " dead" : "", item.m_lock ? " lock" : ""));
+}
+
+// everything the key state builds from the XKB map, one line per entry
+Lines
+describe(XWindowsKeyState& keyState, barrier::KeyMap& keyMap)
+{
+    Lines lines;
+    keyMap.foreachKey(&describeKey, &lines);
+
+    // keycodes for the same key may be in any order
+    Lines keycodes;
+    for (const auto& entry : keyState.keyCodeFromKey()) {
+        keycodes.push_back(barrier::string::sprintf("keycode %x %d",
+                                entry.first, entry.second));
+    }
+    std::sort(keycodes.begin(), keycodes.end());
+    lines.insert(lines.end(), keycodes.begin(), keycodes.end());
+
+    for (size_t i = 0; i < keyState.modifierFromX().size(); ++i) {
+        lines.push_back(barrier::string::sprintf("from x %d %x",
+                                static_cast<int>(i), keyState.modifierFromX()[i]));
+    }
+    for (const auto& entry : keyState.modifierToX()) {
+        lines.push_back(barrier::string::sprintf("to x %x %x",
+                                entry.first, entry.second));
+    }
+    return lines;
+}
+
+// the result of building the map for \p xkb from scratch
+Lines
+describeRebuilt(XkbDescPtr xkb)
+{
+    EventQueue events;
+    barrier::KeyMap keyMap;
+    NullXWindowsImpl impl(xkb);
+    XWindowsKeyState keyState(&impl, NULL, true, &events, keyMap);
+    keyState.updateKeyMap();
+    return describe(keyState, keyMap);
+}
+
+void
+remapKey(XkbDescPtr xkb, KeyCode keycode, int letter)
+{
+    KeySym* syms = XkbKeySymsPtr(xkb, keycode);
+    syms[0] = XK_a + letter;
+    syms[1] = XK_A + letter;
+}
+
+// makes \p keycode a Mod5 key without changing its symbols
+void
+addToModMap(XkbDescPtr xkb, KeyCode keycode)
+{
+    xkb->map->modmap[keycode] = Mod5Mask;
+}
+
+} // namespace
+
+class XWindowsKeyStateTests : public ::testing::Test {
+public:
+    XWindowsKeyStateTests() :
+        m_xkb(createKeyboard()),
+        m_impl(m_xkb),
+        m_keyState(&m_impl, NULL, true, &m_events, m_keyMap)
+    {
+        setLayout(m_xkb, 0);
+        m_keyState.updateKeyMap();
+    }
+
+    // the same keyboard as the fixture's, built from scratch
+    XkbDescPtr copyKeyboard(int layout)
+    {
+        XkbDescPtr xkb = createKeyboard();
+        setLayout(xkb, layout);
+        return xkb;
+    }
+
+    EventQueue m_events;
+    barrier::KeyMap m_keyMap;
+    XkbDescPtr m_xkb;
+    NullXWindowsImpl m_impl;
+    XWindowsKeyState m_keyState;
+};
+
+TEST_F(XWindowsKeyStateTests, updateKeyMap_remappedKey_patchedLikeRebuild)
+{
+    const size_t cached = m_keyState.keyMapCacheSize();
+    const Lines before = describe(m_keyState, m_keyMap);
+
+    remapKey(m_xkb, 38, 25);
+    m_keyState.updateKeyMap(38, 1);
+    EXPECT_NE(before, describe(m_keyState, m_keyMap));
+
+    XkbDescPtr expected = copyKeyboard(0);
+    remapKey(expected, 38, 25);
+    EXPECT_EQ(describeRebuilt(expected), describe(m_keyState, m_keyMap));
+
+    // a patched map doesn't set the old one aside
+    EXPECT_EQ(cached, m_keyState.keyMapCacheSize());
+}
+
+TEST_F(XWindowsKeyStateTests, updateKeyMap_previousLayout_restoredLikeRebuild)
+{
+    const Lines first = describe(m_keyState, m_keyMap);
+
+    setLayout(m_xkb, 1);
+    m_keyState.updateKeyMap();
+    EXPECT_EQ(describeRebuilt(copyKeyboard(1)), describe(m_keyState, m_keyMap));
+    EXPECT_EQ(1u, m_keyState.keyMapCacheSize());
+
+    setLayout(m_xkb, 0);
+    m_keyState.updateKeyMap();
+    EXPECT_EQ(first, describe(m_keyState, m_keyMap));
+    EXPECT_EQ(describeRebuilt(copyKeyboard(0)), describe(m_keyState, m_keyMap));
+
+    // the second layout took the first's place in the cache
+    EXPECT_EQ(1u, m_keyState.keyMapCacheSize());
+}
+
+TEST_F(XWindowsKeyStateTests, updateKeyMap_modMapChanged_rebuilt)
+{
+    const size_t cached = m_keyState.keyMapCacheSize();
+
+    addToModMap(m_xkb, 38);
+    m_keyState.updateKeyMap(38, 1);
+
+    XkbDescPtr expected = copyKeyboard(0);
+    addToModMap(expected, 38);
+    EXPECT_EQ(describeRebuilt(expected), describe(m_keyState, m_keyMap));
+
+    // a rebuild sets the old map aside
+    EXPECT_EQ(cached + 1, m_keyState.keyMapCacheSize());
+}
+
+TEST_F(XWindowsKeyStateTests, updateKeyMap_modifierKeyRemapped_rebuilt)
+{
+    const size_t cached = m_keyState.keyMapCacheSize();
+
+    // turn Shift_R into Control_R
+    XkbKeySymsPtr(m_xkb, 62)[0] = XK_Control_R;
+    XkbKeySymsPtr(m_xkb, 62)[1] = XK_Control_R;
+    m_xkb->map->modmap[62] = ControlMask;
+    m_keyState.updateKeyMap(62, 1);
+
+    XkbDescPtr expected = copyKeyboard(0);
+    XkbKeySymsPtr(expected, 62)[0] = XK_Control_R;
+    XkbKeySymsPtr(expected, 62)[1] = XK_Control_R;
+    expected->map->modmap[62] = ControlMask;
+    EXPECT_EQ(describeRebuilt(expected), describe(m_keyState, m_keyMap));
+    EXPECT_EQ(cached + 1, m_keyState.keyMapCacheSize());
+}
+
+#endif // HAVE_XKB_EXTENSION
+
+#endif // WINAPI_XWINDOWS
@@ -0,0 +1,136 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/Config.h"
+
+#include "test/global/gtest.h"
+
+#include <sstream>
+
+namespace {
+
+void
+makeConfig(Config& config)
+{
+    config.addScreen("server");
+    config.addScreen("left");
+    config.addScreen("right");
+    config.connect("server", kLeft, 0.0f, 1.0f, "left", 0.0f, 1.0f);
+    config.connect("server", kRight, 0.0f, 1.0f, "right", 0.0f, 1.0f);
+    config.addOption("left", kOptionHalfDuplexCapsLock, 1);
+}
+
+} // namespace
+
+TEST(ConfigTests, diff_sameConfig_isEmpty)
+{
+    Config a(NULL), b(NULL);
+    makeConfig(a);
+    makeConfig(b);
+
+    EXPECT_TRUE(a.diff(b).isEmpty());
+}
+
+TEST(ConfigTests, diff_fromEmpty_everyScreenAdded)
+{
+    Config a(NULL), b(NULL);
+    makeConfig(b);
+
+    Config::Delta delta = a.diff(b);
+
+    EXPECT_EQ(3U, delta.m_addedScreens.size());
+    EXPECT_EQ(3U, delta.m_changedOptions.size());
+    EXPECT_TRUE(delta.m_removedScreens.empty());
+}
+
+TEST(ConfigTests, diff_screenOption_onlyThatScreenChanged)
+{
+    Config a(NULL), b(NULL);
+    makeConfig(a);
+    makeConfig(b);
+    b.addOption("right", kOptionHalfDuplexNumLock, 1);
+
+    Config::Delta delta = a.diff(b);
+
+    EXPECT_EQ(1U, delta.m_changedOptions.size());
+    EXPECT_EQ(1U, delta.m_changedOptions.count("right"));
+    EXPECT_TRUE(delta.m_changedLinks.empty());
+    EXPECT_FALSE(delta.m_globalOptionsChanged);
+}
+
+TEST(ConfigTests, diff_link_onlyLinksChanged)
+{
+    Config a(NULL), b(NULL);
+    makeConfig(a);
+    makeConfig(b);
+    b.disconnect("server", kRight);
+
+    Config::Delta delta = a.diff(b);
+
+    EXPECT_EQ(1U, delta.m_changedLinks.count("server"));
+    EXPECT_TRUE(delta.m_changedOptions.empty());
+    EXPECT_TRUE(delta.m_removedScreens.empty());
+}
+
+TEST(ConfigTests, diff_removedScreenAndAlias_reported)
+{
+    Config a(NULL), b(NULL);
+    makeConfig(a);
+    b.addScreen("server");
+    b.addScreen("left");
+    b.connect("server", kLeft, 0.0f, 1.0f, "left", 0.0f, 1.0f);
+    b.addOption("left", kOptionHalfDuplexCapsLock, 1);
+    b.addAlias("left", "left.local");
+
+    Config::Delta delta = a.diff(b);
+
+    EXPECT_EQ(1U, delta.m_removedScreens.count("right"));
+    EXPECT_TRUE(delta.m_aliasesChanged);
+}
+
+TEST(ConfigTests, diff_globalOption_reported)
+{
+    Config a(NULL), b(NULL);
+    makeConfig(a);
+    makeConfig(b);
+    b.addOption("", kOptionScreenSwitchDelay, 250);
+
+    Config::Delta delta = a.diff(b);
+
+    EXPECT_TRUE(delta.m_globalOptionsChanged);
+    EXPECT_TRUE(delta.m_changedOptions.empty());
+}
+
+TEST(ConfigTests, read_xi2RawMotion_screenOption)
+{
+    std::istringstream text(
+        "section: screens\n"
+        "    server:\n"
+        "        xi2RawMotion = true\n"
+        "end\n");
+    Config config(NULL);
+    text >> config;
+
+    const Config::ScreenOptions* options = config.getOptions("server");
+    ASSERT_TRUE(options != NULL);
+    ASSERT_EQ(1U, options->count(kOptionXIRawMotion));
+    EXPECT_EQ(1, options->find(kOptionXIRawMotion)->second);
+
+    std::ostringstream written;
+    written << config;
+    EXPECT_NE(std::string::npos, written.str().find("xi2RawMotion = true"));
+}
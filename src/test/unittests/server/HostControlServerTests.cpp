@@ -0,0 +1,570 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "server/HostControlServer.h"
+#include "server/Config.h"
+#include "server/PrimaryClient.h"
+#include "server/Server.h"
+#include "barrier/IInputInjector.h"
+#include "net/IDataSocket.h"
+#include "net/IListenSocket.h"
+#include "net/ISocketFactory.h"
+#include "net/NetworkAddress.h"
+#include "base/EventQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
+namespace {
+
+// the client end of a fake connection.  outlives the server's socket.
+struct Peer {
+    Peer() : m_socket(NULL), m_closed(false), m_deleted(false) { }
+
+    IDataSocket*        m_socket;
+    std::string         m_toServer;
+    std::string         m_fromServer;
+    bool                m_closed;
+    bool                m_deleted;
+};
+
+// a data socket that buffers in memory.  the test delivers the events a
+// real socket would get from the multiplexer.
+class FakeDataSocket : public IDataSocket {
+public:
+    FakeDataSocket(Peer* peer) : IDataSocket(NULL), m_peer(peer)
+    {
+        m_peer->m_socket = this;
+    }
+    virtual ~FakeDataSocket() { m_peer->m_deleted = true; }
+
+    virtual void connect(const NetworkAddress&) { }
+    virtual void bind(const NetworkAddress&) { }
+    virtual void close() { m_peer->m_closed = true; }
+    virtual void* getEventTarget() const
+    {
+        return const_cast<FakeDataSocket*>(this);
+    }
+    virtual UInt32 read(void* buffer, UInt32 n)
+    {
+        std::string& input = m_peer->m_toServer;
+        n = std::min(n, static_cast<UInt32>(input.size()));
+        input.copy(static_cast<char*>(buffer), n);
+        input.erase(0, n);
+        return n;
+    }
+    virtual void write(const void* buffer, UInt32 n)
+    {
+        m_peer->m_fromServer.append(static_cast<const char*>(buffer), n);
+    }
+    virtual void flush() { }
+    virtual void shutdownInput() { }
+    virtual void shutdownOutput() { }
+    virtual bool isReady() const { return !m_peer->m_toServer.empty(); }
+    virtual bool isFatal() const { return false; }
+    virtual UInt32 getSize() const
+    {
+        return static_cast<UInt32>(m_peer->m_toServer.size());
+    }
+
+private:
+    Peer*               m_peer;
+};
+
+class FakeListenSocket : public IListenSocket {
+public:
+    virtual IDataSocket* accept()
+    {
+        if (m_pending.empty()) {
+            return NULL;
+        }
+        IDataSocket* socket = m_pending.front();
+        m_pending.pop_front();
+        return socket;
+    }
+    virtual IDataSocket* accept(SocketMultiplexerShards*) { return accept(); }
+    virtual void bind(const NetworkAddress&) { }
+    virtual void close() { }
+    virtual void* getEventTarget() const
+    {
+        return const_cast<FakeListenSocket*>(this);
+    }
+
+    std::deque<IDataSocket*> m_pending;
+};
+
+class FakeSocketFactory : public ISocketFactory {
+public:
+    FakeSocketFactory(FakeListenSocket** listen) : m_listen(listen) { }
+
+    virtual IDataSocket* create(IArchNetwork::EAddressFamily,
+                            ConnectionSecurityLevel) const
+    {
+        return NULL;
+    }
+    virtual IListenSocket* createListen(IArchNetwork::EAddressFamily,
+                            ConnectionSecurityLevel) const
+    {
+        *m_listen = new FakeListenSocket;
+        return *m_listen;
+    }
+
+private:
+    FakeListenSocket**  m_listen;
+};
+
+// a host control server on fake sockets answering for a test server
+class HostControlHarness {
+public:
+    HostControlHarness() :
+        m_listen(NULL),
+        m_config(NULL),
+        m_server(m_config, &m_primary),
+        m_hostControl(NetworkAddress(HostControlServer::kDefaultPort),
+                            new FakeSocketFactory(&m_listen), &m_events)
+    {
+        m_config.addScreen("server");
+        m_hostControl.setServer(&m_server);
+    }
+
+    void connect(Peer& peer)
+    {
+        m_listen->m_pending.push_back(new FakeDataSocket(&peer));
+        m_events.dispatchEvent(Event(m_events.forIListenSocket().connecting(),
+                            m_listen));
+    }
+
+    void send(Peer& peer, const std::string& data)
+    {
+        peer.m_toServer += data;
+        m_events.dispatchEvent(Event(m_events.forIStream().inputReady(),
+                            peer.m_socket->getEventTarget()));
+    }
+
+    void flushed(Peer& peer)
+    {
+        m_events.dispatchEvent(Event(m_events.forIStream().outputFlushed(),
+                            peer.m_socket->getEventTarget()));
+    }
+
+    // handle anything the server queued for itself
+    void drain()
+    {
+        m_events.addEvent(Event(Event::kQuit));
+        m_events.loop();
+    }
+
+    std::string response(const HostControlServer::Response& response,
+                            bool keepAlive = true) const
+    {
+        return HostControlServer::formatResponse(response, keepAlive);
+    }
+
+    EventQueue          m_events;
+    FakeListenSocket*   m_listen;
+    Config              m_config;
+    PrimaryClient       m_primary;
+    Server              m_server;
+    HostControlServer   m_hostControl;
+};
+
+HostControlServer::Response
+makeResponse(const std::string& contentType, const std::string& body)
+{
+    HostControlServer::Response response;
+    response.m_contentType = contentType;
+    response.m_body        = body;
+    return response;
+}
+
+const char* kStateJson = "{\"server\": {\"current\":\"\", \"ip\":\"\"}}";
+
+// writes each injected event as a line of text
+class RecordingInjector : public IInputInjector {
+public:
+    virtual void injectMouseMove(SInt32 x, SInt32 y)
+    {
+        m_log << "move " << x << " " << y << "\n";
+    }
+    virtual void injectMouseRelativeMove(SInt32 dx, SInt32 dy)
+    {
+        m_log << "rmove " << dx << " " << dy << "\n";
+    }
+    virtual void injectMouseButton(ButtonID id, bool press)
+    {
+        m_log << "button " << int(id) << " " << press << "\n";
+    }
+    virtual void injectMouseWheel(SInt32 xDelta, SInt32 yDelta)
+    {
+        m_log << "wheel " << xDelta << " " << yDelta << "\n";
+    }
+    virtual void injectKey(KeyID id, KeyModifierMask mask,
+                            KeyButton button, bool press)
+    {
+        m_log << "key " << id << " " << mask << " " << button << " "
+              << press << "\n";
+    }
+
+    std::ostringstream m_log;
+};
+
+} // namespace
+
+TEST(HostControlServerTests, parseRequest_simpleGet_complete)
+{
+    std::string buffer = "GET /get/config HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    HostControlServer::Request request;
+
+    EXPECT_EQ(HostControlServer::kComplete,
+              HostControlServer::parseRequest(buffer, request));
+    EXPECT_EQ("GET", request.m_method);
+    EXPECT_EQ("/get/config", request.m_path);
+    EXPECT_EQ("HTTP/1.1", request.m_version);
+    EXPECT_TRUE(request.m_keepAlive);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(HostControlServerTests, parseRequest_pipelined_parsedInOrder)
+{
+    std::string buffer =
+        "GET /set/screen/left HTTP/1.1\r\n\r\n"
+        "POST /set/config HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+        "GET / HTTP/1.1\r\n\r\n";
+    HostControlServer::Request request;
+
+    ASSERT_EQ(HostControlServer::kComplete,
+              HostControlServer::parseRequest(buffer, request));
+    EXPECT_EQ("/set/screen/left", request.m_path);
+
+    ASSERT_EQ(HostControlServer::kComplete,
+              HostControlServer::parseRequest(buffer, request));
+    EXPECT_EQ("POST", request.m_method);
+    EXPECT_EQ("hello", request.m_body);
+
+    ASSERT_EQ(HostControlServer::kComplete,
+              HostControlServer::parseRequest(buffer, request));
+    EXPECT_EQ("/", request.m_path);
+    EXPECT_EQ(HostControlServer::kIncomplete,
+              HostControlServer::parseRequest(buffer, request));
+}
+
+TEST(HostControlServerTests, parseRequest_partialBody_incomplete)
+{
+    std::string buffer = "POST /set/config HTTP/1.1\r\nContent-Length: 10\r\n\r\nabc";
+    HostControlServer::Request request;
+
+    EXPECT_EQ(HostControlServer::kIncomplete,
+              HostControlServer::parseRequest(buffer, request));
+
+    buffer += "defghij";
+    EXPECT_EQ(HostControlServer::kComplete,
+              HostControlServer::parseRequest(buffer, request));
+    EXPECT_EQ("abcdefghij", request.m_body);
+}
+
+TEST(HostControlServerTests, parseRequest_connectionClose_notKeepAlive)
+{
+    std::string buffer =
+        "GET / HTTP/1.0\r\n\r\n"
+        "GET / HTTP/1.1\r\nconnection: Close\r\n\r\n"
+        "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+    HostControlServer::Request request;
+
+    HostControlServer::parseRequest(buffer, request);
+    EXPECT_FALSE(request.m_keepAlive);
+    HostControlServer::parseRequest(buffer, request);
+    EXPECT_FALSE(request.m_keepAlive);
+    HostControlServer::parseRequest(buffer, request);
+    EXPECT_TRUE(request.m_keepAlive);
+}
+
+TEST(HostControlServerTests, parseRequest_malformed_badRequest)
+{
+    HostControlServer::Request request;
+
+    std::string noVersion = "GET /\r\n\r\n";
+    EXPECT_EQ(HostControlServer::kBadRequest,
+              HostControlServer::parseRequest(noVersion, request));
+
+    std::string badHeader = "GET / HTTP/1.1\r\nbogus\r\n\r\n";
+    EXPECT_EQ(HostControlServer::kBadRequest,
+              HostControlServer::parseRequest(badHeader, request));
+
+    std::string chunked = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    EXPECT_EQ(HostControlServer::kBadRequest,
+              HostControlServer::parseRequest(chunked, request));
+
+    std::string huge(HostControlServer::kMaxHeaderSize + 1, 'a');
+    EXPECT_EQ(HostControlServer::kBadRequest,
+              HostControlServer::parseRequest(huge, request));
+}
+
+TEST(HostControlServerTests, formatResponse_setsLengthAndConnection)
+{
+    HostControlServer::Response response;
+    response.m_contentType = "application/json";
+    response.m_body        = "{}";
+
+    EXPECT_EQ("HTTP/1.1 200 OK\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Length: 2\r\n"
+              "Connection: keep-alive\r\n"
+              "\r\n"
+              "{}",
+              HostControlServer::formatResponse(response, true));
+
+    response.m_status = 404;
+    std::string closed = HostControlServer::formatResponse(response, false);
+    EXPECT_EQ(0u, closed.find("HTTP/1.1 404 Not Found\r\n"));
+    EXPECT_NE(std::string::npos, closed.find("Connection: close\r\n"));
+}
+
+TEST(HostControlServerTests, formatResponse_stream_hasNoContentLength)
+{
+    HostControlServer::Response response;
+    response.m_stream = true;
+    response.m_body   = HostControlServer::formatEvent("screen", "{}");
+
+    std::string head = HostControlServer::formatResponse(response, true);
+    EXPECT_NE(std::string::npos, head.find("Content-Type: text/event-stream\r\n"));
+    EXPECT_EQ(std::string::npos, head.find("Content-Length"));
+    EXPECT_EQ(head.size() - response.m_body.size(), head.find("\r\n\r\n") + 4);
+}
+
+TEST(HostControlServerTests, formatEvent_serverSentEventFormat)
+{
+    EXPECT_EQ("event: connected\ndata: {\"screen\":\"left\"}\n\n",
+              HostControlServer::formatEvent("connected", "{\"screen\":\"left\"}"));
+}
+
+TEST(HostControlServerTests, injectInput_allCommands_injectedInOrder)
+{
+    RecordingInjector injector;
+
+    EXPECT_TRUE(HostControlServer::injectInput(
+        "move 100 200\n"
+        "rmove -3 0x10\r\n"
+        "\n"
+        "button 1 down\n"
+        "wheel 0 -120\n"
+        "key 97 down\n"
+        "key 0x41 up 0x1 38\n", injector));
+
+    EXPECT_EQ("move 100 200\n"
+              "rmove -3 16\n"
+              "button 1 1\n"
+              "wheel 0 -120\n"
+              "key 97 0 0 1\n"
+              "key 65 1 38 0\n", injector.m_log.str());
+}
+
+TEST(HostControlServerTests, injectInput_badCommand_injectsNothing)
+{
+    const char* bad[] = {
+        "jump 1 2",
+        "move 1",
+        "move 1 2 3",
+        "move 1x 2",
+        "button 1 pressed",
+        "key 97 down shift"
+    };
+
+    for (const char* command : bad) {
+        RecordingInjector injector;
+        EXPECT_FALSE(HostControlServer::injectInput(
+            std::string("wheel 0 1\n") + command + "\nwheel 0 2\n", injector))
+            << command;
+        EXPECT_EQ("", injector.m_log.str()) << command;
+    }
+}
+
+TEST(HostControlServerTests, injectInput_typoAfterKeyDown_keyNotPressed)
+{
+    RecordingInjector injector;
+
+    EXPECT_FALSE(HostControlServer::injectInput(
+        "key 97 down\n"
+        "key 97 upp\n", injector));
+
+    EXPECT_EQ("", injector.m_log.str());
+}
+
+TEST(HostControlServerTests, connection_keepAlive_reusedForNextRequest)
+{
+    HostControlHarness harness;
+    Peer peer;
+    harness.connect(peer);
+    const std::string state = harness.response(
+                            makeResponse("application/json", kStateJson));
+
+    harness.send(peer, "GET / HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(state, peer.m_fromServer);
+    harness.flushed(peer);
+    harness.drain();
+    EXPECT_FALSE(peer.m_closed);
+
+    harness.send(peer, "GET / HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(state + state, peer.m_fromServer);
+    EXPECT_EQ(1u, harness.m_hostControl.getNumConnections());
+}
+
+TEST(HostControlServerTests, connection_pipelinedBurst_answeredInOrder)
+{
+    HostControlHarness harness;
+    Peer peer;
+    harness.connect(peer);
+
+    // arrives in pieces that don't line up with the requests
+    harness.send(peer, "GET /set/screen/nowhere HTTP/1.1\r\n\r\nGET /get/con");
+    harness.send(peer, "fig HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n");
+
+    std::ostringstream config;
+    config << harness.m_config;
+    EXPECT_EQ(harness.response(makeResponse("text/plain", "false")) +
+              harness.response(makeResponse("text/plain", config.str())) +
+              harness.response(makeResponse("application/json", kStateJson)),
+              peer.m_fromServer);
+}
+
+TEST(HostControlServerTests, connection_severalClients_answeredIndependently)
+{
+    HostControlHarness harness;
+    Peer first, second;
+    harness.connect(first);
+    harness.connect(second);
+    EXPECT_EQ(2u, harness.m_hostControl.getNumConnections());
+    const std::string state = harness.response(
+                            makeResponse("application/json", kStateJson));
+
+    // a partial request on one doesn't hold up the other
+    harness.send(first, "GET / HTTP/1.1\r\n");
+    harness.send(second, "GET / HTTP/1.1\r\n\r\n");
+    EXPECT_EQ("", first.m_fromServer);
+    EXPECT_EQ(state, second.m_fromServer);
+
+    harness.send(first, "\r\n");
+    EXPECT_EQ(state, first.m_fromServer);
+    EXPECT_EQ(state, second.m_fromServer);
+
+    // one leaving doesn't affect the other
+    harness.send(second, "GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+    harness.flushed(second);
+    harness.drain();
+    EXPECT_TRUE(second.m_deleted);
+    EXPECT_FALSE(first.m_closed);
+    EXPECT_EQ(1u, harness.m_hostControl.getNumConnections());
+}
+
+TEST(HostControlServerTests, connection_connectionClose_closedOnceFlushed)
+{
+    HostControlHarness harness;
+    Peer peer;
+    harness.connect(peer);
+
+    // anything after the closing request is ignored
+    harness.send(peer,
+        "GET / HTTP/1.1\r\nConnection: close\r\n\r\n"
+        "GET / HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(harness.response(makeResponse("application/json", kStateJson),
+                            false),
+              peer.m_fromServer);
+
+    // not until the response has gone out
+    EXPECT_FALSE(peer.m_closed);
+    harness.flushed(peer);
+    EXPECT_TRUE(peer.m_closed);
+    EXPECT_EQ(0u, harness.m_hostControl.getNumConnections());
+
+    harness.drain();
+    EXPECT_TRUE(peer.m_deleted);
+}
+
+TEST(HostControlServerTests, publish_subscriber_receivesServerSentEvents)
+{
+    HostControlHarness harness;
+    Peer peer;
+    harness.connect(peer);
+
+    // the stream starts with the current state
+    harness.send(peer, "GET /events HTTP/1.1\r\n\r\n");
+    HostControlServer::Response head = makeResponse("text/event-stream",
+        HostControlServer::formatEvent("screen",
+                            "{\"current\":\"\", \"ip\":\"\"}"));
+    head.m_stream = true;
+    std::string expected = harness.response(head);
+    EXPECT_EQ(expected, peer.m_fromServer);
+    EXPECT_EQ(1u, harness.m_hostControl.getNumSubscribers());
+
+    harness.flushed(peer);
+    harness.m_hostControl.publish("screen", "{\"current\":\"left\"}");
+    expected += "event: screen\ndata: {\"current\":\"left\"}\n\n";
+    EXPECT_EQ(expected, peer.m_fromServer);
+
+    // events published before the socket flushes go out together
+    harness.m_hostControl.publish("config", "{\"changed\":true}");
+    harness.m_hostControl.publish("screen", "{\"current\":\"right\"}");
+    EXPECT_EQ(expected, peer.m_fromServer);
+    harness.flushed(peer);
+    expected += "event: config\ndata: {\"changed\":true}\n\n"
+                "event: screen\ndata: {\"current\":\"right\"}\n\n";
+    EXPECT_EQ(expected, peer.m_fromServer);
+
+    // subscribers only listen
+    harness.send(peer, "GET / HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(expected, peer.m_fromServer);
+}
+
+TEST(HostControlServerTests, publish_slowSubscriber_droppedOthersKeepReceiving)
+{
+    HostControlHarness harness;
+    Peer slow, fast;
+    harness.connect(slow);
+    harness.connect(fast);
+    harness.send(slow, "GET /events HTTP/1.1\r\n\r\n");
+    harness.send(fast, "GET /events HTTP/1.1\r\n\r\n");
+    harness.flushed(fast);
+    const size_t slowStart = slow.m_fromServer.size();
+    const size_t fastStart = fast.m_fromServer.size();
+
+    // the slow subscriber's socket never flushes so everything queues
+    const std::string event = HostControlServer::formatEvent("screen", "{}");
+    for (size_t i = 0; i < HostControlServer::kMaxQueuedEvents; ++i) {
+        harness.m_hostControl.publish("screen", "{}");
+        harness.flushed(fast);
+    }
+    EXPECT_FALSE(slow.m_closed);
+    EXPECT_EQ(2u, harness.m_hostControl.getNumSubscribers());
+
+    harness.m_hostControl.publish("screen", "{}");
+    EXPECT_TRUE(slow.m_closed);
+    EXPECT_EQ(1u, harness.m_hostControl.getNumSubscribers());
+    EXPECT_EQ(slowStart, slow.m_fromServer.size());
+
+    harness.flushed(fast);
+    harness.m_hostControl.publish("screen", "{}");
+    EXPECT_EQ((HostControlServer::kMaxQueuedEvents + 2) * event.size(),
+              fast.m_fromServer.size() - fastStart);
+
+    harness.drain();
+    EXPECT_TRUE(slow.m_deleted);
+    EXPECT_FALSE(fast.m_closed);
+}
@@ -0,0 +1,131 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "server/InputFilter.h"
+#include "server/Server.h"
+#include "base/EventQueue.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+
+class InputFilterTests : public ::testing::Test {
+public:
+    InputFilterTests() : m_filter(&m_events) { }
+
+    virtual void SetUp()
+    {
+        m_events.adoptHandler(m_events.forServer().switchToScreen(), &m_filter,
+            new TMethodEventJob<InputFilterTests>(this,
+                &InputFilterTests::handleSwitch));
+        m_events.adoptHandler(m_events.forIPrimaryScreen().buttonDown(), &m_filter,
+            new TMethodEventJob<InputFilterTests>(this,
+                &InputFilterTests::handlePassThrough));
+    }
+
+    virtual void TearDown()
+    {
+        m_events.removeHandlers(&m_filter);
+    }
+
+    // add a rule that switches to \p screen when \p condition matches
+    void addRule(InputFilter::Condition* condition, const std::string& screen)
+    {
+        InputFilter::Rule rule(condition);
+        rule.adoptAction(new InputFilter::SwitchToScreenAction(&m_events, screen), true);
+        m_filter.addFilterRule(rule);
+    }
+
+    void buttonDown(ButtonID button, KeyModifierMask mask)
+    {
+        IPlatformScreen::ButtonInfo* info =
+            IPlatformScreen::ButtonInfo::alloc(button, mask);
+        m_filter.handleEventForTest(Event(m_events.forIPrimaryScreen().buttonDown(),
+                                          NULL, info));
+        free(info);
+    }
+
+    void handleSwitch(const Event& event, void*)
+    {
+        Server::SwitchToScreenInfo* info =
+            static_cast<Server::SwitchToScreenInfo*>(event.getData());
+        m_switched.push_back(info->m_screen);
+    }
+
+    void handlePassThrough(const Event&, void*)
+    {
+        ++m_passedThrough;
+    }
+
+    EventQueue m_events;
+    InputFilter m_filter;
+    std::vector<std::string> m_switched;
+    int m_passedThrough = 0;
+};
+
+TEST_F(InputFilterTests, buttonRule_matchingButton_firstRuleWins)
+{
+    addRule(new InputFilter::MouseButtonCondition(&m_events, kButtonLeft, 0), "a");
+    addRule(new InputFilter::MouseButtonCondition(&m_events, kButtonRight, 0), "b");
+    addRule(new InputFilter::MouseButtonCondition(&m_events, kButtonRight, 0), "c");
+
+    buttonDown(kButtonRight, 0);
+
+    ASSERT_EQ(1U, m_switched.size());
+    EXPECT_EQ("b", m_switched[0]);
+    EXPECT_EQ(0, m_passedThrough);
+}
+
+TEST_F(InputFilterTests, buttonRule_ignoredModifiers_stillMatches)
+{
+    addRule(new InputFilter::MouseButtonCondition(&m_events, kButtonLeft,
+                                                  KeyModifierShift), "a");
+
+    buttonDown(kButtonLeft, KeyModifierShift | KeyModifierCapsLock);
+    buttonDown(kButtonLeft, KeyModifierControl);
+
+    ASSERT_EQ(1U, m_switched.size());
+    EXPECT_EQ("a", m_switched[0]);
+    EXPECT_EQ(1, m_passedThrough);
+}
+
+TEST_F(InputFilterTests, removeFilterRule_laterRuleMatches)
+{
+    addRule(new InputFilter::MouseButtonCondition(&m_events, kButtonLeft, 0), "a");
+    addRule(new InputFilter::MouseButtonCondition(&m_events, kButtonLeft, 0), "b");
+
+    buttonDown(kButtonLeft, 0);
+    m_filter.removeFilterRule(0);
+    buttonDown(kButtonLeft, 0);
+
+    ASSERT_EQ(2U, m_switched.size());
+    EXPECT_EQ("a", m_switched[0]);
+    EXPECT_EQ("b", m_switched[1]);
+}
+
+TEST_F(InputFilterTests, noRules_eventPassesThrough)
+{
+    addRule(new InputFilter::ScreenConnectedCondition(&m_events, ""), "a");
+
+    buttonDown(kButtonMiddle, 0);
+
+    EXPECT_TRUE(m_switched.empty());
+    EXPECT_EQ(1, m_passedThrough);
+}
@@ -0,0 +1,110 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) Barrier contributors
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "server/Server.h"
+#include "server/Config.h"
+#include "server/InputFilter.h"
+#include "server/PrimaryClient.h"
+
+#include "test/global/gtest.h"
+
+#include <sstream>
+
+namespace {
+
+const char* kScrollLockRule = "keystroke(ScrollLock) = lockCursorToScreen(toggle)";
+
+UInt32
+countRules(InputFilter* filter, const std::string& format)
+{
+    UInt32 count = 0;
+    for (UInt32 i = 0; i < filter->getNumRules(); ++i) {
+        if (filter->getRule(i).format() == format) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(ServerTests, addLockToScreenHotkey_noHotkeys_addsScrollLockOnce)
+{
+    Config config(NULL);
+    config.addScreen("server");
+    PrimaryClient primary;
+    Server server(config, &primary);
+
+    // on construction
+    server.addLockToScreenHotkeyForTest();
+    EXPECT_EQ(1u, countRules(config.getInputFilter(), kScrollLockRule));
+
+    // re-applying the same configuration doesn't add it again
+    server.addLockToScreenHotkeyForTest();
+    EXPECT_EQ(1u, countRules(config.getInputFilter(), kScrollLockRule));
+
+    // a reload replaces the filter
+    Config reloaded(NULL);
+    reloaded.addScreen("server");
+    config = reloaded;
+    EXPECT_EQ(0u, countRules(config.getInputFilter(), kScrollLockRule));
+    server.addLockToScreenHotkeyForTest();
+    EXPECT_EQ(1u, countRules(config.getInputFilter(), kScrollLockRule));
+}
+
+TEST(ServerTests, addLockToScreenHotkey_configuredLockAction_leavesFilter)
+{
+    Config config(NULL);
+    std::istringstream text(
+        "section: screens\n"
+        "    server:\n"
+        "end\n"
+        "section: options\n"
+        "    keystroke(F12) = lockCursorToScreen(toggle)\n"
+        "end\n");
+    text >> config;
+    PrimaryClient primary;
+    Server server(config, &primary);
+
+    server.addLockToScreenHotkeyForTest();
+
+    EXPECT_EQ(1u, config.getInputFilter()->getNumRules());
+    EXPECT_EQ(0u, countRules(config.getInputFilter(), kScrollLockRule));
+}
+
+TEST(ServerTests, recordAppliedConfig_identicalReload_emptyDelta)
+{
+    Config config(NULL);
+    config.addScreen("server");
+    PrimaryClient primary;
+    Server server(config, &primary);
+
+    // first application, then the built-in hotkey goes into the filter
+    EXPECT_FALSE(server.recordAppliedConfigForTest(config).isEmpty());
+    server.addLockToScreenHotkeyForTest();
+    ASSERT_EQ(1u, countRules(config.getInputFilter(), kScrollLockRule));
+
+    // reloading the same file reports no changes
+    Config reloaded(NULL);
+    reloaded.addScreen("server");
+    config = reloaded;
+    Config::Delta delta = server.recordAppliedConfigForTest(config);
+    EXPECT_TRUE(delta.isEmpty());
+    EXPECT_FALSE(delta.m_filterChanged);
+}